@@ -29,6 +29,8 @@
 /* Exported constants --------------------------------------------------------*/
 
 /* ########################## Module Selection ############################## */
+#include "lorawan_crypto_conf.h"  /* LORAWAN_CRYPTO_BACKEND */
+
 /**
   * @brief This is the list of modules to be used in the HAL driver
   */
@@ -36,7 +38,9 @@
 #define HAL_ADC_MODULE_ENABLED
 /*#define HAL_COMP_MODULE_ENABLED   */
 /*#define HAL_CRC_MODULE_ENABLED   */
-/*#define HAL_CRYP_MODULE_ENABLED   */
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES)
+#define HAL_CRYP_MODULE_ENABLED
+#endif /* LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES */
 /*#define HAL_DAC_MODULE_ENABLED   */
 /*#define HAL_GTZC_MODULE_ENABLED   */
 /*#define HAL_HSEM_MODULE_ENABLED   */
@@ -68,7 +68,10 @@ typedef enum
   CFG_SEQ_Task_Vcom,
   CFG_SEQ_Task_LmHandler_process_task,
   CFG_SEQ_Task_lora_tx_task,
-  CFG_SEQ_Task_initial_join_retry_task,
+  CFG_SEQ_Task_initial_join_task,
+  CFG_SEQ_Task_join_task,
+  CFG_SEQ_Task_app_sample_task,
+  CFG_SEQ_Task_app_backfill_task,
 
   CFG_SEQ_Task_NBR
 } CFG_SEQ_Task_Id_t;
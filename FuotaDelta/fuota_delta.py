@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""
+FUOTA delta patch generator
+
+Builds the patch applied on the device by DeltaPatch.c
+(Middlewares/Third_Party/LoRaWAN/LmHandler/Packages/DeltaPatch.h describes
+the format). The old image is the content of the active slot the device runs,
+the new image is the file a full FUOTA session would send.
+
+    fuota_delta.py old.bin new.bin update.patch [--frag-size 216]
+
+The patch is sent like a full image, with the FragSessionSetupReq
+descriptor 0x31544C44 ("DLT1").
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b"DLT1"
+HEADER_SIZE = 80
+
+WINDOW_SIZE = 1024
+MIN_MATCH = 3
+MAX_SHORT_MATCH = 66
+MAX_MATCH = MAX_SHORT_MATCH + 255
+
+SEED = 8          # bytes needed to look up a match in the old image
+MAX_CANDIDATES = 32
+MAX_MISMATCH = 16  # a diff region ends after this many differing bytes in a row
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value - 1) << 1) | 1
+
+
+def find_regions(old, new):
+    """Returns (old_start, new_start, length) regions where new mostly equals old"""
+    index = {}
+    for pos in range(len(old) - SEED + 1):
+        index.setdefault(old[pos:pos + SEED], []).append(pos)
+
+    regions = []
+    new_pos = 0
+    old_next = 0
+    while new_pos + SEED <= len(new):
+        # Continuing the previous region is the most likely match: after a
+        # replaced block ( same length ) or after an inserted block
+        skipped = new_pos - (regions[-1][1] + regions[-1][2]) if regions else new_pos
+        candidates = [old_next + skipped, old_next]
+        candidates += index.get(new[new_pos:new_pos + SEED], [])[:MAX_CANDIDATES]
+
+        best_old = None
+        best_len = 0
+        for cand in candidates:
+            if cand < 0 or cand >= len(old):
+                continue
+            length = 0
+            while (new_pos + length < len(new) and cand + length < len(old)
+                   and old[cand + length] == new[new_pos + length]):
+                length += 1
+            if length > best_len:
+                best_old, best_len = cand, length
+
+        if best_len < SEED:
+            new_pos += 1
+            continue
+
+        # Extend over small changes (e.g. moved addresses) until the images diverge
+        end = best_len
+        last_equal = best_len
+        while new_pos + end < len(new) and best_old + end < len(old) and end - last_equal < MAX_MISMATCH:
+            if old[best_old + end] == new[new_pos + end]:
+                last_equal = end + 1
+            end += 1
+
+        regions.append((best_old, new_pos, last_equal))
+        new_pos += last_equal
+        old_next = best_old + last_equal
+    return regions
+
+
+def build_commands(old, new, regions):
+    """Serializes the diff / extra / seek commands"""
+    out = bytearray()
+    old_pos = 0
+    new_pos = 0
+    if not regions or regions[0][1] != 0:
+        regions = [(0, 0, 0)] + regions
+
+    for i, (old_start, new_start, length) in enumerate(regions):
+        assert new_start == new_pos
+        out += varint(length)
+        out += bytes((new[new_start + k] - old[old_start + k]) & 0xFF for k in range(length))
+        new_pos += length
+        old_pos = old_start + length
+
+        extra_end = regions[i + 1][1] if i + 1 < len(regions) else len(new)
+        out += varint(extra_end - new_pos)
+        out += new[new_pos:extra_end]
+        new_pos = extra_end
+
+        if new_pos < len(new):
+            out += varint(zigzag(regions[i + 1][0] - old_pos))
+    return bytes(out)
+
+
+def lzss_compress(data):
+    out = bytearray()
+    heads = {}
+    pos = 0
+    flags_pos = None
+    flag_bit = 8
+    while pos < len(data):
+        if flag_bit == 8:
+            flags_pos = len(out)
+            out.append(0)
+            flag_bit = 0
+
+        best_len = 0
+        best_dist = 0
+        key = data[pos:pos + MIN_MATCH]
+        if len(key) == MIN_MATCH:
+            for cand in reversed(heads.get(key, [])):
+                dist = pos - cand
+                if dist > WINDOW_SIZE:
+                    break
+                length = 0
+                # Overlapping matches are fine, the decoder copies byte by byte
+                while (length < MAX_MATCH and pos + length < len(data)
+                       and data[cand + length] == data[pos + length]):
+                    length += 1
+                if length > best_len:
+                    best_len, best_dist = length, dist
+                    if length == MAX_MATCH:
+                        break
+
+        if best_len >= MIN_MATCH:
+            code = ((best_dist - 1) << 6) | (min(best_len, MAX_SHORT_MATCH) - MIN_MATCH)
+            out += struct.pack("<H", code)
+            if best_len >= MAX_SHORT_MATCH:
+                out.append(best_len - MAX_SHORT_MATCH)
+            step = best_len
+        else:
+            out[flags_pos] |= 1 << flag_bit
+            out.append(data[pos])
+            step = 1
+        flag_bit += 1
+
+        for p in range(pos, pos + step):
+            chain = heads.setdefault(data[p:p + MIN_MATCH], [])
+            chain.append(p)
+            if len(chain) > 64:
+                del chain[:32]
+        pos += step
+    return bytes(out)
+
+
+def lzss_decompress(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        flags = data[pos]
+        pos += 1
+        for bit in range(8):
+            if pos >= len(data):
+                break
+            if flags & (1 << bit):
+                out.append(data[pos])
+                pos += 1
+            else:
+                code = data[pos] | (data[pos + 1] << 8)
+                pos += 2
+                dist = (code >> 6) + 1
+                length = (code & 0x3F) + MIN_MATCH
+                if length == MAX_SHORT_MATCH:
+                    length += data[pos]
+                    pos += 1
+                for _ in range(length):
+                    out.append(out[-dist] if dist <= len(out) else 0)
+    return bytes(out)
+
+
+def apply_patch(old, patch):
+    """Reference implementation of DeltaPatchApply()"""
+    magic, old_size, new_size, body_size = struct.unpack_from("<4sIII", patch)
+    assert magic == MAGIC and old_size == len(old)
+    assert hashlib.sha256(old).digest() == patch[16:48]
+    cmds = lzss_decompress(patch[HEADER_SIZE:HEADER_SIZE + body_size])
+    pos = 0
+
+    def get_varint():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            byte = cmds[pos]
+            pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    new = bytearray()
+    old_pos = 0
+    while len(new) < new_size:
+        length = get_varint()
+        new += bytes((old[old_pos + k] + cmds[pos + k]) & 0xFF for k in range(length))
+        pos += length
+        old_pos += length
+        length = get_varint()
+        new += cmds[pos:pos + length]
+        pos += length
+        if len(new) < new_size:
+            seek = get_varint()
+            old_pos += (seek >> 1) if not seek & 1 else -(seek >> 1) - 1
+    assert hashlib.sha256(new).digest() == patch[48:80]
+    return bytes(new)
+
+
+def make_patch(old, new):
+    body = lzss_compress(build_commands(old, new, find_regions(old, new)))
+    header = struct.pack("<4sIII", MAGIC, len(old), len(new), len(body))
+    header += hashlib.sha256(old).digest() + hashlib.sha256(new).digest()
+    assert len(header) == HEADER_SIZE
+    return header + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("old", help="image currently installed on the devices")
+    parser.add_argument("new", help="image to install")
+    parser.add_argument("patch", help="output patch file")
+    parser.add_argument("--frag-size", type=int, default=216, help="fragment size of the FUOTA session")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    patch = make_patch(old, new)
+    if apply_patch(old, patch) != new:
+        sys.exit("patch verification failed")
+
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+
+    frags_full = -(-len(new) // args.frag_size)
+    frags_patch = -(-len(patch) // args.frag_size)
+    print("new image %d bytes, %d fragments" % (len(new), frags_full))
+    print("patch     %d bytes, %d fragments (%.1fx fewer)" % (len(patch), frags_patch, frags_full / frags_patch))
+
+
+if __name__ == "__main__":
+    main()
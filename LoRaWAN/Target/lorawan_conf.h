@@ -54,13 +54,36 @@ extern "C" {
 
 #define HYBRID_ENABLED          0
 
+/*!
+ * Binds the Region API of Region.h directly to the single region enabled above,
+ * instead of switching on the region at each call
+ */
+#ifndef REGION_SINGLE_ENABLED
+#define REGION_SINGLE_ENABLED   1
+#endif /* !REGION_SINGLE_ENABLED */
+
 #define KEY_LOG_ENABLED         1
 
+/*!
+ * Calibrates the RX windows timing from the downlinks received
+ * ( LoRaMacRxCalibration.h ), instead of the fixed SystemMaxRxError
+ */
+#define LORAMAC_RX_CALIBRATION_ENABLED  1
+
+/* Crypto backend of the soft secure element (crypto_backend.h) ------*/
+/* Selected in lorawan_crypto_conf.h, which stm32wlxx_hal_conf.h includes as well */
+#include "lorawan_crypto_conf.h"
+
 /* Class B ------------------------------------*/
 #define LORAMAC_CLASSB_ENABLED  0
 
-#if ( LORAMAC_CLASSB_ENABLED == 1 )
-/* CLASS B LSE crystall calibration*/
+/* LSE crystal calibration ------------------------------------*/
+/*!
+ * Compensates the temperature drift of the LSE crystal with the RTC smooth
+ * calibration ( rtc_temp_comp.h ). Class B then uses the RTC time unchanged.
+ */
+#define RTC_TEMP_COMPENSATION_ENABLED                   1
+
 /**
   * \brief Temperature coefficient of the clock source
   */
@@ -80,7 +103,6 @@ extern "C" {
   * \brief Turnover temperature deviation of the clock source
   */
 #define RTC_TEMP_DEV_TURNOVER                           ( 5.0 )
-#endif /* LORAMAC_CLASSB_ENABLED == 1 */
 
 /* USER CODE BEGIN EC */
 
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    lorawan_crypto_conf.h
+  * @brief   Crypto backend of the soft secure element (crypto_backend.h).
+  *          Kept free of other includes, stm32wlxx_hal_conf.h enables the
+  *          CRYP driver from it.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LORAWAN_CRYPTO_CONF_H__
+#define __LORAWAN_CRYPTO_CONF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Software AES and CMAC (lorawan_aes.c, cmac.c)
+ */
+#define LORAWAN_CRYPTO_BACKEND_SOFT           0
+
+/*!
+ * STM32WL AES peripheral, fed by DMA (crypto_aes_engine_stm32wl.c)
+ */
+#define LORAWAN_CRYPTO_BACKEND_STM32WL_AES    1
+
+/*!
+ * Software model of the AES peripheral (crypto_aes_engine_host.c). Runs the
+ * code of the peripheral backend without hardware, e.g. in a host build.
+ */
+#define LORAWAN_CRYPTO_BACKEND_HOST           2
+
+/*!
+ * Selected backend: LORAWAN_CRYPTO_BACKEND_SOFT, LORAWAN_CRYPTO_BACKEND_STM32WL_AES
+ * or LORAWAN_CRYPTO_BACKEND_HOST
+ */
+#ifndef LORAWAN_CRYPTO_BACKEND
+#define LORAWAN_CRYPTO_BACKEND                LORAWAN_CRYPTO_BACKEND_SOFT
+#endif /* !LORAWAN_CRYPTO_BACKEND */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LORAWAN_CRYPTO_CONF_H__ */
@@ -32,6 +32,7 @@ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 DEALINGS WITH THE SOFTWARE
 
 *****************************************************************************/
+#include <stddef.h>
 #include <stdint.h>
 #include "lorawan_aes.h"
 #include "cmac.h"
@@ -61,11 +62,46 @@ void AES_CMAC_Init( AES_CMAC_CTX* ctx )
     memset1( ctx->X, 0, sizeof ctx->X );
     ctx->M_n = 0;
     memset1( ctx->rijndael.ksch, '\0', 240 );
+    ctx->aes = &ctx->rijndael;
+    ctx->subkeys = NULL;
 }
 
 void AES_CMAC_SetKey( AES_CMAC_CTX* ctx, const uint8_t key[AES_CMAC_KEY_LENGTH] )
 {
     lorawan_aes_set_key( key, AES_CMAC_KEY_LENGTH, &ctx->rijndael );
+    ctx->aes = &ctx->rijndael;
+    ctx->subkeys = NULL;
+}
+
+/*
+ * Uses an already expanded key schedule and, if not NULL, the subkeys
+ * from AES_CMAC_DeriveSubkeys() instead of AES_CMAC_SetKey(). Both must
+ * stay valid until AES_CMAC_Final() returns.
+ */
+void AES_CMAC_SetKeySchedule( AES_CMAC_CTX* ctx, const lorawan_aes_context* aes,
+                              const AES_CMAC_SUBKEYS* subkeys )
+{
+    ctx->aes = aes;
+    ctx->subkeys = subkeys;
+}
+
+void AES_CMAC_DeriveSubkeys( const lorawan_aes_context* aes, AES_CMAC_SUBKEYS* subkeys )
+{
+    uint8_t L[16];
+
+    memset1( L, '\0', 16 );
+    lorawan_aes_encrypt( L, L, aes );
+
+    /* K1 = L << 1, K2 = K1 << 1, each reduced by 0x87 on carry */
+    LSHIFT( L, subkeys->K1 );
+    if( L[0] & 0x80 )
+        subkeys->K1[15] ^= 0x87;
+
+    LSHIFT( subkeys->K1, subkeys->K2 );
+    if( subkeys->K1[0] & 0x80 )
+        subkeys->K2[15] ^= 0x87;
+
+    memset1( L, 0, sizeof L );
 }
 
 void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
@@ -83,7 +119,7 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
         XOR( ctx->M_last, ctx->X );
 
         memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        lorawan_aes_encrypt( in, in, &ctx->rijndael );
+        lorawan_aes_encrypt( in, in, ctx->aes );
         memcpy1( &ctx->X[0], in, 16 );
 
         data += mlen;
@@ -95,7 +131,7 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
         XOR( data, ctx->X );
 
         memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-        lorawan_aes_encrypt( in, in, &ctx->rijndael );
+        lorawan_aes_encrypt( in, in, ctx->aes );
         memcpy1( &ctx->X[0], in, 16 );
 
         data += 16;
@@ -108,47 +144,33 @@ void AES_CMAC_Update( AES_CMAC_CTX* ctx, const uint8_t* data, uint32_t len )
 
 void AES_CMAC_Final( uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX* ctx )
 {
-    uint8_t K[16];
+    AES_CMAC_SUBKEYS subkeys;
+    const AES_CMAC_SUBKEYS *sk = ctx->subkeys;
     uint8_t in[16];
-    /* generate subkey K1 */
-    memset1( K, '\0', 16 );
 
-    lorawan_aes_encrypt( K, K, &ctx->rijndael );
-
-    if( K[0] & 0x80 )
+    if( sk == NULL )
     {
-        LSHIFT( K, K );
-        K[15] ^= 0x87;
+        AES_CMAC_DeriveSubkeys( ctx->aes, &subkeys );
+        sk = &subkeys;
     }
-    else
-        LSHIFT( K, K );
 
     if( ctx->M_n == 16 )
     {
         /* last block was a complete block */
-        XOR( K, ctx->M_last );
+        XOR( sk->K1, ctx->M_last );
     }
     else
     {
-        /* generate subkey K2 */
-        if( K[0] & 0x80 )
-        {
-            LSHIFT( K, K );
-            K[15] ^= 0x87;
-        }
-        else
-            LSHIFT( K, K );
-
         /* padding(M_last) */
         ctx->M_last[ctx->M_n] = 0x80;
         while( ++ctx->M_n < 16 )
             ctx->M_last[ctx->M_n] = 0;
 
-        XOR( K, ctx->M_last );
+        XOR( sk->K2, ctx->M_last );
     }
     XOR( ctx->M_last, ctx->X );
 
     memcpy1( in, &ctx->X[0], 16 );  // Otherwise it does not look good
-    lorawan_aes_encrypt( in, digest, &ctx->rijndael );
-    memset1( K, 0, sizeof K );
+    lorawan_aes_encrypt( in, digest, ctx->aes );
+    memset1( ( uint8_t * ) &subkeys, 0, sizeof subkeys );
 }
@@ -45,8 +45,15 @@ extern "C" {
 #define AES_CMAC_KEY_LENGTH     16
 #define AES_CMAC_DIGEST_LENGTH  16
  
+typedef struct _AES_CMAC_SUBKEYS {
+            uint8_t        K1[16];
+            uint8_t        K2[16];
+    } AES_CMAC_SUBKEYS;
+
 typedef struct _AES_CMAC_CTX {
             lorawan_aes_context    rijndael;
+            const lorawan_aes_context *aes;     /* key schedule in use, rijndael or a pre-keyed one  */
+            const AES_CMAC_SUBKEYS *subkeys;    /* pre-computed subkeys, NULL to derive them in Final */
             uint8_t        X[16];
             uint8_t        M_last[16];
             uint32_t       M_n;
@@ -57,6 +64,9 @@ typedef struct _AES_CMAC_CTX {
 //__BEGIN_DECLS
 void     AES_CMAC_Init(AES_CMAC_CTX * ctx);
 void     AES_CMAC_SetKey(AES_CMAC_CTX * ctx, const uint8_t key[AES_CMAC_KEY_LENGTH]);
+void     AES_CMAC_SetKeySchedule(AES_CMAC_CTX * ctx, const lorawan_aes_context * aes,
+                                 const AES_CMAC_SUBKEYS * subkeys);
+void     AES_CMAC_DeriveSubkeys(const lorawan_aes_context * aes, AES_CMAC_SUBKEYS * subkeys);
 void     AES_CMAC_Update(AES_CMAC_CTX * ctx, const uint8_t * data, uint32_t len);
           //          __attribute__((__bounded__(__string__,2,3)));
 void     AES_CMAC_Final(uint8_t digest[AES_CMAC_DIGEST_LENGTH], AES_CMAC_CTX  * ctx);
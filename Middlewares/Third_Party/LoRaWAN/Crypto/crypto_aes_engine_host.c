@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    crypto_aes_engine_host.c
+  * @brief   Software model of the STM32WL AES peripheral for the AES engine
+  *          backend. Takes key and IV in register word order like the
+  *          peripheral, so the engine backend runs unchanged on a host.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "utilities.h"
+#include "crypto_backend.h"
+
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_HOST)
+
+/* Private functions prototypes ---------------------------------------------------*/
+static void WordsToBlock(const uint32_t *words, uint8_t *block);
+
+/* Exported functions ---------------------------------------------------------*/
+SecureElementStatus_t CryptoAesEngineInit(void)
+{
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoAesEngineEncrypt(const uint32_t *keyWords, const uint32_t *ivWords,
+                                             const uint32_t *input, uint32_t *output, uint16_t blocks)
+{
+  lorawan_aes_context aesContext;
+  uint8_t key[16];
+  uint8_t chain[16] = { 0 };
+
+  if ((keyWords == NULL) || (input == NULL) || (output == NULL))
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+  if (blocks > CRYPTO_ENGINE_BATCH_BLOCKS)
+  {
+    return SECURE_ELEMENT_ERROR_BUF_SIZE;
+  }
+
+  /* The peripheral loads the key for every operation as well */
+  WordsToBlock(keyWords, key);
+  memset1(aesContext.ksch, '\0', 240);
+  lorawan_aes_set_key(key, 16, &aesContext);
+
+  if (ivWords != NULL)
+  {
+    WordsToBlock(ivWords, chain);
+  }
+
+  for (uint16_t b = 0; b < blocks; b++)
+  {
+    uint8_t block[16];
+
+    memcpy1(block, (const uint8_t *) &input[b * 4], 16);
+    if (ivWords != NULL)
+    {
+      for (uint8_t i = 0; i < 16; i++)
+      {
+        block[i] ^= chain[i];
+      }
+    }
+    lorawan_aes_encrypt(block, (uint8_t *) &output[b * 4], &aesContext);
+    memcpy1(chain, (const uint8_t *) &output[b * 4], 16);
+  }
+
+  memset1(key, 0, sizeof(key));
+  memset1((uint8_t *) &aesContext, 0, sizeof(aesContext));
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void WordsToBlock(const uint32_t *words, uint8_t *block)
+{
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    block[4 * i] = (uint8_t)(words[i] >> 24);
+    block[4 * i + 1] = (uint8_t)(words[i] >> 16);
+    block[4 * i + 2] = (uint8_t)(words[i] >> 8);
+    block[4 * i + 3] = (uint8_t) words[i];
+  }
+}
+
+#endif /* LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_HOST */
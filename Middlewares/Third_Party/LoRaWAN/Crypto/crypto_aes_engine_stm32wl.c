@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file    crypto_aes_engine_stm32wl.c
+  * @brief   AES engine of the crypto backend on the STM32WL AES peripheral.
+  *          Blocks are moved by DMA1 channel 1 (AES_IN) and 2 (AES_OUT).
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "lorawan_crypto_conf.h"  /* LORAWAN_CRYPTO_BACKEND */
+
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES)
+#include "stm32wlxx_hal.h" /* before utilities.h, which defines SUCCESS */
+#endif /* LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES */
+#include "crypto_backend.h"
+
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES)
+
+#ifndef HAL_CRYP_MODULE_ENABLED
+#error "LORAWAN_CRYPTO_BACKEND_STM32WL_AES needs HAL_CRYP_MODULE_ENABLED in stm32wlxx_hal_conf.h"
+#endif /* !HAL_CRYP_MODULE_ENABLED */
+
+/* Private constants ---------------------------------------------------------*/
+/*!
+ * Upper limit for one engine operation, a batch takes a few microseconds
+ */
+#define AES_ENGINE_TIMEOUT_MS       10U
+
+/* Private variables ---------------------------------------------------------*/
+static CRYP_HandleTypeDef hcryp;
+static DMA_HandleTypeDef hdma_aes_in;
+static DMA_HandleTypeDef hdma_aes_out;
+
+static volatile bool AesEngineDone = false;
+static volatile bool AesEngineError = false;
+
+/* Exported functions ---------------------------------------------------------*/
+SecureElementStatus_t CryptoAesEngineInit(void)
+{
+  static uint32_t initKey[4] = { 0 };
+
+  hcryp.Instance = AES;
+  hcryp.Init.DataType = CRYP_DATATYPE_8B;
+  hcryp.Init.KeySize = CRYP_KEYSIZE_128B;
+  hcryp.Init.pKey = initKey;
+  hcryp.Init.Algorithm = CRYP_AES_ECB;
+  hcryp.Init.DataWidthUnit = CRYP_DATAWIDTHUNIT_BYTE;
+  hcryp.Init.KeyIVConfigSkip = CRYP_KEYIVCONFIG_ALWAYS;
+
+  if (HAL_CRYP_Init(&hcryp) != HAL_OK)
+  {
+    return SECURE_ELEMENT_ERROR;
+  }
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoAesEngineEncrypt(const uint32_t *keyWords, const uint32_t *ivWords,
+                                             const uint32_t *input, uint32_t *output, uint16_t blocks)
+{
+  CRYP_ConfigTypeDef config;
+
+  if ((keyWords == NULL) || (input == NULL) || (output == NULL))
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+  if (blocks > CRYPTO_ENGINE_BATCH_BLOCKS)
+  {
+    return SECURE_ELEMENT_ERROR_BUF_SIZE;
+  }
+
+  if (HAL_CRYP_GetConfig(&hcryp, &config) != HAL_OK)
+  {
+    return SECURE_ELEMENT_ERROR;
+  }
+  config.pKey = (uint32_t *) keyWords;
+  config.pInitVect = (uint32_t *) ivWords;
+  config.Algorithm = (ivWords != NULL) ? CRYP_AES_CBC : CRYP_AES_ECB;
+  if (HAL_CRYP_SetConfig(&hcryp, &config) != HAL_OK)
+  {
+    return SECURE_ELEMENT_ERROR;
+  }
+
+  AesEngineDone = false;
+  AesEngineError = false;
+
+  if (HAL_CRYP_Encrypt_DMA(&hcryp, (uint32_t *) input, blocks * 16U, output) != HAL_OK)
+  {
+    return SECURE_ELEMENT_ERROR;
+  }
+
+  uint32_t tickstart = HAL_GetTick();
+  while ((AesEngineDone == false) && (AesEngineError == false))
+  {
+    if ((HAL_GetTick() - tickstart) > AES_ENGINE_TIMEOUT_MS)
+    {
+      (void)HAL_CRYP_DeInit(&hcryp);
+      (void)CryptoAesEngineInit();
+      return SECURE_ELEMENT_ERROR;
+    }
+  }
+
+  return (AesEngineError == false) ? SECURE_ELEMENT_SUCCESS : SECURE_ELEMENT_ERROR;
+}
+
+/* HAL callbacks and interrupt handlers of the AES peripheral ---------------*/
+void HAL_CRYP_MspInit(CRYP_HandleTypeDef *hcryp_p)
+{
+  __HAL_RCC_AES_CLK_ENABLE();
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  hdma_aes_in.Instance = DMA1_Channel1;
+  hdma_aes_in.Init.Request = DMA_REQUEST_AES_IN;
+  hdma_aes_in.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_aes_in.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_aes_in.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_aes_in.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_aes_in.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_aes_in.Init.Mode = DMA_NORMAL;
+  hdma_aes_in.Init.Priority = DMA_PRIORITY_HIGH;
+  (void)HAL_DMA_Init(&hdma_aes_in);
+  __HAL_LINKDMA(hcryp_p, hdmain, hdma_aes_in);
+
+  hdma_aes_out.Instance = DMA1_Channel2;
+  hdma_aes_out.Init.Request = DMA_REQUEST_AES_OUT;
+  hdma_aes_out.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_aes_out.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_aes_out.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_aes_out.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_aes_out.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma_aes_out.Init.Mode = DMA_NORMAL;
+  hdma_aes_out.Init.Priority = DMA_PRIORITY_HIGH;
+  (void)HAL_DMA_Init(&hdma_aes_out);
+  __HAL_LINKDMA(hcryp_p, hdmaout, hdma_aes_out);
+
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 2, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 2, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+}
+
+void HAL_CRYP_MspDeInit(CRYP_HandleTypeDef *hcryp_p)
+{
+  HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+  HAL_NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+  (void)HAL_DMA_DeInit(hcryp_p->hdmain);
+  (void)HAL_DMA_DeInit(hcryp_p->hdmaout);
+  __HAL_RCC_AES_CLK_DISABLE();
+}
+
+void HAL_CRYP_OutCpltCallback(CRYP_HandleTypeDef *hcryp_p)
+{
+  UNUSED(hcryp_p);
+  AesEngineDone = true;
+}
+
+void HAL_CRYP_ErrorCallback(CRYP_HandleTypeDef *hcryp_p)
+{
+  UNUSED(hcryp_p);
+  AesEngineError = true;
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_aes_in);
+}
+
+void DMA1_Channel2_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_aes_out);
+}
+
+#endif /* LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_STM32WL_AES */
@@ -0,0 +1,254 @@
+/**
+  ******************************************************************************
+  * @file    crypto_backend.c
+  * @brief   Common part of the AES backends and the AES engine based backend
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "utilities.h"
+#include "crypto_backend.h"
+
+#if (LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT)
+/* Private variables ---------------------------------------------------------*/
+/*
+ * Word aligned blocks handed to the AES engine (DMA source and destination)
+ */
+static uint32_t EngineInput[CRYPTO_ENGINE_BATCH_BLOCKS * 4];
+static uint32_t EngineOutput[CRYPTO_ENGINE_BATCH_BLOCKS * 4];
+
+/* Private functions prototypes ---------------------------------------------------*/
+static void BlockToWords(const uint8_t *block, uint32_t *words);
+static SecureElementStatus_t DeriveSubkeys(CryptoKey_t *cryptoKey);
+#endif /* LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT */
+
+/* Exported functions ---------------------------------------------------------*/
+void CryptoXorKeystream(uint8_t *buffer, const uint32_t *keystream, uint16_t size)
+{
+  const uint8_t *keystreamBytes = (const uint8_t *) keystream;
+  uint16_t i = 0;
+
+  if (((uintptr_t) buffer & 3UL) == 0)
+  {
+    uint32_t *bufferWords = (uint32_t *) buffer;
+    for (; (i + 4U) <= size; i += 4U)
+    {
+      *bufferWords++ ^= keystream[i / 4U];
+    }
+  }
+
+  for (; i < size; i++)
+  {
+    buffer[i] ^= keystreamBytes[i];
+  }
+}
+
+#if (LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT)
+SecureElementStatus_t CryptoBackendInit(void)
+{
+  return CryptoAesEngineInit();
+}
+
+SecureElementStatus_t CryptoBackendSetKey(const uint8_t *key, CryptoKey_t *cryptoKey)
+{
+  if ((key == NULL) || (cryptoKey == NULL))
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+
+  BlockToWords(key, cryptoKey->KeyWords);
+  cryptoKey->SubkeysValid = false;
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoBackendEcbEncrypt(CryptoKey_t *cryptoKey, const uint8_t *input, uint16_t size,
+                                              uint8_t *output)
+{
+  SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+
+  while ((retval == SECURE_ELEMENT_SUCCESS) && (size != 0))
+  {
+    uint16_t batchSize = MIN(size, (uint16_t)(CRYPTO_ENGINE_BATCH_BLOCKS * 16));
+
+    memcpy1((uint8_t *) EngineInput, input, batchSize);
+    retval = CryptoAesEngineEncrypt(cryptoKey->KeyWords, NULL, EngineInput, EngineOutput, batchSize / 16);
+    memcpy1(output, (uint8_t *) EngineOutput, batchSize);
+
+    input += batchSize;
+    output += batchSize;
+    size -= batchSize;
+  }
+
+  memset1((uint8_t *) EngineOutput, 0, sizeof(EngineOutput));
+
+  return retval;
+}
+
+SecureElementStatus_t CryptoBackendCtrCrypt(CryptoKey_t *cryptoKey, const uint8_t *aBlock, uint8_t *buffer,
+                                            uint16_t size)
+{
+  SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+  uint8_t ctrBlock[16];
+
+  memcpy1(ctrBlock, aBlock, 16);
+
+  /* The counter blocks of a batch go to the engine in one transfer */
+  while ((retval == SECURE_ELEMENT_SUCCESS) && (size != 0))
+  {
+    uint16_t batchSize = MIN(size, (uint16_t)(CRYPTO_ENGINE_BATCH_BLOCKS * 16));
+    uint16_t blocks = (batchSize + 15) / 16;
+
+    for (uint16_t i = 0; i < blocks; i++)
+    {
+      memcpy1((uint8_t *) &EngineInput[i * 4], ctrBlock, 16);
+      ctrBlock[15]++;
+    }
+
+    retval = CryptoAesEngineEncrypt(cryptoKey->KeyWords, NULL, EngineInput, EngineOutput, blocks);
+    if (retval == SECURE_ELEMENT_SUCCESS)
+    {
+      CryptoXorKeystream(buffer, EngineOutput, batchSize);
+    }
+
+    buffer += batchSize;
+    size -= batchSize;
+  }
+
+  memset1((uint8_t *) EngineOutput, 0, sizeof(EngineOutput));
+
+  return retval;
+}
+
+SecureElementStatus_t CryptoBackendCmac(CryptoKey_t *cryptoKey, const uint8_t *micBxBuffer, const uint8_t *buffer,
+                                        uint16_t size, uint8_t *cmac)
+{
+  SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+  uint16_t prefixSize = (micBxBuffer != NULL) ? 16 : 0;
+  uint32_t totalSize = (uint32_t) prefixSize + size;
+  uint32_t lastBlock = (totalSize == 0) ? 0 : ((totalSize - 1) / 16);
+  uint32_t ivWords[4] = { 0 };
+  uint32_t block = 0;
+
+  if (cryptoKey->SubkeysValid == false)
+  {
+    retval = DeriveSubkeys(cryptoKey);
+  }
+
+  /* CBC-MAC over the message with the last block padded and XORed with K1 or K2 */
+  while ((retval == SECURE_ELEMENT_SUCCESS) && (block <= lastBlock))
+  {
+    uint8_t *engineBytes = (uint8_t *) EngineInput;
+    uint16_t blocks = 0;
+
+    while ((blocks < CRYPTO_ENGINE_BATCH_BLOCKS) && (block <= lastBlock))
+    {
+      const uint8_t *subkey = cryptoKey->CmacSubkeys.K2;
+
+      for (uint8_t i = 0; i < 16; i++)
+      {
+        uint32_t pos = (block * 16) + i;
+
+        if (pos < prefixSize)
+        {
+          engineBytes[i] = micBxBuffer[pos];
+        }
+        else if (pos < totalSize)
+        {
+          engineBytes[i] = buffer[pos - prefixSize];
+        }
+        else
+        {
+          engineBytes[i] = (pos == totalSize) ? 0x80 : 0x00;
+        }
+      }
+
+      if (block == lastBlock)
+      {
+        if ((totalSize != 0) && ((totalSize % 16) == 0))
+        {
+          subkey = cryptoKey->CmacSubkeys.K1;
+        }
+        for (uint8_t i = 0; i < 16; i++)
+        {
+          engineBytes[i] ^= subkey[i];
+        }
+      }
+
+      engineBytes += 16;
+      blocks++;
+      block++;
+    }
+
+    retval = CryptoAesEngineEncrypt(cryptoKey->KeyWords, ivWords, EngineInput, EngineOutput, blocks);
+    if (retval != SECURE_ELEMENT_SUCCESS)
+    {
+      /* Nothing is chained or written from a failed batch */
+      break;
+    }
+
+    /* The last cipher block chains into the next batch */
+    BlockToWords((const uint8_t *) &EngineOutput[(blocks - 1) * 4], ivWords);
+    if (block > lastBlock)
+    {
+      memcpy1(cmac, (const uint8_t *) &EngineOutput[(blocks - 1) * 4], 16);
+    }
+  }
+
+  memset1((uint8_t *) EngineInput, 0, sizeof(EngineInput));
+  memset1((uint8_t *) EngineOutput, 0, sizeof(EngineOutput));
+
+  return retval;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/*
+ * Converts a 16-byte block into the word order of the key and IV registers
+ * (first byte is the most significant byte of the first word)
+ */
+static void BlockToWords(const uint8_t *block, uint32_t *words)
+{
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    words[i] = ((uint32_t) block[4 * i] << 24) | ((uint32_t) block[4 * i + 1] << 16) |
+               ((uint32_t) block[4 * i + 2] << 8) | (uint32_t) block[4 * i + 3];
+  }
+}
+
+/*
+ * Derives the CMAC subkeys K1 and K2 (RFC 4493) with the engine
+ */
+static SecureElementStatus_t DeriveSubkeys(CryptoKey_t *cryptoKey)
+{
+  const uint8_t *L = (const uint8_t *) EngineOutput;
+  uint8_t *K1 = cryptoKey->CmacSubkeys.K1;
+  uint8_t *K2 = cryptoKey->CmacSubkeys.K2;
+  SecureElementStatus_t retval;
+
+  memset1((uint8_t *) EngineInput, 0, 16);
+  retval = CryptoAesEngineEncrypt(cryptoKey->KeyWords, NULL, EngineInput, EngineOutput, 1);
+  if (retval != SECURE_ELEMENT_SUCCESS)
+  {
+    memset1((uint8_t *) EngineOutput, 0, 16);
+    return retval;
+  }
+
+  for (uint8_t i = 0; i < 15; i++)
+  {
+    K1[i] = (uint8_t)(L[i] << 1) | (L[i + 1] >> 7);
+  }
+  K1[15] = (uint8_t)(L[15] << 1) ^ (((L[0] & 0x80) != 0) ? 0x87 : 0x00);
+
+  for (uint8_t i = 0; i < 15; i++)
+  {
+    K2[i] = (uint8_t)(K1[i] << 1) | (K1[i + 1] >> 7);
+  }
+  K2[15] = (uint8_t)(K1[15] << 1) ^ (((K1[0] & 0x80) != 0) ? 0x87 : 0x00);
+
+  memset1((uint8_t *) EngineOutput, 0, 16);
+  cryptoKey->SubkeysValid = true;
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+#endif /* LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT */
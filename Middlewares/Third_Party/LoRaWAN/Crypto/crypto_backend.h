@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    crypto_backend.h
+  * @brief   AES backends of the soft secure element (ECB, CTR and CMAC)
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CRYPTO_BACKEND_H__
+#define __CRYPTO_BACKEND_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "lorawan_crypto_conf.h"  /* LORAWAN_CRYPTO_BACKEND */
+#include "secure-element.h"
+#include "cmac.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Largest number of blocks handed to the AES engine at once
+ */
+#define CRYPTO_ENGINE_BATCH_BLOCKS            8U
+
+/* Exported types ------------------------------------------------------------*/
+/*!
+ * Key prepared for the selected backend
+ */
+typedef struct sCryptoKey
+{
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_SOFT)
+  /*!
+   * Expanded AES key schedule
+   */
+  lorawan_aes_context AesContext;
+#else /* AES engine */
+  /*!
+   * Key in the word order of the AES peripheral key registers
+   */
+  uint32_t KeyWords[4];
+#endif /* LORAWAN_CRYPTO_BACKEND */
+  /*!
+   * CMAC subkeys K1 and K2, derived on the first CMAC
+   */
+  AES_CMAC_SUBKEYS CmacSubkeys;
+  bool SubkeysValid;
+} CryptoKey_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+/*!
+ * Initializes the selected backend
+ *
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoBackendInit(void);
+
+/*!
+ * Prepares a key for the other backend functions
+ *
+ * \param[IN]  key            - AES-128 key
+ * \param[OUT] cryptoKey      - Prepared key
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoBackendSetKey(const uint8_t *key, CryptoKey_t *cryptoKey);
+
+/*!
+ * Encrypts whole blocks in AES-ECB mode
+ *
+ * \param[IN]  cryptoKey      - Prepared key
+ * \param[IN]  input          - Input buffer
+ * \param[IN]  size           - Size, multiple of 16
+ * \param[OUT] output         - Output buffer, may be the input buffer
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoBackendEcbEncrypt(CryptoKey_t *cryptoKey, const uint8_t *input, uint16_t size,
+                                              uint8_t *output);
+
+/*!
+ * Encrypts or decrypts in place in AES-CTR mode, see SecureElementAesCtrCrypt()
+ *
+ * \param[IN]  cryptoKey      - Prepared key
+ * \param[IN]  aBlock         - First counter block
+ * \param[IN/OUT] buffer      - Data buffer
+ * \param[IN]  size           - Size, any length
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoBackendCtrCrypt(CryptoKey_t *cryptoKey, const uint8_t *aBlock, uint8_t *buffer,
+                                            uint16_t size);
+
+/*!
+ * Computes the AES-CMAC of [micBxBuffer |] buffer
+ *
+ * \param[IN]  cryptoKey      - Prepared key, the CMAC subkeys are cached in it
+ * \param[IN]  micBxBuffer    - Optional first block ( 16 byte ), NULL if not used
+ * \param[IN]  buffer         - Data buffer
+ * \param[IN]  size           - Data buffer size
+ * \param[OUT] cmac           - Computed CMAC ( 16 byte )
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoBackendCmac(CryptoKey_t *cryptoKey, const uint8_t *micBxBuffer, const uint8_t *buffer,
+                                        uint16_t size, uint8_t *cmac);
+
+/*!
+ * XORs a keystream onto a buffer, a word at a time when the buffer allows it
+ *
+ * \param[IN/OUT] buffer      - Data buffer
+ * \param[IN]  keystream      - Keystream, word aligned
+ * \param[IN]  size           - Number of bytes to process
+ */
+void CryptoXorKeystream(uint8_t *buffer, const uint32_t *keystream, uint16_t size);
+
+#if (LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT)
+/*!
+ * AES engine of the peripheral backends: initialization
+ *
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoAesEngineInit(void);
+
+/*!
+ * AES engine of the peripheral backends: encrypts whole blocks in ECB mode,
+ * or in CBC mode if an initialization vector is given
+ *
+ * \param[IN]  keyWords       - Key in key register word order
+ * \param[IN]  ivWords        - Initialization vector in IV register word order, NULL for ECB
+ * \param[IN]  input          - Input blocks, word aligned
+ * \param[OUT] output         - Output blocks, word aligned, not overlapping the input
+ * \param[IN]  blocks         - Number of blocks, at most CRYPTO_ENGINE_BATCH_BLOCKS
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoAesEngineEncrypt(const uint32_t *keyWords, const uint32_t *ivWords,
+                                             const uint32_t *input, uint32_t *output, uint16_t blocks);
+#endif /* LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_BACKEND_H__ */
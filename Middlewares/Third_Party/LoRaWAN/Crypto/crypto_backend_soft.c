@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    crypto_backend_soft.c
+  * @brief   Software AES backend of the soft secure element
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "utilities.h"
+#include "crypto_backend.h"
+
+#if (LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_SOFT)
+
+/* Private constants ---------------------------------------------------------*/
+/*!
+ * Number of AES-CTR keystream blocks generated before they are applied
+ */
+#define CTR_BATCH_BLOCKS     4U
+
+/* Exported functions ---------------------------------------------------------*/
+SecureElementStatus_t CryptoBackendInit(void)
+{
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoBackendSetKey(const uint8_t *key, CryptoKey_t *cryptoKey)
+{
+  if ((key == NULL) || (cryptoKey == NULL))
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+
+  memset1(cryptoKey->AesContext.ksch, '\0', 240);
+  lorawan_aes_set_key(key, 16, &cryptoKey->AesContext);
+  cryptoKey->SubkeysValid = false;
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoBackendEcbEncrypt(CryptoKey_t *cryptoKey, const uint8_t *input, uint16_t size,
+                                              uint8_t *output)
+{
+  for (uint16_t offset = 0; offset < size; offset += 16)
+  {
+    lorawan_aes_encrypt(&input[offset], &output[offset], &cryptoKey->AesContext);
+  }
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoBackendCtrCrypt(CryptoKey_t *cryptoKey, const uint8_t *aBlock, uint8_t *buffer,
+                                            uint16_t size)
+{
+  uint32_t keystream[CTR_BATCH_BLOCKS * 4];
+  uint8_t ctrBlock[16];
+
+  memcpy1(ctrBlock, aBlock, 16);
+
+  while (size != 0)
+  {
+    uint16_t batchSize = MIN(size, (uint16_t)(CTR_BATCH_BLOCKS * 16));
+
+    for (uint16_t offset = 0; offset < batchSize; offset += 16)
+    {
+      lorawan_aes_encrypt(ctrBlock, (uint8_t *) &keystream[offset / 4], &cryptoKey->AesContext);
+      ctrBlock[15]++;
+    }
+
+    CryptoXorKeystream(buffer, keystream, batchSize);
+    buffer += batchSize;
+    size -= batchSize;
+  }
+
+  memset1((uint8_t *) keystream, 0, sizeof(keystream));
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+SecureElementStatus_t CryptoBackendCmac(CryptoKey_t *cryptoKey, const uint8_t *micBxBuffer, const uint8_t *buffer,
+                                        uint16_t size, uint8_t *cmac)
+{
+  AES_CMAC_CTX aesCmacCtx[1];
+
+  if (cryptoKey->SubkeysValid == false)
+  {
+    AES_CMAC_DeriveSubkeys(&cryptoKey->AesContext, &cryptoKey->CmacSubkeys);
+    cryptoKey->SubkeysValid = true;
+  }
+
+  AES_CMAC_Init(aesCmacCtx);
+  AES_CMAC_SetKeySchedule(aesCmacCtx, &cryptoKey->AesContext, &cryptoKey->CmacSubkeys);
+
+  if (micBxBuffer != NULL)
+  {
+    AES_CMAC_Update(aesCmacCtx, micBxBuffer, 16);
+  }
+
+  AES_CMAC_Update(aesCmacCtx, buffer, size);
+
+  AES_CMAC_Final(cmac, aesCmacCtx);
+
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+#endif /* LORAWAN_CRYPTO_BACKEND == LORAWAN_CRYPTO_BACKEND_SOFT */
@@ -0,0 +1,182 @@
+/**
+  ******************************************************************************
+  * @file    crypto_drbg.c
+  * @brief   AES-128 CTR_DRBG ( NIST SP 800-90A, without derivation function ).
+  *          The block cipher is the crypto backend selected for the soft
+  *          secure element.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "utilities.h"
+#include "crypto_backend.h"
+#include "crypto_drbg.h"
+
+/* Private constants ---------------------------------------------------------*/
+#define DRBG_BLOCK_SIZE                       16U
+
+/* Private Types ---------------------------------------------------------*/
+/*
+ * Working state of the generator
+ */
+typedef struct sCryptoDrbgCtx
+{
+  /*
+   * Key, prepared for the crypto backend
+   */
+  CryptoKey_t Key;
+  /*
+   * Counter block
+   */
+  uint8_t V[DRBG_BLOCK_SIZE];
+  /*
+   * Generate requests since the last ( re )seed
+   */
+  uint32_t ReseedCounter;
+  /*
+   * Set once instantiated
+   */
+  bool Seeded;
+} CryptoDrbgCtx_t;
+
+/* Private variables ---------------------------------------------------------*/
+static CryptoDrbgCtx_t DrbgCtx;
+
+/* Private functions prototypes ---------------------------------------------------*/
+static void IncrementCounter(uint8_t *v);
+static SecureElementStatus_t DrbgUpdate(const uint8_t *providedData);
+
+/* Private functions ---------------------------------------------------------*/
+/*
+ * Increments the 128 bit big endian counter block
+ */
+static void IncrementCounter(uint8_t *v)
+{
+  for (int8_t i = DRBG_BLOCK_SIZE - 1; i >= 0; i--)
+  {
+    if (++v[i] != 0)
+    {
+      break;
+    }
+  }
+}
+
+/*
+ * CTR_DRBG_Update: ( Key, V ) = E( Key, V + 1 ) | E( Key, V + 2 ) xor providedData
+ */
+static SecureElementStatus_t DrbgUpdate(const uint8_t *providedData)
+{
+  uint8_t temp[CRYPTO_DRBG_SEED_SIZE];
+  SecureElementStatus_t retval;
+
+  IncrementCounter(DrbgCtx.V);
+  memcpy1(temp, DrbgCtx.V, DRBG_BLOCK_SIZE);
+  IncrementCounter(DrbgCtx.V);
+  memcpy1(temp + DRBG_BLOCK_SIZE, DrbgCtx.V, DRBG_BLOCK_SIZE);
+
+  retval = CryptoBackendEcbEncrypt(&DrbgCtx.Key, temp, CRYPTO_DRBG_SEED_SIZE, temp);
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
+    if (providedData != NULL)
+    {
+      for (uint8_t i = 0; i < CRYPTO_DRBG_SEED_SIZE; i++)
+      {
+        temp[i] ^= providedData[i];
+      }
+    }
+    retval = CryptoBackendSetKey(temp, &DrbgCtx.Key);
+    memcpy1(DrbgCtx.V, temp + DRBG_BLOCK_SIZE, DRBG_BLOCK_SIZE);
+  }
+
+  memset1(temp, 0, sizeof(temp));
+  return retval;
+}
+
+/* Exported functions ---------------------------------------------------------*/
+SecureElementStatus_t CryptoDrbgSeed(const uint8_t *input, uint16_t size)
+{
+  uint8_t seedMaterial[CRYPTO_DRBG_SEED_SIZE];
+  SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+  uint16_t chunk;
+
+  if (input == NULL)
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+
+  if (DrbgCtx.Seeded == false)
+  {
+    /* Instantiate: Key = 0, V = 0 */
+    memset1(seedMaterial, 0, DRBG_BLOCK_SIZE);
+    retval = CryptoBackendSetKey(seedMaterial, &DrbgCtx.Key);
+    memset1(DrbgCtx.V, 0, DRBG_BLOCK_SIZE);
+  }
+
+  while ((retval == SECURE_ELEMENT_SUCCESS) && (size > 0))
+  {
+    chunk = (size < CRYPTO_DRBG_SEED_SIZE) ? size : CRYPTO_DRBG_SEED_SIZE;
+    memset1(seedMaterial, 0, CRYPTO_DRBG_SEED_SIZE);
+    memcpy1(seedMaterial, input, chunk);
+    retval = DrbgUpdate(seedMaterial);
+    input += chunk;
+    size -= chunk;
+  }
+  memset1(seedMaterial, 0, sizeof(seedMaterial));
+
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
+    DrbgCtx.ReseedCounter = 0;
+    DrbgCtx.Seeded = true;
+  }
+  else
+  {
+    DrbgCtx.Seeded = false;
+  }
+  return retval;
+}
+
+SecureElementStatus_t CryptoDrbgGenerate(uint8_t *output, uint16_t size)
+{
+  uint8_t block[DRBG_BLOCK_SIZE];
+  SecureElementStatus_t retval = SECURE_ELEMENT_SUCCESS;
+  uint16_t chunk;
+
+  if (output == NULL)
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+  if (DrbgCtx.Seeded == false)
+  {
+    return SECURE_ELEMENT_ERROR;
+  }
+
+  while ((retval == SECURE_ELEMENT_SUCCESS) && (size > 0))
+  {
+    IncrementCounter(DrbgCtx.V);
+    retval = CryptoBackendEcbEncrypt(&DrbgCtx.Key, DrbgCtx.V, DRBG_BLOCK_SIZE, block);
+    chunk = (size < DRBG_BLOCK_SIZE) ? size : DRBG_BLOCK_SIZE;
+    memcpy1(output, block, chunk);
+    output += chunk;
+    size -= chunk;
+  }
+  memset1(block, 0, sizeof(block));
+
+  /* Backtracking resistance: the state in use no longer gives the output */
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
+    retval = DrbgUpdate(NULL);
+  }
+  if (retval != SECURE_ELEMENT_SUCCESS)
+  {
+    DrbgCtx.Seeded = false;
+    return retval;
+  }
+  DrbgCtx.ReseedCounter++;
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+bool CryptoDrbgNeedsSeed(void)
+{
+  return (DrbgCtx.Seeded == false) || (DrbgCtx.ReseedCounter >= CRYPTO_DRBG_RESEED_INTERVAL);
+}
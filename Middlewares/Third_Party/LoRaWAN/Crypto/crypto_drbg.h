@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    crypto_drbg.h
+  * @brief   AES-128 CTR_DRBG ( NIST SP 800-90A, without derivation function )
+  *          feeding the random numbers of the soft secure element
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CRYPTO_DRBG_H__
+#define __CRYPTO_DRBG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+#include "secure-element.h"
+
+/* Exported constants --------------------------------------------------------*/
+/*!
+ * Seed length of the AES-128 CTR_DRBG: key ( 16 ) and counter block ( 16 )
+ */
+#define CRYPTO_DRBG_SEED_SIZE                 32U
+
+/*!
+ * Number of generate requests after which the generator asks for a reseed
+ */
+#ifndef CRYPTO_DRBG_RESEED_INTERVAL
+#define CRYPTO_DRBG_RESEED_INTERVAL           0x10000UL
+#endif /* !CRYPTO_DRBG_RESEED_INTERVAL */
+
+/* Exported functions prototypes ---------------------------------------------*/
+/*!
+ * Instantiates the generator on the first call, reseeds it on the next ones.
+ * The input is absorbed CRYPTO_DRBG_SEED_SIZE bytes at a time, the last chunk
+ * is zero padded.
+ * \param[IN]  input          - Entropy input and personalization data
+ * \param[IN]  size           - Input size
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t CryptoDrbgSeed(const uint8_t *input, uint16_t size);
+
+/*!
+ * Generates random bytes
+ * \param[OUT] output         - Output buffer
+ * \param[IN]  size           - Number of bytes to generate
+ * \retval                    - Status of the operation, SECURE_ELEMENT_ERROR
+ *                              if the generator was never seeded
+ */
+SecureElementStatus_t CryptoDrbgGenerate(uint8_t *output, uint16_t size);
+
+/*!
+ * Tells whether the generator must be ( re )seeded before the next generate
+ * \retval                    - True if never seeded or after
+ *                              CRYPTO_DRBG_RESEED_INTERVAL generate requests
+ */
+bool CryptoDrbgNeedsSeed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_DRBG_H__ */
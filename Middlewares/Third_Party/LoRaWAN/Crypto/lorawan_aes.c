@@ -46,7 +46,9 @@
 #include <stdint.h>
 
 /* define if you have fast 32-bit types on your system */
-#if ( __CORTEX_M != 0 ) // if Cortex is different from M0/M0+
+/* __CORTEX_M is only known with the CMSIS device header, the compiler defines the architecture */
+#if !defined( HAVE_UINT_32T ) && ( defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ ) \
+ || defined( __ARM_ARCH_8M_MAIN__ ) || ( defined( __CORTEX_M ) && ( __CORTEX_M != 0 ) ) ) // if Cortex is different from M0/M0+
 #  define HAVE_UINT_32T
 #endif
 
@@ -64,6 +66,21 @@
 
 #include "lorawan_aes.h"
 
+/* the T-table rounds need the tables and 32-bit types */
+#if defined( AES_ENC_TTABLE ) && defined( AES_ENC_PREKEYED ) && defined( HAVE_UINT_32T ) && defined( USE_TABLES )
+#  define USE_ENC_TTABLE
+#endif
+
+/* the byte oriented encryption rounds are still needed for 'on the fly' keying */
+#if !defined( USE_ENC_TTABLE ) || defined( AES_ENC_128_OTFK ) || defined( AES_ENC_256_OTFK )
+#  define USE_BYTE_ENC_ROUNDS
+#endif
+
+#if defined( USE_BYTE_ENC_ROUNDS ) || defined( AES_DEC_PREKEYED ) \
+ || defined( AES_DEC_128_OTFK ) || defined( AES_DEC_256_OTFK )
+#  define USE_BYTE_ROUND_KEYS
+#endif
+
 //#if defined( HAVE_UINT_32T )
 //  typedef unsigned long uint32_t;
 //#endif
@@ -197,8 +214,20 @@ static const uint8_t sbox[256]  =  sb_data(f1);
 static const uint8_t isbox[256] = isb_data(f1);
 #endif
 
+#if defined( USE_BYTE_ENC_ROUNDS )
 static const uint8_t gfm2_sbox[256] = sb_data(f2);
 static const uint8_t gfm3_sbox[256] = sb_data(f3);
+#endif
+
+#if defined( USE_ENC_TTABLE )
+
+/* One column of MixColumns(SubBytes(x)) for x in row 0, stored little     */
+/* endian (row 0 in the low byte). The other rows are byte rotations of it */
+#define t_col(x) ( (uint32_t)f2(x) | ((uint32_t)(x) << 8) \
+                 | ((uint32_t)(x) << 16) | ((uint32_t)f3(x) << 24) )
+
+static const uint32_t t_enc[256] = sb_data(t_col);
+#endif
 
 #if defined( AES_DEC_PREKEYED )
 static const uint8_t gfmul_9[256] = mm_data(f9);
@@ -373,6 +402,8 @@ static void xor_block( void *d, const void *s )
 #endif
 }
 
+#if defined( USE_BYTE_ROUND_KEYS )
+
 static void copy_and_key( void *d, const void *s, const void *k )
 {
 #if defined( HAVE_UINT_32T )
@@ -408,6 +439,10 @@ static void add_round_key( uint8_t d[N_BLOCK], const uint8_t k[N_BLOCK] )
     xor_block(d, k);
 }
 
+#endif
+
+#if defined( USE_BYTE_ENC_ROUNDS )
+
 static void shift_sub_rows( uint8_t st[N_BLOCK] )
 {   uint8_t tt;
 
@@ -424,6 +459,8 @@ static void shift_sub_rows( uint8_t st[N_BLOCK] )
     st[ 7] = s_box(st[ 3]); st[ 3] = s_box( tt );
 }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
@@ -444,6 +481,8 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
 
 #endif
 
+#if defined( USE_BYTE_ENC_ROUNDS )
+
 #if defined( VERSION_1 )
   static void mix_sub_columns( uint8_t dt[N_BLOCK] )
   { uint8_t st[N_BLOCK];
@@ -473,6 +512,8 @@ static void inv_shift_sub_rows( uint8_t st[N_BLOCK] )
     dt[15] = gfm3_sb(st[12]) ^ s_box(st[1]) ^ s_box(st[6]) ^ gfm2_sb(st[11]);
   }
 
+#endif
+
 #if defined( AES_DEC_PREKEYED )
 
 #if defined( VERSION_1 )
@@ -565,6 +606,72 @@ return_type lorawan_aes_set_key( const uint8_t key[], length_type keylen, lorawa
 
 /*  Encrypt a single block of 16 bytes */
 
+#if defined( USE_ENC_TTABLE )
+
+/*  Byte order independent 32-bit load and store, the compiler turns them  */
+/*  into single word accesses where the target allows unaligned accesses   */
+
+#define load_le32(p)    ( (uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) \
+                        | ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24) )
+
+static void store_le32( uint8_t *p, uint32_t v )
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+#define rotl32(v, n)    ( ((v) << (n)) | ((v) >> (32 - (n))) )
+
+/* SubBytes, ShiftRows and MixColumns for the output column c */
+#define t_round(s0, s1, s2, s3) ( t_enc[(s0) & 0xff] \
+                                ^ rotl32(t_enc[((s1) >> 8) & 0xff], 8) \
+                                ^ rotl32(t_enc[((s2) >> 16) & 0xff], 16) \
+                                ^ rotl32(t_enc[(s3) >> 24], 24) )
+
+/* SubBytes and ShiftRows only, for the last round */
+#define t_last(s0, s1, s2, s3)  ( (uint32_t)s_box((s0) & 0xff) \
+                                | ((uint32_t)s_box(((s1) >> 8) & 0xff) << 8) \
+                                | ((uint32_t)s_box(((s2) >> 16) & 0xff) << 16) \
+                                | ((uint32_t)s_box((s3) >> 24) << 24) )
+
+/*  Encrypt a single block of 16 bytes, one state column per 32-bit word */
+
+return_type lorawan_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const lorawan_aes_context ctx[1] )
+{
+    const uint8_t *k = ctx->ksch;
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t r;
+
+    if( ctx->rnd == 0 )
+        return ( uint8_t )-1;
+
+    s0 = load_le32(in     ) ^ load_le32(k     );
+    s1 = load_le32(in +  4) ^ load_le32(k +  4);
+    s2 = load_le32(in +  8) ^ load_le32(k +  8);
+    s3 = load_le32(in + 12) ^ load_le32(k + 12);
+
+    for( r = 1 ; r < ctx->rnd ; ++r )
+    {
+        k += N_BLOCK;
+        t0 = t_round(s0, s1, s2, s3) ^ load_le32(k     );
+        t1 = t_round(s1, s2, s3, s0) ^ load_le32(k +  4);
+        t2 = t_round(s2, s3, s0, s1) ^ load_le32(k +  8);
+        t3 = t_round(s3, s0, s1, s2) ^ load_le32(k + 12);
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+
+    k += N_BLOCK;
+    store_le32(out     , t_last(s0, s1, s2, s3) ^ load_le32(k     ));
+    store_le32(out +  4, t_last(s1, s2, s3, s0) ^ load_le32(k +  4));
+    store_le32(out +  8, t_last(s2, s3, s0, s1) ^ load_le32(k +  8));
+    store_le32(out + 12, t_last(s3, s0, s1, s2) ^ load_le32(k + 12));
+    return 0;
+}
+
+#else
+
 return_type lorawan_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const lorawan_aes_context ctx[1] )
 {
     if( ctx->rnd )
@@ -592,6 +699,8 @@ return_type lorawan_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK
     return 0;
 }
 
+#endif
+
 /* CBC encrypt a number of blocks (input and return an IV) */
 
 return_type lorawan_aes_cbc_encrypt( const uint8_t *in, uint8_t *out,
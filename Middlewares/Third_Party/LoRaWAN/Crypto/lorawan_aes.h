@@ -43,6 +43,11 @@ extern "C" {
 #if 0
 #  define AES_DEC_PREKEYED  /* AES decryption with a precomputed key schedule  */
 #endif
+#if !defined( AES_ENC_BYTE_ROUNDS )
+#  define AES_ENC_TTABLE    /* Pre-keyed AES encryption on 32-bit columns with  */
+#endif                      /* one 1 KB T-table (needs 32-bit types), otherwise */
+                            /* the 8-bit byte oriented rounds are used, also    */
+                            /* forced with -DAES_ENC_BYTE_ROUNDS                */
 #if 0
 #  define AES_ENC_128_OTFK  /* AES encryption with 'on the fly' 128 bit keying */
 #endif
@@ -51,14 +51,13 @@
 #include "LoRaMacHeaderTypes.h"
 #include "secure-element.h"
 #include "se-identity.h"
+#include "crypto_backend.h"
+#include "crypto_drbg.h"
 
-#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
-#include "lorawan_aes.h"
-#include "cmac.h"
-#else /* LORAWAN_KMS == 1 */
+#if (defined (LORAWAN_KMS) && (LORAWAN_KMS == 1))
 #include "mw_log_conf.h"   /* needed for MW_LOG */
 #include "kms_if.h"
-#endif /* LORAWAN_KMS */
+#endif /* LORAWAN_KMS == 1 */
 
 /* Private constants ---------------------------------------------------------*/
 /*!
@@ -87,9 +86,25 @@
                                         + LORAMAC_JOIN_EUI_FIELD_SIZE + DEV_NONCE_SIZE + LORAMAC_MHDR_FIELD_SIZE )
 
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+/*!
+ * Number of keys kept with expanded AES key schedule and CMAC subkeys
+ * (per uplink/downlink NwkSKey and AppSKey, NwkKey/AppKey for the join)
+ */
+#define KEY_CACHE_SIZE       4UL
+
+/*!
+ * Radio random words taken when the random generator is seeded, at boot and
+ * every CRYPTO_DRBG_RESEED_INTERVAL draws
+ */
+#define RANDOM_SEED_RADIO_WORDS      8UL
+
+#if (SE_RANDOM_SEED_SIZE != CRYPTO_DRBG_SEED_SIZE)
+#error "The saved random seed is one seed of the random generator"
+#endif /* SE_RANDOM_SEED_SIZE */
 #else /* LORAWAN_KMS == 1 */
 #define DERIVED_OBJECT_HANDLE_RESET_VAL      0x0UL
 #define PAYLOAD_MAX_SIZE     270UL  /* 270 PHYPayload: 1+(22+1+242)+4 */
+#define CTR_BATCH_BLOCKS     ( PAYLOAD_MAX_SIZE / 16UL )  /* keystream blocks per KMS call */
 #endif /* LORAWAN_KMS */
 
 /* Private macro -------------------------------------------------------------*/
@@ -133,6 +148,31 @@ typedef struct sKey
 #endif /* LORAWAN_KMS */
 } Key_t;
 
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+/*!
+ * Expanded key material of one key, derived from the key list on first use
+ */
+typedef struct sKeyCache
+{
+  /*
+   * Entry holds the key material of KeyID
+   */
+  bool Valid;
+  /*
+   * Key identifier
+   */
+  KeyIdentifier_t KeyID;
+  /*
+   * Last use, for the replacement of the least recently used entry
+   */
+  uint32_t LastUse;
+  /*
+   * Key prepared for the crypto backend
+   */
+  CryptoKey_t CryptoKey;
+} KeyCache_t;
+#endif /* LORAWAN_KMS == 0 */
+
 /*
  * Secure Element Non Volatile Context structure
  */
@@ -150,6 +190,13 @@ typedef struct sSecureElementNvCtx
    * Key List
    */
   Key_t KeyList[NUM_OF_KEYS];
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+  /*
+   * Seed for the random generator at the next boot, drawn from the generator
+   * so that it never reveals the numbers in use
+   */
+  uint8_t RandomSeed[CRYPTO_DRBG_SEED_SIZE];
+#endif /* LORAWAN_KMS == 0 */
 } SecureElementNvCtx_t;
 
 /* Private variables ---------------------------------------------------------*/
@@ -173,6 +220,12 @@ static SecureElementNvCtx_t SeNvmCtx =
 
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
 static const Key_t InitialKeyList[NUM_OF_KEYS] = SOFT_SE_KEY_LIST;
+
+/*!
+ * Key material cache, not part of the NVM context
+ */
+static KeyCache_t KeyCache[KEY_CACHE_SIZE];
+static uint32_t KeyCacheUseCounter = 0;
 #endif /* LORAWAN_KMS == 0 */
 
 static SecureElementNvmEvent SeNvmCtxChanged;
@@ -206,6 +259,10 @@ static uint8_t tag[SE_KEY_SIZE] ALIGN(4) = {0};
 /* Private functions prototypes ---------------------------------------------------*/
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
 static SecureElementStatus_t GetKeyByID(KeyIdentifier_t keyID, Key_t **keyItem);
+static SecureElementStatus_t GetKeyCacheByID(KeyIdentifier_t keyID, KeyCache_t **cacheItem);
+static void InvalidateKeyCache(KeyIdentifier_t keyID);
+static SecureElementStatus_t SeedRandomGenerator(void);
+static SecureElementStatus_t RefreshRandomSeed(void);
 #else /* LORAWAN_KMS == 1 */
 static SecureElementStatus_t GetKeyIndexByID(KeyIdentifier_t keyID, CK_OBJECT_HANDLE *keyItem);
 #endif /* LORAWAN_KMS */
@@ -225,6 +282,13 @@ static void DummyCB(void);
  */
 static SecureElementStatus_t GetKeyByID(KeyIdentifier_t keyID, Key_t **keyItem)
 {
+  /* The key list is stored in KeyIdentifier_t order, look there first */
+  if (((uint32_t) keyID < NUM_OF_KEYS) && (SeNvmCtx.KeyList[keyID].KeyID == keyID))
+  {
+    *keyItem = &(SeNvmCtx.KeyList[keyID]);
+    return SECURE_ELEMENT_SUCCESS;
+  }
+
   for (uint8_t i = 0; i < NUM_OF_KEYS; i++)
   {
     if (SeNvmCtx.KeyList[i].KeyID == keyID)
@@ -236,6 +300,114 @@ static SecureElementStatus_t GetKeyByID(KeyIdentifier_t keyID, Key_t **keyItem)
   return SECURE_ELEMENT_ERROR_INVALID_KEY_ID;
 }
 
+/*
+ * Gets the expanded key material of a key, expands it on a cache miss.
+ *
+ * \param[IN]  keyID          - Key identifier
+ * \param[OUT] cacheItem      - Cache entry reference, valid until the next call
+ * \retval                    - Status of the operation
+ */
+static SecureElementStatus_t GetKeyCacheByID(KeyIdentifier_t keyID, KeyCache_t **cacheItem)
+{
+  KeyCache_t *entry = &KeyCache[0];
+
+  for (uint8_t i = 0; i < KEY_CACHE_SIZE; i++)
+  {
+    if ((KeyCache[i].Valid == true) && (KeyCache[i].KeyID == keyID))
+    {
+      entry = &KeyCache[i];
+      break;
+    }
+    /* Otherwise replace a free or the least recently used entry */
+    if ((entry->Valid == true) && ((KeyCache[i].Valid == false) || (KeyCache[i].LastUse < entry->LastUse)))
+    {
+      entry = &KeyCache[i];
+    }
+  }
+
+  if ((entry->Valid == false) || (entry->KeyID != keyID))
+  {
+    Key_t *keyItem;
+    SecureElementStatus_t retval = GetKeyByID(keyID, &keyItem);
+    if (retval != SECURE_ELEMENT_SUCCESS)
+    {
+      return retval;
+    }
+
+    retval = CryptoBackendSetKey(keyItem->KeyValue, &entry->CryptoKey);
+    if (retval != SECURE_ELEMENT_SUCCESS)
+    {
+      return retval;
+    }
+    entry->KeyID = keyID;
+    entry->Valid = true;
+  }
+
+  entry->LastUse = ++KeyCacheUseCounter;
+  *cacheItem = entry;
+  return SECURE_ELEMENT_SUCCESS;
+}
+
+/*
+ * Drops the expanded key material of a changed key.
+ *
+ * \param[IN]  keyID          - Key identifier, NO_KEY drops all entries
+ */
+static void InvalidateKeyCache(KeyIdentifier_t keyID)
+{
+  for (uint8_t i = 0; i < KEY_CACHE_SIZE; i++)
+  {
+    if ((keyID == NO_KEY) || (KeyCache[i].KeyID == keyID))
+    {
+      memset1((uint8_t *) &KeyCache[i], 0, sizeof(KeyCache_t));
+    }
+  }
+}
+
+/*
+ * Seeds the random generator from the radio noise, the MCU unique ID and the
+ * seed saved at the previous boot. The radio is only woken up here, once per
+ * boot and then every CRYPTO_DRBG_RESEED_INTERVAL draws.
+ */
+static SecureElementStatus_t SeedRandomGenerator(void)
+{
+  uint8_t seed[(RANDOM_SEED_RADIO_WORDS * 4) + SE_EUI_SIZE + CRYPTO_DRBG_SEED_SIZE];
+  uint32_t radioWord;
+  SecureElementStatus_t retval;
+
+  for (uint8_t i = 0; i < RANDOM_SEED_RADIO_WORDS; i++)
+  {
+    radioWord = Radio.Random();
+    memcpy1(&seed[i * 4], (uint8_t *) &radioWord, 4);
+  }
+  GetUniqueId(&seed[RANDOM_SEED_RADIO_WORDS * 4]);
+  memcpy1(&seed[(RANDOM_SEED_RADIO_WORDS * 4) + SE_EUI_SIZE], SeNvmCtx.RandomSeed, CRYPTO_DRBG_SEED_SIZE);
+
+  retval = CryptoDrbgSeed(seed, sizeof(seed));
+  memset1(seed, 0, sizeof(seed));
+  if (retval != SECURE_ELEMENT_SUCCESS)
+  {
+    return retval;
+  }
+  return RefreshRandomSeed();
+}
+
+/*
+ * Replaces the saved seed with a fresh one, so that no two boots start from
+ * the same saved seed
+ */
+static SecureElementStatus_t RefreshRandomSeed(void)
+{
+  SecureElementStatus_t retval;
+
+  retval = CryptoDrbgGenerate(SeNvmCtx.RandomSeed, CRYPTO_DRBG_SEED_SIZE);
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
+    SeNvmCtxChanged();
+  }
+  return retval;
+}
+
 #else /* LORAWAN_KMS == 1 */
 
 /*
@@ -291,26 +463,17 @@ static SecureElementStatus_t ComputeCmac(uint8_t *micBxBuffer, uint8_t *buffer,
 
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
   uint8_t Cmac[16];
-  AES_CMAC_CTX aesCmacCtx[1];
 
-  AES_CMAC_Init(aesCmacCtx);
-
-  Key_t *keyItem;
-  retval = GetKeyByID(keyID, &keyItem);
+  KeyCache_t *cacheItem;
+  retval = GetKeyCacheByID(keyID, &cacheItem);
 
   if (retval == SECURE_ELEMENT_SUCCESS)
   {
-    AES_CMAC_SetKey(aesCmacCtx, keyItem->KeyValue);
-
-    if (micBxBuffer != NULL)
-    {
-      AES_CMAC_Update(aesCmacCtx, micBxBuffer, 16);
-    }
-
-    AES_CMAC_Update(aesCmacCtx, buffer, size);
-
-    AES_CMAC_Final(Cmac, aesCmacCtx);
+    retval = CryptoBackendCmac(&cacheItem->CryptoKey, micBxBuffer, buffer, size, Cmac);
+  }
 
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
     /* Bring into the required format */
     *cmac = (uint32_t)((uint32_t) Cmac[3] << 24 | (uint32_t) Cmac[2] << 16 | (uint32_t) Cmac[1] << 8 |
                        (uint32_t) Cmac[0]);
@@ -400,6 +563,13 @@ SecureElementStatus_t SecureElementInit(SecureElementNvmEvent seNvmCtxChanged)
 
   /* Initialize LoRaWAN Key List buffer */
   memcpy1((uint8_t *)(SeNvmCtx.KeyList), (const uint8_t *)InitialKeyList, sizeof(Key_t)*NUM_OF_KEYS);
+  InvalidateKeyCache(NO_KEY);
+
+  retval = CryptoBackendInit();
+  if (retval != SECURE_ELEMENT_SUCCESS)
+  {
+    return retval;
+  }
 
   retval = GetKeyByID(APP_KEY, &keyItem);
   KEY_LOG(TS_OFF, VLEVEL_M, "###### OTAA ######\r\n");
@@ -528,6 +698,18 @@ SecureElementStatus_t SecureElementRestoreNvmCtx(void *seNvmCtx)
   if (seNvmCtx != 0)
   {
     memcpy1((uint8_t *) &SeNvmCtx, (uint8_t *) seNvmCtx, sizeof(SeNvmCtx));
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+    InvalidateKeyCache(NO_KEY);
+    /* Already seeded at this boot: mix the saved seed in and save a new one */
+    if (CryptoDrbgNeedsSeed() == false)
+    {
+      if ((CryptoDrbgSeed(SeNvmCtx.RandomSeed, CRYPTO_DRBG_SEED_SIZE) != SECURE_ELEMENT_SUCCESS)
+          || (RefreshRandomSeed() != SECURE_ELEMENT_SUCCESS))
+      {
+        return SECURE_ELEMENT_ERROR;
+      }
+    }
+#endif /* LORAWAN_KMS == 0 */
     return SECURE_ELEMENT_SUCCESS;
   }
   else
@@ -567,6 +749,7 @@ SecureElementStatus_t SecureElementSetKey(KeyIdentifier_t keyID, uint8_t *key)
         retval = SecureElementAesEncrypt(key, 16, MC_KE_KEY, decryptedKey);
 
         memcpy1(SeNvmCtx.KeyList[i].KeyValue, decryptedKey, SE_KEY_SIZE);
+        InvalidateKeyCache(keyID);
         SeNvmCtxChanged();
 
         return retval;
@@ -574,6 +757,7 @@ SecureElementStatus_t SecureElementSetKey(KeyIdentifier_t keyID, uint8_t *key)
       else
       {
         memcpy1(SeNvmCtx.KeyList[i].KeyValue, key, SE_KEY_SIZE);
+        InvalidateKeyCache(keyID);
         SeNvmCtxChanged();
         return SECURE_ELEMENT_SUCCESS;
       }
@@ -703,24 +887,12 @@ SecureElementStatus_t SecureElementAesEncrypt(uint8_t *buffer, uint16_t size, Ke
   }
 
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
-  lorawan_aes_context aesContext;
-  memset1(aesContext.ksch, '\0', 240);
-
-  Key_t *pItem;
-  retval = GetKeyByID(keyID, &pItem);
+  KeyCache_t *cacheItem;
+  retval = GetKeyCacheByID(keyID, &cacheItem);
 
   if (retval == SECURE_ELEMENT_SUCCESS)
   {
-    lorawan_aes_set_key(pItem->KeyValue, 16, &aesContext);
-
-    uint8_t block = 0;
-
-    while (size != 0)
-    {
-      lorawan_aes_encrypt(&buffer[block], &encBuffer[block], &aesContext);
-      block = block + 16;
-      size = size - 16;
-    }
+    retval = CryptoBackendEcbEncrypt(&cacheItem->CryptoKey, buffer, size, encBuffer);
   }
 #else /* LORAWAN_KMS == 1 */
   CK_RV rv;
@@ -777,6 +949,97 @@ SecureElementStatus_t SecureElementAesEncrypt(uint8_t *buffer, uint16_t size, Ke
   return retval;
 }
 
+SecureElementStatus_t SecureElementAesCtrCrypt(const uint8_t *aBlock, uint8_t *buffer, uint16_t size,
+                                               KeyIdentifier_t keyID)
+{
+  SecureElementStatus_t retval = SECURE_ELEMENT_ERROR;
+  uint8_t ctrBlock[16];
+
+  if ((aBlock == NULL) || (buffer == NULL))
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+
+  memcpy1(ctrBlock, aBlock, 16);
+
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+  KeyCache_t *cacheItem;
+  retval = GetKeyCacheByID(keyID, &cacheItem);
+
+  if (retval == SECURE_ELEMENT_SUCCESS)
+  {
+    retval = CryptoBackendCtrCrypt(&cacheItem->CryptoKey, ctrBlock, buffer, size);
+  }
+#else /* LORAWAN_KMS == 1 */
+  CK_RV rv = CKR_OK;
+  CK_SESSION_HANDLE session;
+  CK_FLAGS session_flags = CKF_SERIAL_SESSION;  /* Read ONLY session */
+  uint32_t encrypted_length = 0;
+  CK_OBJECT_HANDLE object_handle;
+  uint8_t dummy_tag[SE_KEY_SIZE] = {0};
+  uint32_t dummy_tag_lenth = 0;
+
+  CK_MECHANISM aes_ecb_mechanism = { CKM_AES_ECB, (CK_VOID_PTR *) NULL, 0 };
+
+  retval = GetKeyIndexByID(keyID, &object_handle);
+  if (retval != SECURE_ELEMENT_SUCCESS)
+  {
+    return retval;
+  }
+
+  /* Open session with KMS */
+  rv = C_OpenSession(0,  session_flags, NULL, 0, &session);
+
+  /* Configure session to encrypt the counter blocks in AES ECB */
+  if (rv == CKR_OK)
+  {
+    rv = C_EncryptInit(session, &aes_ecb_mechanism, object_handle);
+  }
+
+  /* Generate the keystream of up to CTR_BATCH_BLOCKS blocks per call */
+  while ((rv == CKR_OK) && (size != 0))
+  {
+    uint16_t batchSize = MIN(size, (uint16_t)(CTR_BATCH_BLOCKS * 16));
+    uint16_t blocksSize = (batchSize + 15) & ~15U;
+
+    for (uint16_t offset = 0; offset < blocksSize; offset += 16)
+    {
+      memcpy1(&input_align_combined_buf[offset], ctrBlock, 16);
+      ctrBlock[15]++;
+    }
+
+    encrypted_length = sizeof(output_align);
+    rv = C_EncryptUpdate(session, (CK_BYTE_PTR)input_align_combined_buf, blocksSize,
+                         output_align, (CK_ULONG_PTR)&encrypted_length);
+    if (rv == CKR_OK)
+    {
+      CryptoXorKeystream(buffer, (const uint32_t *) output_align, batchSize);
+      buffer += batchSize;
+      size -= batchSize;
+    }
+  }
+
+  /* In this case C_EncryptFinal is just called to Free the Alloc mem */
+  if (rv == CKR_OK)
+  {
+    dummy_tag_lenth = sizeof(tag);
+    rv = C_EncryptFinal(session, &dummy_tag[0], (CK_ULONG_PTR)&dummy_tag_lenth);
+  }
+
+  /* Close session with KMS */
+  (void)C_CloseSession(session);
+
+  memset1(output_align, 0, sizeof(output_align));
+
+  if (rv != CKR_OK)
+  {
+    retval = SECURE_ELEMENT_ERROR;
+  }
+#endif /* LORAWAN_KMS */
+
+  return retval;
+}
+
 SecureElementStatus_t SecureElementDeriveAndStoreKey(Version_t version, uint8_t *input, KeyIdentifier_t rootKeyID,
                                                      KeyIdentifier_t targetKeyID)
 {
@@ -960,8 +1223,59 @@ SecureElementStatus_t SecureElementRandomNumber(uint32_t *randomNum)
   {
     return SECURE_ELEMENT_ERROR_NPE;
   }
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+  if (CryptoDrbgNeedsSeed() == true)
+  {
+    SecureElementStatus_t retval = SeedRandomGenerator();
+    if (retval != SECURE_ELEMENT_SUCCESS)
+    {
+      return retval;
+    }
+  }
+  return CryptoDrbgGenerate((uint8_t *) randomNum, sizeof(uint32_t));
+#else /* LORAWAN_KMS == 1 */
   *randomNum = Radio.Random( );
   return SECURE_ELEMENT_SUCCESS;
+#endif /* LORAWAN_KMS */
+}
+
+SecureElementStatus_t SecureElementSetRandomSeed(const uint8_t *seed)
+{
+  if (seed == NULL)
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+  memcpy1(SeNvmCtx.RandomSeed, seed, SE_RANDOM_SEED_SIZE);
+  /* Already seeded at this boot: mix the saved seed in and save a new one */
+  if (CryptoDrbgNeedsSeed() == false)
+  {
+    SecureElementStatus_t retval = CryptoDrbgSeed(SeNvmCtx.RandomSeed, CRYPTO_DRBG_SEED_SIZE);
+    if (retval != SECURE_ELEMENT_SUCCESS)
+    {
+      return retval;
+    }
+    return RefreshRandomSeed();
+  }
+  SeNvmCtxChanged();
+  return SECURE_ELEMENT_SUCCESS;
+#else /* LORAWAN_KMS == 1 */
+  return SECURE_ELEMENT_ERROR;
+#endif /* LORAWAN_KMS */
+}
+
+SecureElementStatus_t SecureElementGetRandomSeed(uint8_t *seed)
+{
+  if (seed == NULL)
+  {
+    return SECURE_ELEMENT_ERROR_NPE;
+  }
+#if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
+  memcpy1(seed, SeNvmCtx.RandomSeed, SE_RANDOM_SEED_SIZE);
+  return SECURE_ELEMENT_SUCCESS;
+#else /* LORAWAN_KMS == 1 */
+  return SECURE_ELEMENT_ERROR;
+#endif /* LORAWAN_KMS */
 }
 
 SecureElementStatus_t SecureElementSetDevEui(uint8_t *devEui)
@@ -50,6 +50,7 @@
 #include "lora_info.h"
 #include "LmhpCompliance.h"
 #include "LoRaMacTest.h"
+#include "LoRaMacCrypto.h"
 #if (!defined (LORAWAN_DATA_DISTRIB_MGT) || (LORAWAN_DATA_DISTRIB_MGT == 0))
 #else /* LORAWAN_DATA_DISTRIB_MGT == 1 */
 #include "LmhpDataDistribution.h"
@@ -294,6 +295,11 @@ static bool IsClassBSwitchPending = false;
 
 static bool CtxRestoreDone = false;
 
+/*!
+ * Indicates if the MAC has been busy since the last idle notification
+ */
+static bool IsMacBusy = false;
+
 /* Exported functions ---------------------------------------------------------*/
 LmHandlerErrorStatus_t LmHandlerInit(LmHandlerCallbacks_t *handlerCallbacks)
 {
@@ -419,8 +425,7 @@ bool LmHandlerIsBusy(void)
 
   if (LmHandlerJoinStatus() != LORAMAC_HANDLER_SET)
   {
-    /* The network isn't yet joined, try again later. */
-    LmHandlerJoin(JoinParams.Mode);
+    /* The network isn't yet joined, the upper layer schedules the join requests */
     return true;
   }
 
@@ -449,6 +454,20 @@ void LmHandlerProcess(void)
   }
 
   NvmCtxMgmtStore();
+
+  /* Notify the upper layer once the MAC is back to idle (TX done and all RX windows closed) */
+  if (LoRaMacIsBusy() == true)
+  {
+    IsMacBusy = true;
+  }
+  else if (IsMacBusy == true)
+  {
+    IsMacBusy = false;
+    if (LmHandlerCallbacks.OnMacIdle != NULL)
+    {
+      LmHandlerCallbacks.OnMacIdle();
+    }
+  }
 }
 
 LmHandlerFlagStatus_t LmHandlerJoinStatus(void)
@@ -477,8 +496,14 @@ LmHandlerFlagStatus_t LmHandlerJoinStatus(void)
 }
 
 void LmHandlerJoin(ActivationType_t mode)
+{
+  LmHandlerJoinAtDatarate(mode, LmHandlerParams.TxDatarate);
+}
+
+LmHandlerErrorStatus_t LmHandlerJoinAtDatarate(ActivationType_t mode, int8_t datarate)
 {
   MibRequestConfirm_t mibReq;
+  LmHandlerErrorStatus_t lmhStatus = LORAMAC_HANDLER_SUCCESS;
 
 #if (!defined (LORAWAN_KMS) || (LORAWAN_KMS == 0))
 #else /* LORAWAN_KMS == 1 */
@@ -508,9 +533,22 @@ void LmHandlerJoin(ActivationType_t mode)
 
     /* Starts the OTAA join procedure */
     mlmeReq.Type = MLME_JOIN;
-    mlmeReq.Req.Join.Datarate = LmHandlerParams.TxDatarate;
-    LoRaMacMlmeRequest(&mlmeReq);
-
+    mlmeReq.Req.Join.Datarate = datarate;
+    switch (LoRaMacMlmeRequest(&mlmeReq))
+    {
+      case LORAMAC_STATUS_OK:
+        IsMacBusy = true;
+        break;
+      case LORAMAC_STATUS_BUSY:
+        lmhStatus = LORAMAC_HANDLER_BUSY_ERROR;
+        break;
+      case LORAMAC_STATUS_DUTYCYCLE_RESTRICTED:
+        lmhStatus = LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED;
+        break;
+      default:
+        lmhStatus = LORAMAC_HANDLER_ERROR;
+        break;
+    }
   }
   else
   {
@@ -557,6 +595,8 @@ void LmHandlerJoin(ActivationType_t mode)
     LmHandlerCallbacks.OnJoinRequest(&JoinParams);
     LmHandlerRequestClass(LmHandlerParams.DefaultClass);
   }
+
+  return lmhStatus;
 }
 
 LmHandlerErrorStatus_t LmHandlerStop(void)
@@ -586,8 +626,7 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
 
   if (LmHandlerJoinStatus() != LORAMAC_HANDLER_SET)
   {
-    /* The network isn't yet joined, try again later. */
-    LmHandlerJoin(JoinParams.Mode);
+    /* The network isn't yet joined, the upper layer schedules the join requests */
     return LORAMAC_HANDLER_NO_NETWORK_JOINED;
   }
 
@@ -636,6 +675,7 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   {
   case LORAMAC_STATUS_OK:
     lmhStatus = LORAMAC_HANDLER_SUCCESS;
+    IsMacBusy = true;
     break;
   case LORAMAC_STATUS_BUSY:
   case LORAMAC_STATUS_BUSY_UPLINK_COLLISION:
@@ -668,6 +708,25 @@ LmHandlerErrorStatus_t LmHandlerSend(LmHandlerAppData_t *appData, LmHandlerMsgTy
   return lmhStatus;
 }
 
+LmHandlerErrorStatus_t LmHandlerLinkCheckReq(void)
+{
+  LoRaMacStatus_t status;
+  MlmeReq_t mlmeReq;
+
+  mlmeReq.Type = MLME_LINK_CHECK;
+
+  status = LoRaMacMlmeRequest(&mlmeReq);
+
+  if (status == LORAMAC_STATUS_OK)
+  {
+    return LORAMAC_HANDLER_SUCCESS;
+  }
+  else
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+}
+
 LmHandlerErrorStatus_t LmHandlerRequestClass(DeviceClass_t newClass)
 {
   MibRequestConfirm_t mibReq;
@@ -1074,6 +1133,34 @@ int32_t LmHandlerGetTxPower(int8_t *txPower)
   return LORAMAC_HANDLER_SUCCESS;
 }
 
+int32_t LmHandlerGetDevNonce(uint16_t *devNonce)
+{
+  if (devNonce == NULL)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  if (LoRaMacCryptoGetDevNonce(devNonce) != LORAMAC_CRYPTO_SUCCESS)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+int32_t LmHandlerSetDevNonce(uint16_t devNonce)
+{
+  if (LmHandlerJoinStatus() == LORAMAC_HANDLER_SET)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+
+  if (LoRaMacCryptoSetDevNonce(devNonce) != LORAMAC_CRYPTO_SUCCESS)
+  {
+    return LORAMAC_HANDLER_ERROR;
+  }
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
 int32_t LmHandlerGetRx1Delay(uint32_t *rxDelay)
 {
   MibRequestConfirm_t mibReq;
@@ -1369,6 +1456,8 @@ static void McpsConfirm(McpsConfirm_t *mcpsConfirm)
   TxParams.TxPower = mcpsConfirm->TxPower;
   TxParams.Channel = mcpsConfirm->Channel;
   TxParams.AckReceived = mcpsConfirm->AckReceived;
+  TxParams.NbRetries = mcpsConfirm->NbRetries;
+  TxParams.TxTimeOnAir = mcpsConfirm->TxTimeOnAir;
 
   LmHandlerCallbacks.OnTxData(&TxParams);
 
@@ -1456,8 +1545,17 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm)
     break;
     case MLME_LINK_CHECK:
     {
-      /* Check DemodMargin */
-      /* Check NbGateways */
+      LmHandlerLinkCheckParams_t linkCheckParams;
+
+      /* DemodMargin and NbGateways are only set by an answer */
+      linkCheckParams.Status = mlmeConfirm->Status;
+      linkCheckParams.DemodMargin = mlmeConfirm->DemodMargin;
+      linkCheckParams.NbGateways = mlmeConfirm->NbGateways;
+
+      if (LmHandlerCallbacks.OnLinkCheck != NULL)
+      {
+        LmHandlerCallbacks.OnLinkCheck(&linkCheckParams);
+      }
     }
     break;
     case MLME_DEVICE_TIME:
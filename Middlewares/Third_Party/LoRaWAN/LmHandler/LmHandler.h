@@ -70,6 +70,8 @@ typedef struct LmHandlerTxParams_s
   LmHandlerAppData_t AppData;
   int8_t TxPower;
   uint8_t Channel;
+  uint8_t NbRetries;
+  TimerTime_t TxTimeOnAir;
 } LmHandlerTxParams_t;
 
 /*!
@@ -80,12 +82,22 @@ typedef struct LmHandlerRxParams_s
   uint8_t IsMcpsIndication;
   LoRaMacEventInfoStatus_t Status;
   int8_t Datarate;
-  int8_t Rssi;
+  int16_t Rssi;
   int8_t Snr;
   uint32_t DownlinkCounter;
   int8_t RxSlot;
 } LmHandlerRxParams_t;
 
+/*!
+ * \brief Link check notification parameters
+ */
+typedef struct LmHandlerLinkCheckParams_s
+{
+  LoRaMacEventInfoStatus_t Status;
+  uint8_t DemodMargin;
+  uint8_t NbGateways;
+} LmHandlerLinkCheckParams_t;
+
 /*!
  * \brief Beacon notification parameters
  */
@@ -172,6 +184,21 @@ typedef struct LmHandlerCallbacks_s
    * \param [in] params notification parameters
    */
   void (*OnRxData)(LmHandlerAppData_t *appData, LmHandlerRxParams_t *params);
+  /*!
+   * \brief Notifies the upper layer that the MAC is idle again after a request
+   *        (confirm sent and all RX windows closed). Optional, may be NULL.
+   *
+   * \note Runs in the context of \ref LmHandlerProcess
+   */
+  void (*OnMacIdle)(void);
+  /*!
+   * \brief Notifies the upper layer of the answer to a link check request,
+   *        see \ref LmHandlerLinkCheckReq. Optional, may be NULL.
+   *
+   * \param [in] params notification parameters, the margin and the number
+   *                    of gateways are only valid if the status is OK
+   */
+  void (*OnLinkCheck)(LmHandlerLinkCheckParams_t *params);
 } LmHandlerCallbacks_t;
 
 /* External variables --------------------------------------------------------*/
@@ -229,6 +256,22 @@ LmHandlerFlagStatus_t LmHandlerJoinStatus(void);
  */
 void LmHandlerJoin(ActivationType_t mode);
 
+/*!
+ * \brief Join a LoRa Network in classA, the join request is sent at the given datarate
+ *
+ * \note Callback OnJoinRequest informs upper layer of the result once the
+ *       request is accepted
+ *
+ * \param [in] mode Activation mode (OTAA or ABP)
+ * \param [in] datarate Datarate of the join request (OTAA only)
+ *
+ * \retval status Returns \ref LORAMAC_HANDLER_SUCCESS if the request has been
+ *                accepted, \ref LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED if the
+ *                join duty cycle is exhausted, \ref LORAMAC_HANDLER_BUSY_ERROR
+ *                if the MAC is busy else \ref LORAMAC_HANDLER_ERROR
+ */
+LmHandlerErrorStatus_t LmHandlerJoinAtDatarate(ActivationType_t mode, int8_t datarate);
+
 /*!
  * \brief Stop a LoRa Network connection
  *
@@ -251,6 +294,16 @@ LmHandlerErrorStatus_t LmHandlerStop(void);
  */
 LmHandlerErrorStatus_t LmHandlerRequestClass(DeviceClass_t newClass);
 
+/*!
+ * \brief Requests a link check, piggybacked on the next uplink
+ *
+ * \note Callback OnLinkCheck informs upper layer of the answer
+ *
+ * \retval status Returns \ref LORAMAC_HANDLER_SUCCESS if request has been
+ *                queued else \ref LORAMAC_HANDLER_ERROR
+ */
+LmHandlerErrorStatus_t LmHandlerLinkCheckReq(void);
+
 /*!
  * \brief LoRaMac handler configuration
  *
@@ -462,6 +515,27 @@ int32_t LmHandlerGetRX2Params(RxChannelParams_t *rxParams);
  */
 int32_t LmHandlerGetTxPower(int8_t *txPower);
 
+/*!
+ * \brief Gets the DevNonce of the last join request
+ *
+ * \param [out] devNonce DevNonce of the last join request
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+int32_t LmHandlerGetDevNonce(uint16_t *devNonce);
+
+/*!
+ * \brief Sets the DevNonce of the last join request, e.g. restored after a reset.
+ *        Only possible while not joined.
+ *
+ * \param [in] devNonce DevNonce of the last join request
+ *
+ * \retval -1 LORAMAC_HANDLER_ERROR
+ *          0 LORAMAC_HANDLER_SUCCESS
+ */
+int32_t LmHandlerSetDevNonce(uint16_t devNonce);
+
 /*!
  * \brief Gets the current RX1 delay (after the TX done)
  *
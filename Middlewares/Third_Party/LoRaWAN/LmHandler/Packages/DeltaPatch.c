@@ -0,0 +1,586 @@
+/**
+  ******************************************************************************
+  * @file    DeltaPatch.c
+  * @brief   Applies a delta patch received by FUOTA to the current image
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "DeltaPatch.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t State[8];
+  uint64_t Length;
+  uint8_t Block[64];
+  uint8_t BlockLength;
+} Sha256Context_t;
+
+typedef struct
+{
+  DeltaPatchCallbacks_t *Callbacks;
+  bool Error;
+
+  /* Patch body stream */
+  uint32_t PatchAddr;
+  uint32_t PatchEnd;
+  uint16_t PatchBufferPos;
+  uint16_t PatchBufferLength;
+  uint8_t PatchBuffer[DELTA_PATCH_IO_BUFFER_SIZE];
+
+  /* LZSS decoder */
+  uint8_t Window[DELTA_PATCH_WINDOW_SIZE];
+  uint16_t WindowPos;
+  uint16_t MatchDistance;
+  uint16_t MatchLeft;
+  uint8_t Flags;
+  uint8_t FlagsLeft;
+
+  /* Current image, random access through a one buffer cache */
+  uint32_t OldSize;
+  uint32_t OldBufferAddr;
+  uint16_t OldBufferLength;
+  uint8_t OldBuffer[DELTA_PATCH_IO_BUFFER_SIZE];
+
+  /* New image, written sequentially */
+  uint32_t NewSize;
+  uint32_t NewAddr;
+  uint16_t NewBufferLength;
+  uint8_t NewBuffer[DELTA_PATCH_IO_BUFFER_SIZE];
+
+  Sha256Context_t Sha256;
+} DeltaPatch_t;
+
+/* Private define ------------------------------------------------------------*/
+#define DELTA_PATCH_OLD_SIZE_OFFSET                 4
+#define DELTA_PATCH_NEW_SIZE_OFFSET                 8
+#define DELTA_PATCH_BODY_SIZE_OFFSET                12
+#define DELTA_PATCH_OLD_HASH_OFFSET                 16
+#define DELTA_PATCH_NEW_HASH_OFFSET                 48
+
+/* Private macro -------------------------------------------------------------*/
+#define ROTR32(x, n)                                ( ( ( x ) >> ( n ) ) | ( ( x ) << ( 32 - ( n ) ) ) )
+
+/* Private function prototypes -----------------------------------------------*/
+/*!
+ * \brief Reads a little endian 32-bit value
+ */
+static uint32_t GetUint32(const uint8_t *data);
+
+/*!
+ * \brief Gets the next byte of the patch body
+ */
+static bool PatchGetByte(uint8_t *byte);
+
+/*!
+ * \brief Gets the next decompressed byte of the patch body
+ */
+static bool LzssGetByte(uint8_t *byte);
+
+/*!
+ * \brief Reads an unsigned LEB128 value from the decompressed stream
+ */
+static bool GetVarint(uint32_t *value);
+
+/*!
+ * \brief Gets the byte of the current image at `addr`
+ */
+static bool OldGetByte(uint32_t addr, uint8_t *byte);
+
+/*!
+ * \brief Appends a byte to the new image
+ */
+static bool NewPutByte(uint8_t byte);
+
+/*!
+ * \brief Writes the buffered bytes of the new image
+ */
+static bool NewFlush(void);
+
+/*!
+ * \brief Hashes `size` bytes of an image read with `read` and compares the digest
+ */
+static bool ImageHashMatches(uint8_t (*read)(uint32_t addr, uint8_t *data, uint32_t size), uint32_t size,
+                             const uint8_t *digest);
+
+static void Sha256Init(Sha256Context_t *ctx);
+static void Sha256Update(Sha256Context_t *ctx, const uint8_t *data, uint32_t size);
+static void Sha256Final(Sha256Context_t *ctx, uint8_t *digest);
+static void Sha256Block(Sha256Context_t *ctx, const uint8_t *block);
+
+/* Private variables ---------------------------------------------------------*/
+static DeltaPatch_t DeltaPatch;
+
+static const uint32_t Sha256K[64] =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Exported functions ---------------------------------------------------------*/
+bool DeltaPatchCheckHeader(const uint8_t *header, uint32_t patchSize, uint32_t maxNewSize)
+{
+  if ((header == NULL) || (patchSize < DELTA_PATCH_HEADER_SIZE))
+  {
+    return false;
+  }
+  if (GetUint32(header) != DELTA_PATCH_DESCRIPTOR)
+  {
+    return false;
+  }
+  if ((GetUint32(&header[DELTA_PATCH_NEW_SIZE_OFFSET]) == 0) ||
+      (GetUint32(&header[DELTA_PATCH_NEW_SIZE_OFFSET]) > maxNewSize))
+  {
+    return false;
+  }
+  if (GetUint32(&header[DELTA_PATCH_BODY_SIZE_OFFSET]) > (patchSize - DELTA_PATCH_HEADER_SIZE))
+  {
+    return false;
+  }
+  return true;
+}
+
+DeltaPatchStatus_t DeltaPatchApply(uint32_t patchSize, uint32_t maxNewSize, DeltaPatchCallbacks_t *callbacks,
+                                   uint32_t *newSize)
+{
+  uint8_t header[DELTA_PATCH_HEADER_SIZE];
+  uint32_t oldPos = 0;
+  uint32_t newPos = 0;
+
+  if ((callbacks == NULL) || (callbacks->ReadPatch == NULL) || (callbacks->ReadOld == NULL) ||
+      (callbacks->WriteNew == NULL) || (callbacks->ReadNew == NULL))
+  {
+    return DELTA_PATCH_ERROR_IO;
+  }
+  if ((patchSize < DELTA_PATCH_HEADER_SIZE) ||
+      (callbacks->ReadPatch(0, header, DELTA_PATCH_HEADER_SIZE) != 0))
+  {
+    return DELTA_PATCH_ERROR_HEADER;
+  }
+  if (DeltaPatchCheckHeader(header, patchSize, maxNewSize) == false)
+  {
+    return DELTA_PATCH_ERROR_HEADER;
+  }
+
+  DeltaPatch.Callbacks = callbacks;
+  DeltaPatch.Error = false;
+  DeltaPatch.OldSize = GetUint32(&header[DELTA_PATCH_OLD_SIZE_OFFSET]);
+  DeltaPatch.NewSize = GetUint32(&header[DELTA_PATCH_NEW_SIZE_OFFSET]);
+
+  /* Nothing is written unless the patch was made for the current image */
+  if (ImageHashMatches(callbacks->ReadOld, DeltaPatch.OldSize, &header[DELTA_PATCH_OLD_HASH_OFFSET]) == false)
+  {
+    return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_OLD_IMAGE : DELTA_PATCH_ERROR_IO;
+  }
+
+  DeltaPatch.PatchAddr = DELTA_PATCH_HEADER_SIZE;
+  DeltaPatch.PatchEnd = DELTA_PATCH_HEADER_SIZE + GetUint32(&header[DELTA_PATCH_BODY_SIZE_OFFSET]);
+  DeltaPatch.PatchBufferPos = 0;
+  DeltaPatch.PatchBufferLength = 0;
+  for (uint16_t i = 0; i < DELTA_PATCH_WINDOW_SIZE; i++)
+  {
+    DeltaPatch.Window[i] = 0;
+  }
+  DeltaPatch.WindowPos = 0;
+  DeltaPatch.MatchLeft = 0;
+  DeltaPatch.FlagsLeft = 0;
+  DeltaPatch.OldBufferLength = 0;
+  DeltaPatch.NewAddr = 0;
+  DeltaPatch.NewBufferLength = 0;
+
+  while (newPos < DeltaPatch.NewSize)
+  {
+    uint32_t length;
+    uint8_t byte;
+
+    /* Diff: new bytes are the old bytes plus the patch bytes */
+    if ((GetVarint(&length) == false) || (length > (DeltaPatch.NewSize - newPos)) ||
+        (length > DeltaPatch.OldSize) || (oldPos > (DeltaPatch.OldSize - length)))
+    {
+      return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_CORRUPT : DELTA_PATCH_ERROR_IO;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+      uint8_t oldByte;
+
+      if ((LzssGetByte(&byte) == false) || (OldGetByte(oldPos++, &oldByte) == false) ||
+          (NewPutByte((uint8_t)(oldByte + byte)) == false))
+      {
+        return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_CORRUPT : DELTA_PATCH_ERROR_IO;
+      }
+    }
+    newPos += length;
+
+    /* Extra: new bytes taken from the patch as they are */
+    if ((GetVarint(&length) == false) || (length > (DeltaPatch.NewSize - newPos)))
+    {
+      return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_CORRUPT : DELTA_PATCH_ERROR_IO;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+      if ((LzssGetByte(&byte) == false) || (NewPutByte(byte) == false))
+      {
+        return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_CORRUPT : DELTA_PATCH_ERROR_IO;
+      }
+    }
+    newPos += length;
+
+    if (newPos < DeltaPatch.NewSize)
+    {
+      /* Seek in the old image, zig-zag encoded */
+      int64_t seekPos;
+
+      if (GetVarint(&length) == false)
+      {
+        return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_CORRUPT : DELTA_PATCH_ERROR_IO;
+      }
+      if ((length & 1) != 0)
+      {
+        seekPos = (int64_t) oldPos - (int64_t)(length >> 1) - 1;
+      }
+      else
+      {
+        seekPos = (int64_t) oldPos + (int64_t)(length >> 1);
+      }
+      if ((seekPos < 0) || (seekPos > (int64_t) DeltaPatch.OldSize))
+      {
+        return DELTA_PATCH_ERROR_CORRUPT;
+      }
+      oldPos = (uint32_t) seekPos;
+    }
+  }
+
+  if (NewFlush() == false)
+  {
+    return DELTA_PATCH_ERROR_IO;
+  }
+
+  /* Check what actually landed in flash */
+  if (ImageHashMatches(callbacks->ReadNew, DeltaPatch.NewSize, &header[DELTA_PATCH_NEW_HASH_OFFSET]) == false)
+  {
+    return (DeltaPatch.Error == false) ? DELTA_PATCH_ERROR_HASH : DELTA_PATCH_ERROR_IO;
+  }
+
+  if (newSize != NULL)
+  {
+    *newSize = DeltaPatch.NewSize;
+  }
+  return DELTA_PATCH_SUCCESS;
+}
+
+/* Private  functions ---------------------------------------------------------*/
+static uint32_t GetUint32(const uint8_t *data)
+{
+  return (uint32_t) data[0] | ((uint32_t) data[1] << 8) | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+static bool PatchGetByte(uint8_t *byte)
+{
+  if (DeltaPatch.PatchBufferPos == DeltaPatch.PatchBufferLength)
+  {
+    uint32_t size = DeltaPatch.PatchEnd - DeltaPatch.PatchAddr;
+
+    if (size == 0)
+    {
+      return false;
+    }
+    if (size > DELTA_PATCH_IO_BUFFER_SIZE)
+    {
+      size = DELTA_PATCH_IO_BUFFER_SIZE;
+    }
+    if (DeltaPatch.Callbacks->ReadPatch(DeltaPatch.PatchAddr, DeltaPatch.PatchBuffer, size) != 0)
+    {
+      DeltaPatch.Error = true;
+      return false;
+    }
+    DeltaPatch.PatchAddr += size;
+    DeltaPatch.PatchBufferPos = 0;
+    DeltaPatch.PatchBufferLength = (uint16_t) size;
+  }
+  *byte = DeltaPatch.PatchBuffer[DeltaPatch.PatchBufferPos++];
+  return true;
+}
+
+static bool LzssGetByte(uint8_t *byte)
+{
+  if (DeltaPatch.MatchLeft == 0)
+  {
+    uint8_t isLiteral;
+
+    if (DeltaPatch.FlagsLeft == 0)
+    {
+      if (PatchGetByte(&DeltaPatch.Flags) == false)
+      {
+        return false;
+      }
+      DeltaPatch.FlagsLeft = 8;
+    }
+    isLiteral = DeltaPatch.Flags & 0x01;
+    DeltaPatch.Flags >>= 1;
+    DeltaPatch.FlagsLeft--;
+
+    if (isLiteral != 0)
+    {
+      if (PatchGetByte(byte) == false)
+      {
+        return false;
+      }
+      DeltaPatch.Window[DeltaPatch.WindowPos] = *byte;
+      DeltaPatch.WindowPos = (DeltaPatch.WindowPos + 1) & (DELTA_PATCH_WINDOW_SIZE - 1);
+      return true;
+    }
+    else
+    {
+      uint8_t code[2];
+
+      if ((PatchGetByte(&code[0]) == false) || (PatchGetByte(&code[1]) == false))
+      {
+        return false;
+      }
+      DeltaPatch.MatchDistance = (uint16_t)((((uint16_t) code[1] << 8) | code[0]) >> 6) + 1;
+      DeltaPatch.MatchLeft = (code[0] & 0x3F) + 3;
+      if (DeltaPatch.MatchLeft == 66)
+      {
+        /* Long match, mostly the zero runs of unchanged code */
+        uint8_t extension;
+
+        if (PatchGetByte(&extension) == false)
+        {
+          return false;
+        }
+        DeltaPatch.MatchLeft += extension;
+      }
+    }
+  }
+
+  *byte = DeltaPatch.Window[(DeltaPatch.WindowPos - DeltaPatch.MatchDistance) & (DELTA_PATCH_WINDOW_SIZE - 1)];
+  DeltaPatch.MatchLeft--;
+  DeltaPatch.Window[DeltaPatch.WindowPos] = *byte;
+  DeltaPatch.WindowPos = (DeltaPatch.WindowPos + 1) & (DELTA_PATCH_WINDOW_SIZE - 1);
+  return true;
+}
+
+static bool GetVarint(uint32_t *value)
+{
+  uint8_t byte;
+
+  *value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7)
+  {
+    if (LzssGetByte(&byte) == false)
+    {
+      return false;
+    }
+    *value |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool OldGetByte(uint32_t addr, uint8_t *byte)
+{
+  if ((addr < DeltaPatch.OldBufferAddr) || (addr >= (DeltaPatch.OldBufferAddr + DeltaPatch.OldBufferLength)))
+  {
+    uint32_t size = DeltaPatch.OldSize - addr;
+
+    if (size > DELTA_PATCH_IO_BUFFER_SIZE)
+    {
+      size = DELTA_PATCH_IO_BUFFER_SIZE;
+    }
+    if (DeltaPatch.Callbacks->ReadOld(addr, DeltaPatch.OldBuffer, size) != 0)
+    {
+      DeltaPatch.Error = true;
+      return false;
+    }
+    DeltaPatch.OldBufferAddr = addr;
+    DeltaPatch.OldBufferLength = (uint16_t) size;
+  }
+  *byte = DeltaPatch.OldBuffer[addr - DeltaPatch.OldBufferAddr];
+  return true;
+}
+
+static bool NewPutByte(uint8_t byte)
+{
+  DeltaPatch.NewBuffer[DeltaPatch.NewBufferLength++] = byte;
+  if (DeltaPatch.NewBufferLength == DELTA_PATCH_IO_BUFFER_SIZE)
+  {
+    return NewFlush();
+  }
+  return true;
+}
+
+static bool NewFlush(void)
+{
+  if (DeltaPatch.NewBufferLength == 0)
+  {
+    return true;
+  }
+  if (DeltaPatch.Callbacks->WriteNew(DeltaPatch.NewAddr, DeltaPatch.NewBuffer, DeltaPatch.NewBufferLength) != 0)
+  {
+    DeltaPatch.Error = true;
+    return false;
+  }
+  DeltaPatch.NewAddr += DeltaPatch.NewBufferLength;
+  DeltaPatch.NewBufferLength = 0;
+  return true;
+}
+
+static bool ImageHashMatches(uint8_t (*read)(uint32_t addr, uint8_t *data, uint32_t size), uint32_t size,
+                             const uint8_t *digest)
+{
+  /* The old image buffer is free at the start and at the end of a patch */
+  uint8_t *chunk = DeltaPatch.OldBuffer;
+  uint8_t computed[32];
+  uint8_t diff = 0;
+
+  DeltaPatch.OldBufferLength = 0;
+  Sha256Init(&DeltaPatch.Sha256);
+  for (uint32_t addr = 0; addr < size; addr += DELTA_PATCH_IO_BUFFER_SIZE)
+  {
+    uint32_t chunkSize = size - addr;
+
+    if (chunkSize > DELTA_PATCH_IO_BUFFER_SIZE)
+    {
+      chunkSize = DELTA_PATCH_IO_BUFFER_SIZE;
+    }
+    if (read(addr, chunk, chunkSize) != 0)
+    {
+      DeltaPatch.Error = true;
+      return false;
+    }
+    Sha256Update(&DeltaPatch.Sha256, chunk, chunkSize);
+  }
+  Sha256Final(&DeltaPatch.Sha256, computed);
+
+  for (uint8_t i = 0; i < 32; i++)
+  {
+    diff |= computed[i] ^ digest[i];
+  }
+  return diff == 0;
+}
+
+static void Sha256Init(Sha256Context_t *ctx)
+{
+  ctx->State[0] = 0x6a09e667;
+  ctx->State[1] = 0xbb67ae85;
+  ctx->State[2] = 0x3c6ef372;
+  ctx->State[3] = 0xa54ff53a;
+  ctx->State[4] = 0x510e527f;
+  ctx->State[5] = 0x9b05688c;
+  ctx->State[6] = 0x1f83d9ab;
+  ctx->State[7] = 0x5be0cd19;
+  ctx->Length = 0;
+  ctx->BlockLength = 0;
+}
+
+static void Sha256Update(Sha256Context_t *ctx, const uint8_t *data, uint32_t size)
+{
+  for (uint32_t i = 0; i < size; i++)
+  {
+    ctx->Block[ctx->BlockLength++] = data[i];
+    if (ctx->BlockLength == 64)
+    {
+      Sha256Block(ctx, ctx->Block);
+      ctx->BlockLength = 0;
+    }
+  }
+  ctx->Length += size;
+}
+
+static void Sha256Final(Sha256Context_t *ctx, uint8_t *digest)
+{
+  uint64_t bitLength = ctx->Length * 8;
+
+  ctx->Block[ctx->BlockLength++] = 0x80;
+  if (ctx->BlockLength > 56)
+  {
+    while (ctx->BlockLength < 64)
+    {
+      ctx->Block[ctx->BlockLength++] = 0;
+    }
+    Sha256Block(ctx, ctx->Block);
+    ctx->BlockLength = 0;
+  }
+  while (ctx->BlockLength < 56)
+  {
+    ctx->Block[ctx->BlockLength++] = 0;
+  }
+  for (int8_t i = 7; i >= 0; i--)
+  {
+    ctx->Block[ctx->BlockLength++] = (uint8_t)(bitLength >> (8 * i));
+  }
+  Sha256Block(ctx, ctx->Block);
+
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    digest[4 * i] = (uint8_t)(ctx->State[i] >> 24);
+    digest[4 * i + 1] = (uint8_t)(ctx->State[i] >> 16);
+    digest[4 * i + 2] = (uint8_t)(ctx->State[i] >> 8);
+    digest[4 * i + 3] = (uint8_t) ctx->State[i];
+  }
+}
+
+static void Sha256Block(Sha256Context_t *ctx, const uint8_t *block)
+{
+  uint32_t w[16];
+  uint32_t a = ctx->State[0];
+  uint32_t b = ctx->State[1];
+  uint32_t c = ctx->State[2];
+  uint32_t d = ctx->State[3];
+  uint32_t e = ctx->State[4];
+  uint32_t f = ctx->State[5];
+  uint32_t g = ctx->State[6];
+  uint32_t h = ctx->State[7];
+
+  for (uint8_t i = 0; i < 64; i++)
+  {
+    uint32_t t1;
+    uint32_t t2;
+
+    /* Message schedule kept in a 16 word ring */
+    if (i < 16)
+    {
+      w[i] = ((uint32_t) block[4 * i] << 24) | ((uint32_t) block[4 * i + 1] << 16) |
+             ((uint32_t) block[4 * i + 2] << 8) | (uint32_t) block[4 * i + 3];
+    }
+    else
+    {
+      uint32_t w15 = w[(i - 15) & 15];
+      uint32_t w2 = w[(i - 2) & 15];
+
+      w[i & 15] += (ROTR32(w15, 7) ^ ROTR32(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15] +
+                   (ROTR32(w2, 17) ^ ROTR32(w2, 19) ^ (w2 >> 10));
+    }
+
+    t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + Sha256K[i] + w[i & 15];
+    t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  ctx->State[0] += a;
+  ctx->State[1] += b;
+  ctx->State[2] += c;
+  ctx->State[3] += d;
+  ctx->State[4] += e;
+  ctx->State[5] += f;
+  ctx->State[6] += g;
+  ctx->State[7] += h;
+}
@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    DeltaPatch.h
+  * @brief   Applies a delta patch received by FUOTA to the current image
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DELTA_PATCH_H__
+#define __DELTA_PATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+/*!
+ * FragSessionSetupReq descriptor announcing a delta patch instead of a full
+ * image ( "DLT1" )
+ */
+#define DELTA_PATCH_DESCRIPTOR                      0x31544C44UL
+
+/*!
+ * Patch header size
+ *
+ * Patch format ( all integers little endian ):
+ *   Header: magic "DLT1", old image size ( 4 ), new image size ( 4 ),
+ *           body size ( 4 ), SHA-256 of the old image ( 32 ),
+ *           SHA-256 of the new image ( 32 )
+ *   Body:   LZSS stream, see DELTA_PATCH_WINDOW_SIZE, of the commands
+ *           - diff length ( varint ), diff bytes added to the old image bytes
+ *           - extra length ( varint ), bytes copied as they are
+ *           - old image seek ( zig-zag varint )
+ *           repeated until the new image is complete.
+ *
+ * The host side generator is FuotaDelta/fuota_delta.py.
+ */
+#define DELTA_PATCH_HEADER_SIZE                     80
+
+/*!
+ * LZSS window size, part of the patch format. A flag byte announces the next
+ * 8 items LSB first, 1 for a literal byte, 0 for a 2 byte match:
+ * distance - 1 in bits 15:6, length - 3 in bits 5:0. Length 66 is followed by
+ * one more byte added to the length.
+ */
+#define DELTA_PATCH_WINDOW_SIZE                     1024
+
+/*!
+ * Size of the buffer used for each of the patch, old image and new image
+ * streams.
+ *
+ * \remark Memory footprint: DELTA_PATCH_WINDOW_SIZE + 3 * DELTA_PATCH_IO_BUFFER_SIZE
+ *         + about 150 bytes. Must be a multiple of 8 ( flash double-word ).
+ */
+#ifndef DELTA_PATCH_IO_BUFFER_SIZE
+#define DELTA_PATCH_IO_BUFFER_SIZE                  128
+#endif /* DELTA_PATCH_IO_BUFFER_SIZE */
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum eDeltaPatchStatus
+{
+  DELTA_PATCH_SUCCESS = 0,
+  DELTA_PATCH_ERROR_HEADER,     /* Not a patch, or sizes out of range */
+  DELTA_PATCH_ERROR_OLD_IMAGE,  /* The current image is not the one the patch was made for */
+  DELTA_PATCH_ERROR_CORRUPT,    /* Malformed patch body */
+  DELTA_PATCH_ERROR_IO,         /* A callback failed */
+  DELTA_PATCH_ERROR_HASH,       /* The written image does not match the patch */
+} DeltaPatchStatus_t;
+
+typedef struct sDeltaPatchCallbacks
+{
+  /*!
+   * Reads `size` bytes of the received patch at `addr`
+   *
+   * \retval status Read operation status [0: Success, -1 Fail]
+   */
+  uint8_t (*ReadPatch)(uint32_t addr, uint8_t *data, uint32_t size);
+  /*!
+   * Reads `size` bytes of the current image at `addr`
+   *
+   * \retval status Read operation status [0: Success, -1 Fail]
+   */
+  uint8_t (*ReadOld)(uint32_t addr, uint8_t *data, uint32_t size);
+  /*!
+   * Writes `size` bytes of the new image at `addr` ( erased area, sequential )
+   *
+   * \retval status Write operation status [0: Success, -1 Fail]
+   */
+  uint8_t (*WriteNew)(uint32_t addr, uint8_t *data, uint32_t size);
+  /*!
+   * Reads back `size` bytes of the new image at `addr`
+   *
+   * \retval status Read operation status [0: Success, -1 Fail]
+   */
+  uint8_t (*ReadNew)(uint32_t addr, uint8_t *data, uint32_t size);
+} DeltaPatchCallbacks_t;
+
+/* Exported functions ------------------------------------------------------- */
+/*!
+ * Checks the patch header
+ *
+ * \param [in] header     First DELTA_PATCH_HEADER_SIZE bytes of the received file
+ * \param [in] patchSize  Received file size
+ * \param [in] maxNewSize Space available for the new image
+ *
+ * \retval isValid        True if the file is a patch which fits
+ */
+bool DeltaPatchCheckHeader(const uint8_t *header, uint32_t patchSize, uint32_t maxNewSize);
+
+/*!
+ * Rebuilds the new image from the current image and the received patch.
+ * The current image hash is checked before anything is written and the new
+ * image is read back and checked against its hash at the end.
+ *
+ * \param [in]  patchSize  Received file size
+ * \param [in]  maxNewSize Space available for the new image
+ * \param [in]  callbacks  Flash access callbacks
+ * \param [out] newSize    Size of the new image
+ *
+ * \retval status          DELTA_PATCH_SUCCESS once the new image is verified
+ */
+DeltaPatchStatus_t DeltaPatchApply(uint32_t patchSize, uint32_t maxNewSize, DeltaPatchCallbacks_t *callbacks,
+                                   uint32_t *newSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DELTA_PATCH_H__ */
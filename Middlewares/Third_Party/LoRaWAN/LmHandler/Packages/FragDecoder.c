@@ -33,26 +33,68 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdbool.h>
 #include "mw_log_conf.h"   /* needed for MW_LOG */
+#include "stm32_mem.h"
 #include "FragDecoder.h"
 #include "sfu_fwimg_regions.h"
 
+/* Private define ------------------------------------------------------------*/
+/*!
+ * Bit arrays are stored in 32-bit words, bit index 0 is the MSB of word 0
+ */
+#define BIT_ARRAY_WORDS(bits)                       ( ( ( bits ) >> 5 ) + 1 )
+
+/*!
+ * Number of bits of the upper triangular matrix M2B
+ */
+#define M2B_BITS                                    ( ( FRAG_MAX_REDUNDANCY * ( FRAG_MAX_REDUNDANCY + 1 ) ) >> 1 )
+
 /* Private typedef -----------------------------------------------------------*/
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+typedef struct {
+	uint16_t Row;
+	uint8_t Valid;
+	uint8_t Dirty;
+	uint32_t LastUse;
+} FragRowCacheEntry_t;
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
+
+#if (FRAG_PARITY_ROW_CACHE_NB_ROWS > 0)
+typedef struct {
+	uint16_t N;
+	uint16_t M; /* 0: entry not used */
+	uint32_t Row[BIT_ARRAY_WORDS(FRAG_MAX_NB)];
+} FragParityRowCacheEntry_t;
+#endif /* FRAG_PARITY_ROW_CACHE_NB_ROWS > 0 */
+
 typedef struct {
 	FragDecoderCallbacks_t *Callbacks;
 	uint16_t FragNb;
 	uint8_t FragSize;
 
 	uint32_t M2BLine;
-	uint8_t MatrixM2B[((FRAG_MAX_REDUNDANCY >> 3) + 1) * FRAG_MAX_REDUNDANCY];
+	/* Rows packed back to back, one spare word for unaligned word access */
+	uint32_t MatrixM2B[BIT_ARRAY_WORDS(M2B_BITS) + 1];
 	uint16_t FragNbMissingIndex[FRAG_MAX_NB];
+	/* Inverse of FragNbMissingIndex: fragment index of the x th missing frag */
+	uint16_t FragMissingIndexToFrag[FRAG_MAX_REDUNDANCY];
+
+	uint32_t S[BIT_ARRAY_WORDS(FRAG_MAX_REDUNDANCY)];
 
-	uint8_t S[(FRAG_MAX_REDUNDANCY >> 3) + 1];
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+	/* Entry i holds its row at RowCacheData[i * FragSize] */
+	FragRowCacheEntry_t RowCache[FRAG_ROW_CACHE_NB_ROWS];
+	uint8_t RowCacheData[FRAG_ROW_CACHE_NB_ROWS * FRAG_MAX_SIZE];
+	uint32_t RowCacheUseCounter;
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
 
 	FragDecoderStatus_t Status;
 } FragDecoder_t;
 
-/* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+/*!
+ * Mask of the bit at the given index within its bit array word
+ */
+#define BIT_MASK(index)                             ( 0x80000000UL >> ( ( index ) & 31 ) )
 /* Private function prototypes -----------------------------------------------*/
 /*!
  * \brief Sets a row from source into file destination
@@ -72,6 +114,39 @@ static void SetRow(uint8_t *src, uint16_t row, uint16_t size);
  */
 static void GetRow(uint8_t *src, uint16_t row, uint16_t size);
 
+/*!
+ * \brief Decodes one received frame, see FragDecoderProcess()
+ *
+ * \param [in] fragCounter Fragment counter
+ * \param [in] rawData     Pointer to the fragment to be processed
+ *
+ * \retval status          Process status
+ */
+static int32_t FragDecoderProcessFrame(uint16_t fragCounter, uint8_t *rawData);
+
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+/*!
+ * \brief Gets the row cache entry holding a row
+ *
+ * \param [in] row  Row index
+ * \retval index    Entry index, -1 if the row is not cached
+ */
+static int32_t FragRowCacheFind(uint16_t row);
+
+/*!
+ * \brief Gets a free entry for a row, evicts the least recently used one
+ *
+ * \param [in] row  Row index
+ * \retval index    Entry index
+ */
+static int32_t FragRowCacheAlloc(uint16_t row);
+
+/*!
+ * \brief Writes all pending rows, consecutive rows with a single Write call
+ */
+static void FragRowCacheFlush(void);
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
+
 /*!
  * \brief Gets the parity value from a given row of the parity matrix
  *
@@ -80,7 +155,7 @@ static void GetRow(uint8_t *src, uint16_t row, uint16_t size);
  *
  * \retval parity         Parity value at the given index
  */
-static uint8_t GetParity(uint16_t index, uint8_t *matrixRow);
+static uint8_t GetParity(uint16_t index, uint32_t *matrixRow);
 
 /*!
  * \brief Sets the parity value on the given row of the parity matrix
@@ -89,7 +164,7 @@ static uint8_t GetParity(uint16_t index, uint8_t *matrixRow);
  * \param [IN/OUT] matrixRow Pointer to the parity matrix.
  * \param [in]     parity    The parity value to be set in the parity matrix
  */
-static void SetParity(uint16_t index, uint8_t *matrixRow, uint8_t parity);
+static void SetParity(uint16_t index, uint32_t *matrixRow, uint8_t parity);
 
 /*!
  * \brief Check if the provided value is a power of 2
@@ -120,7 +195,7 @@ static void XorDataLine(uint8_t *line1, uint8_t *line2, int32_t size);
  *
  * \param [out] result XOR( line1, line2 ) result stored in line1
  */
-static void XorParityLine(uint8_t *line1, uint8_t *line2, int32_t size);
+static void XorParityLine(uint32_t *line1, uint32_t *line2, int32_t size);
 
 /*!
  * \brief Generates a pseudo random number : PRBS23
@@ -138,7 +213,7 @@ static int32_t FragPrbs23(int32_t value);
  * \param [in]  m         Fragment number
  * \param [out] matrixRow Parity matrix
  */
-static void FragGetParityMatrixRow(int32_t n, int32_t m, uint8_t *matrixRow);
+static void FragGetParityMatrixRow(int32_t n, int32_t m, uint32_t *matrixRow);
 
 /*!
  * \brief Finds the index of the first one in a bit array
@@ -147,7 +222,7 @@ static void FragGetParityMatrixRow(int32_t n, int32_t m, uint8_t *matrixRow);
  * \param [in] size     Bit array size
  * \retval index        The index of the first 1 in the bit array
  */
-static uint16_t BitArrayFindFirstOne(uint8_t *bitArray, uint16_t size);
+static uint16_t BitArrayFindFirstOne(uint32_t *bitArray, uint16_t size);
 
 /*!
  * \brief Checks if the provided bit array only contains zeros
@@ -156,7 +231,33 @@ static uint16_t BitArrayFindFirstOne(uint8_t *bitArray, uint16_t size);
  * \param [in] size     Bit array size
  * \retval isAllZeros   [0: Contains ones, 1: Contains all zeros]
  */
-static uint8_t BitArrayIsAllZeros(uint8_t *bitArray, uint16_t size);
+static uint8_t BitArrayIsAllZeros(uint32_t *bitArray, uint16_t size);
+
+/*!
+ * \brief Gets the mask of the valid bits of one word of a bit array
+ *
+ * \param [in] size     Bit array size
+ * \param [in] word     Word index
+ * \retval mask         Bits of the word below size
+ */
+static uint32_t BitArrayWordMask(uint16_t size, uint16_t word);
+
+/*!
+ * \brief Counts the leading zero bits of a word (CLZ)
+ *
+ * \param [in] value    Word, not 0
+ * \retval count        Index of the first one
+ */
+static uint8_t CountLeadingZeros(uint32_t value);
+
+/*!
+ * \brief Gets the bit offset of a row in the packed matrix M2B
+ *
+ * \param [in] rowIndex  Matrix row index
+ * \param [in] bitsInRow Number of bits in one row
+ * \retval offset        Offset of the row diagonal element
+ */
+static uint32_t FragGetM2BRowOffset(uint16_t rowIndex, uint16_t bitsInRow);
 
 /*!
  * \brief Finds & marks missing fragments
@@ -182,7 +283,7 @@ static uint16_t FragFindMissingIndex(uint16_t x);
  * \param [in] rowIndex  Matrix row index
  * \param [in] bitsInRow Number of bits in one row
  */
-static void FragExtractLineFromBinaryMatrix(uint8_t *bitArray,
+static void FragExtractLineFromBinaryMatrix(uint32_t *bitArray,
 		uint16_t rowIndex, uint16_t bitsInRow);
 
 /*!
@@ -192,12 +293,19 @@ static void FragExtractLineFromBinaryMatrix(uint8_t *bitArray,
  * \param [in] rowIndex  Matrix row index
  * \param [in] bitsInRow Number of bits in one row
  */
-static void FragPushLineToBinaryMatrix(uint8_t *bitArray, uint16_t rowIndex,
+static void FragPushLineToBinaryMatrix(uint32_t *bitArray, uint16_t rowIndex,
 		uint16_t bitsInRow);
 
 /* Private variables ---------------------------------------------------------*/
 static FragDecoder_t FragDecoder;
 
+#if (FRAG_PARITY_ROW_CACHE_NB_ROWS > 0)
+/*
+ * Parity rows depend on ( n, m ) only, they are kept across sessions
+ */
+static FragParityRowCacheEntry_t FragParityRowCache[FRAG_PARITY_ROW_CACHE_NB_ROWS];
+#endif /* FRAG_PARITY_ROW_CACHE_NB_ROWS > 0 */
+
 /* Exported functions ---------------------------------------------------------*/
 void FragDecoderInit(uint16_t fragNb, uint8_t fragSize,
 		FragDecoderCallbacks_t *callbacks) {
@@ -211,19 +319,26 @@ void FragDecoderInit(uint16_t fragNb, uint8_t fragSize,
 	FragDecoder.Status.FragNbLost = 0;
 	FragDecoder.M2BLine = 0;
 
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+	for (uint32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS; i++) {
+		FragDecoder.RowCache[i].Valid = 0;
+		FragDecoder.RowCache[i].Dirty = 0;
+	}
+	FragDecoder.RowCacheUseCounter = 0;
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
+
 	/* Initialize missing fragments index array */
 	for (uint16_t i = 0; i < FRAG_MAX_NB; i++) {
 		FragDecoder.FragNbMissingIndex[i] = 1;
 	}
 
 	/* Initialize parity matrix */
-	for (uint32_t i = 0; i < ((FRAG_MAX_REDUNDANCY >> 3) + 1); i++) {
+	for (uint32_t i = 0; i < BIT_ARRAY_WORDS(FRAG_MAX_REDUNDANCY); i++) {
 		FragDecoder.S[i] = 0;
 	}
 
-	for (uint32_t i = 0;
-			i < (((FRAG_MAX_REDUNDANCY >> 3) + 1) * FRAG_MAX_REDUNDANCY); i++) {
-		FragDecoder.MatrixM2B[i] = 0xFF;
+	for (uint32_t i = 0; i < (BIT_ARRAY_WORDS(M2B_BITS) + 1); i++) {
+		FragDecoder.MatrixM2B[i] = 0xFFFFFFFFUL;
 	}
 
 	/* Initialize final uncoded data buffer ( FRAG_MAX_NB * FRAG_MAX_SIZE ) */
@@ -243,23 +358,41 @@ uint32_t FragDecoderGetMaxFileSize(void) {
 }
 
 int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData) {
+	int32_t status = FragDecoderProcessFrame(fragCounter, rawData);
+
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+	if (status != FRAG_SESSION_ONGOING) {
+		/* The file is complete or the session gave up: write pending rows */
+		FragRowCacheFlush();
+	}
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
+	return status;
+}
+
+FragDecoderStatus_t FragDecoderGetStatus(void) {
+	return FragDecoder.Status;
+}
+
+/* Private  functions ---------------------------------------------------------*/
+static int32_t FragDecoderProcessFrame(uint16_t fragCounter, uint8_t *rawData) {
 	uint16_t firstOneInRow = 0;
 	int32_t first = 0;
 	int32_t noInfo = 0;
 
-	uint8_t matrixRow[(FRAG_MAX_NB >> 3) + 1];
-	uint8_t matrixDataTemp[FRAG_MAX_SIZE];
-	uint8_t dataTempVector[(FRAG_MAX_REDUNDANCY >> 3) + 1];
-	uint8_t dataTempVector2[(FRAG_MAX_REDUNDANCY >> 3) + 1];
+	uint32_t matrixRow[BIT_ARRAY_WORDS(FRAG_MAX_NB)];
+	uint32_t matrixDataWords[(FRAG_MAX_SIZE + 3) >> 2];
+	uint8_t *matrixDataTemp = (uint8_t *) matrixDataWords;
+	uint32_t dataTempVector[BIT_ARRAY_WORDS(FRAG_MAX_REDUNDANCY)];
+	uint32_t dataTempVector2[BIT_ARRAY_WORDS(FRAG_MAX_REDUNDANCY)];
 
-	UTIL_MEM_set_8(matrixRow, 0, (FRAG_MAX_NB >> 3) + 1);
-	UTIL_MEM_set_8(matrixDataTemp, 0, FRAG_MAX_SIZE);
-	UTIL_MEM_set_8(dataTempVector, 0, (FRAG_MAX_REDUNDANCY >> 3) + 1);
-	UTIL_MEM_set_8(dataTempVector2, 0, (FRAG_MAX_REDUNDANCY >> 3) + 1);
+	UTIL_MEM_set_8(matrixRow, 0, sizeof(matrixRow));
+	UTIL_MEM_set_8(matrixDataWords, 0, sizeof(matrixDataWords));
+	UTIL_MEM_set_8(dataTempVector, 0, sizeof(dataTempVector));
+	UTIL_MEM_set_8(dataTempVector2, 0, sizeof(dataTempVector2));
 
 	FragDecoder.Status.FragNbRx = fragCounter;
 
-	if (fragCounter < FragDecoder.Status.FragNbLastRx) {
+	if ((fragCounter == 0) || (fragCounter < FragDecoder.Status.FragNbLastRx)) {
 		return FRAG_SESSION_ONGOING ; /* Drop frame out of order */
 	}
 
@@ -274,16 +407,18 @@ int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData) {
 		/* Update the FragDecoder.FragNbMissingIndex with the losing frame */
 		FragFindMissingFrags(fragCounter);
 	} else {
-		if (FragDecoder.Status.FragNbLost > FRAG_MAX_REDUNDANCY) {
-			FragDecoder.Status.MatrixError = 1;
-			return FRAG_SESSION_FINISHED ;
-		}
 		/* At this point we receive encoded frames and the number of losing frames */
 		/* is well known: FragDecoder.FragNbLost - 1; */
 
 		/* In case of the end of true data is missing */
 		FragFindMissingFrags(fragCounter);
 
+		/* Checked after the update: the parity vectors hold FRAG_MAX_REDUNDANCY bits */
+		if (FragDecoder.Status.FragNbLost > FRAG_MAX_REDUNDANCY) {
+			FragDecoder.Status.MatrixError = 1;
+			return FRAG_SESSION_FINISHED ;
+		}
+
 		if (FragDecoder.Status.FragNbLost == 0) {
 			/* the case : all the M(FragNb) first rows have been transmitted with no error */
 			return FragDecoder.Status.FragNbLost;
@@ -293,11 +428,16 @@ int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData) {
 		FragGetParityMatrixRow(fragCounter - FragDecoder.FragNb,
 				FragDecoder.FragNb, matrixRow);
 
-		for (int32_t i = 0; i < FragDecoder.FragNb; i++) {
-			if (GetParity(i, matrixRow) == 1) {
+		/* Visit the set bits of the parity row only */
+		for (uint16_t w = 0; (w << 5) < FragDecoder.FragNb; w++) {
+			uint32_t bits = matrixRow[w] & BitArrayWordMask(FragDecoder.FragNb, w);
+
+			while (bits != 0) {
+				uint16_t i = (w << 5) + CountLeadingZeros(bits);
+				bits &= ~BIT_MASK(i);
+
 				if (FragDecoder.FragNbMissingIndex[i] == 0) {
 					/* XOR with already receive frag */
-					SetParity(i, matrixRow, 0);
 					GetRow(matrixDataTemp, i, FragDecoder.FragSize);
 					XorDataLine(rawData, matrixDataTemp, FragDecoder.FragSize);
 				} else {
@@ -356,16 +496,12 @@ int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData) {
 					for (i = (FragDecoder.Status.FragNbLost - 2); i >= 0; i--) {
 						li = FragFindMissingIndex(i);
 						GetRow(matrixDataTemp, li, FragDecoder.FragSize);
+						/* Rows below i are already solved: only the ones of row i matter */
+						FragExtractLineFromBinaryMatrix(dataTempVector2, i,
+								FragDecoder.Status.FragNbLost);
 						for (j = (FragDecoder.Status.FragNbLost - 1); j > i;
 								j--) {
-							FragExtractLineFromBinaryMatrix(dataTempVector2, i,
-									FragDecoder.Status.FragNbLost);
-							FragExtractLineFromBinaryMatrix(dataTempVector, j,
-									FragDecoder.Status.FragNbLost);
 							if (GetParity(j, dataTempVector2) == 1) {
-								XorParityLine(dataTempVector2, dataTempVector,
-										FragDecoder.Status.FragNbLost);
-
 								lj = FragFindMissingIndex(j);
 
 								GetRow(rawData, lj, FragDecoder.FragSize);
@@ -386,59 +522,182 @@ int32_t FragDecoderProcess(uint16_t fragCounter, uint8_t *rawData) {
 	return FRAG_SESSION_ONGOING ;
 }
 
-FragDecoderStatus_t FragDecoderGetStatus(void) {
-	return FragDecoder.Status;
-}
-
-/* Private  functions ---------------------------------------------------------*/
 static void SetRow(uint8_t *src, uint16_t row, uint16_t size) {
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+	int32_t entry = FragRowCacheFind(row);
+
+	if (entry < 0) {
+		entry = FragRowCacheAlloc(row);
+	}
+	UTIL_MEM_cpy_8(&FragDecoder.RowCacheData[entry * size], src, size);
+	FragDecoder.RowCache[entry].Dirty = 1;
+	FragDecoder.RowCache[entry].LastUse = ++FragDecoder.RowCacheUseCounter;
+#else /* FRAG_ROW_CACHE_NB_ROWS == 0 */
 	if ((FragDecoder.Callbacks != NULL)
 			&& (FragDecoder.Callbacks->FragDecoderWrite != NULL)) {
 		FragDecoder.Callbacks->FragDecoderWrite(row * size, src, size);
 	}
+#endif /* FRAG_ROW_CACHE_NB_ROWS */
 }
 
 static void GetRow(uint8_t *dst, uint16_t row, uint16_t size) {
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+	int32_t entry = FragRowCacheFind(row);
+
+	/* Reads do not allocate: they must not evict rows waiting to be written */
+	if (entry >= 0) {
+		UTIL_MEM_cpy_8(dst, &FragDecoder.RowCacheData[entry * size], size);
+		FragDecoder.RowCache[entry].LastUse = ++FragDecoder.RowCacheUseCounter;
+		return;
+	}
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
 	if ((FragDecoder.Callbacks != NULL)
 			&& (FragDecoder.Callbacks->FragDecoderRead != NULL)) {
 		FragDecoder.Callbacks->FragDecoderRead(row * size, dst, size);
 	}
 }
 
-static uint8_t GetParity(uint16_t index, uint8_t *matrixRow) {
-	uint8_t parity;
-	parity = matrixRow[index >> 3];
-	parity = (parity >> (7 - (index % 8))) & 0x01;
-	return parity;
+#if (FRAG_ROW_CACHE_NB_ROWS > 0)
+static int32_t FragRowCacheFind(uint16_t row) {
+	for (int32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS; i++) {
+		if ((FragDecoder.RowCache[i].Valid != 0)
+				&& (FragDecoder.RowCache[i].Row == row)) {
+			return i;
+		}
+	}
+	return -1;
 }
 
-static void SetParity(uint16_t index, uint8_t *matrixRow, uint8_t parity) {
-	uint8_t mask = 0xFF - (1 << (7 - (index % 8)));
-	parity = parity << (7 - (index % 8));
-	matrixRow[index >> 3] = (matrixRow[index >> 3] & mask) + parity;
+static int32_t FragRowCacheAlloc(uint16_t row) {
+	int32_t entry = 0;
+
+	for (int32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS; i++) {
+		if (FragDecoder.RowCache[i].Valid == 0) {
+			entry = i;
+			break;
+		}
+		if (FragDecoder.RowCache[i].LastUse
+				< FragDecoder.RowCache[entry].LastUse) {
+			entry = i;
+		}
+	}
+
+	if ((FragDecoder.RowCache[entry].Valid != 0)
+			&& (FragDecoder.RowCache[entry].Dirty != 0)) {
+		/* Write everything pending at once, which coalesces consecutive rows */
+		FragRowCacheFlush();
+		/* The flush sorts the entries, the victim is the LRU entry again */
+		for (int32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS; i++) {
+			if (FragDecoder.RowCache[i].LastUse
+					< FragDecoder.RowCache[entry].LastUse) {
+				entry = i;
+			}
+		}
+	}
+
+	FragDecoder.RowCache[entry].Row = row;
+	FragDecoder.RowCache[entry].Valid = 1;
+	FragDecoder.RowCache[entry].Dirty = 0;
+	return entry;
 }
 
-static bool IsPowerOfTwo(uint32_t x) {
-	uint8_t sumBit = 0;
+static void FragRowCacheFlush(void) {
+	uint16_t size = FragDecoder.FragSize;
 
-	for (uint8_t i = 0; i < 32; i++) {
-		sumBit += (x & (1 << i)) >> i;
+	/* Sort the entries by row so that consecutive rows are adjacent in RAM */
+	for (int32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS - 1; i++) {
+		int32_t min = i;
+
+		for (int32_t j = i + 1; j < FRAG_ROW_CACHE_NB_ROWS; j++) {
+			if ((FragDecoder.RowCache[j].Valid != 0)
+					&& ((FragDecoder.RowCache[min].Valid == 0)
+							|| (FragDecoder.RowCache[j].Row
+									< FragDecoder.RowCache[min].Row))) {
+				min = j;
+			}
+		}
+		if (min != i) {
+			FragRowCacheEntry_t entry = FragDecoder.RowCache[i];
+			uint8_t *a = &FragDecoder.RowCacheData[i * size];
+			uint8_t *b = &FragDecoder.RowCacheData[min * size];
+
+			FragDecoder.RowCache[i] = FragDecoder.RowCache[min];
+			FragDecoder.RowCache[min] = entry;
+			for (uint16_t k = 0; k < size; k++) {
+				uint8_t tmp = a[k];
+				a[k] = b[k];
+				b[k] = tmp;
+			}
+		}
+	}
+
+	/* Write runs of dirty consecutive rows */
+	for (int32_t i = 0; i < FRAG_ROW_CACHE_NB_ROWS;) {
+		int32_t run = 1;
+
+		if ((FragDecoder.RowCache[i].Valid == 0)
+				|| (FragDecoder.RowCache[i].Dirty == 0)) {
+			i++;
+			continue;
+		}
+		while (((i + run) < FRAG_ROW_CACHE_NB_ROWS)
+				&& (FragDecoder.RowCache[i + run].Valid != 0)
+				&& (FragDecoder.RowCache[i + run].Dirty != 0)
+				&& (FragDecoder.RowCache[i + run].Row
+						== (FragDecoder.RowCache[i].Row + run))) {
+			run++;
+		}
+
+		if ((FragDecoder.Callbacks != NULL)
+				&& (FragDecoder.Callbacks->FragDecoderWrite != NULL)) {
+			FragDecoder.Callbacks->FragDecoderWrite(
+					FragDecoder.RowCache[i].Row * size,
+					&FragDecoder.RowCacheData[i * size], run * size);
+		}
+		for (int32_t k = i; k < (i + run); k++) {
+			FragDecoder.RowCache[k].Dirty = 0;
+		}
+		i += run;
 	}
-	if (sumBit == 1) {
-		return true;
+}
+#endif /* FRAG_ROW_CACHE_NB_ROWS > 0 */
+
+static uint8_t GetParity(uint16_t index, uint32_t *matrixRow) {
+	return (matrixRow[index >> 5] & BIT_MASK(index)) != 0 ? 1 : 0;
+}
+
+static void SetParity(uint16_t index, uint32_t *matrixRow, uint8_t parity) {
+	if (parity != 0) {
+		matrixRow[index >> 5] |= BIT_MASK(index);
+	} else {
+		matrixRow[index >> 5] &= ~BIT_MASK(index);
 	}
-	return false;
+}
+
+static bool IsPowerOfTwo(uint32_t x) {
+	return (x != 0) && ((x & (x - 1)) == 0);
 }
 
 static void XorDataLine(uint8_t *line1, uint8_t *line2, int32_t size) {
-	for (int32_t i = 0; i < size; i++) {
+	int32_t i = 0;
+
+	if ((((uintptr_t) line1 | (uintptr_t) line2) & 3UL) == 0) {
+		uint32_t *words1 = (uint32_t *) line1;
+		uint32_t *words2 = (uint32_t *) line2;
+
+		for (; (i + 4) <= size; i += 4) {
+			*words1++ ^= *words2++;
+		}
+	}
+	for (; i < size; i++) {
 		line1[i] = line1[i] ^ line2[i];
 	}
 }
 
-static void XorParityLine(uint8_t *line1, uint8_t *line2, int32_t size) {
-	for (int32_t i = 0; i < size; i++) {
-		SetParity(i, line1, (GetParity(i, line1) ^ GetParity(i, line2)));
+static void XorParityLine(uint32_t *line1, uint32_t *line2, int32_t size) {
+	/* Bits at and above size are 0 in both lines */
+	for (int32_t w = 0; (w << 5) < size; w++) {
+		line1[w] ^= line2[w];
 	}
 }
 
@@ -448,11 +707,20 @@ static int32_t FragPrbs23(int32_t value) {
 	return (value >> 1) + ((b0 ^ b1) << 22);;
 }
 
-static void FragGetParityMatrixRow(int32_t n, int32_t m, uint8_t *matrixRow) {
+static void FragGetParityMatrixRow(int32_t n, int32_t m, uint32_t *matrixRow) {
 	int32_t mTemp;
 	int32_t x;
 	int32_t nbCoeff = 0;
 	int32_t r;
+#if (FRAG_PARITY_ROW_CACHE_NB_ROWS > 0)
+	FragParityRowCacheEntry_t *entry =
+			&FragParityRowCache[(n - 1) % FRAG_PARITY_ROW_CACHE_NB_ROWS];
+
+	if ((entry->N == n) && (entry->M == m)) {
+		UTIL_MEM_cpy_8(matrixRow, entry->Row, BIT_ARRAY_WORDS(m) * 4);
+		return;
+	}
+#endif /* FRAG_PARITY_ROW_CACHE_NB_ROWS > 0 */
 
 	if (IsPowerOfTwo(m) != false) {
 		mTemp = 1;
@@ -461,7 +729,7 @@ static void FragGetParityMatrixRow(int32_t n, int32_t m, uint8_t *matrixRow) {
 	}
 
 	x = 1 + (1001 * n);
-	for (uint8_t i = 0; i < ((m >> 3) + 1); i++) {
+	for (uint16_t i = 0; i < BIT_ARRAY_WORDS(m); i++) {
 		matrixRow[i] = 0;
 	}
 	while (nbCoeff < (m >> 1)) {
@@ -473,20 +741,51 @@ static void FragGetParityMatrixRow(int32_t n, int32_t m, uint8_t *matrixRow) {
 		SetParity(r, matrixRow, 1);
 		nbCoeff += 1;
 	}
+#if (FRAG_PARITY_ROW_CACHE_NB_ROWS > 0)
+	entry->N = n;
+	entry->M = m;
+	UTIL_MEM_cpy_8(entry->Row, matrixRow, BIT_ARRAY_WORDS(m) * 4);
+#endif /* FRAG_PARITY_ROW_CACHE_NB_ROWS > 0 */
 }
 
-static uint16_t BitArrayFindFirstOne(uint8_t *bitArray, uint16_t size) {
-	for (uint16_t i = 0; i < size; i++) {
-		if (GetParity(i, bitArray) == 1) {
-			return i;
+static uint32_t BitArrayWordMask(uint16_t size, uint16_t word) {
+	if (((uint32_t) word << 5) + 32 <= size) {
+		return 0xFFFFFFFFUL;
+	}
+	if (((uint32_t) word << 5) >= size) {
+		return 0;
+	}
+	return ~(0xFFFFFFFFUL >> (size & 31));
+}
+
+static uint8_t CountLeadingZeros(uint32_t value) {
+#if defined(__GNUC__)
+	return (uint8_t) __builtin_clz(value);
+#else
+	uint8_t count = 0;
+
+	while ((value & 0x80000000UL) == 0) {
+		value <<= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+static uint16_t BitArrayFindFirstOne(uint32_t *bitArray, uint16_t size) {
+	for (uint16_t w = 0; (w << 5) < size; w++) {
+		uint32_t bits = bitArray[w] & BitArrayWordMask(size, w);
+
+		if (bits != 0) {
+			return (w << 5) + CountLeadingZeros(bits);
 		}
 	}
 	return 0;
 }
 
-static uint8_t BitArrayIsAllZeros(uint8_t *bitArray, uint16_t size) {
-	for (uint16_t i = 0; i < size; i++) {
-		if (GetParity(i, bitArray) == 1) {
+static uint8_t BitArrayIsAllZeros(uint32_t *bitArray, uint16_t size) {
+	for (uint16_t w = 0; (w << 5) < size; w++) {
+		if ((bitArray[w] & BitArrayWordMask(size, w)) != 0) {
 			return 0;
 		}
 	}
@@ -499,6 +798,9 @@ static void FragFindMissingFrags(uint16_t counter) {
 		if (i < FragDecoder.FragNb) {
 			FragDecoder.Status.FragNbLost++;
 			FragDecoder.FragNbMissingIndex[i] = FragDecoder.Status.FragNbLost;
+			if (FragDecoder.Status.FragNbLost <= FRAG_MAX_REDUNDANCY) {
+				FragDecoder.FragMissingIndexToFrag[FragDecoder.Status.FragNbLost - 1] = i;
+			}
 		}
 	}
 	if (i < FragDecoder.FragNb) {
@@ -516,6 +818,9 @@ static void FragFindMissingFrags(uint16_t counter) {
 }
 
 static uint16_t FragFindMissingIndex(uint16_t x) {
+	if ((x < FragDecoder.Status.FragNbLost) && (x < FRAG_MAX_REDUNDANCY)) {
+		return FragDecoder.FragMissingIndexToFrag[x];
+	}
 	for (uint16_t i = 0; i < FragDecoder.FragNb; i++) {
 		if (FragDecoder.FragNbMissingIndex[i] == (x + 1)) {
 			return i;
@@ -524,56 +829,52 @@ static uint16_t FragFindMissingIndex(uint16_t x) {
 	return 0;
 }
 
-static void FragExtractLineFromBinaryMatrix(uint8_t *bitArray,
+static uint32_t FragGetM2BRowOffset(uint16_t rowIndex, uint16_t bitsInRow) {
+	/* Row i holds the bits i..bitsInRow-1, rows are packed back to back */
+	return ((uint32_t) rowIndex * bitsInRow)
+			- (((uint32_t) rowIndex * (rowIndex - 1)) >> 1);
+}
+
+static void FragExtractLineFromBinaryMatrix(uint32_t *bitArray,
 		uint16_t rowIndex, uint16_t bitsInRow) {
-	uint32_t findByte = 0;
-	uint32_t findBitInByte = 0;
-
-	if (rowIndex > 0) {
-		findByte = (rowIndex * bitsInRow - ((rowIndex * (rowIndex - 1)) >> 1))
-				>> 3;
-		findBitInByte = (rowIndex * bitsInRow
-				- ((rowIndex * (rowIndex - 1)) >> 1)) % 8;
-	}
-	if (rowIndex > 0) {
-		for (uint16_t i = 0; i < rowIndex; i++) {
-			SetParity(i, bitArray, 0);
+	/* Bit i of the line is bit (i + shift) of the packed matrix */
+	uint32_t shift = FragGetM2BRowOffset(rowIndex, bitsInRow) - rowIndex;
+
+	for (uint16_t w = 0; (w << 5) < bitsInRow; w++) {
+		uint32_t src = ((uint32_t) w << 5) + shift;
+		uint32_t bits = FragDecoder.MatrixM2B[src >> 5] << (src & 31);
+
+		if ((src & 31) != 0) {
+			bits |= FragDecoder.MatrixM2B[(src >> 5) + 1] >> (32 - (src & 31));
 		}
-	}
-	for (uint16_t i = rowIndex; i < bitsInRow; i++) {
-		SetParity(i, bitArray,
-				(FragDecoder.MatrixM2B[findByte] >> (7 - findBitInByte))
-						& 0x01);
 
-		findBitInByte++;
-		if (findBitInByte == 8) {
-			findBitInByte = 0;
-			findByte++;
+		/* Bits left of the diagonal and right of the row end are 0 */
+		bits &= BitArrayWordMask(bitsInRow, w);
+		if (((uint32_t) w << 5) + 32 <= rowIndex) {
+			bits = 0;
+		} else if (((uint32_t) w << 5) < rowIndex) {
+			bits &= 0xFFFFFFFFUL >> (rowIndex & 31);
 		}
+		bitArray[w] = bits;
 	}
 }
 
-static void FragPushLineToBinaryMatrix(uint8_t *bitArray, uint16_t rowIndex,
+static void FragPushLineToBinaryMatrix(uint32_t *bitArray, uint16_t rowIndex,
 		uint16_t bitsInRow) {
-	uint32_t findByte = 0;
-	uint32_t findBitInByte = 0;
+	/* The matrix is initialized with ones, clear the zeros of the row */
+	uint32_t shift = FragGetM2BRowOffset(rowIndex, bitsInRow) - rowIndex;
 
-	if (rowIndex > 0) {
-		findByte = (rowIndex * bitsInRow - ((rowIndex * (rowIndex - 1)) >> 1))
-				>> 3;
-		findBitInByte = (rowIndex * bitsInRow
-				- ((rowIndex * (rowIndex - 1)) >> 1)) % 8;
+	for (uint16_t w = (rowIndex >> 5); (w << 5) < bitsInRow; w++) {
+		uint32_t zeros = ~bitArray[w] & BitArrayWordMask(bitsInRow, w);
+		uint32_t dst = ((uint32_t) w << 5) + shift;
 
-	}
-	for (uint16_t i = rowIndex; i < bitsInRow; i++) {
-		if (GetParity(i, bitArray) == 0) {
-			FragDecoder.MatrixM2B[findByte] = FragDecoder.MatrixM2B[findByte]
-					& (0xFF - (1 << (7 - findBitInByte)));
+		if (((uint32_t) w << 5) < rowIndex) {
+			zeros &= 0xFFFFFFFFUL >> (rowIndex & 31);
 		}
-		findBitInByte++;
-		if (findBitInByte == 8) {
-			findBitInByte = 0;
-			findByte++;
+
+		FragDecoder.MatrixM2B[dst >> 5] &= ~(zeros >> (dst & 31));
+		if ((dst & 31) != 0) {
+			FragDecoder.MatrixM2B[(dst >> 5) + 1] &= ~(zeros << (32 - (dst & 31)));
 		}
 	}
 }
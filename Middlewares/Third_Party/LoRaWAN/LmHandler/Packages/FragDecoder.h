@@ -87,6 +87,31 @@ extern "C" {
 #define FRAG_MAX_REDUNDANCY                         40
 #endif /* INTEROP_TEST_MODE */
 
+/*!
+ * Number of rows kept in RAM between the decoder and the Write/Read callbacks.
+ * Row writes are deferred, runs of consecutive rows are written with a single
+ * Write call, and reads of a cached row skip the Read callback. Pending rows
+ * are written when the session finishes.
+ *
+ * \remark Memory footprint: FRAG_ROW_CACHE_NB_ROWS * ( FRAG_MAX_SIZE + 8 ) bytes,
+ *         0 disables the cache.
+ */
+#ifndef FRAG_ROW_CACHE_NB_ROWS
+#define FRAG_ROW_CACHE_NB_ROWS                      8
+#endif /* FRAG_ROW_CACHE_NB_ROWS */
+
+/*!
+ * Number of parity matrix rows kept in RAM. A row only depends on the coded
+ * fragment number and on the number of fragments, cached rows are reused when
+ * the same file is sent again, e.g. in a new session after a failed one.
+ *
+ * \remark Memory footprint: FRAG_PARITY_ROW_CACHE_NB_ROWS * ( ( FRAG_MAX_NB / 32 + 1 ) * 4 + 4 )
+ *         bytes, 0 disables the cache.
+ */
+#ifndef FRAG_PARITY_ROW_CACHE_NB_ROWS
+#define FRAG_PARITY_ROW_CACHE_NB_ROWS               0
+#endif /* FRAG_PARITY_ROW_CACHE_NB_ROWS */
+
 #define FRAG_SESSION_FINISHED                       ( int32_t )0
 #define FRAG_SESSION_NOT_STARTED                    ( int32_t )-2
 #define FRAG_SESSION_ONGOING                        ( int32_t )-1
@@ -23,6 +23,7 @@
 #include "LmhpRemoteMcastSetup.h"
 #include "LmhpFragmentation.h"
 #include "LmhpFirmwareManagement.h"
+#include "DeltaPatch.h"
 #include "LmHandler.h"
 #include "mw_log_conf.h"
 #include "utilities.h"
@@ -138,6 +139,28 @@ static void OnFragProgress(uint16_t fragCounter, uint16_t fragNb, uint8_t fragSi
 static void OnFragDone(int32_t status, uint32_t size);
 
 #if (INTEROP_TEST_MODE == 0)
+/**
+  * @brief  Callback to notify a new fragmentation session. A delta patch is
+  *         stored at the top of the download slot so that the new image can
+  *         be rebuilt from the start of the slot.
+  * @param  descriptor file descriptor of the session
+  * @param  size size of the file
+  * @retval None
+  */
+static void OnFragSessionSetup(uint32_t descriptor, uint32_t size);
+
+/**
+  * @brief  Rebuilds the new image in the download slot from the received patch
+  * @param  size size of the received patch
+  * @retval true once the new image is verified
+  */
+static bool DeltaPatchRun(uint32_t size);
+
+static uint8_t DeltaPatchReadPatch(uint32_t addr, uint8_t *data, uint32_t size);
+static uint8_t DeltaPatchReadOld(uint32_t addr, uint8_t *data, uint32_t size);
+static uint8_t DeltaPatchWriteNew(uint32_t addr, uint8_t *data, uint32_t size);
+static uint8_t DeltaPatchReadNew(uint32_t addr, uint8_t *data, uint32_t size);
+
 /**
   * @brief  Run FW Update process.
   * @param  None
@@ -172,7 +195,10 @@ static LmhpFragmentationParams_t FragmentationParams =
     .FragDecoderRead = FragDecoderRead,
   },
   .OnProgress = OnFragProgress,
-  .OnDone = OnFragDone
+  .OnDone = OnFragDone,
+#if (INTEROP_TEST_MODE == 0)
+  .OnSessionSetup = OnFragSessionSetup,
+#endif /* INTEROP_TEST_MODE == 0 */
 };
 
 /*
@@ -180,6 +206,27 @@ static LmhpFragmentationParams_t FragmentationParams =
  */
 static volatile bool IsFileTransferDone = false;
 
+#if (INTEROP_TEST_MODE == 0)
+/*
+ * Offset of the received file in the download slot, 0 unless a delta patch
+ * is received
+ */
+static uint32_t FileOffset = 0;
+
+/*
+ * Indicates if the current session carries a delta patch
+ */
+static bool IsDeltaSession = false;
+
+static DeltaPatchCallbacks_t DeltaPatchCallbacks =
+{
+  .ReadPatch = DeltaPatchReadPatch,
+  .ReadOld = DeltaPatchReadOld,
+  .WriteNew = DeltaPatchWriteNew,
+  .ReadNew = DeltaPatchReadNew,
+};
+#endif /* INTEROP_TEST_MODE == 0 */
+
 #if (INTEROP_TEST_MODE == 1)  /*write fragment in RAM - Caching mode*/
 /*
  * Un-fragmented data storage.
@@ -272,7 +319,7 @@ static uint8_t FragDecoderWrite(uint32_t addr, uint8_t *data, uint32_t size)
     UnfragmentedData[addr + i] = data[i];
   }
 #else /* INTEROP_TEST_MODE == 0 */
-  if (FLASH_Write(SlotStartAdd[SLOT_DWL_1] + addr, data, size) != HAL_OK)
+  if (FLASH_Write(SlotStartAdd[SLOT_DWL_1] + FileOffset + addr, data, size) != HAL_OK)
   {
     return -1;
   }
@@ -294,7 +341,7 @@ static uint8_t FragDecoderRead(uint32_t addr, uint8_t *data, uint32_t size)
     data[i] = UnfragmentedData[addr + i];
   }
 #else /* INTEROP_TEST_MODE == 0 */
-  if (FLASH_Read((void *)(SlotStartAdd[SLOT_DWL_1] + addr), data, size) != HAL_OK)
+  if (FLASH_Read((void *)(SlotStartAdd[SLOT_DWL_1] + FileOffset + addr), data, size) != HAL_OK)
   {
     return -1;
   }
@@ -320,8 +367,13 @@ static void OnFragDone(int32_t status, uint32_t size)
 {
   IsFileTransferDone = true;
 #if (INTEROP_TEST_MODE == 0)
-  /* Do a request to Run the Secure boot - The file is already in flash */
-  FwUpdateAgentRun();
+  /* A delta patch is turned into the new image first, on failure the current
+     image is kept */
+  if ((IsDeltaSession == false) || (DeltaPatchRun(size) == true))
+  {
+    /* Do a request to Run the Secure boot - The file is already in flash */
+    FwUpdateAgentRun();
+  }
 #else
   /* BSP_LED_Off(LED_BLUE); */
   HAL_GPIO_WritePin(GPIOB, GPIO_PIN_15, GPIO_PIN_RESET);
@@ -331,6 +383,75 @@ static void OnFragDone(int32_t status, uint32_t size)
 }
 
 #if (INTEROP_TEST_MODE == 0)
+static void OnFragSessionSetup(uint32_t descriptor, uint32_t size)
+{
+  uint32_t slotSize = SlotEndAdd[SLOT_DWL_1] - SlotStartAdd[SLOT_DWL_1] + 1U;
+  uint32_t patchArea = ((size + FLASH_PAGE_SIZE - 1U) / FLASH_PAGE_SIZE) * FLASH_PAGE_SIZE;
+
+  IsDeltaSession = (descriptor == DELTA_PATCH_DESCRIPTOR) && (patchArea < slotSize);
+  FileOffset = (IsDeltaSession == true) ? (slotSize - patchArea) : 0U;
+}
+
+static bool DeltaPatchRun(uint32_t size)
+{
+  DeltaPatchStatus_t status;
+  uint32_t newSize = 0;
+
+  MW_LOG(TS_OFF, VLEVEL_M, "\r\n....... DELTA_PATCH %d bytes .......\r\n", size);
+  status = DeltaPatchApply(size, FileOffset, &DeltaPatchCallbacks, &newSize);
+  if (status != DELTA_PATCH_SUCCESS)
+  {
+    MW_LOG(TS_OFF, VLEVEL_M, "DELTA_PATCH : error %d\r\n", status);
+    return false;
+  }
+  MW_LOG(TS_OFF, VLEVEL_M, "NEW IMAGE   : %d bytes\r\n", newSize);
+  return true;
+}
+
+static uint8_t DeltaPatchReadPatch(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  if (FLASH_Read(data, (void *)(SlotStartAdd[SLOT_DWL_1] + FileOffset + addr), size) != HAL_OK)
+  {
+    return -1;
+  }
+  return 0; /* Success */
+}
+
+static uint8_t DeltaPatchReadOld(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  if ((addr + size) > (SlotEndAdd[SLOT_ACTIVE_1] - SlotStartAdd[SLOT_ACTIVE_1] + 1U))
+  {
+    return (uint8_t) - 1; /* Fail */
+  }
+  if (FLASH_Read(data, (void *)(SlotStartAdd[SLOT_ACTIVE_1] + addr), size) != HAL_OK)
+  {
+    return -1;
+  }
+  return 0; /* Success */
+}
+
+static uint8_t DeltaPatchWriteNew(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  if ((addr + size) > FileOffset)
+  {
+    return (uint8_t) - 1; /* Fail, would overwrite the patch */
+  }
+  if (FLASH_Write(SlotStartAdd[SLOT_DWL_1] + addr, data, size) != HAL_OK)
+  {
+    return -1;
+  }
+  return 0; /* Success */
+}
+
+static uint8_t DeltaPatchReadNew(uint32_t addr, uint8_t *data, uint32_t size)
+{
+  if (FLASH_Read(data, (void *)(SlotStartAdd[SLOT_DWL_1] + addr), size) != HAL_OK)
+  {
+    return -1;
+  }
+  return 0; /* Success */
+}
+
 static void FwUpdateAgentRun(void)
 {
   HAL_StatusTypeDef ret = HAL_ERROR;
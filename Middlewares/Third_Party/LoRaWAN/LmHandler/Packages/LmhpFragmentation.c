@@ -57,6 +57,7 @@ typedef struct LmhpFragmentationState_s
   uint8_t DataBufferMaxSize;
   uint8_t *DataBuffer;
   uint8_t *file;
+  uint8_t DecoderFragIndex;  /* Session the single FragDecoder instance is set up for */
 } LmhpFragmentationState_t;
 
 typedef enum LmhpFragmentationMoteCmd_e
@@ -123,6 +124,22 @@ typedef struct FragSessionData_s
 
 #define FRAGMENTATION_MAX_SESSIONS                  4
 
+/*!
+ * Payload sizes of the server requests, after the command identifier
+ */
+#define FRAGMENTATION_FRAG_STATUS_REQ_SIZE          1
+#define FRAGMENTATION_FRAG_SESSION_SETUP_REQ_SIZE   10
+#define FRAGMENTATION_FRAG_SESSION_DELETE_REQ_SIZE  1
+#define FRAGMENTATION_DATA_FRAGMENT_HEADER_SIZE     2
+
+/*!
+ * Sizes of the answers, including the command identifier
+ */
+#define FRAGMENTATION_PKG_VERSION_ANS_SIZE          3
+#define FRAGMENTATION_FRAG_STATUS_ANS_SIZE          5
+#define FRAGMENTATION_FRAG_SESSION_SETUP_ANS_SIZE   2
+#define FRAGMENTATION_FRAG_SESSION_DELETE_ANS_SIZE  2
+
 /* Private macro -------------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /*!
@@ -167,6 +184,20 @@ static void LmhpFragmentationProcess(void);
  */
 static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication);
 
+/*!
+ * Checks that a command payload and its answer fit in their buffers
+ *
+ * \param [in] mcpsIndication  MCPS indication primitive data
+ * \param [in] cmdIndex        Index of the command payload in the downlink
+ * \param [in] reqSize         Size of the command payload
+ * \param [in] dataBufferIndex Index of the answer in the uplink buffer
+ * \param [in] ansSize         Size of the answer, 0 if there is none
+ *
+ * \retval status              [true: Both fit, false: Command must be dropped]
+ */
+static bool LmhpFragmentationCmdFits(McpsIndication_t *mcpsIndication, uint16_t cmdIndex, uint16_t reqSize,
+                                     uint16_t dataBufferIndex, uint16_t ansSize);
+
 /* Private variables ---------------------------------------------------------*/
 /*!
  * LoRaWAN fragmented data block transport handler parameters
@@ -243,6 +274,9 @@ static void LmhpFragmentationInit(void *params, uint8_t *dataBuffer, uint8_t dat
 
   /* initialize the global fragmentation session buffer */
   UTIL_MEM_set_8(FragSessionData, 0, sizeof(FragSessionData));
+  LmhpFragmentationState.DecoderFragIndex = 0;
+  /* A delayed answer refers to the cleared sessions and to the previous buffer */
+  LmhpFragmentationState.TxDelayState = FRAGMENTATION_TX_DELAY_STATE_IDLE;
 }
 
 static bool LmhpFragmentationIsInitialized(void)
@@ -312,6 +346,12 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
           /* Multicast channel. Don't process command. */
           break;
         }
+        if (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, 0,
+                                     dataBufferIndex, FRAGMENTATION_PKG_VERSION_ANS_SIZE) == false)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
         LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_PKG_VERSION_ANS;
         LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_ID;
         LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_VERSION;
@@ -319,19 +359,27 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
       }
       case FRAGMENTATION_FRAG_STATUS_REQ:
       {
+        if (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, FRAGMENTATION_FRAG_STATUS_REQ_SIZE,
+                                     dataBufferIndex, FRAGMENTATION_FRAG_STATUS_ANS_SIZE) == false)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
         uint8_t fragIndex = mcpsIndication->Buffer[cmdIndex++];
         uint8_t participants = fragIndex & 0x01;
 
-        fragIndex >>= 1;
+        /* FragIndex is bits 2:1, bits 7:3 are RFU */
+        fragIndex = (fragIndex >> 1) & 0x03;
         FragSessionData[fragIndex].FragDecoderStatus = FragDecoderGetStatus();
 
         if ((participants == 1) ||
             ((participants == 0) && (FragSessionData[fragIndex].FragDecoderStatus.FragNbLost > 0)))
         {
+          /* NbReceived ( bits 13:0 ) and FragIndex ( bits 15:14 ), little endian */
           LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_FRAG_STATUS_ANS;
-          LmhpFragmentationState.DataBuffer[dataBufferIndex++] = (fragIndex << 14) |
-                                                                 ((FragSessionData[fragIndex].FragDecoderStatus.FragNbRx >> 8) & 0x3F);
           LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FragSessionData[fragIndex].FragDecoderStatus.FragNbRx & 0xFF;
+          LmhpFragmentationState.DataBuffer[dataBufferIndex++] = (fragIndex << 6) |
+                                                                 ((FragSessionData[fragIndex].FragDecoderStatus.FragNbRx >> 8) & 0x3F);
           LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FragSessionData[fragIndex].FragDecoderStatus.FragNbLost;
           LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FragSessionData[fragIndex].FragDecoderStatus.MatrixError & 0x01;
 
@@ -348,6 +396,12 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
           /* Multicast channel. Don't process command. */
           break;
         }
+        if (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, FRAGMENTATION_FRAG_SESSION_SETUP_REQ_SIZE,
+                                     dataBufferIndex, FRAGMENTATION_FRAG_SESSION_SETUP_ANS_SIZE) == false)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
         FragSessionData_t fragSessionData;
         uint8_t status = 0x00;
 
@@ -362,18 +416,21 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
 
         fragSessionData.FragGroupData.Padding = mcpsIndication->Buffer[cmdIndex++];
 
-        fragSessionData.FragGroupData.Descriptor = (mcpsIndication->Buffer[cmdIndex++] << 0) & 0x000000FF;
-        fragSessionData.FragGroupData.Descriptor += (mcpsIndication->Buffer[cmdIndex++] << 8) & 0x0000FF00;
-        fragSessionData.FragGroupData.Descriptor += (mcpsIndication->Buffer[cmdIndex++] << 16) & 0x00FF0000;
-        fragSessionData.FragGroupData.Descriptor += (mcpsIndication->Buffer[cmdIndex++] << 24) & 0xFF000000;
+        fragSessionData.FragGroupData.Descriptor = ((uint32_t)mcpsIndication->Buffer[cmdIndex++] << 0) & 0x000000FF;
+        fragSessionData.FragGroupData.Descriptor += ((uint32_t)mcpsIndication->Buffer[cmdIndex++] << 8) & 0x0000FF00;
+        fragSessionData.FragGroupData.Descriptor += ((uint32_t)mcpsIndication->Buffer[cmdIndex++] << 16) & 0x00FF0000;
+        fragSessionData.FragGroupData.Descriptor += ((uint32_t)mcpsIndication->Buffer[cmdIndex++] << 24) & 0xFF000000;
 
         if (fragSessionData.FragGroupData.Control.Fields.FragAlgo > 0)
         {
           status |= 0x01; /* Encoding unsupported */
         }
 
-        if ((fragSessionData.FragGroupData.FragNb * fragSessionData.FragGroupData.FragSize) > FragDecoderGetMaxFileSize())
+        if (((fragSessionData.FragGroupData.FragNb * fragSessionData.FragGroupData.FragSize) > FragDecoderGetMaxFileSize()) ||
+            (fragSessionData.FragGroupData.FragNb == 0) || (fragSessionData.FragGroupData.FragNb > FRAG_MAX_NB) ||
+            (fragSessionData.FragGroupData.FragSize == 0) || (fragSessionData.FragGroupData.FragSize > FRAG_MAX_SIZE))
         {
+          /* The decoder matrices are sized for FRAG_MAX_NB fragments of FRAG_MAX_SIZE bytes */
           status |= 0x02; /* Not enough Memory */
         }
         status |= (fragSessionData.FragGroupData.FragSession.Fields.FragIndex << 6) & 0xC0;
@@ -396,6 +453,13 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
           fragSessionData.FragGroupData.IsActive = true;
           fragSessionData.FragDecoderProcessStatus = FRAG_SESSION_ONGOING;
           FragSessionData[fragSessionData.FragGroupData.FragSession.Fields.FragIndex] = fragSessionData;
+          LmhpFragmentationState.DecoderFragIndex = fragSessionData.FragGroupData.FragSession.Fields.FragIndex;
+          if (LmhpFragmentationParams->OnSessionSetup != NULL)
+          {
+            LmhpFragmentationParams->OnSessionSetup(fragSessionData.FragGroupData.Descriptor,
+                                                    (uint32_t)fragSessionData.FragGroupData.FragNb *
+                                                    fragSessionData.FragGroupData.FragSize);
+          }
           FragDecoderInit(fragSessionData.FragGroupData.FragNb,
                           fragSessionData.FragGroupData.FragSize,
                           &LmhpFragmentationParams->DecoderCallbacks);
@@ -412,6 +476,12 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
           /* Multicast channel. Don't process command. */
           break;
         }
+        if (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, FRAGMENTATION_FRAG_SESSION_DELETE_REQ_SIZE,
+                                     dataBufferIndex, FRAGMENTATION_FRAG_SESSION_DELETE_ANS_SIZE) == false)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
         uint8_t status = 0x00;
         uint8_t id = mcpsIndication->Buffer[cmdIndex++] & 0x03;
 
@@ -435,12 +505,21 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
         uint8_t fragIndex = 0;
         uint16_t fragCounter = 0;
 
+        if (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, FRAGMENTATION_DATA_FRAGMENT_HEADER_SIZE, 0, 0) == false)
+        {
+          cmdIndex = mcpsIndication->BufferSize;
+          break;
+        }
         fragCounter = (mcpsIndication->Buffer[cmdIndex++] << 0) & 0x00FF;
         fragCounter |= (mcpsIndication->Buffer[cmdIndex++] << 8) & 0xFF00;
 
         fragIndex = (fragCounter >> 14) & 0x03;
         fragCounter &= 0x3FFF;
-        if (FragSessionData[fragIndex].FragGroupData.IsActive == false)
+        /* Only the last session set up owns the decoder, a fragment carries FragSize bytes */
+        if ((FragSessionData[fragIndex].FragGroupData.IsActive == false) ||
+            (fragIndex != LmhpFragmentationState.DecoderFragIndex) ||
+            (LmhpFragmentationCmdFits(mcpsIndication, cmdIndex, FragSessionData[fragIndex].FragGroupData.FragSize,
+                                      0, 0) == false))
         {
           cmdIndex = mcpsIndication->BufferSize;
           break;
@@ -537,3 +616,19 @@ static void LmhpFragmentationOnMcpsIndication(McpsIndication_t *mcpsIndication)
     }
   }
 }
+
+static bool LmhpFragmentationCmdFits(McpsIndication_t *mcpsIndication, uint16_t cmdIndex, uint16_t reqSize,
+                                     uint16_t dataBufferIndex, uint16_t ansSize)
+{
+  if ((cmdIndex + reqSize) > mcpsIndication->BufferSize)
+  {
+    /* Truncated command */
+    return false;
+  }
+  if ((dataBufferIndex + ansSize) > LmhpFragmentationState.DataBufferMaxSize)
+  {
+    /* No room left for the answer */
+    return false;
+  }
+  return true;
+}
@@ -77,6 +77,14 @@ typedef struct LmhpFragmentationParams_s
    * \param [in] size   Received file size
    */
   void (*OnDone)(int32_t status, uint32_t size);
+  /*!
+   * Notifies that a fragmentation session is accepted, before the decoder
+   * is initialized. Optional.
+   *
+   * \param [in] descriptor FragSessionSetupReq file descriptor
+   * \param [in] size       File size ( FragNb * FragSize )
+   */
+  void (*OnSessionSetup)(uint32_t descriptor, uint32_t size);
 } LmhpFragmentationParams_t;
 
 /* External variables --------------------------------------------------------*/
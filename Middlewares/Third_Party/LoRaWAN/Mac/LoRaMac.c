@@ -54,6 +54,7 @@
 #include "LoRaMacParser.h"
 #include "LoRaMacCommands.h"
 #include "LoRaMacAdr.h"
+#include "LoRaMacRxCalibration.h"
 #include "LoRaMacSerializer.h"
 
 #include "LoRaMac.h"
@@ -278,6 +279,13 @@ typedef struct sLoRaMacCtx
     uint32_t RxWindow1Delay;
     uint32_t RxWindow2Delay;
     /*
+    * LoRaMac reception windows nominal delay, start of the downlink
+    * \remark normal frame: ReceiveDelayX
+    *         join frame  : JoinAcceptDelayX
+    */
+    uint32_t RxWindow1NominalDelay;
+    uint32_t RxWindow2NominalDelay;
+    /*
     * LoRaMac Rx windows configuration
     */
     RxConfigParams_t RxWindow1Config;
@@ -393,6 +401,7 @@ struct
 struct
 {
     TimerTime_t LastRxDone;
+    TimerTime_t PreambleDetected;
     uint8_t *Payload;
     uint16_t Size;
     int16_t Rssi;
@@ -452,6 +461,11 @@ static void OnRadioRxError( void );
  */
 static void OnRadioRxTimeout( void );
 
+/*!
+ * \brief Function executed on Radio Preamble Detected event
+ */
+static void OnRadioPreambleDetected( void );
+
 /*!
  * \brief Function executed on duty cycle delayed Tx  timer event
  */
@@ -528,6 +542,80 @@ static uint8_t GetMaxAppPayloadWithoutFOptsLength( int8_t datarate );
  */
 static bool ValidatePayloadLength( uint8_t lenN, int8_t datarate, uint8_t fOptsLen );
 
+/*!
+ * Downlink MAC command being processed
+ */
+typedef struct sMacCmdRxCtx
+{
+    /*!
+     * MAC command, CID first
+     */
+    uint8_t* Payload;
+    /*!
+     * Bytes left in the MAC commands buffer from Payload
+     */
+    uint8_t Size;
+    /*!
+     * Bytes consumed by the command, CID included. Preset to the command size,
+     * updated by the handlers which consume a block of commands
+     */
+    uint8_t CmdSize;
+    /*!
+     * SNR of the frame
+     */
+    int8_t Snr;
+    /*!
+     * RX slot where the frame was received
+     */
+    LoRaMacRxSlot_t RxSlot;
+    /*!
+     * Set once a LinkAdrReq block is processed
+     */
+    bool AdrBlockFound;
+}MacCmdRxCtx_t;
+
+/*!
+ * Downlink MAC command handler
+ */
+typedef void ( *MacCmdHandler_t )( MacCmdRxCtx_t* ctx );
+
+static void MacCmdLinkCheckAns( MacCmdRxCtx_t* ctx );
+static void MacCmdLinkAdrReq( MacCmdRxCtx_t* ctx );
+static void MacCmdDutyCycleReq( MacCmdRxCtx_t* ctx );
+static void MacCmdRxParamSetupReq( MacCmdRxCtx_t* ctx );
+static void MacCmdDevStatusReq( MacCmdRxCtx_t* ctx );
+static void MacCmdNewChannelReq( MacCmdRxCtx_t* ctx );
+static void MacCmdRxTimingSetupReq( MacCmdRxCtx_t* ctx );
+static void MacCmdTxParamSetupReq( MacCmdRxCtx_t* ctx );
+static void MacCmdDlChannelReq( MacCmdRxCtx_t* ctx );
+static void MacCmdDeviceTimeAns( MacCmdRxCtx_t* ctx );
+static void MacCmdPingSlotInfoAns( MacCmdRxCtx_t* ctx );
+static void MacCmdPingSlotChannelReq( MacCmdRxCtx_t* ctx );
+static void MacCmdBeaconTimingAns( MacCmdRxCtx_t* ctx );
+static void MacCmdBeaconFreqReq( MacCmdRxCtx_t* ctx );
+
+/*!
+ * Downlink MAC command handlers, indexed by CID. The command sizes are
+ * given by LoRaMacCommandsGetCmdSize.
+ */
+static const MacCmdHandler_t MacCmdHandlers[] =
+{
+    [SRV_MAC_LINK_CHECK_ANS]        = MacCmdLinkCheckAns,
+    [SRV_MAC_LINK_ADR_REQ]          = MacCmdLinkAdrReq,
+    [SRV_MAC_DUTY_CYCLE_REQ]        = MacCmdDutyCycleReq,
+    [SRV_MAC_RX_PARAM_SETUP_REQ]    = MacCmdRxParamSetupReq,
+    [SRV_MAC_DEV_STATUS_REQ]        = MacCmdDevStatusReq,
+    [SRV_MAC_NEW_CHANNEL_REQ]       = MacCmdNewChannelReq,
+    [SRV_MAC_RX_TIMING_SETUP_REQ]   = MacCmdRxTimingSetupReq,
+    [SRV_MAC_TX_PARAM_SETUP_REQ]    = MacCmdTxParamSetupReq,
+    [SRV_MAC_DL_CHANNEL_REQ]        = MacCmdDlChannelReq,
+    [SRV_MAC_DEVICE_TIME_ANS]       = MacCmdDeviceTimeAns,
+    [SRV_MAC_PING_SLOT_INFO_ANS]    = MacCmdPingSlotInfoAns,
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = MacCmdPingSlotChannelReq,
+    [SRV_MAC_BEACON_TIMING_ANS]     = MacCmdBeaconTimingAns,
+    [SRV_MAC_BEACON_FREQ_REQ]       = MacCmdBeaconFreqReq,
+};
+
 /*!
  * \brief Decodes MAC commands in the fOpts field and in the payload
  *
@@ -594,6 +682,15 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh );
  */
 static void CalculateBackOff( void );
 
+/*!
+ * \brief Sets up the parameters of the channel selection for the next uplink
+ *
+ * \param [OUT] nextChan  Channel selection parameters
+ * \param [IN] aggrTimeOff Aggregated time-off to apply
+ * \param [IN] pktLen     PHY payload size of the uplink
+ */
+static void SetupNextChanParams( NextChanParams_t* nextChan, TimerTime_t aggrTimeOff, uint16_t pktLen );
+
 /*
  * \brief Function to remove pending MAC commands
  *
@@ -649,6 +746,12 @@ static void ResetMacParameters( void );
  */
 static void RxWindowSetup( TimerEvent_t* rxTimer, RxConfigParams_t* rxConfig );
 
+/*!
+ * \brief Feeds the RX windows calibration with the timing of the downlink
+ *        received in RX1 or RX2
+ */
+static void ProcessRxCalibration( void );
+
 /*!
  * \brief Opens up a continuous RX C window. This is used for
  *        class c devices.
@@ -875,6 +978,11 @@ static void OnRadioRxTimeout( void )
     MW_LOG(TS_ON, VLEVEL_M, "MAC rxTimeOut\r\n" );
 }
 
+static void OnRadioPreambleDetected( void )
+{
+    RxDoneParams.PreambleDetected = TimerGetCurrentTime( );
+}
+
 static void UpdateRxSlotIdleState( void )
 {
     if( MacCtx.NvmCtx->DeviceClass != CLASS_C )
@@ -1040,6 +1148,8 @@ static void ProcessRadioRxDone( void )
 
             if( LORAMAC_CRYPTO_SUCCESS == macCryptoStatus )
             {
+                ProcessRxCalibration( );
+
                 // Network ID
                 MacCtx.NvmCtx->NetID = ( uint32_t ) macMsgJoinAccept.NetID[0];
                 MacCtx.NvmCtx->NetID |= ( ( uint32_t ) macMsgJoinAccept.NetID[1] << 8 );
@@ -1215,6 +1325,7 @@ static void ProcessRadioRxDone( void )
 
             // Frame is valid
             MacCtx.McpsIndication.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+            ProcessRxCalibration( );
             MacCtx.McpsIndication.Multicast = multicast;
             MacCtx.McpsIndication.FramePending = macMsgData.FHDR.FCtrl.Bits.FPending;
             MacCtx.McpsIndication.Buffer = NULL;
@@ -1437,6 +1548,11 @@ static void HandleRadioRxErrorTimeout( LoRaMacEventInfoStatus_t rx1EventInfoStat
 
             if( MacCtx.NvmCtx->DeviceClass != CLASS_C )
             {
+                // Both windows missed the downlink expected
+                if( ( MacCtx.NodeAckRequested == true ) || ( LoRaMacConfirmQueueIsCmdActive( MLME_JOIN ) == true ) )
+                {
+                    LoRaMacRxCalibrationAddFailure( );
+                }
                 MacCtx.MacFlags.Bits.MacDone = 1;
             }
         }
@@ -1931,325 +2047,342 @@ static void SetMlmeScheduleUplinkIndication( void )
     MacCtx.MacFlags.Bits.MlmeSchedUplinkInd = 1;
 }
 
-static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, int8_t snr, LoRaMacRxSlot_t rxSlot )
+static void MacCmdLinkCheckAns( MacCmdRxCtx_t* ctx )
 {
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
+        MacCtx.MlmeConfirm.DemodMargin = ctx->Payload[1];
+        MacCtx.MlmeConfirm.NbGateways = ctx->Payload[2];
+    }
+}
+
+static void MacCmdLinkAdrReq( MacCmdRxCtx_t* ctx )
+{
+    LinkAdrReqParams_t linkAdrReq;
+    int8_t linkAdrDatarate = DR_0;
+    int8_t linkAdrTxPower = TX_POWER_0;
+    uint8_t linkAdrNbRep = 0;
+    uint8_t linkAdrNbBytesParsed = 0;
     uint8_t status = 0;
-    bool adrBlockFound = false;
+
+    // Only the first block of contiguous LinkAdrReq commands is processed
+    if( ctx->AdrBlockFound == true )
+    {
+        return;
+    }
+    ctx->AdrBlockFound = true;
+
+    // Fill parameter structure
+    linkAdrReq.Payload = ctx->Payload;
+    linkAdrReq.PayloadSize = ctx->Size;
+    linkAdrReq.AdrEnabled = MacCtx.NvmCtx->AdrCtrlOn;
+    linkAdrReq.UplinkDwellTime = MacCtx.NvmCtx->MacParams.UplinkDwellTime;
+    linkAdrReq.CurrentDatarate = MacCtx.NvmCtx->MacParams.ChannelsDatarate;
+    linkAdrReq.CurrentTxPower = MacCtx.NvmCtx->MacParams.ChannelsTxPower;
+    linkAdrReq.CurrentNbRep = MacCtx.NvmCtx->MacParams.ChannelsNbTrans;
+    linkAdrReq.Version = MacCtx.NvmCtx->Version;
+
+    // Process the ADR requests
+    status = RegionLinkAdrReq( MacCtx.NvmCtx->Region, &linkAdrReq, &linkAdrDatarate,
+                               &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
+
+    if( ( status & 0x07 ) == 0x07 )
+    {
+        MacCtx.NvmCtx->MacParams.ChannelsDatarate = linkAdrDatarate;
+        MacCtx.NvmCtx->MacParams.ChannelsTxPower = linkAdrTxPower;
+        MacCtx.NvmCtx->MacParams.ChannelsNbTrans = linkAdrNbRep;
+    }
+
+    // Add the answers to the buffer
+    for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
+    {
+        LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
+    }
+    // The whole block is consumed
+    ctx->CmdSize = MAX( ctx->CmdSize, linkAdrNbBytesParsed );
+}
+
+static void MacCmdDutyCycleReq( MacCmdRxCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+
+    MacCtx.NvmCtx->MaxDCycle = ctx->Payload[1] & 0x0F;
+    MacCtx.NvmCtx->AggregatedDCycle = 1 << MacCtx.NvmCtx->MaxDCycle;
+    LoRaMacCommandsAddCmd( MOTE_MAC_DUTY_CYCLE_ANS, macCmdPayload, 0 );
+}
+
+static void MacCmdRxParamSetupReq( MacCmdRxCtx_t* ctx )
+{
+    RxParamSetupReqParams_t rxParamSetupReq;
+    uint8_t status = 0x07;
+
+    rxParamSetupReq.DrOffset = ( ctx->Payload[1] >> 4 ) & 0x07;
+    rxParamSetupReq.Datarate = ctx->Payload[1] & 0x0F;
+
+    rxParamSetupReq.Frequency = ( uint32_t ) ctx->Payload[2];
+    rxParamSetupReq.Frequency |= ( uint32_t ) ctx->Payload[3] << 8;
+    rxParamSetupReq.Frequency |= ( uint32_t ) ctx->Payload[4] << 16;
+    rxParamSetupReq.Frequency *= 100;
+
+    // Perform request on region
+    status = RegionRxParamSetupReq( MacCtx.NvmCtx->Region, &rxParamSetupReq );
+
+    if( ( status & 0x07 ) == 0x07 )
+    {
+        MacCtx.NvmCtx->MacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
+        MacCtx.NvmCtx->MacParams.RxCChannel.Datarate = rxParamSetupReq.Datarate;
+        MacCtx.NvmCtx->MacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
+        MacCtx.NvmCtx->MacParams.RxCChannel.Frequency = rxParamSetupReq.Frequency;
+        MacCtx.NvmCtx->MacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
+    }
+    LoRaMacCommandsAddCmd( MOTE_MAC_RX_PARAM_SETUP_ANS, &status, 1 );
+    // Setup indication to inform the application
+    SetMlmeScheduleUplinkIndication( );
+}
+
+static void MacCmdDevStatusReq( MacCmdRxCtx_t* ctx )
+{
     uint8_t macCmdPayload[2] = { 0x00, 0x00 };
+    uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
 
-    while( macIndex < commandsSize )
+    if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->GetBatteryLevel != NULL ) )
     {
-        // Make sure to parse only complete MAC commands
-        if( ( LoRaMacCommandsGetCmdSize( payload[macIndex] ) + macIndex ) > commandsSize )
-        {
-            return;
-        }
+        batteryLevel = MacCtx.MacCallbacks->GetBatteryLevel( );
+    }
+    macCmdPayload[0] = batteryLevel;
+    macCmdPayload[1] = ( uint8_t )( ctx->Snr & 0x3F );
+    LoRaMacCommandsAddCmd( MOTE_MAC_DEV_STATUS_ANS, macCmdPayload, 2 );
+}
 
-        // Decode Frame MAC commands
-        switch( payload[macIndex++] )
-        {
-            case SRV_MAC_LINK_CHECK_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_LINK_CHECK ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_LINK_CHECK );
-                    MacCtx.MlmeConfirm.DemodMargin = payload[macIndex++];
-                    MacCtx.MlmeConfirm.NbGateways = payload[macIndex++];
-                }
-                break;
-            }
-            case SRV_MAC_LINK_ADR_REQ:
-            {
-                LinkAdrReqParams_t linkAdrReq;
-                int8_t linkAdrDatarate = DR_0;
-                int8_t linkAdrTxPower = TX_POWER_0;
-                uint8_t linkAdrNbRep = 0;
-                uint8_t linkAdrNbBytesParsed = 0;
+static void MacCmdNewChannelReq( MacCmdRxCtx_t* ctx )
+{
+    NewChannelReqParams_t newChannelReq;
+    ChannelParams_t chParam;
+    uint8_t status = 0x03;
 
-                if( adrBlockFound == false )
-                {
-                    adrBlockFound = true;
-
-                    // Fill parameter structure
-                    linkAdrReq.Payload = &payload[macIndex - 1];
-                    linkAdrReq.PayloadSize = commandsSize - ( macIndex - 1 );
-                    linkAdrReq.AdrEnabled = MacCtx.NvmCtx->AdrCtrlOn;
-                    linkAdrReq.UplinkDwellTime = MacCtx.NvmCtx->MacParams.UplinkDwellTime;
-                    linkAdrReq.CurrentDatarate = MacCtx.NvmCtx->MacParams.ChannelsDatarate;
-                    linkAdrReq.CurrentTxPower = MacCtx.NvmCtx->MacParams.ChannelsTxPower;
-                    linkAdrReq.CurrentNbRep = MacCtx.NvmCtx->MacParams.ChannelsNbTrans;
-                    linkAdrReq.Version = MacCtx.NvmCtx->Version;
-
-                    // Process the ADR requests
-                    status = RegionLinkAdrReq( MacCtx.NvmCtx->Region, &linkAdrReq, &linkAdrDatarate,
-                                               &linkAdrTxPower, &linkAdrNbRep, &linkAdrNbBytesParsed );
-
-                    if( ( status & 0x07 ) == 0x07 )
-                    {
-                        MacCtx.NvmCtx->MacParams.ChannelsDatarate = linkAdrDatarate;
-                        MacCtx.NvmCtx->MacParams.ChannelsTxPower = linkAdrTxPower;
-                        MacCtx.NvmCtx->MacParams.ChannelsNbTrans = linkAdrNbRep;
-                    }
+    newChannelReq.ChannelId = ctx->Payload[1];
+    newChannelReq.NewChannel = &chParam;
 
-                    // Add the answers to the buffer
-                    for( uint8_t i = 0; i < ( linkAdrNbBytesParsed / 5 ); i++ )
-                    {
-                        LoRaMacCommandsAddCmd( MOTE_MAC_LINK_ADR_ANS, &status, 1 );
-                    }
-                    // Update MAC index
-                    macIndex += linkAdrNbBytesParsed - 1;
-                }
-                break;
-            }
-            case SRV_MAC_DUTY_CYCLE_REQ:
-            {
-                MacCtx.NvmCtx->MaxDCycle = payload[macIndex++] & 0x0F;
-                MacCtx.NvmCtx->AggregatedDCycle = 1 << MacCtx.NvmCtx->MaxDCycle;
-                LoRaMacCommandsAddCmd( MOTE_MAC_DUTY_CYCLE_ANS, macCmdPayload, 0 );
-                break;
-            }
-            case SRV_MAC_RX_PARAM_SETUP_REQ:
-            {
-                RxParamSetupReqParams_t rxParamSetupReq;
-                status = 0x07;
+    chParam.Frequency = ( uint32_t ) ctx->Payload[2];
+    chParam.Frequency |= ( uint32_t ) ctx->Payload[3] << 8;
+    chParam.Frequency |= ( uint32_t ) ctx->Payload[4] << 16;
+    chParam.Frequency *= 100;
+    chParam.Rx1Frequency = 0;
+    chParam.DrRange.Value = ctx->Payload[5];
 
-                rxParamSetupReq.DrOffset = ( payload[macIndex] >> 4 ) & 0x07;
-                rxParamSetupReq.Datarate = payload[macIndex] & 0x0F;
-                macIndex++;
+    status = RegionNewChannelReq( MacCtx.NvmCtx->Region, &newChannelReq );
 
-                rxParamSetupReq.Frequency = ( uint32_t ) payload[macIndex++];
-                rxParamSetupReq.Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                rxParamSetupReq.Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                rxParamSetupReq.Frequency *= 100;
+    LoRaMacCommandsAddCmd( MOTE_MAC_NEW_CHANNEL_ANS, &status, 1 );
+}
 
-                // Perform request on region
-                status = RegionRxParamSetupReq( MacCtx.NvmCtx->Region, &rxParamSetupReq );
+static void MacCmdRxTimingSetupReq( MacCmdRxCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t delay = ctx->Payload[1] & 0x0F;
 
-                if( ( status & 0x07 ) == 0x07 )
-                {
-                    MacCtx.NvmCtx->MacParams.Rx2Channel.Datarate = rxParamSetupReq.Datarate;
-                    MacCtx.NvmCtx->MacParams.RxCChannel.Datarate = rxParamSetupReq.Datarate;
-                    MacCtx.NvmCtx->MacParams.Rx2Channel.Frequency = rxParamSetupReq.Frequency;
-                    MacCtx.NvmCtx->MacParams.RxCChannel.Frequency = rxParamSetupReq.Frequency;
-                    MacCtx.NvmCtx->MacParams.Rx1DrOffset = rxParamSetupReq.DrOffset;
-                }
-                macCmdPayload[0] = status;
-                LoRaMacCommandsAddCmd( MOTE_MAC_RX_PARAM_SETUP_ANS, macCmdPayload, 1 );
-                // Setup indication to inform the application
-                SetMlmeScheduleUplinkIndication( );
-                break;
-            }
-            case SRV_MAC_DEV_STATUS_REQ:
-            {
-                uint8_t batteryLevel = BAT_LEVEL_NO_MEASURE;
-                if( ( MacCtx.MacCallbacks != NULL ) && ( MacCtx.MacCallbacks->GetBatteryLevel != NULL ) )
-                {
-                    batteryLevel = MacCtx.MacCallbacks->GetBatteryLevel( );
-                }
-                macCmdPayload[0] = batteryLevel;
-                macCmdPayload[1] = ( uint8_t )( snr & 0x3F );
-                LoRaMacCommandsAddCmd( MOTE_MAC_DEV_STATUS_ANS, macCmdPayload, 2 );
-                break;
-            }
-            case SRV_MAC_NEW_CHANNEL_REQ:
-            {
-                NewChannelReqParams_t newChannelReq;
-                ChannelParams_t chParam;
-                status = 0x03;
+    if( delay == 0 )
+    {
+        delay++;
+    }
+    MacCtx.NvmCtx->MacParams.ReceiveDelay1 = delay * 1000;
+    MacCtx.NvmCtx->MacParams.ReceiveDelay2 = MacCtx.NvmCtx->MacParams.ReceiveDelay1 + 1000;
+    LoRaMacCommandsAddCmd( MOTE_MAC_RX_TIMING_SETUP_ANS, macCmdPayload, 0 );
+    // Setup indication to inform the application
+    SetMlmeScheduleUplinkIndication( );
+}
 
-                newChannelReq.ChannelId = payload[macIndex++];
-                newChannelReq.NewChannel = &chParam;
+static void MacCmdTxParamSetupReq( MacCmdRxCtx_t* ctx )
+{
+    TxParamSetupReqParams_t txParamSetupReq;
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint8_t eirpDwellTime = ctx->Payload[1];
 
-                chParam.Frequency = ( uint32_t ) payload[macIndex++];
-                chParam.Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                chParam.Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                chParam.Frequency *= 100;
-                chParam.Rx1Frequency = 0;
-                chParam.DrRange.Value = payload[macIndex++];
+    txParamSetupReq.UplinkDwellTime = 0;
+    txParamSetupReq.DownlinkDwellTime = 0;
 
-                status = RegionNewChannelReq( MacCtx.NvmCtx->Region, &newChannelReq );
+    if( ( eirpDwellTime & 0x20 ) == 0x20 )
+    {
+        txParamSetupReq.DownlinkDwellTime = 1;
+    }
+    if( ( eirpDwellTime & 0x10 ) == 0x10 )
+    {
+        txParamSetupReq.UplinkDwellTime = 1;
+    }
+    txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
 
-                macCmdPayload[0] = status;
-                LoRaMacCommandsAddCmd( MOTE_MAC_NEW_CHANNEL_ANS, macCmdPayload, 1 );
-                break;
-            }
-            case SRV_MAC_RX_TIMING_SETUP_REQ:
-            {
-                uint8_t delay = payload[macIndex++] & 0x0F;
+    // Check the status for correctness
+    if( RegionTxParamSetupReq( MacCtx.NvmCtx->Region, &txParamSetupReq ) != -1 )
+    {
+        // Accept command
+        MacCtx.NvmCtx->MacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
+        MacCtx.NvmCtx->MacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
+        MacCtx.NvmCtx->MacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
+        // Update the datarate in case of the new configuration limits it
+        getPhy.Attribute = PHY_MIN_TX_DR;
+        getPhy.UplinkDwellTime = MacCtx.NvmCtx->MacParams.UplinkDwellTime;
+        phyParam = RegionGetPhyParam( MacCtx.NvmCtx->Region, &getPhy );
+        MacCtx.NvmCtx->MacParams.ChannelsDatarate = MAX( MacCtx.NvmCtx->MacParams.ChannelsDatarate, ( int8_t )phyParam.Value );
 
-                if( delay == 0 )
-                {
-                    delay++;
-                }
-                MacCtx.NvmCtx->MacParams.ReceiveDelay1 = delay * 1000;
-                MacCtx.NvmCtx->MacParams.ReceiveDelay2 = MacCtx.NvmCtx->MacParams.ReceiveDelay1 + 1000;
-                LoRaMacCommandsAddCmd( MOTE_MAC_RX_TIMING_SETUP_ANS, macCmdPayload, 0 );
-                // Setup indication to inform the application
-                SetMlmeScheduleUplinkIndication( );
-                break;
-            }
-            case SRV_MAC_TX_PARAM_SETUP_REQ:
-            {
-                TxParamSetupReqParams_t txParamSetupReq;
-                GetPhyParams_t getPhy;
-                PhyParam_t phyParam;
-                uint8_t eirpDwellTime = payload[macIndex++];
+        // Add command response
+        LoRaMacCommandsAddCmd( MOTE_MAC_TX_PARAM_SETUP_ANS, macCmdPayload, 0 );
+    }
+}
 
-                txParamSetupReq.UplinkDwellTime = 0;
-                txParamSetupReq.DownlinkDwellTime = 0;
+static void MacCmdDlChannelReq( MacCmdRxCtx_t* ctx )
+{
+    DlChannelReqParams_t dlChannelReq;
+    uint8_t status = 0x03;
+
+    dlChannelReq.ChannelId = ctx->Payload[1];
+    dlChannelReq.Rx1Frequency = ( uint32_t ) ctx->Payload[2];
+    dlChannelReq.Rx1Frequency |= ( uint32_t ) ctx->Payload[3] << 8;
+    dlChannelReq.Rx1Frequency |= ( uint32_t ) ctx->Payload[4] << 16;
+    dlChannelReq.Rx1Frequency *= 100;
+
+    status = RegionDlChannelReq( MacCtx.NvmCtx->Region, &dlChannelReq );
+    LoRaMacCommandsAddCmd( MOTE_MAC_DL_CHANNEL_ANS, &status, 1 );
+    // Setup indication to inform the application
+    SetMlmeScheduleUplinkIndication( );
+}
 
-                if( ( eirpDwellTime & 0x20 ) == 0x20 )
-                {
-                    txParamSetupReq.DownlinkDwellTime = 1;
-                }
-                if( ( eirpDwellTime & 0x10 ) == 0x10 )
-                {
-                    txParamSetupReq.UplinkDwellTime = 1;
-                }
-                txParamSetupReq.MaxEirp = eirpDwellTime & 0x0F;
+static void MacCmdDeviceTimeAns( MacCmdRxCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
+        SysTime_t gpsEpochTime = { 0 };
+        SysTime_t sysTime = { 0 };
+        SysTime_t sysTimeCurrent = { 0 };
 
-                // Check the status for correctness
-                if( RegionTxParamSetupReq( MacCtx.NvmCtx->Region, &txParamSetupReq ) != -1 )
-                {
-                    // Accept command
-                    MacCtx.NvmCtx->MacParams.UplinkDwellTime = txParamSetupReq.UplinkDwellTime;
-                    MacCtx.NvmCtx->MacParams.DownlinkDwellTime = txParamSetupReq.DownlinkDwellTime;
-                    MacCtx.NvmCtx->MacParams.MaxEirp = LoRaMacMaxEirpTable[txParamSetupReq.MaxEirp];
-                    // Update the datarate in case of the new configuration limits it
-                    getPhy.Attribute = PHY_MIN_TX_DR;
-                    getPhy.UplinkDwellTime = MacCtx.NvmCtx->MacParams.UplinkDwellTime;
-                    phyParam = RegionGetPhyParam( MacCtx.NvmCtx->Region, &getPhy );
-                    MacCtx.NvmCtx->MacParams.ChannelsDatarate = MAX( MacCtx.NvmCtx->MacParams.ChannelsDatarate, ( int8_t )phyParam.Value );
-
-                    // Add command response
-                    LoRaMacCommandsAddCmd( MOTE_MAC_TX_PARAM_SETUP_ANS, macCmdPayload, 0 );
-                }
-                break;
-            }
-            case SRV_MAC_DL_CHANNEL_REQ:
-            {
-                DlChannelReqParams_t dlChannelReq;
-                status = 0x03;
-
-                dlChannelReq.ChannelId = payload[macIndex++];
-                dlChannelReq.Rx1Frequency = ( uint32_t ) payload[macIndex++];
-                dlChannelReq.Rx1Frequency |= ( uint32_t ) payload[macIndex++] << 8;
-                dlChannelReq.Rx1Frequency |= ( uint32_t ) payload[macIndex++] << 16;
-                dlChannelReq.Rx1Frequency *= 100;
-
-                status = RegionDlChannelReq( MacCtx.NvmCtx->Region, &dlChannelReq );
-                macCmdPayload[0] = status;
-                LoRaMacCommandsAddCmd( MOTE_MAC_DL_CHANNEL_ANS, macCmdPayload, 1 );
-                // Setup indication to inform the application
-                SetMlmeScheduleUplinkIndication( );
-                break;
-            }
-            case SRV_MAC_DEVICE_TIME_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_DEVICE_TIME ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_DEVICE_TIME );
-                    SysTime_t gpsEpochTime = { 0 };
-                    SysTime_t sysTime = { 0 };
-                    SysTime_t sysTimeCurrent = { 0 };
-
-                    gpsEpochTime.Seconds = ( uint32_t )payload[macIndex++];
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 8;
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 16;
-                    gpsEpochTime.Seconds |= ( uint32_t )payload[macIndex++] << 24;
-                    gpsEpochTime.SubSeconds = payload[macIndex++];
-
-                    // Convert the fractional second received in ms
-                    // round( pow( 0.5, 8.0 ) * 1000 ) = 3.90625
-                    gpsEpochTime.SubSeconds = ( int16_t )( ( ( int32_t )gpsEpochTime.SubSeconds * 1000 ) >> 8 );
-
-                    // Copy received GPS Epoch time into system time
-                    sysTime = gpsEpochTime;
-                    // Add Unix to Gps epcoh offset. The system time is based on Unix time.
-                    sysTime.Seconds += UNIX_GPS_EPOCH_OFFSET;
-
-                    // Compensate time difference between Tx Done time and now
-                    sysTimeCurrent = SysTimeGet( );
-                    sysTime = SysTimeAdd( sysTimeCurrent, SysTimeSub( sysTime, MacCtx.LastTxSysTime ) );
-
-                    // Apply the new system time.
-                    SysTimeSet( sysTime );
-                    LoRaMacClassBDeviceTimeAns( );
-                    MacCtx.McpsIndication.DeviceTimeAnsReceived = true;
-                }
-                break;
-            }
-            case SRV_MAC_PING_SLOT_INFO_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_PING_SLOT_INFO ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_PING_SLOT_INFO );
-                    // According to the specification, it is not allowed to process this answer in
-                    // a ping or multicast slot
-                    if( ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_PING_SLOT ) && ( MacCtx.RxSlot != RX_SLOT_WIN_CLASS_B_MULTICAST_SLOT ) )
-                    {
-                        LoRaMacClassBPingSlotInfoAns( );
-                    }
-                }
-                break;
-            }
-            case SRV_MAC_PING_SLOT_CHANNEL_REQ:
-            {
-                uint8_t status = 0x03;
-                uint32_t frequency = 0;
-                uint8_t datarate;
-
-                frequency = ( uint32_t )payload[macIndex++];
-                frequency |= ( uint32_t )payload[macIndex++] << 8;
-                frequency |= ( uint32_t )payload[macIndex++] << 16;
-                frequency *= 100;
-                datarate = payload[macIndex++] & 0x0F;
-
-                status = LoRaMacClassBPingSlotChannelReq( datarate, frequency );
-                macCmdPayload[0] = status;
-                LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_FREQ_ANS, macCmdPayload, 1 );
-                break;
-            }
-            case SRV_MAC_BEACON_TIMING_ANS:
-            {
-                if( LoRaMacConfirmQueueIsCmdActive( MLME_BEACON_TIMING ) == true )
-                {
-                    LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_BEACON_TIMING );
-                    uint16_t beaconTimingDelay = 0;
-                    uint8_t beaconTimingChannel = 0;
+        gpsEpochTime.Seconds = ( uint32_t )ctx->Payload[1];
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Payload[2] << 8;
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Payload[3] << 16;
+        gpsEpochTime.Seconds |= ( uint32_t )ctx->Payload[4] << 24;
+        gpsEpochTime.SubSeconds = ctx->Payload[5];
 
-                    beaconTimingDelay = ( uint16_t )payload[macIndex++];
-                    beaconTimingDelay |= ( uint16_t )payload[macIndex++] << 8;
-                    beaconTimingChannel = payload[macIndex++];
+        // Convert the fractional second received in ms
+        // round( pow( 0.5, 8.0 ) * 1000 ) = 3.90625
+        gpsEpochTime.SubSeconds = ( int16_t )( ( ( int32_t )gpsEpochTime.SubSeconds * 1000 ) >> 8 );
 
-                    LoRaMacClassBBeaconTimingAns( beaconTimingDelay, beaconTimingChannel, RxDoneParams.LastRxDone );
-                }
-                break;
-            }
-            case SRV_MAC_BEACON_FREQ_REQ:
-                {
-                    uint32_t frequency = 0;
+        // Copy received GPS Epoch time into system time
+        sysTime = gpsEpochTime;
+        // Add Unix to Gps epcoh offset. The system time is based on Unix time.
+        sysTime.Seconds += UNIX_GPS_EPOCH_OFFSET;
 
-                    frequency = ( uint32_t )payload[macIndex++];
-                    frequency |= ( uint32_t )payload[macIndex++] << 8;
-                    frequency |= ( uint32_t )payload[macIndex++] << 16;
-                    frequency *= 100;
+        // Compensate time difference between Tx Done time and now
+        sysTimeCurrent = SysTimeGet( );
+        sysTime = SysTimeAdd( sysTimeCurrent, SysTimeSub( sysTime, MacCtx.LastTxSysTime ) );
 
-                    if( LoRaMacClassBBeaconFreqReq( frequency ) == true )
-                    {
-                        macCmdPayload[0] = 1;
-                    }
-                    else
-                    {
-                        macCmdPayload[0] = 0;
-                    }
-                    LoRaMacCommandsAddCmd( MOTE_MAC_BEACON_FREQ_ANS, macCmdPayload, 1 );
-                }
-                break;
-            default:
-                // Unknown command. ABORT MAC commands processing
-                return;
+        // Apply the new system time.
+        SysTimeSet( sysTime );
+        LoRaMacClassBDeviceTimeAns( );
+        MacCtx.McpsIndication.DeviceTimeAnsReceived = true;
+    }
+}
+
+static void MacCmdPingSlotInfoAns( MacCmdRxCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_PING_SLOT_INFO ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_PING_SLOT_INFO );
+        // According to the specification, it is not allowed to process this answer in
+        // a ping or multicast slot
+        if( ( ctx->RxSlot != RX_SLOT_WIN_CLASS_B_PING_SLOT ) && ( ctx->RxSlot != RX_SLOT_WIN_CLASS_B_MULTICAST_SLOT ) )
+        {
+            LoRaMacClassBPingSlotInfoAns( );
+        }
+    }
+}
+
+static void MacCmdPingSlotChannelReq( MacCmdRxCtx_t* ctx )
+{
+    uint8_t status = 0x03;
+    uint32_t frequency = 0;
+    uint8_t datarate;
+
+    frequency = ( uint32_t )ctx->Payload[1];
+    frequency |= ( uint32_t )ctx->Payload[2] << 8;
+    frequency |= ( uint32_t )ctx->Payload[3] << 16;
+    frequency *= 100;
+    datarate = ctx->Payload[4] & 0x0F;
+
+    status = LoRaMacClassBPingSlotChannelReq( datarate, frequency );
+    LoRaMacCommandsAddCmd( MOTE_MAC_PING_SLOT_FREQ_ANS, &status, 1 );
+}
+
+static void MacCmdBeaconTimingAns( MacCmdRxCtx_t* ctx )
+{
+    if( LoRaMacConfirmQueueIsCmdActive( MLME_BEACON_TIMING ) == true )
+    {
+        LoRaMacConfirmQueueSetStatus( LORAMAC_EVENT_INFO_STATUS_OK, MLME_BEACON_TIMING );
+        uint16_t beaconTimingDelay = 0;
+        uint8_t beaconTimingChannel = 0;
+
+        beaconTimingDelay = ( uint16_t )ctx->Payload[1];
+        beaconTimingDelay |= ( uint16_t )ctx->Payload[2] << 8;
+        beaconTimingChannel = ctx->Payload[3];
+
+        LoRaMacClassBBeaconTimingAns( beaconTimingDelay, beaconTimingChannel, RxDoneParams.LastRxDone );
+    }
+}
+
+static void MacCmdBeaconFreqReq( MacCmdRxCtx_t* ctx )
+{
+    uint8_t macCmdPayload[1] = { 0x00 };
+    uint32_t frequency = 0;
+
+    frequency = ( uint32_t )ctx->Payload[1];
+    frequency |= ( uint32_t )ctx->Payload[2] << 8;
+    frequency |= ( uint32_t )ctx->Payload[3] << 16;
+    frequency *= 100;
+
+    if( LoRaMacClassBBeaconFreqReq( frequency ) == true )
+    {
+        macCmdPayload[0] = 1;
+    }
+    else
+    {
+        macCmdPayload[0] = 0;
+    }
+    LoRaMacCommandsAddCmd( MOTE_MAC_BEACON_FREQ_ANS, macCmdPayload, 1 );
+}
+
+static void ProcessMacCommands( uint8_t *payload, uint8_t macIndex, uint8_t commandsSize, int8_t snr, LoRaMacRxSlot_t rxSlot )
+{
+    MacCmdRxCtx_t ctx;
+
+    ctx.Snr = snr;
+    ctx.RxSlot = rxSlot;
+    ctx.AdrBlockFound = false;
+
+    while( macIndex < commandsSize )
+    {
+        uint8_t cid = payload[macIndex];
+
+        // The size table and the handler table define the known commands
+        ctx.CmdSize = LoRaMacCommandsGetCmdSize( cid );
+        if( ( ctx.CmdSize == 0 ) || ( cid >= ( sizeof( MacCmdHandlers ) / sizeof( MacCmdHandlers[0] ) ) ) ||
+            ( MacCmdHandlers[cid] == NULL ) )
+        {
+            // Unknown command. ABORT MAC commands processing
+            return;
+        }
+
+        // Make sure to parse only complete MAC commands
+        if( ( ctx.CmdSize + macIndex ) > commandsSize )
+        {
+            return;
         }
+
+        ctx.Payload = &payload[macIndex];
+        ctx.Size = commandsSize - macIndex;
+        MacCmdHandlers[cid]( &ctx );
+
+        // Commands are skipped as a whole, even when they are ignored
+        macIndex += ctx.CmdSize;
     }
 }
 
@@ -2400,6 +2533,25 @@ static LoRaMacStatus_t CheckForClassBCollision( void )
 
 static void ComputeRxWindowParameters( void )
 {
+    int32_t rx1Correction;
+    int32_t rx2Correction;
+    uint32_t rx1Error;
+    uint32_t rx2Error;
+
+    // Default setup, in case the device joined
+    MacCtx.RxWindow1NominalDelay = MacCtx.NvmCtx->MacParams.ReceiveDelay1;
+    MacCtx.RxWindow2NominalDelay = MacCtx.NvmCtx->MacParams.ReceiveDelay2;
+
+    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        MacCtx.RxWindow1NominalDelay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay1;
+        MacCtx.RxWindow2NominalDelay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay2;
+    }
+
+    // Timing error of the windows, SystemMaxRxError until calibrated
+    LoRaMacRxCalibrationGetWindow( MacCtx.RxWindow1NominalDelay, MacCtx.NvmCtx->MacParams.SystemMaxRxError, &rx1Correction, &rx1Error );
+    LoRaMacRxCalibrationGetWindow( MacCtx.RxWindow2NominalDelay, MacCtx.NvmCtx->MacParams.SystemMaxRxError, &rx2Correction, &rx2Error );
+
     // Compute Rx1 windows parameters
     RegionComputeRxWindowParameters( MacCtx.NvmCtx->Region,
                                      RegionApplyDrOffset( MacCtx.NvmCtx->Region,
@@ -2407,24 +2559,60 @@ static void ComputeRxWindowParameters( void )
                                                           MacCtx.NvmCtx->MacParams.ChannelsDatarate,
                                                           MacCtx.NvmCtx->MacParams.Rx1DrOffset ),
                                      MacCtx.NvmCtx->MacParams.MinRxSymbols,
-                                     MacCtx.NvmCtx->MacParams.SystemMaxRxError,
+                                     rx1Error,
                                      &MacCtx.RxWindow1Config );
     // Compute Rx2 windows parameters
     RegionComputeRxWindowParameters( MacCtx.NvmCtx->Region,
                                      MacCtx.NvmCtx->MacParams.Rx2Channel.Datarate,
                                      MacCtx.NvmCtx->MacParams.MinRxSymbols,
-                                     MacCtx.NvmCtx->MacParams.SystemMaxRxError,
+                                     rx2Error,
                                      &MacCtx.RxWindow2Config );
 
-    // Default setup, in case the device joined
-    MacCtx.RxWindow1Delay = MacCtx.NvmCtx->MacParams.ReceiveDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-    MacCtx.RxWindow2Delay = MacCtx.NvmCtx->MacParams.ReceiveDelay2 + MacCtx.RxWindow2Config.WindowOffset;
+    MacCtx.RxWindow1Delay = MacCtx.RxWindow1NominalDelay + rx1Correction + MacCtx.RxWindow1Config.WindowOffset;
+    MacCtx.RxWindow2Delay = MacCtx.RxWindow2NominalDelay + rx2Correction + MacCtx.RxWindow2Config.WindowOffset;
+}
 
-    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
+static void ProcessRxCalibration( void )
+{
+    RxConfigParams_t* rxConfig = &MacCtx.RxWindow1Config;
+    uint32_t nominalDelay = MacCtx.RxWindow1NominalDelay;
+    uint32_t windowDelay = MacCtx.RxWindow1Delay;
+    uint32_t preambleDelay = RxDoneParams.PreambleDetected - MacCtx.NvmCtx->LastTxDoneTime;
+    uint32_t wakeUpTime = Radio.GetWakeupTime( );
+    uint32_t detectTime;
+
+    if( MacCtx.RxSlot == RX_SLOT_WIN_2 )
+    {
+        rxConfig = &MacCtx.RxWindow2Config;
+        nominalDelay = MacCtx.RxWindow2NominalDelay;
+        windowDelay = MacCtx.RxWindow2Delay;
+    }
+    else if( MacCtx.RxSlot != RX_SLOT_WIN_1 )
+    {
+        return;
+    }
+
+    // The preamble was detected outside of this window, e.g. by the previous one
+    if( ( preambleDelay < windowDelay ) || ( preambleDelay > ( RxDoneParams.LastRxDone - MacCtx.NvmCtx->LastTxDoneTime ) ) )
+    {
+        return;
+    }
+
+    // Time the radio takes to detect the preamble
+    detectTime = ( ( MacCtx.NvmCtx->MacParams.MinRxSymbols * ( rxConfig->SymbolTime / 1000 ) ) + 500 ) / 1000;
+
+    if( preambleDelay <= ( windowDelay + wakeUpTime + detectTime ) )
     {
-        MacCtx.RxWindow1Delay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay1 + MacCtx.RxWindow1Config.WindowOffset;
-        MacCtx.RxWindow2Delay = MacCtx.NvmCtx->MacParams.JoinAcceptDelay2 + MacCtx.RxWindow2Config.WindowOffset;
+        // Detected as soon as the radio listened, the downlink started at
+        // the earliest when the radio woke up. Unexpected if the window
+        // was opened ahead of the downlink.
+        if( rxConfig->WindowOffset < -( int32_t )( wakeUpTime + 1 ) )
+        {
+            LoRaMacRxCalibrationAddFailure( );
+        }
+        return;
     }
+    LoRaMacRxCalibrationAddSample( nominalDelay, ( int32_t )( preambleDelay - detectTime - nominalDelay ) );
 }
 
 static LoRaMacStatus_t VerifyTxFrame( void )
@@ -2498,21 +2686,7 @@ static LoRaMacStatus_t ScheduleTx( bool allowDelayedTx )
         return status;
     }
 
-    nextChan.AggrTimeOff = MacCtx.NvmCtx->AggregatedTimeOff;
-    nextChan.Datarate = MacCtx.NvmCtx->MacParams.ChannelsDatarate;
-    nextChan.DutyCycleEnabled = MacCtx.NvmCtx->DutyCycleOn;
-    nextChan.ElapsedTimeSinceStartUp = SysTimeSub( SysTimeGetMcuTime( ), MacCtx.NvmCtx->InitializationTime );
-    nextChan.LastAggrTx = MacCtx.NvmCtx->LastTxDoneTime;
-    nextChan.LastTxIsJoinRequest = false;
-    nextChan.Joined = true;
-    nextChan.PktLen = MacCtx.PktBufferLen;
-
-    // Setup the parameters based on the join status
-    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
-    {
-        nextChan.LastTxIsJoinRequest = true;
-        nextChan.Joined = false;
-    }
+    SetupNextChanParams( &nextChan, MacCtx.NvmCtx->AggregatedTimeOff, MacCtx.PktBufferLen );
 
     // Select channel
     status = RegionNextChannel( MacCtx.NvmCtx->Region, &nextChan, &MacCtx.Channel, &MacCtx.DutyCycleWaitTime, &MacCtx.NvmCtx->AggregatedTimeOff );
@@ -2594,6 +2768,25 @@ static LoRaMacStatus_t SecureFrame( uint8_t txDr, uint8_t txCh )
     return LORAMAC_STATUS_OK;
 }
 
+static void SetupNextChanParams( NextChanParams_t* nextChan, TimerTime_t aggrTimeOff, uint16_t pktLen )
+{
+    nextChan->AggrTimeOff = aggrTimeOff;
+    nextChan->Datarate = MacCtx.NvmCtx->MacParams.ChannelsDatarate;
+    nextChan->DutyCycleEnabled = MacCtx.NvmCtx->DutyCycleOn;
+    nextChan->ElapsedTimeSinceStartUp = SysTimeSub( SysTimeGetMcuTime( ), MacCtx.NvmCtx->InitializationTime );
+    nextChan->LastAggrTx = MacCtx.NvmCtx->LastTxDoneTime;
+    nextChan->LastTxIsJoinRequest = false;
+    nextChan->Joined = true;
+    nextChan->PktLen = pktLen;
+
+    // Setup the parameters based on the join status
+    if( MacCtx.NvmCtx->NetworkActivation == ACTIVATION_TYPE_NONE )
+    {
+        nextChan->LastTxIsJoinRequest = true;
+        nextChan->Joined = false;
+    }
+}
+
 static void CalculateBackOff( void )
 {
     // Make sure that the calculation of the backoff time for the aggregated time off will only be done in
@@ -3384,6 +3577,9 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     MacCtx.NvmCtx->LastTxDoneTime = 0;
     MacCtx.NvmCtx->AggregatedTimeOff = 0;
 
+    // RX windows timing starts from the defaults
+    LoRaMacRxCalibrationReset( );
+
     // Initialize timers
     TimerInit( &MacCtx.TxDelayedTimer, OnTxDelayedTimerEvent );
     TimerInit( &MacCtx.RxWindowTimer1, OnRxWindow1TimerEvent );
@@ -3399,6 +3595,7 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
     MacCtx.RadioEvents.RxError = OnRadioRxError;
     MacCtx.RadioEvents.TxTimeout = OnRadioTxTimeout;
     MacCtx.RadioEvents.RxTimeout = OnRadioRxTimeout;
+    MacCtx.RadioEvents.PreambleDetected = OnRadioPreambleDetected;
     Radio.Init( &MacCtx.RadioEvents );
 
     // Initialize the Secure Element driver
@@ -3425,8 +3622,14 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t* primitives, LoRaMacC
         return LORAMAC_STATUS_CRYPTO_ERROR;
     }
 
-    // Random seed initialization
-    srand1( Radio.Random( ) );
+    // Random seed initialization, the secure element seeds its random
+    // generator from the radio once per boot
+    uint32_t randomSeed = 0;
+    if( SecureElementRandomNumber( &randomSeed ) != SECURE_ELEMENT_SUCCESS )
+    {
+        return LORAMAC_STATUS_CRYPTO_ERROR;
+    }
+    srand1( randomSeed );
 
     Radio.SetPublicNetwork( MacCtx.NvmCtx->PublicNetwork );
     Radio.Sleep( );
@@ -3536,6 +3739,42 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
     }
 }
 
+LoRaMacStatus_t LoRaMacQueryNextTxTime( uint8_t size, TimerTime_t* waitTime )
+{
+    NextChanParams_t nextChan;
+    TimerTime_t aggregatedTimeOff = MacCtx.NvmCtx->AggregatedTimeOff;
+    size_t macCmdsSize = 0;
+    uint8_t channel = 0;
+
+    if( waitTime == NULL )
+    {
+        return LORAMAC_STATUS_PARAMETER_INVALID;
+    }
+    *waitTime = 0;
+
+    if( LoRaMacIsBusy( ) == true )
+    {
+        return LORAMAC_STATUS_BUSY;
+    }
+    if( LoRaMacCommandsGetSizeSerializedCmds( &macCmdsSize ) != LORAMAC_COMMANDS_SUCCESS )
+    {
+        return LORAMAC_STATUS_MAC_COMMAD_ERROR;
+    }
+
+    // Back-off which CalculateBackOff will apply to the next uplink
+    if( aggregatedTimeOff == 0 )
+    {
+        aggregatedTimeOff = ( MacCtx.TxTimeOnAir * MacCtx.NvmCtx->AggregatedDCycle - MacCtx.TxTimeOnAir );
+    }
+
+    SetupNextChanParams( &nextChan, aggregatedTimeOff,
+                         LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE + MIN( macCmdsSize, LORA_MAC_COMMAND_MAX_FOPTS_LENGTH ) + size );
+
+    // The channel selection only brings the band credits up to date, the
+    // channel and the aggregated time-off are not applied
+    return RegionNextChannel( MacCtx.NvmCtx->Region, &nextChan, &channel, waitTime, &aggregatedTimeOff );
+}
+
 LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t* mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
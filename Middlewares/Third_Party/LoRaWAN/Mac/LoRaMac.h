@@ -2539,6 +2539,27 @@ void LoRaMacProcess( void );
  */
 LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo );
 
+/*!
+ * \brief   Queries the LoRaMAC when the duty cycle allows the next uplink with
+ *          a given application data payload size. The scheduled MAC commands and
+ *          the current datarate are taken into account. The MAC state is not
+ *          changed, the application can use the result to schedule the uplink
+ *          instead of sending it and getting \ref LORAMAC_STATUS_DUTYCYCLE_RESTRICTED.
+ *
+ * \param   [IN] size - Size of application data payload to be send next
+ *
+ * \param   [OUT] waitTime - Time in milliseconds until the uplink is allowed,
+ *                           0 if it is allowed now
+ *
+ * \retval  LoRaMacStatus_t Status of the operation. Possible returns are:
+ *          \ref LORAMAC_STATUS_OK,
+ *          \ref LORAMAC_STATUS_DUTYCYCLE_RESTRICTED,
+ *          \ref LORAMAC_STATUS_NO_CHANNEL_FOUND,
+ *          \ref LORAMAC_STATUS_BUSY,
+ *          \ref LORAMAC_STATUS_PARAMETER_INVALID.
+ */
+LoRaMacStatus_t LoRaMacQueryNextTxTime( uint8_t size, TimerTime_t* waitTime );
+
 /*!
  * \brief   LoRaMAC channel add service
  *
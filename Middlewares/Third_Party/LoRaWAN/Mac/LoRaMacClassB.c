@@ -79,6 +79,11 @@ static LoRaMacClassBCtx_t Ctx;
  */
 static TimerTime_t TimerTempCompensation( TimerTime_t period, float temperature )
 {
+#if ( RTC_TEMP_COMPENSATION_ENABLED == 1 )
+  // The RTC is compensated in hardware already, see rtc_temp_comp.h
+  ( void )temperature;
+  return period;
+#else
   float k = RTC_TEMP_COEFFICIENT;
   float kDev = RTC_TEMP_DEV_COEFFICIENT;
   float t = RTC_TEMP_TURNOVER;
@@ -110,6 +115,7 @@ static TimerTime_t TimerTempCompensation( TimerTime_t period, float temperature
 
   // Calculate the resulting period
   return ( UTIL_TIMER_Time_t ) interim;
+#endif /* RTC_TEMP_COMPENSATION_ENABLED == 1 */
 }
 
 /*!
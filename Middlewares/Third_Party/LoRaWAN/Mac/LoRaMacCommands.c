@@ -35,29 +35,29 @@
 #include "LoRaMacConfirmQueue.h"
 
 /*!
- * Number of MAC Command slots
+ * Number of MAC Command slots, at most 16 ( one bit each in a uint16_t )
  */
 #define NUM_OF_MAC_COMMANDS 15
 
+/*!
+ * Mask of all the MAC Command slots
+ */
+#define MAC_COMMANDS_SLOTS_MASK ( ( uint16_t )( ( 1UL << NUM_OF_MAC_COMMANDS ) - 1 ) )
+
+/*!
+ * List link of a slot without neighbour
+ */
+#define MAC_COMMANDS_NO_SLOT 0xFF
+
 /*!
  * Size of the CID field of MAC commands
  */
 #define CID_FIELD_SIZE 1
 
 /*!
- *  Mac Commands list structure
+ * Highest MAC command identifier handled
  */
-typedef struct sMacCommandsList
-{
-    /*
-     * First element of MAC command list.
-     */
-    MacCommand_t* First;
-    /*
-     * Last element of MAC command list.
-     */
-    MacCommand_t* Last;
-} MacCommandsList_t;
+#define MAC_COMMANDS_MAX_CID SRV_MAC_BEACON_FREQ_REQ
 
 /*!
  * LoRaMac Commands Context structure
@@ -65,9 +65,21 @@ typedef struct sMacCommandsList
 typedef struct sLoRaMacCommandsCtx
 {
     /*
-     * List of MAC command elements
+     * Slot of the first ( oldest ) MAC command
      */
-    MacCommandsList_t MacCommandList;
+    uint8_t First;
+    /*
+     * Slot of the last MAC command
+     */
+    uint8_t Last;
+    /*
+     * Bit n set when MacCommandSlots[n] holds a MAC command
+     */
+    uint16_t SlotsInUse;
+    /*
+     * Bit n set when MacCommandSlots[n] holds a sticky MAC command
+     */
+    uint16_t StickySlots;
     /*
      * Buffer to store MAC command elements
      */
@@ -78,6 +90,27 @@ typedef struct sLoRaMacCommandsCtx
     size_t SerializedCmdsSize;
 } LoRaMacCommandsCtx_t;
 
+/*!
+ * Size of the downlink MAC commands, CID included, 0 for the unknown ones
+ */
+static const uint8_t MacCommandsRxSize[MAC_COMMANDS_MAX_CID + 1] =
+{
+    [SRV_MAC_LINK_CHECK_ANS]        = 3, // cid + Margin + GwCnt
+    [SRV_MAC_LINK_ADR_REQ]          = 5, // cid + DataRate_TXPower + ChMask (2) + Redundancy
+    [SRV_MAC_DUTY_CYCLE_REQ]        = 2, // cid + DutyCyclePL
+    [SRV_MAC_RX_PARAM_SETUP_REQ]    = 5, // cid + DLsettings + Frequency (3)
+    [SRV_MAC_DEV_STATUS_REQ]        = 1, // cid
+    [SRV_MAC_NEW_CHANNEL_REQ]       = 6, // cid + ChIndex + Frequency (3) + DrRange
+    [SRV_MAC_RX_TIMING_SETUP_REQ]   = 2, // cid + Settings
+    [SRV_MAC_TX_PARAM_SETUP_REQ]    = 2, // cid + EIRP_DwellTime
+    [SRV_MAC_DL_CHANNEL_REQ]        = 5, // cid + ChIndex + Frequency (3)
+    [SRV_MAC_DEVICE_TIME_ANS]       = 6, // cid + Seconds (4) + Fractional seconds (1)
+    [SRV_MAC_PING_SLOT_INFO_ANS]    = 1, // cid
+    [SRV_MAC_PING_SLOT_CHANNEL_REQ] = 5, // cid + Frequency (3) + DR
+    [SRV_MAC_BEACON_TIMING_ANS]     = 4, // cid + TimingDelay (2) + Channel
+    [SRV_MAC_BEACON_FREQ_REQ]       = 4, // cid + Frequency (3)
+};
+
 /*!
  * Callback function to notify the upper layer about context change
  */
@@ -88,194 +121,101 @@ static LoRaMacCommandsNvmEvent CommandsNvmCtxChanged;
  */
 static LoRaMacCommandsCtx_t NvmCtx;
 
-/* Memory management functions */
+/* Slot management functions */
 
 /*!
- * \brief Determines if a MAC command slot is free
+ * \brief Returns the index of the lowest bit set
  *
- * \param[IN]     slot           - Slot to check
- * \retval                       - Status of the operation
+ * \param[IN]     mask           - Bit mask, not 0
+ * \retval                       - Bit index
  */
-static bool IsSlotFree( const MacCommand_t* slot )
+static uint8_t LowestSlot( uint16_t mask )
 {
-    uint8_t* mem = ( uint8_t* )slot;
+#if defined( __GNUC__ )
+    return ( uint8_t )__builtin_ctz( mask );
+#else
+    uint8_t slot = 0;
 
-    for( uint16_t size = 0; size < sizeof( MacCommand_t ); size++ )
+    while( ( mask & 0x0001 ) == 0 )
     {
-        if( mem[size] != 0x00 )
-        {
-            return false;
-        }
+        mask >>= 1;
+        slot++;
     }
-    return true;
+    return slot;
+#endif
 }
 
 /*!
- * \brief Allocates a new MAC command memory slot
+ * \brief Returns the slot index of a MAC command in use
  *
- * \retval                       - Pointer to slot
+ * \param[IN]     macCmd         - MAC command
+ * \retval                       - Slot index, MAC_COMMANDS_NO_SLOT if macCmd
+ *                                 is not a MAC command in use
  */
-static MacCommand_t* MallocNewMacCommandSlot( void )
+static uint8_t GetSlot( const MacCommand_t* macCmd )
 {
-    uint8_t itr = 0;
-
-    while( IsSlotFree( ( const MacCommand_t* )&NvmCtx.MacCommandSlots[itr] ) == false )
+    if( ( macCmd < &NvmCtx.MacCommandSlots[0] ) || ( macCmd >= &NvmCtx.MacCommandSlots[NUM_OF_MAC_COMMANDS] ) )
     {
-        itr++;
-        if( itr == NUM_OF_MAC_COMMANDS )
-        {
-            return NULL;
-        }
+        return MAC_COMMANDS_NO_SLOT;
     }
 
-    return &NvmCtx.MacCommandSlots[itr];
-}
+    uint8_t slot = ( uint8_t )( macCmd - NvmCtx.MacCommandSlots );
 
-/*!
- * \brief Free memory slot
- *
- * \param[IN]     slot           - Slot to free
- *
- * \retval                       - Status of the operation
- */
-static bool FreeMacCommandSlot( MacCommand_t* slot )
-{
-    if( slot == NULL )
-    {
-        return false;
-    }
-
-    memset1( ( uint8_t* )slot, 0x00, sizeof( MacCommand_t ) );
-
-    return true;
-}
-
-/* Linked list functions */
-
-/*!
- * \brief Initialize list
- *
- * \param[IN]     list           - List that shall be initialized
- * \retval                       - Status of the operation
- */
-static bool LinkedListInit( MacCommandsList_t* list )
-{
-    if( list == NULL )
+    if( ( NvmCtx.SlotsInUse & ( 1U << slot ) ) == 0 )
     {
-        return false;
+        return MAC_COMMANDS_NO_SLOT;
     }
-
-    list->First = NULL;
-    list->Last = NULL;
-
-    return true;
+    return slot;
 }
 
 /*!
- * \brief Add an element to the list
+ * \brief Unlinks and frees a slot in use
  *
- * \param[IN]     list           - List where the element shall be added.
- * \param[IN]     element        - Element to add
- * \retval                       - Status of the operation
+ * \param[IN]     slot           - Slot index
  */
-static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
+static void RemoveSlot( uint8_t slot )
 {
-    if( ( list == NULL ) || ( element == NULL ) )
-    {
-        return false;
-    }
+    MacCommand_t* macCmd = &NvmCtx.MacCommandSlots[slot];
 
-    // Check if this is the first entry to enter the list.
-    if( list->First == NULL )
+    if( macCmd->Prev == MAC_COMMANDS_NO_SLOT )
     {
-        list->First = element;
+        NvmCtx.First = macCmd->Next;
     }
-
-    // Check if the last entry exists and update its next point.
-    if( list->Last )
-    {
-        list->Last->Next = element;
-    }
-
-    // Update the next point of this entry.
-    element->Next = NULL;
-
-    // Update the last entry of the list.
-    list->Last = element;
-
-    return true;
-}
-
-/*!
- * \brief Return the previous element in the list.
- *
- * \param[IN]     list           - List
- * \param[IN]     element        - Element where the previous element shall be searched
- * \retval                       - Status of the operation
- */
-static MacCommand_t* LinkedListGetPrevious( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == NULL ) || ( element == NULL ) )
+    else
     {
-        return NULL;
+        NvmCtx.MacCommandSlots[macCmd->Prev].Next = macCmd->Next;
     }
 
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = list->First;
-
-    // When current element is the first of the list, there's no previous element so we can return NULL immediately.
-    if( element != curElement )
+    if( macCmd->Next == MAC_COMMANDS_NO_SLOT )
     {
-        // Loop through all elements until the end is reached or the next of current is the current element.
-        while( ( curElement != NULL ) && ( curElement->Next != element ) )
-        {
-            curElement = curElement->Next;
-        }
+        NvmCtx.Last = macCmd->Prev;
     }
     else
     {
-        curElement = NULL;
+        NvmCtx.MacCommandSlots[macCmd->Next].Prev = macCmd->Prev;
     }
 
-    return curElement;
+    NvmCtx.SerializedCmdsSize -= ( CID_FIELD_SIZE + macCmd->PayloadSize );
+    NvmCtx.SlotsInUse &= ~( 1U << slot );
+    NvmCtx.StickySlots &= ~( 1U << slot );
+
+    memset1( ( uint8_t* )macCmd, 0x00, sizeof( MacCommand_t ) );
 }
 
 /*!
- * \brief Remove an element from the list
+ * \brief Removes all the MAC commands of a slot mask
  *
- * \param[IN]     list           - List where the element shall be removed from.
- * \param[IN]     element        - Element to remove
- * \retval                       - Status of the operation
+ * \param[IN]     mask           - Slots to remove
  */
-static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
+static void RemoveSlots( uint16_t mask )
 {
-    if( ( list == NULL ) || ( element == NULL ) )
+    while( mask != 0 )
     {
-        return false;
-    }
+        uint8_t slot = LowestSlot( mask );
 
-    MacCommand_t* PrevElement = LinkedListGetPrevious( list, element );
-
-    if( list->First == element )
-    {
-        list->First = element->Next;
-    }
-
-    if( list->Last == element )
-    {
-        list->Last = PrevElement;
+        RemoveSlot( slot );
+        mask &= ~( 1U << slot );
     }
-
-    if( PrevElement != NULL )
-    {
-        PrevElement->Next = element->Next;
-    }
-
-    element->Next = NULL;
-
-    return true;
 }
 
 /*
@@ -315,7 +255,8 @@ LoRaMacCommandStatus_t LoRaMacCommandsInit( LoRaMacCommandsNvmEvent commandsNvmC
     // Initialize with default
     memset1( ( uint8_t* )&NvmCtx, 0, sizeof( NvmCtx ) );
 
-    LinkedListInit( &NvmCtx.MacCommandList );
+    NvmCtx.First = MAC_COMMANDS_NO_SLOT;
+    NvmCtx.Last = MAC_COMMANDS_NO_SLOT;
 
     // Assign callback
     CommandsNvmCtxChanged = commandsNvmCtxChanged;
@@ -349,27 +290,44 @@ LoRaMacCommandStatus_t LoRaMacCommandsAddCmd( uint8_t cid, uint8_t* payload, siz
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* newCmd;
+    if( payloadSize > LORAMAC_COMMADS_MAX_NUM_OF_PARAMS )
+    {
+        return LORAMAC_COMMANDS_ERROR;
+    }
 
-    // Allocate a memory slot
-    newCmd = MallocNewMacCommandSlot( );
+    uint16_t freeSlots = ~NvmCtx.SlotsInUse & MAC_COMMANDS_SLOTS_MASK;
 
-    if( newCmd == NULL )
+    if( freeSlots == 0 )
     {
         return LORAMAC_COMMANDS_ERROR_MEMORY;
     }
 
-    // Add it to the list of Mac commands
-    if( LinkedListAdd( &NvmCtx.MacCommandList, newCmd ) == false )
+    // Take a free slot and link it at the end of the list
+    uint8_t slot = LowestSlot( freeSlots );
+    MacCommand_t* newCmd = &NvmCtx.MacCommandSlots[slot];
+
+    newCmd->Prev = NvmCtx.Last;
+    newCmd->Next = MAC_COMMANDS_NO_SLOT;
+    if( NvmCtx.Last == MAC_COMMANDS_NO_SLOT )
     {
-        return LORAMAC_COMMANDS_ERROR;
+        NvmCtx.First = slot;
     }
+    else
+    {
+        NvmCtx.MacCommandSlots[NvmCtx.Last].Next = slot;
+    }
+    NvmCtx.Last = slot;
+    NvmCtx.SlotsInUse |= ( 1U << slot );
 
     // Set Values
     newCmd->CID = cid;
     newCmd->PayloadSize = payloadSize;
     memcpy1( ( uint8_t* )newCmd->Payload, payload, payloadSize );
     newCmd->IsSticky = IsSticky( cid );
+    if( newCmd->IsSticky == true )
+    {
+        NvmCtx.StickySlots |= ( 1U << slot );
+    }
 
     NvmCtx.SerializedCmdsSize += ( CID_FIELD_SIZE + payloadSize );
 
@@ -385,19 +343,14 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
 
-    // Remove the Mac command element from MacCommandList
-    if( LinkedListRemove( &NvmCtx.MacCommandList, macCmd ) == false )
+    uint8_t slot = GetSlot( macCmd );
+
+    if( slot == MAC_COMMANDS_NO_SLOT )
     {
         return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
     }
 
-    NvmCtx.SerializedCmdsSize -= ( CID_FIELD_SIZE + macCmd->PayloadSize );
-
-    // Free the MacCommand Slot
-    if( FreeMacCommandSlot( macCmd ) == false )
-    {
-        return LORAMAC_COMMANDS_ERROR;
-    }
+    RemoveSlot( slot );
 
     NvmCtxCallback( );
 
@@ -406,50 +359,27 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveCmd( MacCommand_t* macCmd )
 
 LoRaMacCommandStatus_t LoRaMacCommandsGetCmd( uint8_t cid, MacCommand_t** macCmd )
 {
-    MacCommand_t* curElement;
+    uint8_t slot = NvmCtx.First;
 
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements until we find the element with the given CID
-    while( ( curElement != NULL ) && ( curElement->CID != cid ) )
+    // Loop through all elements, oldest first, until we find the element with the given CID
+    while( ( slot != MAC_COMMANDS_NO_SLOT ) && ( NvmCtx.MacCommandSlots[slot].CID != cid ) )
     {
-        curElement = curElement->Next;
+        slot = NvmCtx.MacCommandSlots[slot].Next;
     }
 
-    // Update the pointer anyway
-    *macCmd = curElement;
-
     // Handle error in case if we reached the end without finding it.
-    if( curElement == NULL )
+    if( slot == MAC_COMMANDS_NO_SLOT )
     {
+        *macCmd = NULL;
         return LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND;
     }
+    *macCmd = &NvmCtx.MacCommandSlots[slot];
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveNoneStickyCmds( void )
 {
-    MacCommand_t* curElement;
-    MacCommand_t* nexElement;
-
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements
-    while( curElement != NULL )
-    {
-        if( curElement->IsSticky == false )
-        {
-            nexElement = curElement->Next;
-            LoRaMacCommandsRemoveCmd( curElement );
-            curElement = nexElement;
-        }
-        else
-        {
-            curElement = curElement->Next;
-        }
-    }
+    RemoveSlots( NvmCtx.SlotsInUse & ~NvmCtx.StickySlots );
 
     NvmCtxCallback( );
 
@@ -458,22 +388,7 @@ LoRaMacCommandStatus_t LoRaMacCommandsRemoveNoneStickyCmds( void )
 
 LoRaMacCommandStatus_t LoRaMacCommandsRemoveStickyAnsCmds( void )
 {
-    MacCommand_t* curElement;
-    MacCommand_t* nexElement;
-
-    // Start at the head of the list
-    curElement = NvmCtx.MacCommandList.First;
-
-    // Loop through all elements
-    while( curElement != NULL )
-    {
-        nexElement = curElement->Next;
-        if( IsSticky( curElement->CID ) == true )
-        {
-            LoRaMacCommandsRemoveCmd( curElement );
-        }
-        curElement = nexElement;
-    }
+    RemoveSlots( NvmCtx.StickySlots );
 
     NvmCtxCallback( );
 
@@ -492,8 +407,7 @@ LoRaMacCommandStatus_t LoRaMacCommandsGetSizeSerializedCmds( size_t* size )
 
 LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_t* effectiveSize, uint8_t* buffer )
 {
-    MacCommand_t* curElement = NvmCtx.MacCommandList.First;
-    MacCommand_t* nextElement;
+    uint8_t slot = NvmCtx.First;
     uint8_t itr = 0;
 
     if( ( buffer == NULL ) || ( effectiveSize == NULL ) )
@@ -502,8 +416,10 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
     }
 
     // Loop through all elements which fits into the buffer
-    while( curElement != NULL )
+    while( slot != MAC_COMMANDS_NO_SLOT )
     {
+        MacCommand_t* curElement = &NvmCtx.MacCommandSlots[slot];
+
         // If the next MAC command still fits into the buffer, add it.
         if( ( availableSize - itr ) >= ( CID_FIELD_SIZE + curElement->PayloadSize ) )
         {
@@ -515,17 +431,19 @@ LoRaMacCommandStatus_t LoRaMacCommandsSerializeCmds( size_t availableSize, size_
         {
             break;
         }
-        curElement = curElement->Next;
+        slot = curElement->Next;
     }
 
     // Remove all commands which do not fit into the buffer
-    while( curElement != NULL )
+    while( slot != MAC_COMMANDS_NO_SLOT )
     {
         // Store the next element before removing the current one
-        nextElement = curElement->Next;
-        LoRaMacCommandsRemoveCmd( curElement );
-        curElement = nextElement;
+        uint8_t nextSlot = NvmCtx.MacCommandSlots[slot].Next;
+
+        RemoveSlot( slot );
+        slot = nextSlot;
     }
+    NvmCtxCallback( );
 
     // Fetch the effective size of the mac commands
     LoRaMacCommandsGetSizeSerializedCmds( effectiveSize );
@@ -539,122 +457,18 @@ LoRaMacCommandStatus_t LoRaMacCommandsStickyCmdsPending( bool* cmdsPending )
     {
         return LORAMAC_COMMANDS_ERROR_NPE;
     }
-    MacCommand_t* curElement;
-    curElement = NvmCtx.MacCommandList.First;
 
-    *cmdsPending = false;
-
-    // Loop through all elements
-    while( curElement != NULL )
-    {
-        if( curElement->IsSticky == true )
-        {
-            // Found one sticky MAC command
-            *cmdsPending = true;
-            return LORAMAC_COMMANDS_SUCCESS;
-        }
-        curElement = curElement->Next;
-    }
+    *cmdsPending = ( NvmCtx.StickySlots != 0 );
 
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
 uint8_t LoRaMacCommandsGetCmdSize( uint8_t cid )
 {
-    uint8_t cidSize = 0;
-
-    // Decode Frame MAC commands
-    switch( cid )
+    if( cid > MAC_COMMANDS_MAX_CID )
     {
-        case SRV_MAC_LINK_CHECK_ANS:
-        {
-            // cid + Margin + GwCnt
-            cidSize = 3;
-            break;
-        }
-        case SRV_MAC_LINK_ADR_REQ:
-        {
-            // cid + DataRate_TXPower + ChMask (2) + Redundancy
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_DUTY_CYCLE_REQ:
-        {
-            // cid + DutyCyclePL
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_RX_PARAM_SETUP_REQ:
-        {
-            // cid + DLsettings + Frequency (3)
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_DEV_STATUS_REQ:
-        {
-            // cid
-            cidSize = 1;
-            break;
-        }
-        case SRV_MAC_NEW_CHANNEL_REQ:
-        {
-            // cid + ChIndex + Frequency (3) + DrRange
-            cidSize = 6;
-            break;
-        }
-        case SRV_MAC_RX_TIMING_SETUP_REQ:
-        {
-            // cid + Settings
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_TX_PARAM_SETUP_REQ:
-        {
-            // cid + EIRP_DwellTime
-            cidSize = 2;
-            break;
-        }
-        case SRV_MAC_DL_CHANNEL_REQ:
-        {
-            // cid + ChIndex + Frequency (3)
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_DEVICE_TIME_ANS:
-        {
-            // cid + Seconds (4) + Fractional seconds (1)
-            cidSize = 6;
-            break;
-        }
-        case SRV_MAC_PING_SLOT_INFO_ANS:
-        {
-            // cid
-            cidSize = 1;
-            break;
-        }
-        case SRV_MAC_PING_SLOT_CHANNEL_REQ:
-        {
-            // cid + Frequency (3) + DR
-            cidSize = 5;
-            break;
-        }
-        case SRV_MAC_BEACON_TIMING_ANS:
-        {
-            // cid + TimingDelay (2) + Channel
-            cidSize = 4;
-            break;
-        }
-        case SRV_MAC_BEACON_FREQ_REQ:
-        {
-            // cid + Frequency (3)
-            cidSize = 4;
-            break;
-        }
-        default:
-        {
-            // Unknown command. ABORT MAC commands processing
-            break;
-        }
+        // Unknown command. ABORT MAC commands processing
+        return 0;
     }
-    return cidSize;
+    return MacCommandsRxSize[cid];
 }
@@ -58,9 +58,13 @@ typedef struct sMacCommand MacCommand_t;
 struct sMacCommand
 {
     /*!
-     *  The pointer to the next MAC Command element in the list
+     * Slot of the previous MAC Command element in the list
      */
-    MacCommand_t* Next;
+    uint8_t Prev;
+    /*!
+     * Slot of the next MAC Command element in the list
+     */
+    uint8_t Next;
     /*!
      * MAC command identifier
      */
@@ -222,7 +226,7 @@ LoRaMacCommandStatus_t LoRaMacCommandsStickyCmdsPending( bool* cmdsPending );
  *
  * \param[IN]   cid                - MAC command identifier
  *
- * \retval Size of the command.
+ * \retval Size of the command, CID included, 0 for an unknown command.
  */
 uint8_t LoRaMacCommandsGetCmdSize( uint8_t cid );
 
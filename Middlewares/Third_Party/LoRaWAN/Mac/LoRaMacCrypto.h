@@ -50,9 +50,10 @@ extern "C"
 #include "LoRaMacMessageTypes.h"
 
 /*!
- * Indicates if a random devnonce must be used or not
+ * Indicates if a random devnonce must be used or not.
+ * The counter needs to be kept across resets, see LoRaMacCryptoSetDevNonce.
  */
-#define USE_RANDOM_DEV_NONCE                        1
+#define USE_RANDOM_DEV_NONCE                        0
 
 /*!
  * Indicates if JoinNonce is counter based and requires to be checked
@@ -215,6 +216,23 @@ LoRaMacCryptoStatus_t LoRaMacCryptoGetFCntDown( FCntIdentifier_t fCntID, uint16_
  */
 LoRaMacCryptoStatus_t LoRaMacCryptoGetFCntUp( uint32_t* currentUp );
 
+/*!
+ * Returns the DevNonce of the last join request.
+ *
+ * \param[OUT]    devNonce       - DevNonce of the last join request
+ * \retval                       - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoGetDevNonce( uint16_t* devNonce );
+
+/*!
+ * Sets the DevNonce of the last join request, e.g. restored from non-volatile
+ * memory. The next join request uses devNonce + 1.
+ *
+ * \param[IN]     devNonce       - DevNonce of the last join request
+ * \retval                       - Status of the operation
+ */
+LoRaMacCryptoStatus_t LoRaMacCryptoSetDevNonce( uint16_t devNonce );
+
 /*!
  * Provides multicast context.
  *
@@ -0,0 +1,208 @@
+/*!
+ * \file      LoRaMacRxCalibration.c
+ *
+ * \brief     LoRa MAC RX windows timing calibration
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ */
+#include "utilities.h"
+#include "LoRaMac.h"
+#include "LoRaMacRxCalibration.h"
+
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+/*!
+ * Weight of a new sample, 1 / 2^RX_CALIBRATION_FILTER_SHIFT. The older samples
+ * fade out, so that the calibration follows the drift over temperature.
+ */
+#define RX_CALIBRATION_FILTER_SHIFT                 3
+
+/*!
+ * Fixed point unit of the sample weights
+ */
+#define RX_CALIBRATION_WEIGHT                       256
+
+/*!
+ * Spread of the RX delays of the samples [ms], below which the drift can not
+ * be told from the bias. The last drift estimated is kept then.
+ */
+#define RX_CALIBRATION_MIN_DELAY_SPREAD             250
+
+/*!
+ * Bound of the drift estimated [ppm]
+ */
+#define RX_CALIBRATION_MAX_DRIFT                    100000
+
+/*!
+ * Timing error allowed, in number of mean absolute deviations of the
+ * prediction residuals
+ */
+#define RX_CALIBRATION_DEVIATION_FACTOR             4
+
+/*!
+ * Calibration context
+ */
+typedef struct sRxCalibrationCtx
+{
+    /*!
+     * Exponentially weighted sums of the samples: weight, RX delay, error,
+     * RX delay squared and RX delay times error
+     */
+    int64_t SumW;
+    int64_t SumD;
+    int64_t SumE;
+    int64_t SumDD;
+    int64_t SumDE;
+    /*!
+     * Exponentially weighted sums of the absolute prediction residuals [us]
+     * and of their weights
+     */
+    int64_t SumRes;
+    int64_t SumResW;
+    /*!
+     * Timing error at a null RX delay [us]
+     */
+    int32_t Bias;
+    /*!
+     * Clock drift [ppm]. Positive if the end-device clock runs fast.
+     */
+    int32_t Drift;
+    /*!
+     * Number of samples, saturated at LORAMAC_RX_CALIBRATION_MIN_SAMPLES
+     */
+    uint8_t NbSamples;
+    /*!
+     * Number of failures in a row
+     */
+    uint8_t NbFailures;
+}RxCalibrationCtx_t;
+
+/*!
+ * Calibration context
+ */
+static RxCalibrationCtx_t RxCalibrationCtx;
+
+/*!
+ * \brief Predicts the timing error of a downlink
+ *
+ * \param [IN] rxDelay Nominal delay of the RX window [ms].
+ *
+ * \retval Predicted timing error [us].
+ */
+static int32_t Predict( uint32_t rxDelay )
+{
+    return RxCalibrationCtx.Bias + ( int32_t )( ( ( int64_t )RxCalibrationCtx.Drift * rxDelay ) / 1000 );
+}
+
+/*!
+ * \brief Adds a value to an exponentially weighted sum
+ */
+static void Accumulate( int64_t* sum, int64_t value )
+{
+    *sum = *sum - ( *sum >> RX_CALIBRATION_FILTER_SHIFT ) + value * RX_CALIBRATION_WEIGHT;
+}
+
+/*!
+ * \brief Fits the bias and the drift to the weighted samples
+ */
+static void Fit( void )
+{
+    RxCalibrationCtx_t* ctx = &RxCalibrationCtx;
+    int64_t spread = ( int64_t )RX_CALIBRATION_MIN_DELAY_SPREAD * ctx->SumW;
+    // Both are the weight squared times the ( co )variance
+    int64_t varD = ( ctx->SumDD * ctx->SumW ) - ( ctx->SumD * ctx->SumD );
+    int64_t covDE = ( ctx->SumDE * ctx->SumW ) - ( ctx->SumD * ctx->SumE );
+
+    if( varD >= ( spread * spread ) )
+    {
+        int64_t drift = covDE / ( varD / 1000000 );
+
+        ctx->Drift = ( int32_t )MIN( MAX( drift, -RX_CALIBRATION_MAX_DRIFT ), RX_CALIBRATION_MAX_DRIFT );
+    }
+    ctx->Bias = ( int32_t )( ( ( ctx->SumE * 1000 ) - ( ( ( int64_t )ctx->Drift * ctx->SumD ) / 1000 ) ) / ctx->SumW );
+}
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+
+void LoRaMacRxCalibrationReset( void )
+{
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+    memset1( ( uint8_t* )&RxCalibrationCtx, 0, sizeof( RxCalibrationCtx_t ) );
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+}
+
+void LoRaMacRxCalibrationAddSample( uint32_t rxDelay, int32_t error )
+{
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+    RxCalibrationCtx_t* ctx = &RxCalibrationCtx;
+
+    if( ctx->NbSamples > 0 )
+    {
+        // Jitter: residual of the prediction made before this sample
+        int32_t residual = ( error * 1000 ) - Predict( rxDelay );
+
+        Accumulate( &ctx->SumRes, ( residual < 0 ) ? -residual : residual );
+        Accumulate( &ctx->SumResW, 1 );
+    }
+    Accumulate( &ctx->SumW, 1 );
+    Accumulate( &ctx->SumD, rxDelay );
+    Accumulate( &ctx->SumE, error );
+    Accumulate( &ctx->SumDD, ( int64_t )rxDelay * rxDelay );
+    Accumulate( &ctx->SumDE, ( int64_t )rxDelay * error );
+    Fit( );
+
+    if( ctx->NbSamples < LORAMAC_RX_CALIBRATION_MIN_SAMPLES )
+    {
+        ctx->NbSamples++;
+    }
+    ctx->NbFailures = 0;
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+}
+
+void LoRaMacRxCalibrationAddFailure( void )
+{
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+    // Failures of the default windows are not the calibration's business
+    if( LoRaMacRxCalibrationIsActive( ) == false )
+    {
+        return;
+    }
+    RxCalibrationCtx.NbFailures++;
+    if( RxCalibrationCtx.NbFailures >= LORAMAC_RX_CALIBRATION_MAX_FAILURES )
+    {
+        LoRaMacRxCalibrationReset( );
+    }
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+}
+
+bool LoRaMacRxCalibrationGetWindow( uint32_t rxDelay, uint32_t maxRxError, int32_t* correction, uint32_t* rxError )
+{
+    *correction = 0;
+    *rxError = maxRxError;
+
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+    if( LoRaMacRxCalibrationIsActive( ) == true )
+    {
+        int32_t prediction = Predict( rxDelay );
+        int32_t deviation = ( int32_t )( RxCalibrationCtx.SumRes / RxCalibrationCtx.SumResW );
+        int32_t rounding;
+
+        // Round to the timer resolution, the rounding error adds to the window
+        *correction = ( prediction + ( ( prediction < 0 ) ? -500 : 500 ) ) / 1000;
+        rounding = prediction - ( *correction * 1000 );
+        rounding = ( rounding < 0 ) ? -rounding : rounding;
+
+        *rxError = DIVC( ( RX_CALIBRATION_DEVIATION_FACTOR * deviation ) + rounding, 1000 ) + LORAMAC_RX_CALIBRATION_MARGIN;
+        *rxError = MIN( *rxError, maxRxError );
+        return true;
+    }
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+    return false;
+}
+
+bool LoRaMacRxCalibrationIsActive( void )
+{
+#if ( LORAMAC_RX_CALIBRATION_ENABLED == 1 )
+    return ( RxCalibrationCtx.NbSamples >= LORAMAC_RX_CALIBRATION_MIN_SAMPLES );
+#else
+    return false;
+#endif /* LORAMAC_RX_CALIBRATION_ENABLED == 1 */
+}
@@ -0,0 +1,109 @@
+/*!
+ * \file      LoRaMacRxCalibration.h
+ *
+ * \brief     LoRa MAC RX windows timing calibration
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  LORAMACRXCALIBRATION LoRa MAC RX windows timing calibration
+ *            Learns where the downlinks really start on the end-device clock.
+ *            Each downlink received in RX1 or RX2 gives a timing error
+ *            ( preamble detection versus the scheduled window ), modelled as
+ *            Error = Bias + Drift * RxDelay:
+ *            - Bias:  radio wake-up and software latencies not accounted for
+ *            - Drift: clock error of the timer ( RTC / LSE ) in ppm
+ *            Once enough downlinks were received, the windows are shifted by
+ *            the predicted error and sized for the measured jitter plus a
+ *            safety margin, instead of the fixed SystemMaxRxError.
+ *            The calibration falls back to the default windows after
+ *            LORAMAC_RX_CALIBRATION_MAX_FAILURES failures in a row.
+ * \{
+ */
+#ifndef __LORAMACRXCALIBRATION_H__
+#define __LORAMACRXCALIBRATION_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ * Number of downlinks to receive before the calibrated windows are used
+ */
+#ifndef LORAMAC_RX_CALIBRATION_MIN_SAMPLES
+#define LORAMAC_RX_CALIBRATION_MIN_SAMPLES          4
+#endif
+
+/*!
+ * Number of failures in a row after which the calibration restarts from
+ * the default windows
+ */
+#ifndef LORAMAC_RX_CALIBRATION_MAX_FAILURES
+#define LORAMAC_RX_CALIBRATION_MAX_FAILURES         2
+#endif
+
+/*!
+ * Safety margin added to the measured timing error [ms].
+ * Covers the resolution of the timestamps ( TX done and preamble detection )
+ */
+#ifndef LORAMAC_RX_CALIBRATION_MARGIN
+#define LORAMAC_RX_CALIBRATION_MARGIN               2
+#endif
+
+/*!
+ * \brief Restarts the calibration, the default windows are used until
+ *        LORAMAC_RX_CALIBRATION_MIN_SAMPLES downlinks were received.
+ */
+void LoRaMacRxCalibrationReset( void );
+
+/*!
+ * \brief Adds the timing error measured on a received downlink.
+ *
+ * \param [IN] rxDelay Nominal delay between the end of the uplink and the
+ *                     start of the downlink [ms].
+ *
+ * \param [IN] error   Time at which the preamble was detected minus the
+ *                     time it was expected at [ms].
+ */
+void LoRaMacRxCalibrationAddSample( uint32_t rxDelay, int32_t error );
+
+/*!
+ * \brief Notifies a failure of the calibrated windows: an expected downlink
+ *        was not received, or it was detected too close to the opening of
+ *        the window to tell where it started.
+ */
+void LoRaMacRxCalibrationAddFailure( void );
+
+/*!
+ * \brief Computes the timing of a RX window.
+ *
+ * \param [IN] rxDelay       Nominal delay of the RX window [ms].
+ *
+ * \param [IN] maxRxError    Default timing error, see SystemMaxRxError [ms].
+ *
+ * \param [OUT] correction   Correction to add to the window delay [ms].
+ *
+ * \param [OUT] rxError      Timing error to size the window for [ms], never
+ *                           above maxRxError.
+ *
+ * \retval Returns true, if the window is calibrated.
+ */
+bool LoRaMacRxCalibrationGetWindow( uint32_t rxDelay, uint32_t maxRxError, int32_t* correction, uint32_t* rxError );
+
+/*!
+ * \brief Tells whether the calibrated windows are in use.
+ *
+ * \retval Returns true, if the calibrated windows are in use.
+ */
+bool LoRaMacRxCalibrationIsActive( void );
+
+/*! \} defgroup LORAMACRXCALIBRATION */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LORAMACRXCALIBRATION_H__
@@ -1102,6 +1102,10 @@ typedef struct sRxConfigParams
      * RX frequency.
      */
     uint32_t Frequency;
+    /*!
+     * RX symbol time [ns], see RegionCommonComputeSymbolTimeLoRa
+     */
+    uint32_t SymbolTime;
     /*!
      * RX window timeout
      */
@@ -1550,6 +1554,20 @@ bool RegionRxConfig( LoRaMacRegion_t region, RxConfigParams_t* rxConfig, int8_t*
  */
 void RegionComputeRxWindowParameters( LoRaMacRegion_t region, int8_t datarate, uint8_t minRxSymbols, uint32_t rxError, RxConfigParams_t *rxConfigParams );
 
+/*!
+ * \brief Computes the time-on-air of an uplink, e.g. to choose the payload
+ *        size of the next uplink.
+ *
+ * \param [IN] region LoRaWAN region.
+ *
+ * \param [IN] datarate Uplink datarate.
+ *
+ * \param [IN] pktLen PHY payload size.
+ *
+ * \retval Returns the time-on-air in ms.
+ */
+TimerTime_t RegionGetTimeOnAir( LoRaMacRegion_t region, int8_t datarate, uint16_t pktLen );
+
 /*!
  * \brief TX configuration.
  *
@@ -1719,6 +1737,10 @@ void RegionRxBeaconSetup( LoRaMacRegion_t region, RxBeaconSetup_t* rxBeaconSetup
  */
 Version_t RegionGetVersion( void );
 
+#if ( defined( REGION_SINGLE_ENABLED ) && ( REGION_SINGLE_ENABLED == 1 ) )
+#include "RegionSingle.h"
+#endif /* REGION_SINGLE_ENABLED == 1 */
+
 /*! \} defgroup REGION */
 
 #ifdef __cplusplus
@@ -129,6 +129,11 @@ typedef struct sRegionAS923NvmCtx
  */
 static RegionAS923NvmCtx_t NvmCtx;
 
+/*
+ * Usable channels per datarate, see RegionCommonCountNbOfEnabledChannels.
+ */
+static RegionCommonChannelsCache_t ChannelsCache;
+
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -184,21 +189,30 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+/*!
+ * Uplink time-on-air in ms per datarate and PHY payload size
+ */
+static const uint16_t TimeOnAirAS923[][REGION_COMMON_TOA_TABLE_SIZE] =
 {
-    int8_t phyDr = DataratesAS923[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
-    TimerTime_t timeOnAir = 0;
-
-    if( datarate == DR_7 )
-    { // High Speed FSK channel
-        timeOnAir = Radio.TimeOnAir( MODEM_FSK, bandwidth, phyDr * 1000, 0, 5, false, pktLen, true );
-    }
-    else
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 12, 0 ), // DR_0
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 11, 0 ), // DR_1
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 10, 0 ), // DR_2
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 9, 0 ),  // DR_3
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 0 ),  // DR_4
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 0 ),  // DR_5
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 1 ),  // DR_6
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_FSK, 50, 0 ),  // DR_7
+};
+
+TimerTime_t RegionAS923GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( TimeOnAirAS923 ) / sizeof( TimeOnAirAS923[0] ) ) ) )
     {
-        timeOnAir = Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+        // The radio takes the size as an uint8_t
+        return TimeOnAirAS923[datarate][( uint8_t )pktLen];
     }
-    return timeOnAir;
+    // Not a datarate of the region
+    return 0;
 }
 
 PhyParam_t RegionAS923GetPhyParam( GetPhyParams_t* getPhy )
@@ -446,6 +460,9 @@ void RegionAS923InitDefaults( InitDefaultsParams_t* params )
         AS923_BAND0
     };
 
+    // The channels are set up or restored
+    RegionCommonChannelsCacheReset( &ChannelsCache );
+
     switch( params->Type )
     {
         case INIT_TYPE_DEFAULTS:
@@ -647,6 +664,7 @@ void RegionAS923ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
         tSymbol = RegionCommonComputeSymbolTimeLoRa( DataratesAS923[rxConfigParams->Datarate], BandwidthsAS923[rxConfigParams->Datarate] );
     }
 
+    rxConfigParams->SymbolTime = tSymbol;
     RegionCommonComputeRxWindowParameters( tSymbol, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
 }
 
@@ -739,7 +757,7 @@ bool RegionAS923TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     /* ST_WORKAROUND_END */
 
     // Update time-on-air
-    *txTimeOnAir = GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
+    *txTimeOnAir = RegionAS923GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
 
     // Setup maximum payload length of the radio driver
     Radio.SetMaxPayloadLength( modem, txConfig->PktLen );
@@ -990,6 +1008,7 @@ LoRaMacStatus_t RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = NvmCtx.Bands;
     countChannelsParams.MaxNbChannels = AS923_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = AS923_JOIN_CHANNELS;
+    countChannelsParams.Cache = &ChannelsCache;
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -998,7 +1017,7 @@ LoRaMacStatus_t RegionAS923NextChannel( NextChanParams_t* nextChanParams, uint8_
 
     identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
     identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
-    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+    identifyChannelsParam.ExpectedTimeOnAir = RegionAS923GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
 
     identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
 
@@ -1094,6 +1113,7 @@ LoRaMacStatus_t RegionAS923ChannelAdd( ChannelAddParams_t* channelAdd )
         return LORAMAC_STATUS_FREQUENCY_INVALID;
     }
 
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     memcpy1( ( uint8_t* ) &(NvmCtx.Channels[id]), ( uint8_t* ) channelAdd->NewChannel, sizeof( NvmCtx.Channels[id] ) );
     NvmCtx.Channels[id].Band = 0;
     NvmCtx.ChannelsMask[0] |= ( 1 << id );
@@ -1110,6 +1130,7 @@ bool RegionAS923ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
     }
 
     // Remove the channel from the list of channels
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     NvmCtx.Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
 
     return RegionCommonChanDisable( NvmCtx.ChannelsMask, id, AS923_MAX_NB_CHANNELS );
@@ -440,6 +440,17 @@ void RegionAS923ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
  */
 bool RegionAS923RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate );
 
+/*!
+ * \brief Computes the time-on-air of an uplink.
+ *
+ * \param [IN] datarate Uplink datarate.
+ *
+ * \param [IN] pktLen PHY payload size.
+ *
+ * \retval Returns the time-on-air in ms.
+ */
+TimerTime_t RegionAS923GetTimeOnAir( int8_t datarate, uint16_t pktLen );
+
 /*!
  * \brief TX configuration.
  *
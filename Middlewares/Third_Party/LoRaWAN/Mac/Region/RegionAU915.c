@@ -140,12 +140,37 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+/*!
+ * Uplink time-on-air in ms per datarate and PHY payload size
+ */
+static const uint16_t TimeOnAirAU915[][REGION_COMMON_TOA_TABLE_SIZE] =
 {
-    int8_t phyDr = DataratesAU915[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 12, 0 ), // DR_0
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 11, 0 ), // DR_1
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 10, 0 ), // DR_2
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 9, 0 ),  // DR_3
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 0 ),  // DR_4
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 0 ),  // DR_5
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 2 ),  // DR_6
+};
+
+TimerTime_t RegionAU915GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( TimeOnAirAU915 ) / sizeof( TimeOnAirAU915[0] ) ) ) )
+    {
+        // The radio takes the size as an uint8_t
+        return TimeOnAirAU915[datarate][( uint8_t )pktLen];
+    }
+    // The downlink datarates of the region
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( DataratesAU915 ) / sizeof( DataratesAU915[0] ) ) ) )
+    {
+        int8_t phyDr = DataratesAU915[datarate];
+        uint32_t bandwidth = GetBandwidth( datarate );
 
-    return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+        return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+    }
+    // Not a datarate of the region
+    return 0;
 }
 
 PhyParam_t RegionAU915GetPhyParam( GetPhyParams_t* getPhy )
@@ -607,6 +632,7 @@ void RegionAU915ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
 
     tSymbol = RegionCommonComputeSymbolTimeLoRa( DataratesAU915[rxConfigParams->Datarate], BandwidthsAU915[rxConfigParams->Datarate] );
 
+    rxConfigParams->SymbolTime = tSymbol;
     RegionCommonComputeRxWindowParameters( tSymbol, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
 }
 
@@ -674,7 +700,7 @@ bool RegionAU915TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     // Setup maximum payload length of the radio driver
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
     // Update time-on-air
-    *txTimeOnAir = GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
+    *txTimeOnAir = RegionAU915GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
 
     *txPower = txPowerLimited;
     return true;
@@ -938,6 +964,7 @@ LoRaMacStatus_t RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = NvmCtx.Bands;
     countChannelsParams.MaxNbChannels = AU915_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = 0;
+    countChannelsParams.Cache = NULL;
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -946,7 +973,7 @@ LoRaMacStatus_t RegionAU915NextChannel( NextChanParams_t* nextChanParams, uint8_
 
     identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
     identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
-    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+    identifyChannelsParam.ExpectedTimeOnAir = RegionAU915GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
 
     identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
 
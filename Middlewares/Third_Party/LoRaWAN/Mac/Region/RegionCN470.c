@@ -128,12 +128,28 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+/*!
+ * Uplink time-on-air in ms per datarate and PHY payload size
+ */
+static const uint16_t TimeOnAirCN470[][REGION_COMMON_TOA_TABLE_SIZE] =
 {
-    int8_t phyDr = DataratesCN470[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
-
-    return Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 12, 0 ), // DR_0
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 11, 0 ), // DR_1
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 10, 0 ), // DR_2
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 9, 0 ),  // DR_3
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 0 ),  // DR_4
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 0 ),  // DR_5
+};
+
+TimerTime_t RegionCN470GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( TimeOnAirCN470 ) / sizeof( TimeOnAirCN470[0] ) ) ) )
+    {
+        // The radio takes the size as an uint8_t
+        return TimeOnAirCN470[datarate][( uint8_t )pktLen];
+    }
+    // Not a datarate of the region
+    return 0;
 }
 
 PhyParam_t RegionCN470GetPhyParam( GetPhyParams_t* getPhy )
@@ -514,6 +530,7 @@ void RegionCN470ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
 
     tSymbol = RegionCommonComputeSymbolTimeLoRa( DataratesCN470[rxConfigParams->Datarate], BandwidthsCN470[rxConfigParams->Datarate] );
 
+    rxConfigParams->SymbolTime = tSymbol;
     RegionCommonComputeRxWindowParameters( tSymbol, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
 }
 
@@ -580,7 +597,7 @@ bool RegionCN470TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     // Setup maximum payload length of the radio driver
     Radio.SetMaxPayloadLength( MODEM_LORA, txConfig->PktLen );
     // Update time-on-air
-    *txTimeOnAir = GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
+    *txTimeOnAir = RegionCN470GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
     *txPower = txPowerLimited;
 
     return true;
@@ -757,6 +774,7 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = NvmCtx.Bands;
     countChannelsParams.MaxNbChannels = CN470_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = 0;
+    countChannelsParams.Cache = NULL;
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -765,7 +783,7 @@ LoRaMacStatus_t RegionCN470NextChannel( NextChanParams_t* nextChanParams, uint8_
 
     identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
     identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
-    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+    identifyChannelsParam.ExpectedTimeOnAir = RegionCN470GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
 
     identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
 
@@ -64,6 +64,11 @@ typedef struct sRegionCN779NvmCtx
  */
 static RegionCN779NvmCtx_t NvmCtx;
 
+/*
+ * Usable channels per datarate, see RegionCommonCountNbOfEnabledChannels.
+ */
+static RegionCommonChannelsCache_t ChannelsCache;
+
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -119,21 +124,30 @@ static bool VerifyRfFreq( uint32_t freq )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+/*!
+ * Uplink time-on-air in ms per datarate and PHY payload size
+ */
+static const uint16_t TimeOnAirCN779[][REGION_COMMON_TOA_TABLE_SIZE] =
 {
-    int8_t phyDr = DataratesCN779[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
-    TimerTime_t timeOnAir = 0;
-
-    if( datarate == DR_7 )
-    { // High Speed FSK channel
-        timeOnAir = Radio.TimeOnAir( MODEM_FSK, bandwidth, phyDr * 1000, 0, 5, false, pktLen, true );
-    }
-    else
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 12, 0 ), // DR_0
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 11, 0 ), // DR_1
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 10, 0 ), // DR_2
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 9, 0 ),  // DR_3
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 0 ),  // DR_4
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 0 ),  // DR_5
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 1 ),  // DR_6
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_FSK, 50, 0 ),  // DR_7
+};
+
+TimerTime_t RegionCN779GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( TimeOnAirCN779 ) / sizeof( TimeOnAirCN779[0] ) ) ) )
     {
-        timeOnAir = Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+        // The radio takes the size as an uint8_t
+        return TimeOnAirCN779[datarate][( uint8_t )pktLen];
     }
-    return timeOnAir;
+    // Not a datarate of the region
+    return 0;
 }
 
 PhyParam_t RegionCN779GetPhyParam( GetPhyParams_t* getPhy )
@@ -342,6 +356,9 @@ void RegionCN779InitDefaults( InitDefaultsParams_t* params )
         CN779_BAND0
     };
 
+    // The channels are set up or restored
+    RegionCommonChannelsCacheReset( &ChannelsCache );
+
     switch( params->Type )
     {
         case INIT_TYPE_DEFAULTS:
@@ -531,6 +548,7 @@ void RegionCN779ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
         tSymbol = RegionCommonComputeSymbolTimeLoRa( DataratesCN779[rxConfigParams->Datarate], BandwidthsCN779[rxConfigParams->Datarate] );
     }
 
+    rxConfigParams->SymbolTime = tSymbol;
     RegionCommonComputeRxWindowParameters( tSymbol, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
 }
 
@@ -621,7 +639,7 @@ bool RegionCN779TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     /* ST_WORKAROUND_END */
 
     // Update time-on-air
-    *txTimeOnAir = GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
+    *txTimeOnAir = RegionCN779GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
 
     // Setup maximum payload length of the radio driver
     Radio.SetMaxPayloadLength( modem, txConfig->PktLen );
@@ -870,6 +888,7 @@ LoRaMacStatus_t RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = NvmCtx.Bands;
     countChannelsParams.MaxNbChannels = CN779_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = CN779_JOIN_CHANNELS;
+    countChannelsParams.Cache = &ChannelsCache;
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -878,7 +897,7 @@ LoRaMacStatus_t RegionCN779NextChannel( NextChanParams_t* nextChanParams, uint8_
 
     identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
     identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
-    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+    identifyChannelsParam.ExpectedTimeOnAir = RegionCN779GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
 
     identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
 
@@ -951,6 +970,7 @@ LoRaMacStatus_t RegionCN779ChannelAdd( ChannelAddParams_t* channelAdd )
         return LORAMAC_STATUS_FREQUENCY_INVALID;
     }
 
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     memcpy1( ( uint8_t* ) &(NvmCtx.Channels[id]), ( uint8_t* ) channelAdd->NewChannel, sizeof( NvmCtx.Channels[id] ) );
     NvmCtx.Channels[id].Band = 0;
     NvmCtx.ChannelsMask[0] |= ( 1 << id );
@@ -967,6 +987,7 @@ bool RegionCN779ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
     }
 
     // Remove the channel from the list of channels
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     NvmCtx.Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
 
     return RegionCommonChanDisable( NvmCtx.ChannelsMask, id, CN779_MAX_NB_CHANNELS );
@@ -44,15 +44,12 @@
 #define DUTY_CYCLE_TIME_PERIOD              3600000
 #endif
 
-static uint16_t GetDutyCycle( Band_t* band, bool joined, SysTime_t elapsedTimeSinceStartup )
+static uint16_t GetDutyCycle( Band_t* band, bool joined, uint16_t joinDutyCycle )
 {
-    uint16_t joinDutyCycle = RegionCommonGetJoinDc( elapsedTimeSinceStartup );
     uint16_t dutyCycle = band->DCycle;
 
     if( joined == false )
     {
-        // Get the join duty cycle which depends on the runtime
-        joinDutyCycle = RegionCommonGetJoinDc( elapsedTimeSinceStartup );
         // Take the most restrictive duty cycle
         dutyCycle = MAX( dutyCycle, joinDutyCycle );
     }
@@ -66,14 +63,14 @@ static uint16_t GetDutyCycle( Band_t* band, bool joined, SysTime_t elapsedTimeSi
     return dutyCycle;
 }
 
-static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, SysTime_t elapsedTimeSinceStartup )
+static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, uint16_t joinDutyCycle )
 {
     uint16_t dutyCycle = band->DCycle;
     uint8_t timePeriodFactor = 1;
 
     // Get the band duty cycle. If not joined, the function either returns the join duty cycle
     // or the band duty cycle, whichever is more restrictive.
-    dutyCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
+    dutyCycle = GetDutyCycle( band, joined, joinDutyCycle );
 
     if( joined == false )
     {
@@ -95,37 +92,35 @@ static uint16_t SetMaxTimeCredits( Band_t* band, bool joined, SysTime_t elapsedT
 }
 
 static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnabled,
-                                   bool lastTxIsJoinRequest, SysTime_t elapsedTimeSinceStartup,
+                                   bool lastTxIsJoinRequest, uint16_t joinDutyCycle,
                                    TimerTime_t currentTime )
 {
-    uint16_t dutyCycle = SetMaxTimeCredits( band, joined, elapsedTimeSinceStartup );
+    uint16_t dutyCycle = SetMaxTimeCredits( band, joined, joinDutyCycle );
 
-    if( joined == false )
+    if( ( dutyCycleEnabled == false ) &&
+        ( ( joined == true ) || ( lastTxIsJoinRequest == false ) ) )
     {
-        if( ( dutyCycleEnabled == false ) &&
-            ( lastTxIsJoinRequest == false ) )
-        {
-            // This is the case when the duty cycle is off and the last uplink frame was not a join.
-            // This could happen in case of a rejoin, e.g. in compliance test mode.
-            // In this special case we have to set the time off to 0, since the join duty cycle shall only
-            // be applied after the first join request.
-            band->TimeCredits = band->MaxTimeCredits;
-        }
+        // Without duty cycle the band always has all credits. When not joined this is
+        // only the case if the last uplink frame was not a join, e.g. for a rejoin in
+        // compliance test mode: the join duty cycle shall only be applied after the
+        // first join request.
+        band->TimeCredits = band->MaxTimeCredits;
     }
-    else
+    else if( band->TimeCredits < band->MaxTimeCredits )
     {
-        if( dutyCycleEnabled == false )
+        // Get the difference between now and the last update. A band which has all
+        // its credits does not earn any, only its update time is synchronized below.
+        band->TimeCredits += currentTime - band->LastBandUpdateTime;
+
+        // Limit band credits to maximum
+        if( band->TimeCredits > band->MaxTimeCredits )
         {
             band->TimeCredits = band->MaxTimeCredits;
         }
     }
-
-    // Get the difference between now and the last update
-    band->TimeCredits += TimerGetElapsedTime( band->LastBandUpdateTime );
-
-    // Limit band credits to maximum
-    if( band->TimeCredits > band->MaxTimeCredits )
+    else
     {
+        // Limit band credits to the maximum, which may have been lowered
         band->TimeCredits = band->MaxTimeCredits;
     }
 
@@ -135,6 +130,56 @@ static uint16_t UpdateTimeCredits( Band_t* band, bool joined, bool dutyCycleEnab
     return dutyCycle;
 }
 
+static uint16_t GetCachedDrChannels( RegionCommonCountNbOfEnabledChannelsParams_t* countNbOfEnabledChannelsParams )
+{
+    RegionCommonChannelsCache_t* cache = countNbOfEnabledChannelsParams->Cache;
+    uint8_t datarate = countNbOfEnabledChannelsParams->Datarate;
+    uint16_t channels = 0;
+
+    if( ( cache->ChannelsMask != countNbOfEnabledChannelsParams->ChannelsMask[0] ) ||
+        ( cache->Joined != countNbOfEnabledChannelsParams->Joined ) )
+    {
+        cache->ChannelsMask = countNbOfEnabledChannelsParams->ChannelsMask[0];
+        cache->Joined = countNbOfEnabledChannelsParams->Joined;
+        cache->ValidDatarates = 0;
+    }
+
+    if( ( cache->ValidDatarates & ( 1 << datarate ) ) != 0 )
+    {
+        return cache->DrChannels[datarate];
+    }
+
+    // Same selection as RegionCommonCountNbOfEnabledChannels, apart from the band state
+    for( uint8_t j = 0; j < countNbOfEnabledChannelsParams->MaxNbChannels; j++ )
+    {
+        if( ( cache->ChannelsMask & ( 1 << j ) ) == 0 )
+        {
+            continue;
+        }
+        if( countNbOfEnabledChannelsParams->Channels[j].Frequency == 0 )
+        { // Check if the channel is enabled
+            continue;
+        }
+        if( ( cache->Joined == false ) &&
+            ( countNbOfEnabledChannelsParams->JoinChannels > 0 ) &&
+            ( ( countNbOfEnabledChannelsParams->JoinChannels & ( 1 << j ) ) == 0 ) )
+        {
+            continue;
+        }
+        if( RegionCommonValueInRange( datarate,
+                                      countNbOfEnabledChannelsParams->Channels[j].DrRange.Fields.Min,
+                                      countNbOfEnabledChannelsParams->Channels[j].DrRange.Fields.Max ) == false )
+        { // Check if the current channel selection supports the given datarate
+            continue;
+        }
+        channels |= ( 1 << j );
+    }
+
+    cache->DrChannels[datarate] = channels;
+    cache->ValidDatarates |= ( 1 << datarate );
+    return channels;
+}
+
 static uint8_t CountChannels( uint16_t mask, uint8_t nbBits )
 {
     uint8_t nbActiveBits = 0;
@@ -249,7 +294,7 @@ void RegionCommonSetBandTxDone( Band_t* band, TimerTime_t lastTxAirTime, bool jo
 {
     // Get the band duty cycle. If not joined, the function either returns the join duty cycle
     // or the band duty cycle, whichever is more restrictive.
-    uint16_t dutyCycle = GetDutyCycle( band, joined, elapsedTimeSinceStartup );
+    uint16_t dutyCycle = GetDutyCycle( band, joined, RegionCommonGetJoinDc( elapsedTimeSinceStartup ) );
 
     // Reduce with transmission time
     if( band->TimeCredits > ( lastTxAirTime * dutyCycle ) )
@@ -271,6 +316,7 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
     TimerTime_t minTimeToWait = TIMERTIME_T_MAX;
     TimerTime_t currentTime = TimerGetCurrentTime( );
     TimerTime_t creditCosts = 0;
+    uint16_t joinDutyCycle = RegionCommonGetJoinDc( elapsedTimeSinceStartup );
     uint16_t dutyCycle = 1;
     uint8_t validBands = 0;
 
@@ -278,7 +324,7 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
     {
         // Synchronization of bands and credits
         dutyCycle = UpdateTimeCredits( &bands[i], joined, dutyCycleEnabled,
-                                       lastTxIsJoinRequest, elapsedTimeSinceStartup,
+                                       lastTxIsJoinRequest, joinDutyCycle,
                                        currentTime );
 
         // Calculate the credit costs for the next transmission
@@ -287,8 +333,9 @@ TimerTime_t RegionCommonUpdateBandTimeOff( bool joined, Band_t* bands,
 
         // Check if the band is ready for transmission. Its ready,
         // when the duty cycle is off, or the TimeCredits of the band
-        // is higher than the credit costs for the transmission.
-        if( ( bands[i].TimeCredits > creditCosts ) ||
+        // cover the credit costs for the transmission. The band is
+        // ready again after the minTimeToWait reported below.
+        if( ( bands[i].TimeCredits >= creditCosts ) ||
             ( dutyCycleEnabled == false ) )
         {
             bands[i].ReadyForTransmission = true;
@@ -467,12 +514,40 @@ void RegionCommonRxBeaconSetup( RegionCommonRxBeaconSetupParams_t* rxBeaconSetup
     MW_LOG(TS_ON, VLEVEL_M, "RX_BC on freq %d Hz at DR %d\r\n", rxBeaconSetupParams->Frequency, rxBeaconSetupParams->BeaconDatarate );
 }
 
+void RegionCommonChannelsCacheReset( RegionCommonChannelsCache_t* cache )
+{
+    cache->ValidDatarates = 0;
+}
+
 void RegionCommonCountNbOfEnabledChannels( RegionCommonCountNbOfEnabledChannelsParams_t* countNbOfEnabledChannelsParams,
                                            uint8_t* enabledChannels, uint8_t* nbEnabledChannels, uint8_t* nbRestrictedChannels )
 {
     uint8_t nbChannelCount = 0;
     uint8_t nbRestrictedChannelsCount = 0;
 
+    if( ( countNbOfEnabledChannelsParams->Cache != NULL ) &&
+        ( countNbOfEnabledChannelsParams->Datarate < 16 ) )
+    {
+        uint16_t channels = GetCachedDrChannels( countNbOfEnabledChannelsParams );
+
+        for( uint8_t i = 0; channels != 0; i++, channels >>= 1 )
+        {
+            if( ( channels & 1 ) == 0 )
+            {
+                continue;
+            }
+            if( countNbOfEnabledChannelsParams->Bands[countNbOfEnabledChannelsParams->Channels[i].Band].ReadyForTransmission == false )
+            { // Check if the band is available for transmission
+                nbRestrictedChannelsCount++;
+                continue;
+            }
+            enabledChannels[nbChannelCount++] = i;
+        }
+        *nbEnabledChannels = nbChannelCount;
+        *nbRestrictedChannels = nbRestrictedChannelsCount;
+        return;
+    }
+
     for( uint8_t i = 0, k = 0; i < countNbOfEnabledChannelsParams->MaxNbChannels; i += 16, k++ )
     {
         for( uint8_t j = 0; j < 16; j++ )
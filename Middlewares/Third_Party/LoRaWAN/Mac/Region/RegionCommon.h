@@ -54,6 +54,84 @@ extern "C"
  */
 #define REGION_COMMON_DEFAULT_PING_SLOT_PERIODICITY     7
 
+/*!
+ * Case of a region GetPhyParam switch for a constant attribute, see
+ * EU868_STATIC_PHY_PARAMS
+ */
+#define REGION_COMMON_PHY_PARAM_CASE( attribute, value )    case attribute: { phyParam.Value = ( value ); break; }
+
+/*!
+ * Number of entries of a time-on-air table row, one per PHY payload size.
+ * Radio.TimeOnAir takes the size as an uint8_t.
+ */
+#define REGION_COMMON_TOA_TABLE_SIZE                    256
+
+/*!
+ * LoRa uplink time-on-air in ms, evaluated at compile time. Gives the result of
+ * Radio.TimeOnAir( MODEM_LORA, bw, sf, 1, 8, false, len, true ): coding rate
+ * 4/5, 8 preamble symbols, explicit header and CRC on.
+ *
+ * \param [IN] sf Spreading factor.
+ *
+ * \param [IN] bw Bandwidth index ( 0: 125 kHz, 1: 250 kHz, 2: 500 kHz ).
+ *
+ * \param [IN] len PHY payload size.
+ */
+#define REGION_COMMON_TOA_LORA( sf, bw, len )                                                                   \
+    ( ( uint16_t )( ( ( 1000UL * ( 4UL * REGION_COMMON_TOA_LORA_SYMBOLS( sf, bw, len ) + 1UL ) * ( 1UL << ( ( sf ) - 2 ) ) ) \
+                      + REGION_COMMON_TOA_BW_HZ( bw ) - 1UL ) / REGION_COMMON_TOA_BW_HZ( bw ) ) )
+
+/*!
+ * GFSK uplink time-on-air in ms, evaluated at compile time. Gives the result of
+ * Radio.TimeOnAir( MODEM_FSK, 0, kbps * 1000, 0, 5, false, len, true ).
+ *
+ * \param [IN] kbps Bitrate in kbps.
+ *
+ * \param [IN] unused Unused, keeps the parameter list of REGION_COMMON_TOA_LORA.
+ *
+ * \param [IN] len PHY payload size.
+ */
+#define REGION_COMMON_TOA_FSK( kbps, unused, len )                                                              \
+    ( ( uint16_t )( ( 1000UL * ( ( 5UL << 3 ) + 8UL + 24UL + ( ( ( len ) + 2UL ) << 3 ) ) + ( ( kbps ) * 1000UL ) - 1UL ) \
+                    / ( ( kbps ) * 1000UL ) ) )
+
+/*!
+ * Time-on-air table row for all payload sizes.
+ *
+ * \param [IN] toa REGION_COMMON_TOA_LORA or REGION_COMMON_TOA_FSK.
+ *
+ * \param [IN] p1 Spreading factor or bitrate in kbps.
+ *
+ * \param [IN] p2 Bandwidth index.
+ */
+#define REGION_COMMON_TOA_ROW( toa, p1, p2 )                                                                    \
+    { REGION_COMMON_TOA_ROW16( toa, p1, p2, 0 ),   REGION_COMMON_TOA_ROW16( toa, p1, p2, 16 ),                 \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 32 ),  REGION_COMMON_TOA_ROW16( toa, p1, p2, 48 ),                 \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 64 ),  REGION_COMMON_TOA_ROW16( toa, p1, p2, 80 ),                 \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 96 ),  REGION_COMMON_TOA_ROW16( toa, p1, p2, 112 ),                \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 128 ), REGION_COMMON_TOA_ROW16( toa, p1, p2, 144 ),                \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 160 ), REGION_COMMON_TOA_ROW16( toa, p1, p2, 176 ),                \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 192 ), REGION_COMMON_TOA_ROW16( toa, p1, p2, 208 ),                \
+      REGION_COMMON_TOA_ROW16( toa, p1, p2, 224 ), REGION_COMMON_TOA_ROW16( toa, p1, p2, 240 ) }
+
+/*
+ * Helpers of the time-on-air macros, same steps as the radio driver
+ */
+#define REGION_COMMON_TOA_ROW16( toa, p1, p2, n )                                                               \
+    toa( p1, p2, ( n ) + 0 ),  toa( p1, p2, ( n ) + 1 ),  toa( p1, p2, ( n ) + 2 ),  toa( p1, p2, ( n ) + 3 ),  \
+    toa( p1, p2, ( n ) + 4 ),  toa( p1, p2, ( n ) + 5 ),  toa( p1, p2, ( n ) + 6 ),  toa( p1, p2, ( n ) + 7 ),  \
+    toa( p1, p2, ( n ) + 8 ),  toa( p1, p2, ( n ) + 9 ),  toa( p1, p2, ( n ) + 10 ), toa( p1, p2, ( n ) + 11 ), \
+    toa( p1, p2, ( n ) + 12 ), toa( p1, p2, ( n ) + 13 ), toa( p1, p2, ( n ) + 14 ), toa( p1, p2, ( n ) + 15 )
+#define REGION_COMMON_TOA_BW_HZ( bw )                   ( ( ( bw ) == 0 ) ? 125000UL : ( ( ( bw ) == 1 ) ? 250000UL : 500000UL ) )
+#define REGION_COMMON_TOA_LORA_LDRO( sf, bw )           ( ( ( ( bw ) == 0 ) && ( ( ( sf ) == 11 ) || ( ( sf ) == 12 ) ) ) || \
+                                                          ( ( ( bw ) == 1 ) && ( ( sf ) == 12 ) ) )
+#define REGION_COMMON_TOA_LORA_CEIL_NUM( sf, len )      ( ( ( long )( len ) << 3 ) + 16L - ( 4L * ( sf ) ) + 20L + ( ( ( sf ) <= 6 ) ? 0L : 8L ) )
+#define REGION_COMMON_TOA_LORA_CEIL_DEN( sf, bw )       ( 4L * ( ( sf ) - ( ( ( ( sf ) > 6 ) && REGION_COMMON_TOA_LORA_LDRO( sf, bw ) ) ? 2L : 0L ) ) )
+#define REGION_COMMON_TOA_LORA_SYMBOLS( sf, bw, len )                                                           \
+    ( ( unsigned long )( ( ( ( REGION_COMMON_TOA_LORA_CEIL_NUM( sf, len ) < 0L ) ? 0L : REGION_COMMON_TOA_LORA_CEIL_NUM( sf, len ) ) \
+                           + REGION_COMMON_TOA_LORA_CEIL_DEN( sf, bw ) - 1L ) / REGION_COMMON_TOA_LORA_CEIL_DEN( sf, bw ) ) * 5UL \
+      + ( ( ( sf ) <= 6 ) ? ( 12UL + 12UL + 2UL ) : ( 8UL + 12UL ) ) )
+
 typedef struct sRegionCommonLinkAdrParams
 {
     /*!
@@ -178,6 +256,32 @@ typedef struct sRegionCommonRxBeaconSetupParams
     uint16_t SymbolTimeout;
 }RegionCommonRxBeaconSetupParams_t;
 
+/*!
+ * Cache of the channels which are usable per datarate, for regions with up to
+ * 16 channels. The channels mask and the join state are checked on each use,
+ * changes of the channels themselves must call RegionCommonChannelsCacheReset.
+ */
+typedef struct sRegionCommonChannelsCache
+{
+    /*!
+     * Channels mask the cached entries were built with.
+     */
+    uint16_t ChannelsMask;
+    /*!
+     * Join state the cached entries were built with.
+     */
+    bool Joined;
+    /*!
+     * Bit n is set when DrChannels[n] is valid.
+     */
+    uint16_t ValidDatarates;
+    /*!
+     * Per datarate, the channels which are enabled, defined and support the
+     * datarate. The band state is not part of it.
+     */
+    uint16_t DrChannels[16];
+}RegionCommonChannelsCache_t;
+
 typedef struct sRegionCommonCountNbOfEnabledChannelsParams
 {
     /*!
@@ -208,6 +312,11 @@ typedef struct sRegionCommonCountNbOfEnabledChannelsParams
      * A bitmask containing the join channels.
      */
     uint16_t JoinChannels;
+    /*!
+     * Cache of the usable channels, NULL to scan all channels on each call.
+     * Only for MaxNbChannels up to 16.
+     */
+    RegionCommonChannelsCache_t* Cache;
 }RegionCommonCountNbOfEnabledChannelsParams_t;
 
 typedef struct sRegionCommonIdentifyChannelsParam
@@ -347,6 +456,13 @@ uint8_t RegionCommonCountChannels( uint16_t* channelsMask, uint8_t startIdx, uin
  */
 void RegionCommonChanMaskCopy( uint16_t* channelsMaskDest, uint16_t* channelsMaskSrc, uint8_t len );
 
+/*!
+ * \brief Invalidates a channels cache. To be called when the channels change.
+ *
+ * \param [IN] cache The channels cache.
+ */
+void RegionCommonChannelsCacheReset( RegionCommonChannelsCache_t* cache );
+
 /*!
  * \brief Sets the last tx done property.
  *        This is a generic function and valid for all regions.
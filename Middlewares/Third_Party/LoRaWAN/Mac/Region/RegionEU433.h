@@ -379,6 +379,17 @@ void RegionEU433ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
  */
 bool RegionEU433RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate );
 
+/*!
+ * \brief Computes the time-on-air of an uplink.
+ *
+ * \param [IN] datarate Uplink datarate.
+ *
+ * \param [IN] pktLen PHY payload size.
+ *
+ * \retval Returns the time-on-air in ms.
+ */
+TimerTime_t RegionEU433GetTimeOnAir( int8_t datarate, uint16_t pktLen );
+
 /*!
  * \brief TX configuration.
  *
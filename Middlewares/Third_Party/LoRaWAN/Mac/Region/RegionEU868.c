@@ -64,6 +64,11 @@ typedef struct sRegionEU868NvmCtx
  */
 static RegionEU868NvmCtx_t NvmCtx;
 
+/*
+ * Usable channels per datarate, see RegionCommonCountNbOfEnabledChannels.
+ */
+static RegionCommonChannelsCache_t ChannelsCache;
+
 // Static functions
 static int8_t GetNextLowerTxDr( int8_t dr, int8_t minDr )
 {
@@ -144,21 +149,30 @@ static bool VerifyRfFreq( uint32_t freq, uint8_t *band )
     return true;
 }
 
-static TimerTime_t GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+/*!
+ * Uplink time-on-air in ms per datarate and PHY payload size
+ */
+static const uint16_t TimeOnAirEU868[][REGION_COMMON_TOA_TABLE_SIZE] =
 {
-    int8_t phyDr = DataratesEU868[datarate];
-    uint32_t bandwidth = GetBandwidth( datarate );
-    TimerTime_t timeOnAir = 0;
-
-    if( datarate == DR_7 )
-    { // High Speed FSK channel
-        timeOnAir = Radio.TimeOnAir( MODEM_FSK, bandwidth, phyDr * 1000, 0, 5, false, pktLen, true );
-    }
-    else
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 12, 0 ), // DR_0
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 11, 0 ), // DR_1
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 10, 0 ), // DR_2
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 9, 0 ),  // DR_3
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 8, 0 ),  // DR_4
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 0 ),  // DR_5
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_LORA, 7, 1 ),  // DR_6
+    REGION_COMMON_TOA_ROW( REGION_COMMON_TOA_FSK, 50, 0 ),  // DR_7
+};
+
+TimerTime_t RegionEU868GetTimeOnAir( int8_t datarate, uint16_t pktLen )
+{
+    if( ( datarate >= DR_0 ) && ( datarate < ( int8_t )( sizeof( TimeOnAirEU868 ) / sizeof( TimeOnAirEU868[0] ) ) ) )
     {
-        timeOnAir = Radio.TimeOnAir( MODEM_LORA, bandwidth, phyDr, 1, 8, false, pktLen, true );
+        // The radio takes the size as an uint8_t
+        return TimeOnAirEU868[datarate][( uint8_t )pktLen];
     }
-    return timeOnAir;
+    // Not a datarate of the region
+    return 0;
 }
 
 PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
@@ -167,46 +181,12 @@ PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
 
     switch( getPhy->Attribute )
     {
-        case PHY_MIN_RX_DR:
-        {
-            phyParam.Value = EU868_RX_MIN_DATARATE;
-            break;
-        }
-        case PHY_MIN_TX_DR:
-        {
-            phyParam.Value = EU868_TX_MIN_DATARATE;
-            break;
-        }
-        case PHY_DEF_TX_DR:
-        {
-            phyParam.Value = EU868_DEFAULT_DATARATE;
-            break;
-        }
+        EU868_STATIC_PHY_PARAMS( REGION_COMMON_PHY_PARAM_CASE )
         case PHY_NEXT_LOWER_TX_DR:
         {
             phyParam.Value = GetNextLowerTxDr( getPhy->Datarate, EU868_TX_MIN_DATARATE );
             break;
         }
-        case PHY_MAX_TX_POWER:
-        {
-            phyParam.Value = EU868_MAX_TX_POWER;
-            break;
-        }
-        case PHY_DEF_TX_POWER:
-        {
-            phyParam.Value = EU868_DEFAULT_TX_POWER;
-            break;
-        }
-        case PHY_DEF_ADR_ACK_LIMIT:
-        {
-            phyParam.Value = EU868_ADR_ACK_LIMIT;
-            break;
-        }
-        case PHY_DEF_ADR_ACK_DELAY:
-        {
-            phyParam.Value = EU868_ADR_ACK_DELAY;
-            break;
-        }
         case PHY_MAX_PAYLOAD:
         {
             phyParam.Value = MaxPayloadOfDatarateEU868[getPhy->Datarate];
@@ -217,61 +197,11 @@ PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.Value = MaxPayloadOfDatarateRepeaterEU868[getPhy->Datarate];
             break;
         }
-        case PHY_DUTY_CYCLE:
-        {
-            phyParam.Value = EU868_DUTY_CYCLE_ENABLED;
-            break;
-        }
-        case PHY_MAX_RX_WINDOW:
-        {
-            phyParam.Value = EU868_MAX_RX_WINDOW;
-            break;
-        }
-        case PHY_RECEIVE_DELAY1:
-        {
-            phyParam.Value = EU868_RECEIVE_DELAY1;
-            break;
-        }
-        case PHY_RECEIVE_DELAY2:
-        {
-            phyParam.Value = EU868_RECEIVE_DELAY2;
-            break;
-        }
-        case PHY_JOIN_ACCEPT_DELAY1:
-        {
-            phyParam.Value = EU868_JOIN_ACCEPT_DELAY1;
-            break;
-        }
-        case PHY_JOIN_ACCEPT_DELAY2:
-        {
-            phyParam.Value = EU868_JOIN_ACCEPT_DELAY2;
-            break;
-        }
-        case PHY_MAX_FCNT_GAP:
-        {
-            phyParam.Value = EU868_MAX_FCNT_GAP;
-            break;
-        }
         case PHY_ACK_TIMEOUT:
         {
             phyParam.Value = ( EU868_ACKTIMEOUT + randr( -EU868_ACK_TIMEOUT_RND, EU868_ACK_TIMEOUT_RND ) );
             break;
         }
-        case PHY_DEF_DR1_OFFSET:
-        {
-            phyParam.Value = EU868_DEFAULT_RX1_DR_OFFSET;
-            break;
-        }
-        case PHY_DEF_RX2_FREQUENCY:
-        {
-            phyParam.Value = EU868_RX_WND_2_FREQ;
-            break;
-        }
-        case PHY_DEF_RX2_DR:
-        {
-            phyParam.Value = EU868_RX_WND_2_DR;
-            break;
-        }
         case PHY_CHANNELS_MASK:
         {
             phyParam.ChannelsMask = NvmCtx.ChannelsMask;
@@ -282,22 +212,11 @@ PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.ChannelsMask = NvmCtx.ChannelsDefaultMask;
             break;
         }
-        case PHY_MAX_NB_CHANNELS:
-        {
-            phyParam.Value = EU868_MAX_NB_CHANNELS;
-            break;
-        }
         case PHY_CHANNELS:
         {
             phyParam.Channels = NvmCtx.Channels;
             break;
         }
-        case PHY_DEF_UPLINK_DWELL_TIME:
-        case PHY_DEF_DOWNLINK_DWELL_TIME:
-        {
-            phyParam.Value = 0;
-            break;
-        }
         case PHY_DEF_MAX_EIRP:
         {
             phyParam.fValue = EU868_DEFAULT_MAX_EIRP;
@@ -308,11 +227,6 @@ PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.fValue = EU868_DEFAULT_ANTENNA_GAIN;
             break;
         }
-        case PHY_BEACON_CHANNEL_FREQ:
-        {
-            phyParam.Value = EU868_BEACON_CHANNEL_FREQ;
-            break;
-        }
         case PHY_BEACON_FORMAT:
         {
             phyParam.BeaconFormat.BeaconSize = EU868_BEACON_SIZE;
@@ -320,21 +234,6 @@ PhyParam_t RegionEU868GetPhyParam( GetPhyParams_t* getPhy )
             phyParam.BeaconFormat.Rfu2Size = EU868_RFU2_SIZE;
             break;
         }
-        case PHY_BEACON_CHANNEL_DR:
-        {
-            phyParam.Value = EU868_BEACON_CHANNEL_DR;
-            break;
-        }
-        case PHY_PING_SLOT_CHANNEL_FREQ:
-        {
-            phyParam.Value = EU868_PING_SLOT_CHANNEL_FREQ;
-            break;
-        }
-        case PHY_PING_SLOT_CHANNEL_DR:
-        {
-            phyParam.Value = EU868_PING_SLOT_CHANNEL_DR;
-            break;
-        }
         case PHY_SF_FROM_DR:
         {
             phyParam.Value = DataratesEU868[getPhy->Datarate];
@@ -372,6 +271,9 @@ void RegionEU868InitDefaults( InitDefaultsParams_t* params )
         EU868_BAND5,
     };
 
+    // The channels are set up or restored
+    RegionCommonChannelsCacheReset( &ChannelsCache );
+
     switch( params->Type )
     {
         case INIT_TYPE_DEFAULTS:
@@ -562,6 +464,7 @@ void RegionEU868ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
         tSymbol = RegionCommonComputeSymbolTimeLoRa( DataratesEU868[rxConfigParams->Datarate], BandwidthsEU868[rxConfigParams->Datarate] );
     }
 
+    rxConfigParams->SymbolTime = tSymbol;
     RegionCommonComputeRxWindowParameters( tSymbol, minRxSymbols, rxError, Radio.GetWakeupTime( ), &rxConfigParams->WindowTimeout, &rxConfigParams->WindowOffset );
 }
 
@@ -653,7 +556,7 @@ bool RegionEU868TxConfig( TxConfigParams_t* txConfig, int8_t* txPower, TimerTime
     /* ST_WORKAROUND_END */
 
     // Update time-on-air
-    *txTimeOnAir = GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
+    *txTimeOnAir = RegionEU868GetTimeOnAir( txConfig->Datarate, txConfig->PktLen );
 
     // Setup maximum payload length of the radio driver
     Radio.SetMaxPayloadLength( modem, txConfig->PktLen );
@@ -904,6 +807,7 @@ LoRaMacStatus_t RegionEU868NextChannel( NextChanParams_t* nextChanParams, uint8_
     countChannelsParams.Bands = NvmCtx.Bands;
     countChannelsParams.MaxNbChannels = EU868_MAX_NB_CHANNELS;
     countChannelsParams.JoinChannels = EU868_JOIN_CHANNELS;
+    countChannelsParams.Cache = &ChannelsCache;
 
     identifyChannelsParam.AggrTimeOff = nextChanParams->AggrTimeOff;
     identifyChannelsParam.LastAggrTx = nextChanParams->LastAggrTx;
@@ -912,7 +816,7 @@ LoRaMacStatus_t RegionEU868NextChannel( NextChanParams_t* nextChanParams, uint8_
 
     identifyChannelsParam.ElapsedTimeSinceStartUp = nextChanParams->ElapsedTimeSinceStartUp;
     identifyChannelsParam.LastTxIsJoinRequest = nextChanParams->LastTxIsJoinRequest;
-    identifyChannelsParam.ExpectedTimeOnAir = GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
+    identifyChannelsParam.ExpectedTimeOnAir = RegionEU868GetTimeOnAir( nextChanParams->Datarate, nextChanParams->PktLen );
 
     identifyChannelsParam.CountNbOfEnabledChannelsParam = &countChannelsParams;
 
@@ -986,6 +890,7 @@ LoRaMacStatus_t RegionEU868ChannelAdd( ChannelAddParams_t* channelAdd )
         return LORAMAC_STATUS_FREQUENCY_INVALID;
     }
 
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     memcpy1( ( uint8_t* ) &(NvmCtx.Channels[id]), ( uint8_t* ) channelAdd->NewChannel, sizeof( NvmCtx.Channels[id] ) );
     NvmCtx.Channels[id].Band = band;
     NvmCtx.ChannelsMask[0] |= ( 1 << id );
@@ -1002,6 +907,7 @@ bool RegionEU868ChannelsRemove( ChannelRemoveParams_t* channelRemove  )
     }
 
     // Remove the channel from the list of channels
+    RegionCommonChannelsCacheReset( &ChannelsCache );
     NvmCtx.Channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
 
     return RegionCommonChanDisable( NvmCtx.ChannelsMask, id, EU868_MAX_NB_CHANNELS );
@@ -301,6 +301,36 @@ extern "C"
  */
 #define EU868_JOIN_CHANNELS                         ( uint16_t )( LC( 1 ) | LC( 2 ) | LC( 3 ) )
 
+/*!
+ * PHY attributes of RegionEU868GetPhyParam which are constants, as
+ * PARAM( attribute, value ) entries
+ */
+#define EU868_STATIC_PHY_PARAMS( PARAM )                                   \
+    PARAM( PHY_MIN_RX_DR, EU868_RX_MIN_DATARATE )                      \
+    PARAM( PHY_MIN_TX_DR, EU868_TX_MIN_DATARATE )                      \
+    PARAM( PHY_DEF_TX_DR, EU868_DEFAULT_DATARATE )                     \
+    PARAM( PHY_MAX_TX_POWER, EU868_MAX_TX_POWER )                      \
+    PARAM( PHY_DEF_TX_POWER, EU868_DEFAULT_TX_POWER )                  \
+    PARAM( PHY_DEF_ADR_ACK_LIMIT, EU868_ADR_ACK_LIMIT )                \
+    PARAM( PHY_DEF_ADR_ACK_DELAY, EU868_ADR_ACK_DELAY )                \
+    PARAM( PHY_DUTY_CYCLE, EU868_DUTY_CYCLE_ENABLED )                  \
+    PARAM( PHY_MAX_RX_WINDOW, EU868_MAX_RX_WINDOW )                    \
+    PARAM( PHY_RECEIVE_DELAY1, EU868_RECEIVE_DELAY1 )                  \
+    PARAM( PHY_RECEIVE_DELAY2, EU868_RECEIVE_DELAY2 )                  \
+    PARAM( PHY_JOIN_ACCEPT_DELAY1, EU868_JOIN_ACCEPT_DELAY1 )          \
+    PARAM( PHY_JOIN_ACCEPT_DELAY2, EU868_JOIN_ACCEPT_DELAY2 )          \
+    PARAM( PHY_MAX_FCNT_GAP, EU868_MAX_FCNT_GAP )                      \
+    PARAM( PHY_DEF_DR1_OFFSET, EU868_DEFAULT_RX1_DR_OFFSET )           \
+    PARAM( PHY_DEF_RX2_FREQUENCY, EU868_RX_WND_2_FREQ )                \
+    PARAM( PHY_DEF_RX2_DR, EU868_RX_WND_2_DR )                         \
+    PARAM( PHY_MAX_NB_CHANNELS, EU868_MAX_NB_CHANNELS )                \
+    PARAM( PHY_DEF_UPLINK_DWELL_TIME, 0 )                              \
+    PARAM( PHY_DEF_DOWNLINK_DWELL_TIME, 0 )                            \
+    PARAM( PHY_BEACON_CHANNEL_FREQ, EU868_BEACON_CHANNEL_FREQ )        \
+    PARAM( PHY_BEACON_CHANNEL_DR, EU868_BEACON_CHANNEL_DR )            \
+    PARAM( PHY_PING_SLOT_CHANNEL_FREQ, EU868_PING_SLOT_CHANNEL_FREQ )  \
+    PARAM( PHY_PING_SLOT_CHANNEL_DR, EU868_PING_SLOT_CHANNEL_DR )
+
 /*!
  * Data rates table definition
  */
@@ -407,6 +437,17 @@ void RegionEU868ComputeRxWindowParameters( int8_t datarate, uint8_t minRxSymbols
  */
 bool RegionEU868RxConfig( RxConfigParams_t* rxConfig, int8_t* datarate );
 
+/*!
+ * \brief Computes the time-on-air of an uplink.
+ *
+ * \param [IN] datarate Uplink datarate.
+ *
+ * \param [IN] pktLen PHY payload size.
+ *
+ * \retval Returns the time-on-air in ms.
+ */
+TimerTime_t RegionEU868GetTimeOnAir( int8_t datarate, uint16_t pktLen );
+
 /*!
  * \brief TX configuration.
  *
@@ -0,0 +1,162 @@
+/*!
+ * \file      RegionSingle.h
+ *
+ * \brief     Binds the region API directly to the implementation of the only
+ *            region enabled, see REGION_SINGLE_ENABLED.
+ *
+ * \copyright Revised BSD License, see section \ref LICENSE.
+ *
+ * \defgroup  REGIONSINGLE Single region build
+ *            Replaces the switch on LoRaMacRegion_t of Region.c by direct
+ *            calls. The region argument is still evaluated but not used,
+ *            RegionIsActive( ) only accepts the enabled region.
+ * \{
+ */
+#ifndef __REGIONSINGLE_H__
+#define __REGIONSINGLE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined( REGION_AS923 )
+#include "RegionAS923.h"
+#define REGION_SINGLE_ID                            AS923
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_AS923
+#endif
+#if defined( REGION_AU915 )
+#include "RegionAU915.h"
+#define REGION_SINGLE_ID                            AU915
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_AU915
+#endif
+#if defined( REGION_CN470 )
+#include "RegionCN470.h"
+#define REGION_SINGLE_ID                            CN470
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_CN470
+#endif
+#if defined( REGION_CN779 )
+#include "RegionCN779.h"
+#define REGION_SINGLE_ID                            CN779
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_CN779
+#endif
+#if defined( REGION_EU433 )
+#include "RegionEU433.h"
+#define REGION_SINGLE_ID                            EU433
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_EU433
+#endif
+#if defined( REGION_EU868 )
+#include "RegionEU868.h"
+#define REGION_SINGLE_ID                            EU868
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_EU868
+#define REGION_SINGLE_STATIC_PHY_PARAMS             EU868_STATIC_PHY_PARAMS
+#endif
+#if defined( REGION_KR920 )
+#include "RegionKR920.h"
+#define REGION_SINGLE_ID                            KR920
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_KR920
+#endif
+#if defined( REGION_IN865 )
+#include "RegionIN865.h"
+#define REGION_SINGLE_ID                            IN865
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_IN865
+#endif
+#if defined( REGION_US915 )
+#include "RegionUS915.h"
+#define REGION_SINGLE_ID                            US915
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_US915
+#endif
+#if defined( REGION_RU864 )
+#include "RegionRU864.h"
+#define REGION_SINGLE_ID                            RU864
+#define REGION_SINGLE_MAC_REGION                    LORAMAC_REGION_RU864
+#endif
+
+#if !defined( REGION_SINGLE_ID )
+#error "REGION_SINGLE_ENABLED needs one region enabled in lorawan_conf.h"
+#endif
+#if ( defined( REGION_AS923 ) + defined( REGION_AU915 ) + defined( REGION_CN470 ) + defined( REGION_CN779 ) + \
+      defined( REGION_EU433 ) + defined( REGION_EU868 ) + defined( REGION_KR920 ) + defined( REGION_IN865 ) + \
+      defined( REGION_US915 ) + defined( REGION_RU864 ) ) != 1
+#error "REGION_SINGLE_ENABLED needs exactly one region enabled in lorawan_conf.h"
+#endif
+
+/*!
+ * Region specific function, e.g. REGION_SINGLE_FN( GetPhyParam ) is RegionEU868GetPhyParam
+ */
+#define REGION_SINGLE_FN( fn )                      REGION_SINGLE_XCAT( Region, REGION_SINGLE_ID, fn )
+#define REGION_SINGLE_XCAT( a, b, c )               REGION_SINGLE_CAT( a, b, c )
+#define REGION_SINGLE_CAT( a, b, c )                a##b##c
+
+/*!
+ * PHY attributes which are constants of the region, answered without calling
+ * the region ( see EU868_STATIC_PHY_PARAMS )
+ */
+#if !defined( REGION_SINGLE_STATIC_PHY_PARAMS )
+#define REGION_SINGLE_STATIC_PHY_PARAMS( PARAM )
+#endif
+#define REGION_SINGLE_PHY_PARAM_RETURN( attribute, value )  case attribute: { phyParam.Value = ( value ); return phyParam; }
+
+/*!
+ * \brief Region GetPhyParam of a single region build. Inlined, so that the
+ *        constant attributes fold at the call site.
+ *
+ * \param [IN] getPhy Pointer to the function parameters.
+ *
+ * \retval Returns a structure containing the PHY parameter.
+ */
+static inline PhyParam_t RegionSingleGetPhyParam( GetPhyParams_t* getPhy )
+{
+    PhyParam_t phyParam = { 0 };
+
+    switch( getPhy->Attribute )
+    {
+        REGION_SINGLE_STATIC_PHY_PARAMS( REGION_SINGLE_PHY_PARAM_RETURN )
+        default:
+        {
+            phyParam = REGION_SINGLE_FN( GetPhyParam )( getPhy );
+            break;
+        }
+    }
+    return phyParam;
+}
+
+/*
+ * Region API, see Region.h
+ */
+#define RegionIsActive( region )                                    ( ( region ) == REGION_SINGLE_MAC_REGION )
+#define RegionGetPhyParam( region, getPhy )                         ( ( void )( region ), RegionSingleGetPhyParam( getPhy ) )
+#define RegionSetBandTxDone( region, txDone )                       ( ( void )( region ), REGION_SINGLE_FN( SetBandTxDone )( txDone ) )
+#define RegionInitDefaults( region, params )                        ( ( void )( region ), REGION_SINGLE_FN( InitDefaults )( params ) )
+#define RegionGetNvmCtx( region, params )                           ( ( void )( region ), REGION_SINGLE_FN( GetNvmCtx )( params ) )
+#define RegionVerify( region, verify, phyAttribute )                ( ( void )( region ), REGION_SINGLE_FN( Verify )( verify, phyAttribute ) )
+#define RegionApplyCFList( region, applyCFList )                    ( ( void )( region ), REGION_SINGLE_FN( ApplyCFList )( applyCFList ) )
+#define RegionChanMaskSet( region, chanMaskSet )                    ( ( void )( region ), REGION_SINGLE_FN( ChanMaskSet )( chanMaskSet ) )
+#define RegionRxConfig( region, rxConfig, datarate )                ( ( void )( region ), REGION_SINGLE_FN( RxConfig )( rxConfig, datarate ) )
+#define RegionComputeRxWindowParameters( region, datarate, minRxSymbols, rxError, rxConfigParams ) \
+    ( ( void )( region ), REGION_SINGLE_FN( ComputeRxWindowParameters )( datarate, minRxSymbols, rxError, rxConfigParams ) )
+#define RegionGetTimeOnAir( region, datarate, pktLen )              ( ( void )( region ), REGION_SINGLE_FN( GetTimeOnAir )( datarate, pktLen ) )
+#define RegionTxConfig( region, txConfig, txPower, txTimeOnAir )    ( ( void )( region ), REGION_SINGLE_FN( TxConfig )( txConfig, txPower, txTimeOnAir ) )
+#define RegionLinkAdrReq( region, linkAdrReq, drOut, txPowOut, nbRepOut, nbBytesParsed ) \
+    ( ( void )( region ), REGION_SINGLE_FN( LinkAdrReq )( linkAdrReq, drOut, txPowOut, nbRepOut, nbBytesParsed ) )
+#define RegionRxParamSetupReq( region, rxParamSetupReq )            ( ( void )( region ), REGION_SINGLE_FN( RxParamSetupReq )( rxParamSetupReq ) )
+#define RegionNewChannelReq( region, newChannelReq )                ( ( void )( region ), REGION_SINGLE_FN( NewChannelReq )( newChannelReq ) )
+#define RegionTxParamSetupReq( region, txParamSetupReq )            ( ( void )( region ), REGION_SINGLE_FN( TxParamSetupReq )( txParamSetupReq ) )
+#define RegionDlChannelReq( region, dlChannelReq )                  ( ( void )( region ), REGION_SINGLE_FN( DlChannelReq )( dlChannelReq ) )
+#define RegionAlternateDr( region, currentDr, type )                ( ( void )( region ), REGION_SINGLE_FN( AlternateDr )( currentDr, type ) )
+#define RegionNextChannel( region, nextChanParams, channel, time, aggregatedTimeOff ) \
+    ( ( void )( region ), REGION_SINGLE_FN( NextChannel )( nextChanParams, channel, time, aggregatedTimeOff ) )
+#define RegionChannelAdd( region, channelAdd )                      ( ( void )( region ), REGION_SINGLE_FN( ChannelAdd )( channelAdd ) )
+#define RegionChannelsRemove( region, channelRemove )               ( ( void )( region ), REGION_SINGLE_FN( ChannelsRemove )( channelRemove ) )
+#define RegionSetContinuousWave( region, continuousWave )           ( ( void )( region ), REGION_SINGLE_FN( SetContinuousWave )( continuousWave ) )
+#define RegionApplyDrOffset( region, downlinkDwellTime, dr, drOffset ) \
+    ( ( void )( region ), REGION_SINGLE_FN( ApplyDrOffset )( downlinkDwellTime, dr, drOffset ) )
+#define RegionRxBeaconSetup( region, rxBeaconSetup, outDr )         ( ( void )( region ), REGION_SINGLE_FN( RxBeaconSetup )( rxBeaconSetup, outDr ) )
+
+/*! \} defgroup REGIONSINGLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __REGIONSINGLE_H__
@@ -56,6 +56,11 @@ extern "C"
  */
 #define SE_EUI_SIZE             8
 
+/*!
+ * Size in bytes of the seed the random generator leaves for the next boot
+ */
+#define SE_RANDOM_SEED_SIZE     32
+
 /*!
  * Return values.
  */
@@ -187,6 +192,20 @@ SecureElementStatus_t SecureElementVerifyAesCmac( uint8_t* buffer, uint16_t size
  */
 SecureElementStatus_t SecureElementAesEncrypt( uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID, uint8_t* encBuffer );
 
+/*!
+ * Encrypts or decrypts a buffer in place in AES-CTR mode
+ *
+ * The counter blocks are aBlock with byte 15 incremented for each block,
+ * starting with the value aBlock[15] has on entry.
+ *
+ * \param[IN]  aBlock         - First counter block ( 16 byte ), left unchanged
+ * \param[IN/OUT] buffer      - Data buffer
+ * \param[IN]  size           - Data buffer size, any length
+ * \param[IN]  keyID          - Key identifier to determine the AES key to be used
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementAesCtrCrypt( const uint8_t* aBlock, uint8_t* buffer, uint16_t size, KeyIdentifier_t keyID );
+
 /*!
  * Derives and store a key
  *
@@ -222,6 +241,25 @@ SecureElementStatus_t SecureElementProcessJoinAccept( JoinReqIdentifier_t joinRe
  */
 SecureElementStatus_t SecureElementRandomNumber( uint32_t* randomNum );
 
+/*!
+ * Sets the seed saved at the previous boot. Given before the first random
+ * number, it is used when the generator is seeded. Given later, it is mixed
+ * into the running generator.
+ *
+ * \param[IN] seed            - Pointer to the SE_RANDOM_SEED_SIZE-byte seed
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementSetRandomSeed( const uint8_t* seed );
+
+/*!
+ * Gets the seed to save for the next boot. It is replaced each time the
+ * generator is seeded, the first time with the first random number.
+ *
+ * \param[OUT] seed           - Pointer to the SE_RANDOM_SEED_SIZE-byte seed
+ * \retval                    - Status of the operation
+ */
+SecureElementStatus_t SecureElementGetRandomSeed( uint8_t* seed );
+
 /*!
  * Sets the DevEUI
  *
@@ -113,6 +113,13 @@ typedef struct
      * \param [IN] channelDetected    Channel Activity detected during the CAD
      */
     void ( *CadDone ) ( bool channelActivityDetected );
+
+    /*!
+     * \brief Preamble Detected callback prototype.
+     *
+     * \remark Called from the radio interrupt, keep it short.
+     */
+    void ( *PreambleDetected ) ( void );
 }RadioEvents_t;
 
 /*!
@@ -1860,6 +1860,10 @@ static void RadioIrqProcess( void )
     break;
 
   case IRQ_PREAMBLE_DETECTED:
+    if( ( RadioEvents != NULL ) && ( RadioEvents->PreambleDetected != NULL ) )
+    {
+      RadioEvents->PreambleDetected( );
+    }
     MW_LOG( TS_ON, VLEVEL_M,  "PRE OK\r\n" );
     break;
 
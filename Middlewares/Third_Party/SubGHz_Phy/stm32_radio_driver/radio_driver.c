@@ -52,6 +52,30 @@ typedef struct
     uint8_t       Value;                            //!< The value of the register
 }RadioRegisters_t;
 
+/*!
+ * \brief Last parameters sent with a configuration command, Size 0 when unknown
+ */
+typedef struct
+{
+    uint8_t       Size;                             //!< Size of the parameters
+    uint8_t       Params[9];                        //!< Parameters as sent
+}RadioShadowCmd_t;
+
+/*!
+ * \brief Shadow of the radio configuration, used to skip the commands which
+ *        would not change it
+ */
+typedef struct
+{
+    RadioShadowCmd_t PacketType;
+    RadioShadowCmd_t ModulationParams;
+    RadioShadowCmd_t PacketParams;
+    RadioShadowCmd_t RfFrequency;
+    RadioShadowCmd_t DioIrqParams;
+    RadioShadowCmd_t PaConfig;
+    RadioShadowCmd_t TxParams;
+}RadioShadow_t;
+
 /* Private define ------------------------------------------------------------*/
 
 /*!
@@ -102,8 +126,29 @@ volatile uint32_t FrequencyError = 0;
  */
 static bool ImageCalibrated = false;
 
+/*!
+ * \brief Configuration retained by the radio, invalidated when it is lost
+ */
+static RadioShadow_t RadioShadow;
+
 /* Private function prototypes -----------------------------------------------*/
 
+/*!
+ * \brief Records the parameters of a configuration command in its shadow
+ *
+ * \param [IN] cmd    Shadow of the command
+ * \param [IN] params Parameters to send
+ * \param [IN] size   Size of the parameters
+ *
+ * \retval changed    false if the radio already has these parameters
+ */
+static bool SUBGRF_ShadowUpdate( RadioShadowCmd_t *cmd, const uint8_t *params, uint8_t size );
+
+/*!
+ * \brief Forgets the radio configuration, after a reset or a cold start sleep
+ */
+static void SUBGRF_ShadowInvalidate( void );
+
 /*!
  * \brief This set SMPS drive capability wrt. RF mode
  */
@@ -128,6 +173,7 @@ void SUBGRF_Init( DioIrqHandler dioIrq )
     RADIO_INIT();
 
     ImageCalibrated = false;
+    SUBGRF_ShadowInvalidate( );
 
     SUBGRF_SetStandby( STDBY_RC );
 
@@ -279,6 +325,12 @@ void SUBGRF_SetSleep( SleepParams_t sleepConfig )
                       ( ( uint8_t )sleepConfig.Fields.WakeUpRTC ) );
     SUBGRF_WriteCommand( RADIO_SET_SLEEP, &value, 1 );
     OperatingMode = MODE_SLEEP;
+
+    if( sleepConfig.Fields.WarmStart == 0 )
+    {
+        // The configuration is not retained, the radio wakes up with its defaults
+        SUBGRF_ShadowInvalidate( );
+    }
 }
 
 void SUBGRF_SetStandby( RadioStandbyModes_t standbyConfig )
@@ -466,7 +518,10 @@ void SUBGRF_SetPaConfig( uint8_t paDutyCycle, uint8_t hpMax, uint8_t deviceSel,
     buf[1] = hpMax;
     buf[2] = deviceSel;
     buf[3] = paLut;
-    SUBGRF_WriteCommand( RADIO_SET_PACONFIG, buf, 4 );
+    if( SUBGRF_ShadowUpdate( &RadioShadow.PaConfig, buf, 4 ) == true )
+    {
+        SUBGRF_WriteCommand( RADIO_SET_PACONFIG, buf, 4 );
+    }
 }
 
 void SUBGRF_SetRxTxFallbackMode( uint8_t fallbackMode )
@@ -486,7 +541,10 @@ void SUBGRF_SetDioIrqParams( uint16_t irqMask, uint16_t dio1Mask, uint16_t dio2M
     buf[5] = ( uint8_t )( dio2Mask & 0x00FF );
     buf[6] = ( uint8_t )( ( dio3Mask >> 8 ) & 0x00FF );
     buf[7] = ( uint8_t )( dio3Mask & 0x00FF );
-    SUBGRF_WriteCommand( RADIO_CFG_DIOIRQ, buf, 8 );
+    if( SUBGRF_ShadowUpdate( &RadioShadow.DioIrqParams, buf, 8 ) == true )
+    {
+        SUBGRF_WriteCommand( RADIO_CFG_DIOIRQ, buf, 8 );
+    }
 }
 
 uint16_t SUBGRF_GetIrqStatus( void )
@@ -528,19 +586,32 @@ void SUBGRF_SetRfFrequency( uint32_t frequency )
     buf[1] = ( uint8_t )( ( chan >> 16 ) & 0xFF );
     buf[2] = ( uint8_t )( ( chan >> 8 ) & 0xFF );
     buf[3] = ( uint8_t )( chan & 0xFF );
-    SUBGRF_WriteCommand( RADIO_SET_RFFREQUENCY, buf, 4 );
+    if( SUBGRF_ShadowUpdate( &RadioShadow.RfFrequency, buf, 4 ) == true )
+    {
+        SUBGRF_WriteCommand( RADIO_SET_RFFREQUENCY, buf, 4 );
+    }
 }
 
 void SUBGRF_SetPacketType( RadioPacketTypes_t packetType )
 {
+    uint8_t value = ( uint8_t )packetType;
+
     // Save packet type internally to avoid questioning the radio
     PacketType = packetType;
 
+    if( SUBGRF_ShadowUpdate( &RadioShadow.PacketType, &value, 1 ) == false )
+    {
+        return;
+    }
+    // The modulation and packet parameters depend on the packet type
+    RadioShadow.ModulationParams.Size = 0;
+    RadioShadow.PacketParams.Size = 0;
+
     if( packetType == PACKET_TYPE_GFSK )
     {
         SUBGRF_WriteRegister( REG_BIT_SYNC, 0x00 );
     }
-    SUBGRF_WriteCommand( RADIO_SET_PACKETTYPE, ( uint8_t* )&packetType, 1 );
+    SUBGRF_WriteCommand( RADIO_SET_PACKETTYPE, &value, 1 );
 }
 
 RadioPacketTypes_t SUBGRF_GetPacketType( void )
@@ -592,7 +663,10 @@ void SUBGRF_SetTxParams( uint8_t paSelect, int8_t power, RadioRampTimes_t rampTi
     }
     buf[0] = power;
     buf[1] = ( uint8_t )rampTime;
-    SUBGRF_WriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
+    if( SUBGRF_ShadowUpdate( &RadioShadow.TxParams, buf, 2 ) == true )
+    {
+        SUBGRF_WriteCommand( RADIO_SET_TXPARAMS, buf, 2 );
+    }
 }
 
 void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
@@ -624,7 +698,10 @@ void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
         buf[5] = ( tempVal >> 16 ) & 0xFF;
         buf[6] = ( tempVal >> 8 ) & 0xFF;
         buf[7] = ( tempVal& 0xFF );
-        SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        if( SUBGRF_ShadowUpdate( &RadioShadow.ModulationParams, buf, n ) == true )
+        {
+            SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        }
         break;
     case PACKET_TYPE_BPSK:
         n = 4;
@@ -633,7 +710,10 @@ void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
         buf[1] = ( tempVal >> 8 ) & 0xFF;
         buf[2] = tempVal & 0xFF;
         buf[3] = modulationParams->Params.Bpsk.ModulationShaping;
-        SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        if( SUBGRF_ShadowUpdate( &RadioShadow.ModulationParams, buf, n ) == true )
+        {
+            SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        }
         break;
     case PACKET_TYPE_LORA:
         n = 4;
@@ -642,7 +722,10 @@ void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
         buf[2] = modulationParams->Params.LoRa.CodingRate;
         buf[3] = modulationParams->Params.LoRa.LowDatarateOptimize;
 
-        SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        if( SUBGRF_ShadowUpdate( &RadioShadow.ModulationParams, buf, n ) == true )
+        {
+            SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        }
 
         break;
     case PACKET_TYPE_GMSK:
@@ -653,7 +736,10 @@ void SUBGRF_SetModulationParams( ModulationParams_t *modulationParams )
         buf[2] = tempVal & 0xFF;
         buf[3] = modulationParams->Params.Gfsk.ModulationShaping;
         buf[4] = modulationParams->Params.Gfsk.Bandwidth;
-        SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        if( SUBGRF_ShadowUpdate( &RadioShadow.ModulationParams, buf, n ) == true )
+        {
+            SUBGRF_WriteCommand( RADIO_SET_MODULATIONPARAMS, buf, n );
+        }
         break;
     default:
     case PACKET_TYPE_NONE:
@@ -722,7 +808,10 @@ void SUBGRF_SetPacketParams( PacketParams_t *packetParams )
     case PACKET_TYPE_NONE:
         return;
     }
-    SUBGRF_WriteCommand( RADIO_SET_PACKETPARAMS, buf, n );
+    if( SUBGRF_ShadowUpdate( &RadioShadow.PacketParams, buf, n ) == true )
+    {
+        SUBGRF_WriteCommand( RADIO_SET_PACKETPARAMS, buf, n );
+    }
 }
 
 void SUBGRF_SetCadParams( RadioLoRaCadSymbols_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin, RadioCadExitModes_t cadExitMode, uint32_t cadTimeout )
@@ -1015,6 +1104,33 @@ void HAL_SUBGHZ_HeaderValidCallback(SUBGHZ_HandleTypeDef *hsubghz)
     RadioOnDioIrqCb( IRQ_HEADER_VALID );
 }
 
+static bool SUBGRF_ShadowUpdate( RadioShadowCmd_t *cmd, const uint8_t *params, uint8_t size )
+{
+    uint8_t i;
+
+    if( cmd->Size == size )
+    {
+        for( i = 0; ( i < size ) && ( cmd->Params[i] == params[i] ); i++ )
+        {
+        }
+        if( i == size )
+        {
+            return false;
+        }
+    }
+    for( i = 0; i < size; i++ )
+    {
+        cmd->Params[i] = params[i];
+    }
+    cmd->Size = size;
+    return true;
+}
+
+static void SUBGRF_ShadowInvalidate( void )
+{
+    RADIO_MEMSET8( &RadioShadow, 0, sizeof( RadioShadow ) );
+}
+
 static void Radio_SMPS_Set(uint8_t level)
 {
   if ( 1U == RBI_IsDCDC() )
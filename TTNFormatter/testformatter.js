@@ -8,10 +8,94 @@
  * Byte 1: TX Power (dBm)
  * Byte 2: Datarate (DR0-DR5)
  * Byte 3-4: Supply Voltage (mV, 16-bit Big Endian)
+ *
+ * Port 10 (Einzelmessung):
  * 5-6 Temp
- * 7 Hum
+ * 7-8 Temp
+ * 9 Hum
+ *
+ * Port 11 (Batch) und Port 12 (Aggregat):
+ * 5 Anzahl Samples
+ * 6-7 Sample-Intervall (s)
+ * Port 11: je Sample 7 Bytes, aeltestes zuerst:
+ *          NTC Temp (2), HDC2080 Temp (2), Hum (1), Supply Voltage (2)
+ * Port 12: min/max/mean fuer NTC Temp (6), HDC2080 Temp (6), Hum (3), Supply Voltage (6)
+ * Port 13: je Messgroesse eine komprimierte Reihe (siehe app_ts_codec.h):
+ *          Reihen-ID (1), erster Wert (Zig-Zag-Varint), erstes Delta (Zig-Zag-Varint),
+ *          danach Tokens: Delta-of-Delta (Bit 0 = 0) oder Nullfolge (Bit 0 = 1)
+ *
+ * Port 14 (Nachlieferung aus dem Flash-Log):
+ * 5 Anzahl Samples
+ * je Sample 9 Bytes: Alter in Minuten (2, 0xFFFF = unbekannt), NTC Temp (2),
+ *          HDC2080 Temp (2), Hum (1), Supply Voltage (2)
  */
 
+function decodeTemperature(raw) {
+  switch (raw) {
+    case 0x8000:
+      return "Unknown Error";
+    case 0x8001:
+      return "Overflow";
+    case 0x8002:
+      return "Underflow";
+    default:
+      if (raw > 0x7FFF) {
+        raw = raw - 0x10000; // Signed conversion
+      }
+      return raw / 10;
+  }
+}
+
+function decodeHumidity(raw) {
+  return (raw === 0xFF) ? null : raw;
+}
+
+function readVarint(bytes, pos) {
+  var value = 0;
+  var shift = 0;
+  var b;
+  do {
+    if (pos.i >= bytes.length) {
+      throw "Varint abgeschnitten";
+    }
+    b = bytes[pos.i++];
+    value += (b & 0x7F) * Math.pow(2, shift);
+    shift += 7;
+  } while (b & 0x80);
+  return value;
+}
+
+function unzigzag(value) {
+  return (value % 2 === 0) ? value / 2 : -(value + 1) / 2;
+}
+
+// Dekodiert eine Reihe aus app_ts_codec.c mit count Werten
+function decodeSeries(bytes, pos, count) {
+  var values = [];
+  if (count === 0) {
+    return values;
+  }
+  values.push(unzigzag(readVarint(bytes, pos)));
+  if (count === 1) {
+    return values;
+  }
+  var delta = unzigzag(readVarint(bytes, pos));
+  values.push(values[0] + delta);
+  while (values.length < count) {
+    var token = readVarint(bytes, pos);
+    var run = 1;
+    if (token % 2 === 1) {
+      run = (token - 1) / 2 + 1;
+    } else {
+      delta += unzigzag(token / 2);
+    }
+    for (var r = 0; r < run && values.length < count; r++) {
+      values.push(values[values.length - 1] + delta);
+    }
+  }
+  return values;
+}
+
 function decodeUplink(input) {
   var data = {};
   var warnings = [];
@@ -37,6 +121,7 @@ function decodeUplink(input) {
     3: "FUOTA Event",
     4: "App Cycle Event",
     5: "Timeout Event",
+    6: "Backfill Event",
     255: "Undefined Event"
   };
   //data.tx_reason_code = txReasonCode;
@@ -82,7 +167,96 @@ function decodeUplink(input) {
 
   data.datarate = "DR" + datarate +"/SF" + (12 - datarate) + "/" + bandwidthMap[datarate] + "kHz/" + bitrateMap[datarate]+"bps"; 
 
-  if (input.bytes.length > 5) {
+  if (input.fPort === 14 && input.bytes.length >= 6) {
+    var cnt = input.bytes[i++];
+    data.samples = [];
+    for (var m = 0; m < cnt && (i + 9) <= input.bytes.length; m++) {
+      var rec = {};
+      var age = (input.bytes[i++] << 8) | input.bytes[i++];
+      rec.age_min = (age === 0xFFFF) ? null : age;
+      rec.temp1 = decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]);
+      rec.temp2 = decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]);
+      rec.humidity = decodeHumidity(input.bytes[i++]);
+      rec.supply_voltage = ((input.bytes[i++] << 8) | input.bytes[i++]) / 1000;
+      data.samples.push(rec);
+    }
+    if (data.samples.length !== cnt) {
+      warnings.push("Nachlieferung unvollstaendig: " + data.samples.length + " von " + cnt + " Samples");
+    }
+  } else if (input.fPort === 13 && input.bytes.length >= 8) {
+    var nb = input.bytes[i++];
+    data.sample_count = nb;
+    data.sample_interval_s = (input.bytes[i++] << 8) | input.bytes[i++];
+
+    var series = {};
+    var pos = { i: i };
+    try {
+      while (pos.i < input.bytes.length) {
+        var id = input.bytes[pos.i++];
+        series[id] = decodeSeries(input.bytes, pos, nb);
+      }
+    } catch (e) {
+      errors.push("Komprimierte Reihe fehlerhaft: " + e);
+    }
+
+    data.samples = [];
+    for (var k = 0; k < nb; k++) {
+      var s = {};
+      if (series[1]) { s.temp1 = decodeTemperature(series[1][k] & 0xFFFF); }
+      if (series[2]) { s.temp2 = decodeTemperature(series[2][k] & 0xFFFF); }
+      if (series[3]) { s.humidity = decodeHumidity(series[3][k]); }
+      if (series[4]) { s.supply_voltage = series[4][k] / 1000; }
+      if (data.sample_interval_s > 0) {
+        s.age_s = (nb - 1 - k) * data.sample_interval_s;
+      }
+      data.samples.push(s);
+    }
+  } else if ((input.fPort === 11 || input.fPort === 12) && input.bytes.length >= 8) {
+    var count = input.bytes[i++];
+    data.sample_count = count;
+    data.sample_interval_s = (input.bytes[i++] << 8) | input.bytes[i++];
+
+    if (input.fPort === 11) {
+      // Batch: aeltestes Sample zuerst
+      data.samples = [];
+      for (var n = 0; n < count && (i + 7) <= input.bytes.length; n++) {
+        var sample = {};
+        sample.temp1 = decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]);
+        sample.temp2 = decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]);
+        sample.humidity = decodeHumidity(input.bytes[i++]);
+        sample.supply_voltage = ((input.bytes[i++] << 8) | input.bytes[i++]) / 1000;
+        if (data.sample_interval_s > 0) {
+          sample.age_s = (count - 1 - n) * data.sample_interval_s;
+        }
+        data.samples.push(sample);
+      }
+      if (data.samples.length !== count) {
+        warnings.push("Batch unvollstaendig: " + data.samples.length + " von " + count + " Samples");
+      }
+    } else if (input.bytes.length >= i + 21) {
+      // Aggregat: min/max/mean
+      var names = ["temp1", "temp2"];
+      for (var t = 0; t < names.length; t++) {
+        data[names[t]] = {
+          min: decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]),
+          max: decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++]),
+          mean: decodeTemperature((input.bytes[i++] << 8) | input.bytes[i++])
+        };
+      }
+      data.humidity = {
+        min: decodeHumidity(input.bytes[i++]),
+        max: decodeHumidity(input.bytes[i++]),
+        mean: decodeHumidity(input.bytes[i++])
+      };
+      data.supply_voltage_agg = {
+        min: ((input.bytes[i++] << 8) | input.bytes[i++]) / 1000,
+        max: ((input.bytes[i++] << 8) | input.bytes[i++]) / 1000,
+        mean: ((input.bytes[i++] << 8) | input.bytes[i++]) / 1000
+      };
+    } else {
+      errors.push("Aggregat zu kurz: " + input.bytes.length + " Bytes");
+    }
+  } else if (input.bytes.length > 5) {
   	var temp1 = (input.bytes[i++] << 8) | input.bytes[i++];
   	switch (temp1) {
   	  case 0x8000: 
@@ -0,0 +1,332 @@
+/**
+* @file test_app_samples.c
+* @brief Tests of the sample ring buffer (app_samples.c).
+*
+* app_samples.c is included, the samples are numbered and read back from the
+* batch records (port 11) of the uplinks:
+* - an empty ring encodes nothing in any mode and releases nothing
+* - the samples come out oldest first, across the end of the ring and over
+*   several uplinks limited by the body size
+* - a full ring overwrites the oldest sample, the count stays at
+*   APP_SAMPLES_RING_SIZE
+* - app_samples_release( true ) drops the samples of the last uplink only,
+*   app_samples_release( false ) hands them to the flash sample log in order
+* - app_samples_keep() encodes the same samples again with the next attempt
+* - the aggregate covers the whole ring, the compressed body has the size of
+*   app_samples_get_encoded_size()
+* - without the ELV-AM-TH1 the sample holds the escape values and the supply
+*   level of the base
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+
+// base.h needs the device headers, its one function used here is declared below
+#define __BASE_H__
+uint16_t base_get_supply_level( void );
+
+#include "app_samples.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_BODY_SIZE                          UINT8_MAX
+#define TEST_MAX_BATCH                              ( ( TEST_MAX_BODY_SIZE - APP_SAMPLES_BODY_HEADER_SIZE ) / APP_SAMPLES_BATCH_RECORD_SIZE )
+#define TEST_SUPPLY_LEVEL                           2950
+
+// Variables -------------------------------------------------------------------
+static uint32_t u32_next_sample = 0;                 // Number of the next sample pushed
+static uint32_t log_samples[APP_SAMPLES_RING_SIZE];  // Numbers of the samples written to the flash sample log
+static uint8_t u8_log_count = 0;
+static bool b_th1_present = false;
+
+// Stubs -----------------------------------------------------------------------
+void UTIL_SEQ_RegTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Flags, void ( *Task )( void ) )
+{
+}
+
+void UTIL_SEQ_SetTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio )
+{
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+bool elv_am_th1_is_present( void )
+{
+  return b_th1_present;
+}
+
+void elv_am_th1_do_measurements( th1_data_values_t *t_th1_data_values )
+{
+  t_th1_data_values->i16_ntc_temperature      = 215;
+  t_th1_data_values->i16_HDC2080_temperature  = 230;
+  t_th1_data_values->u8_HDC2080_humidity      = 45;
+  t_th1_data_values->u16_operating_voltage    = 3010;
+}
+
+void rtc_temp_comp_update( int16_t i16_temperature )
+{
+}
+
+uint16_t base_get_supply_level( void )
+{
+  return TEST_SUPPLY_LEVEL;
+}
+
+bool flash_sample_log_append( const app_sample_t *sample )
+{
+  CHECK( u8_log_count < APP_SAMPLES_RING_SIZE );
+  log_samples[u8_log_count++ % APP_SAMPLES_RING_SIZE] = ( uint32_t ) sample->i16_ntc_temperature;
+  return true;
+}
+
+// Functions -------------------------------------------------------------------
+// Sample number n: the NTC temperature holds n, the other values are derived from it
+static void push_samples( uint32_t u32_count )
+{
+  for( uint32_t i = 0; i < u32_count; i++ )
+  {
+    app_sample_t sample = { .i16_ntc_temperature      = ( int16_t ) u32_next_sample,
+                            .i16_HDC2080_temperature  = ( int16_t ) ( 1000 - u32_next_sample ),
+                            .u16_supply_voltage       = ( uint16_t ) ( 3000 + u32_next_sample ),
+                            .u8_HDC2080_humidity      = ( uint8_t ) ( u32_next_sample % 101 ) };
+
+    app_samples_push( &sample );
+    u32_next_sample++;
+  }
+}
+
+static int16_t get_i16( const uint8_t *buffer )
+{
+  return ( int16_t ) ( ( buffer[0] << 8 ) | buffer[1] );
+}
+
+/**
+  * @brief  Encodes a batch of at most u8_max_size bytes and checks its records.
+  * @param[in] u32_first Number of the oldest sample expected.
+  * @return Number of samples of the batch
+  */
+static uint8_t read_batch( uint8_t u8_max_size, uint32_t u32_first )
+{
+  uint8_t buffer[TEST_MAX_BODY_SIZE];
+  uint8_t u8_size = app_samples_encode_batch( buffer, u8_max_size );
+  uint8_t u8_count = buffer[0];
+
+  if( u8_size == 0 )
+  {
+    return 0;
+  }
+  CHECK( u8_size == ( APP_SAMPLES_BODY_HEADER_SIZE + u8_count * APP_SAMPLES_BATCH_RECORD_SIZE ) );
+  CHECK( u8_size <= u8_max_size );
+  CHECK( u8_size == app_samples_get_encoded_size( APP_UPLINK_MODE_BATCH, u8_max_size ) );
+
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    const uint8_t *record = &buffer[APP_SAMPLES_BODY_HEADER_SIZE + i * APP_SAMPLES_BATCH_RECORD_SIZE];
+    uint32_t u32_sample = u32_first + i;
+
+    CHECK( get_i16( &record[0] ) == ( int16_t ) u32_sample );
+    CHECK( get_i16( &record[2] ) == ( int16_t ) ( 1000 - u32_sample ) );
+    CHECK( record[4] == ( uint8_t ) ( u32_sample % 101 ) );
+    CHECK( ( uint16_t ) get_i16( &record[5] ) == ( uint16_t ) ( 3000 + u32_sample ) );
+  }
+
+  return u8_count;
+}
+
+// Reads the ring out over uplinks of u8_max_size bytes, all samples delivered
+static void read_all( uint8_t u8_max_size, uint32_t u32_first )
+{
+  uint8_t u8_count;
+
+  while( ( u8_count = read_batch( u8_max_size, u32_first ) ) != 0 )
+  {
+    CHECK( u8_count == MIN( app_samples_get_count(), ( u8_max_size - APP_SAMPLES_BODY_HEADER_SIZE ) / APP_SAMPLES_BATCH_RECORD_SIZE ) );
+    app_samples_release( true );
+    u32_first += u8_count;
+  }
+  CHECK( app_samples_get_count() == 0 );
+  CHECK( u32_first == u32_next_sample );
+}
+
+static void test_empty( void )
+{
+  uint8_t buffer[TEST_MAX_BODY_SIZE];
+
+  app_samples_init();
+  CHECK( app_samples_get_count() == 0 );
+  CHECK( app_samples_encode_batch( buffer, TEST_MAX_BODY_SIZE ) == 0 );
+  CHECK( app_samples_encode_aggregate( buffer, TEST_MAX_BODY_SIZE ) == 0 );
+  CHECK( app_samples_encode_compressed( buffer, TEST_MAX_BODY_SIZE ) == 0 );
+
+  // Nothing pending: no sample logged, the next push counts from an empty ring
+  app_samples_release( false );
+  CHECK( u8_log_count == 0 );
+  push_samples( 1 );
+  CHECK( app_samples_get_count() == 1 );
+  read_all( TEST_MAX_BODY_SIZE, u32_next_sample - 1 );
+}
+
+static void test_wrap_around( void )
+{
+  uint32_t u32_first;
+
+  // The ring is read out in uplinks of 4 samples while new ones come in, its slots are reused several times
+  app_samples_clear();
+  u32_first = u32_next_sample;
+  for( uint16_t i = 0; i < 5 * APP_SAMPLES_RING_SIZE; i += 3 )
+  {
+    uint8_t u8_count;
+
+    push_samples( 3 + ( i % 2 ) );
+    u8_count = read_batch( APP_SAMPLES_BODY_HEADER_SIZE + 4 * APP_SAMPLES_BATCH_RECORD_SIZE, u32_first );
+    CHECK( u8_count == MIN( app_samples_get_count(), 4 ) );
+    app_samples_release( true );
+    u32_first += u8_count;
+  }
+  read_all( TEST_MAX_BODY_SIZE, u32_first );
+}
+
+static void test_full( void )
+{
+  uint32_t u32_first;
+
+  // Exactly full: nothing is lost
+  app_samples_clear();
+  u32_first = u32_next_sample;
+  push_samples( APP_SAMPLES_RING_SIZE );
+  CHECK( app_samples_get_count() == APP_SAMPLES_RING_SIZE );
+  read_all( TEST_MAX_BODY_SIZE, u32_first );
+
+  // Full plus 10: the 10 oldest are overwritten
+  push_samples( APP_SAMPLES_RING_SIZE + 10 );
+  CHECK( app_samples_get_count() == APP_SAMPLES_RING_SIZE );
+  read_all( TEST_MAX_BODY_SIZE, u32_next_sample - APP_SAMPLES_RING_SIZE );
+
+  // Full many times over from a head in the middle of the ring
+  push_samples( 7 );
+  read_all( TEST_MAX_BODY_SIZE, u32_next_sample - 7 );
+  push_samples( 3 * APP_SAMPLES_RING_SIZE + 5 );
+  CHECK( app_samples_get_count() == APP_SAMPLES_RING_SIZE );
+
+  // The largest batch of a full ring drops the oldest samples only
+  CHECK( read_batch( TEST_MAX_BODY_SIZE, u32_next_sample - APP_SAMPLES_RING_SIZE ) == TEST_MAX_BATCH );
+  app_samples_release( true );
+  CHECK( app_samples_get_count() == APP_SAMPLES_RING_SIZE - TEST_MAX_BATCH );
+  read_all( TEST_MAX_BODY_SIZE, u32_next_sample - APP_SAMPLES_RING_SIZE + TEST_MAX_BATCH );
+}
+
+static void test_release( void )
+{
+  uint32_t u32_first;
+  uint8_t u8_count;
+
+  // Not delivered: the samples of the uplink go to the flash sample log, oldest first
+  app_samples_clear();
+  u32_first = u32_next_sample;
+  push_samples( 20 );
+  u8_count = read_batch( APP_SAMPLES_BODY_HEADER_SIZE + 8 * APP_SAMPLES_BATCH_RECORD_SIZE, u32_first );
+  CHECK( u8_count == 8 );
+  u8_log_count = 0;
+  app_samples_release( false );
+  CHECK( u8_log_count == 8 );
+  for( uint8_t i = 0; i < u8_log_count; i++ )
+  {
+    CHECK( log_samples[i] == ( u32_first + i ) );
+  }
+  CHECK( app_samples_get_count() == 12 );
+
+  // Postponed: the same samples again
+  u32_first += 8;
+  CHECK( read_batch( APP_SAMPLES_BODY_HEADER_SIZE + 5 * APP_SAMPLES_BATCH_RECORD_SIZE, u32_first ) == 5 );
+  app_samples_keep();
+  CHECK( app_samples_get_count() == 12 );
+  app_samples_release( true );
+  CHECK( app_samples_get_count() == 12 );
+  read_all( TEST_MAX_BODY_SIZE, u32_first );
+  u8_log_count = 0;
+}
+
+static void test_modes( void )
+{
+  uint8_t buffer[TEST_MAX_BODY_SIZE];
+  uint8_t u8_size;
+
+  // The aggregate covers the whole ring, across its end
+  app_samples_clear();
+  push_samples( APP_SAMPLES_RING_SIZE + 30 );
+  u8_size = app_samples_encode_aggregate( buffer, TEST_MAX_BODY_SIZE );
+  CHECK( u8_size == APP_SAMPLES_AGGREGATE_BODY_SIZE );
+  CHECK( buffer[0] == APP_SAMPLES_RING_SIZE );
+  CHECK( get_i16( &buffer[3] ) == ( int16_t ) ( u32_next_sample - APP_SAMPLES_RING_SIZE ) );
+  CHECK( get_i16( &buffer[5] ) == ( int16_t ) ( u32_next_sample - 1 ) );
+  app_samples_release( true );
+  CHECK( app_samples_get_count() == 0 );
+
+  // The compressed body of the oldest samples which fit
+  push_samples( APP_SAMPLES_RING_SIZE + 30 );
+  for( uint8_t u8_max_size = 0; u8_max_size < TEST_MAX_BODY_SIZE; u8_max_size += 17 )
+  {
+    uint8_t u8_expected = app_samples_get_encoded_size( APP_UPLINK_MODE_COMPRESSED, u8_max_size );
+
+    u8_size = app_samples_encode_compressed( buffer, u8_max_size );
+    CHECK( u8_size == u8_expected );
+    CHECK( u8_size <= u8_max_size );
+    CHECK( ( u8_size == 0 ) || ( buffer[0] <= APP_SAMPLES_RING_SIZE ) );
+    app_samples_keep();
+  }
+  CHECK( app_samples_get_count() == APP_SAMPLES_RING_SIZE );
+}
+
+static void test_take( void )
+{
+  uint8_t buffer[TEST_MAX_BODY_SIZE];
+
+  app_samples_clear();
+  b_th1_present = false;
+  app_samples_take();
+  b_th1_present = true;
+  app_samples_take();
+  CHECK( app_samples_get_count() == 2 );
+
+  CHECK( app_samples_encode_batch( buffer, TEST_MAX_BODY_SIZE ) == ( APP_SAMPLES_BODY_HEADER_SIZE + 2 * APP_SAMPLES_BATCH_RECORD_SIZE ) );
+  CHECK( get_i16( &buffer[3] ) == ( int16_t ) TEMPERATURE_UNKNOWN );
+  CHECK( get_i16( &buffer[5] ) == ( int16_t ) TEMPERATURE_UNKNOWN );
+  CHECK( buffer[7] == APP_SAMPLES_HUMIDITY_INVALID );
+  CHECK( get_i16( &buffer[8] ) == TEST_SUPPLY_LEVEL );
+  CHECK( get_i16( &buffer[10] ) == 215 );
+  CHECK( get_i16( &buffer[12] ) == 230 );
+  CHECK( buffer[14] == 45 );
+  CHECK( get_i16( &buffer[15] ) == 3010 );
+  app_samples_release( true );
+}
+
+int main( void )
+{
+  test_empty();
+  test_wrap_around();
+  test_full();
+  test_release();
+  test_modes();
+  test_take();
+
+  return TEST_END();
+}
@@ -0,0 +1,300 @@
+/**
+* @file test_ts_codec.c
+* @brief Round trip tests and benchmark of the time series codec (app_ts_codec.c).
+*
+* The series are decoded like TTNFormatter/testformatter.js does it:
+* - counts 0, 1, 2 and 255
+* - the largest deltas and delta-of-deltas of int16_t values
+* - the escape values of the sensors: TEMPERATURE_UNKNOWN, _OVERFLOW and
+*   _UNDERFLOW, APP_SAMPLES_HUMIDITY_INVALID
+* - zero runs of 1, 64 and 253 values, the run token with one and two bytes
+* - app_ts_codec_get_series_size() is the size written by the encoder
+* With TEST_BENCH the body of the compressed series (port 13) is compared with
+* the 7 byte records of the batch (port 11) for a day of samples every 5 and
+* 15 min: an outdoor temperature with a 6 degC swing, the HDC2080 lagging
+* inside the housing, the humidity following the temperature and the supply
+* voltage with ADC noise. The encoding time is host CPU time, there are no
+* figures of the target.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <math.h>
+#include "test.h"
+#include "app_ts_codec.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_VALUES                             255
+#define TEST_MAX_SIZE                               ( 1 + TEST_MAX_VALUES * APP_TS_CODEC_VARINT_MAX_SIZE )
+
+// Escape values of 103AT_2B_Values.h and app_samples.h
+#define TEMPERATURE_UNKNOWN                         ( ( int16_t ) 0x8000 )
+#define TEMPERATURE_OVERFLOW                        ( ( int16_t ) 0x8001 )
+#define TEMPERATURE_UNDERFLOW                       ( ( int16_t ) 0x8002 )
+#define HUMIDITY_INVALID                            0xFF
+
+// Bodies of app_samples.h: header, record of the port 11 batch
+#define TEST_BENCH_BODY_HEADER_SIZE                 3
+#define TEST_BENCH_BATCH_RECORD_SIZE                7
+#define TEST_BENCH_DAY_SAMPLES                      288
+
+// Functions -------------------------------------------------------------------
+static int32_t unzigzag( uint32_t u32_value )
+{
+  return ( int32_t ) ( u32_value >> 1 ) ^ -( int32_t ) ( u32_value & 1 );
+}
+
+static uint32_t read_varint( const uint8_t *buffer, uint16_t *pos, uint16_t size, bool *b_ok )
+{
+  uint32_t u32_value = 0;
+  uint8_t shift = 0;
+  uint8_t b;
+
+  do
+  {
+    if( ( *pos >= size ) || ( shift > 28 ) )
+    {
+      *b_ok = false;
+      return 0;
+    }
+    b = buffer[( *pos )++];
+    u32_value |= ( uint32_t ) ( b & 0x7F ) << shift;
+    shift += 7;
+  } while( b & 0x80 );
+
+  return u32_value;
+}
+
+/**
+  * @brief  Decodes a series of u8_count values, returns false if the series is malformed
+  */
+static bool decode_series( const uint8_t *buffer, uint16_t size, uint8_t u8_count, uint8_t *series_id, int16_t *values )
+{
+  uint16_t pos = 1;
+  uint16_t n = 0;
+  int32_t delta;
+  bool b_ok = true;
+
+  *series_id = buffer[0];
+  if( u8_count == 0 )
+  {
+    return size == 1;
+  }
+
+  values[n++] = ( int16_t ) unzigzag( read_varint( buffer, &pos, size, &b_ok ) );
+  if( u8_count > 1 )
+  {
+    delta = unzigzag( read_varint( buffer, &pos, size, &b_ok ) );
+    values[n] = ( int16_t ) ( values[n - 1] + delta );
+    n++;
+  }
+
+  while( b_ok && ( n < u8_count ) )
+  {
+    uint32_t u32_token = read_varint( buffer, &pos, size, &b_ok );
+    uint32_t u32_run = 1;
+
+    if( u32_token & 1 )
+    {
+      u32_run = ( u32_token >> 1 ) + 1;
+    }
+    else
+    {
+      delta += unzigzag( u32_token >> 1 );
+    }
+    for( uint32_t r = 0; ( r < u32_run ) && ( n < u8_count ); r++ )
+    {
+      values[n] = ( int16_t ) ( values[n - 1] + delta );
+      n++;
+    }
+  }
+
+  return b_ok && ( pos == size );
+}
+
+static void round_trip( const int16_t *values, uint8_t u8_count )
+{
+  static uint8_t buffer[TEST_MAX_SIZE];
+  int16_t decoded[TEST_MAX_VALUES];
+  uint8_t series_id = 0;
+  uint16_t size;
+
+  size = app_ts_codec_encode_series( buffer, APP_TS_SERIES_HDC2080_HUMIDITY, values, u8_count );
+  CHECK( size == app_ts_codec_get_series_size( values, u8_count ) );
+  CHECK( size <= TEST_MAX_SIZE );
+  CHECK( decode_series( buffer, size, u8_count, &series_id, decoded ) );
+  CHECK( series_id == APP_TS_SERIES_HDC2080_HUMIDITY );
+  CHECK_MEM( decoded, values, u8_count * sizeof( int16_t ) );
+}
+
+static void test_varint( void )
+{
+  static const uint32_t u32_values[] = { 0, 1, 0x7F, 0x80, 0x3FFF, 0x4000, 0x1FFFFF, 0x200000, 0xFFFFFFF, 0x10000000, UINT32_MAX };
+  static const uint8_t u8_sizes[]    = { 1, 1, 1,    2,    2,      3,      3,        4,        4,         5,          5 };
+  uint8_t buffer[APP_TS_CODEC_VARINT_MAX_SIZE];
+
+  for( uint8_t i = 0; i < sizeof( u32_values ) / sizeof( u32_values[0] ); i++ )
+  {
+    uint16_t pos = 0;
+    bool b_ok = true;
+
+    CHECK( app_ts_codec_get_varint_size( u32_values[i] ) == u8_sizes[i] );
+    CHECK( app_ts_codec_put_varint( buffer, u32_values[i] ) == u8_sizes[i] );
+    CHECK( read_varint( buffer, &pos, sizeof( buffer ), &b_ok ) == u32_values[i] );
+    CHECK( b_ok && ( pos == u8_sizes[i] ) );
+  }
+
+  CHECK( app_ts_codec_zigzag( 0 ) == 0 );
+  CHECK( app_ts_codec_zigzag( -1 ) == 1 );
+  CHECK( app_ts_codec_zigzag( 1 ) == 2 );
+  CHECK( app_ts_codec_zigzag( INT32_MAX ) == UINT32_MAX - 1 );
+  CHECK( app_ts_codec_zigzag( INT32_MIN ) == UINT32_MAX );
+  CHECK( unzigzag( app_ts_codec_zigzag( -123456 ) ) == -123456 );
+}
+
+static void test_series( void )
+{
+  int16_t values[TEST_MAX_VALUES];
+
+  // Counts 0, 1 and 2
+  values[0] = 215;
+  values[1] = -40;
+  round_trip( values, 0 );
+  round_trip( values, 1 );
+  round_trip( values, 2 );
+  CHECK( app_ts_codec_get_series_size( values, 0 ) == 1 );
+
+  // Largest delta-of-deltas: alternating int16_t limits
+  for( uint16_t i = 0; i < TEST_MAX_VALUES; i++ )
+  {
+    values[i] = ( i & 1 ) ? INT16_MIN : INT16_MAX;
+  }
+  round_trip( values, TEST_MAX_VALUES );
+
+  // Escape values between normal temperatures
+  {
+    const int16_t escapes[] = { 215, 216, TEMPERATURE_UNKNOWN, 217, TEMPERATURE_OVERFLOW, TEMPERATURE_UNDERFLOW,
+                                -400, TEMPERATURE_UNDERFLOW, TEMPERATURE_UNDERFLOW, TEMPERATURE_UNDERFLOW, 1250 };
+    const int16_t humidity[] = { 45, 46, HUMIDITY_INVALID, HUMIDITY_INVALID, HUMIDITY_INVALID, 47, 0, 100, HUMIDITY_INVALID };
+
+    round_trip( escapes, sizeof( escapes ) / sizeof( escapes[0] ) );
+    round_trip( humidity, sizeof( humidity ) / sizeof( humidity[0] ) );
+  }
+
+  // Zero runs: 1 value, 64 values ( two byte run token ), the whole series
+  {
+    const uint16_t runs[] = { 1, 64, TEST_MAX_VALUES - 2 };
+
+    for( uint8_t r = 0; r < sizeof( runs ) / sizeof( runs[0] ); r++ )
+    {
+      for( uint16_t i = 0; i < TEST_MAX_VALUES; i++ )
+      {
+        values[i] = ( int16_t ) ( 1000 + 3 * i + ( ( i > runs[r] + 1 ) ? 7 : 0 ) );
+      }
+      round_trip( values, TEST_MAX_VALUES );
+    }
+    // First value, first delta and a single run token
+    CHECK( app_ts_codec_get_series_size( values, TEST_MAX_VALUES ) == 1 + 2 + 1 + 2 );
+  }
+
+  // Random series of every length
+  for( uint16_t count = 0; count <= TEST_MAX_VALUES; count++ )
+  {
+    for( uint16_t i = 0; i < count; i++ )
+    {
+      switch( test_rand() % 4 )
+      {
+        case 0:
+          values[i] = ( int16_t ) test_rand();
+          break;
+        case 1:
+          values[i] = ( i > 1 ) ? ( int16_t ) ( 2 * values[i - 1] - values[i - 2] ) : 0;
+          break;
+        default:
+          values[i] = ( int16_t ) ( ( i > 0 ? values[i - 1] : 200 ) + ( int16_t ) ( test_rand() % 5 ) - 2 );
+          break;
+      }
+    }
+    round_trip( values, ( uint8_t ) count );
+  }
+}
+
+#if defined( TEST_BENCH )
+// Samples of a day at u16_interval minutes: outdoor NTC, HDC2080 inside the housing, humidity, supply voltage
+static void bench_day( uint16_t u16_interval, int16_t series[4][TEST_BENCH_DAY_SAMPLES] )
+{
+  double housing = 0.0;
+
+  test_rand_state = 1;
+  for( uint16_t i = 0; i < TEST_BENCH_DAY_SAMPLES; i++ )
+  {
+    double minute = ( double ) i * u16_interval;
+    double outdoor = 12.0 + 6.0 * sin( 2.0 * M_PI * ( minute / 1440.0 - 0.375 ) );
+
+    // The housing follows with a time constant of 30 min and is 1.5 degC warmer
+    housing = ( i == 0 ) ? outdoor : housing + ( outdoor - housing ) * ( 1.0 - exp( -u16_interval / 30.0 ) );
+
+    series[0][i] = ( int16_t ) lround( outdoor * 10.0 + ( ( test_rand() % 5 ) - 2 ) * 0.25 );
+    series[1][i] = ( int16_t ) lround( ( housing + 1.5 ) * 10.0 + ( ( test_rand() % 3 ) - 1 ) * 0.4 );
+    series[2][i] = ( int16_t ) lround( 70.0 - 2.5 * ( outdoor - 12.0 ) );
+    series[3][i] = ( int16_t ) ( 3010 - ( i / 48 ) + ( int16_t ) ( test_rand() % 9 ) - 4 );
+  }
+}
+
+/**
+  * @brief  Body of the oldest u8_count samples of a day, compressed (port 13) and as batch records (port 11)
+  */
+static void bench( uint16_t u16_interval, uint8_t u8_count )
+{
+  static uint8_t buffer[TEST_MAX_SIZE];
+  static int16_t series[4][TEST_BENCH_DAY_SAMPLES];
+  uint16_t u16_batch = TEST_BENCH_BODY_HEADER_SIZE + ( u8_count * TEST_BENCH_BATCH_RECORD_SIZE );
+  uint16_t u16_compressed = TEST_BENCH_BODY_HEADER_SIZE;
+  uint32_t runs = 0;
+  double start;
+
+  bench_day( u16_interval, series );
+  for( uint8_t s = 0; s < 4; s++ )
+  {
+    round_trip( series[s], u8_count );
+    u16_compressed += app_ts_codec_get_series_size( series[s], u8_count );
+  }
+
+  // Host CPU time of the four series, for comparisons between the rows only
+  start = test_cpu_time();
+  for( runs = 0; ( test_cpu_time() - start ) < 0.2; runs++ )
+  {
+    for( uint8_t s = 0; s < 4; s++ )
+    {
+      app_ts_codec_encode_series( buffer, ( app_ts_series_id_t ) ( APP_TS_SERIES_NTC_TEMPERATURE + s ), series[s], u8_count );
+    }
+  }
+
+  printf( "  %2u min, %2u samples: %3u bytes compressed, %3u bytes batch, %4.2f vs %u bytes per sample, host %6.2f us\n",
+          u16_interval, u8_count, u16_compressed, u16_batch,
+          ( double ) ( u16_compressed - TEST_BENCH_BODY_HEADER_SIZE ) / u8_count, TEST_BENCH_BATCH_RECORD_SIZE,
+          ( test_cpu_time() - start ) * 1e6 / runs );
+  CHECK( u16_compressed < u16_batch );
+}
+#endif /* TEST_BENCH */
+
+int main( void )
+{
+#if defined( TEST_BENCH )
+  static const uint16_t intervals[] = { 5, 15 };
+  static const uint8_t counts[] = { 12, 32, 64 };
+
+  for( uint8_t i = 0; i < sizeof( intervals ) / sizeof( intervals[0] ); i++ )
+  {
+    for( uint8_t c = 0; c < sizeof( counts ); c++ )
+    {
+      bench( intervals[i], counts[c] );
+    }
+  }
+#else
+  test_varint();
+  test_series();
+#endif /* TEST_BENCH */
+
+  return TEST_END();
+}
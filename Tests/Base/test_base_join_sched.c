@@ -0,0 +1,689 @@
+/**
+* @file test_base_join_sched.c
+* @brief Join simulation of the join scheduler (base_join_sched.c).
+*
+* base_join_sched.c is included, each simulated node swaps its own copy of the
+* static state of the scheduler in and out (node_enter, node_leave). The timer
+* and the sequencer run the scheduler as on the target, the LmHandler and the
+* MAC are replaced by an EU868 model:
+* - join requests of 23 bytes on 3 join channels, the node reaches the gateway
+*   up to its own datarate (range), same channel and datarate overlaps collide
+* - a time-off of the time-on-air times RegionCommonGetJoinDc() after each
+*   join request, of 100 times after each uplink of a joined node
+* - a half-duplex gateway: join accepts of 33 bytes in RX1 (1 % band) or else
+*   RX2 (DR0, 10 % band), the uplinks during its transmissions are lost
+* - joined nodes send an uplink of 25 bytes every TEST_DATA_PERIOD
+* Checks:
+* - one node out of range: the first request within BASE_JOIN_START_DELAY_MAX,
+*   the datarate cycle DR5..DR0, the back-off of each failure randomized within
+*   50..150 % and doubling within a cycle only, the duty cycle wait plus
+*   BASE_JOIN_DC_JITTER_MAX after that
+* - no request before the time-off of the node has passed
+* - the DevNonce of each request is above all the previous ones, also across
+*   reboots, and within the block reserved in the EEPROM, one EEPROM write
+*   per BASE_JOIN_DEV_NONCE_BLOCK requests
+* - time to join of N nodes powered up within 50 ms: all of them join within
+*   TEST_DURATION, the median and the 90th percentile stay below the bounds
+*   of test_join_bounds
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdlib.h>
+#include "test.h"
+#include "radio.h"
+#include "RegionCommon.h"
+#include "base_join_sched.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_NEVER                                  UINT32_MAX
+#define TEST_MAX_NODES                              200
+#define TEST_MAX_UPLINKS                            1024                              // Uplinks kept for the collisions
+#define TEST_MAX_DOWNLINKS                          64                                // Downlinks kept for the half-duplex gateway
+#define TEST_MAX_REQUESTS                           256
+#define TEST_JOIN_CHANNELS                          3
+#define TEST_JOIN_REQ_SIZE                          23
+#define TEST_JOIN_ACCEPT_SIZE                       33
+#define TEST_DATA_SIZE                              25
+#define TEST_DATA_PERIOD                            30000
+#define TEST_JOIN_ACCEPT_DELAY1                     5000
+#define TEST_JOIN_ACCEPT_DELAY2                     6000
+#define TEST_RX2_TIMEOUT                            300                               // RX2 closed without a join accept
+#define TEST_GW_RX1_DUTY_CYCLE                      100
+#define TEST_GW_RX2_DUTY_CYCLE                      10
+#define TEST_DATA_DUTY_CYCLE                        100
+#define TEST_BOOT_SPREAD                            50
+#define TEST_DURATION                               ( 6UL * 3600000 )
+#define TEST_BACKOFF_DURATION                       ( 30UL * 3600000 )
+#define TEST_REBOOTS                                100
+
+typedef struct
+{
+  uint16_t u16_count;
+  uint32_t u32_median_max;                                                            // [s]
+  uint32_t u32_p90_max;                                                               // [s]
+} test_join_bound_t;
+
+typedef struct
+{
+  UTIL_TIMER_Time_t start;
+  UTIL_TIMER_Time_t end;
+  uint8_t channel;
+  int8_t datarate;
+  bool b_collided;
+} test_uplink_t;
+
+typedef struct
+{
+  UTIL_TIMER_Time_t start;
+  UTIL_TIMER_Time_t end;
+} test_downlink_t;
+
+// Copy of the static state of base_join_sched.c
+typedef struct
+{
+  UTIL_TIMER_Object_t join_timer;
+  base_join_sched_stats_t join_stats;
+  ActivationType_t join_activation_type;
+  bool b_running;
+  bool b_request_pending;
+  uint8_t u8_failures;
+  int8_t i8_datarate;
+  uint32_t u32_dev_nonce_bound;
+  UTIL_TIMER_Time_t start_time;
+} test_sched_t;
+
+typedef struct
+{
+  test_sched_t sched;
+  int8_t i8_max_datarate;                   // Highest datarate reaching the gateway, -1: out of range
+  // Events
+  UTIL_TIMER_Time_t boot_due;
+  UTIL_TIMER_Time_t timer_due;
+  UTIL_TIMER_Time_t tx_end_due;
+  UTIL_TIMER_Time_t result_due;
+  UTIL_TIMER_Time_t data_due;
+  uint32_t u32_timer_period;
+  // MAC
+  UTIL_TIMER_Time_t boot_time;
+  UTIL_TIMER_Time_t next_tx;                // End of the time-off
+  uint16_t u16_dev_nonce;
+  uint16_t u16_uplink;                      // Index in test_uplinks of the uplink on air
+  bool b_join_request;
+  bool b_busy;
+  bool b_accepted;
+  bool b_joined;
+  int8_t i8_datarate;
+  // EEPROM
+  uint32_t u32_eeprom_dev_nonce;
+  uint32_t u32_eeprom_writes;
+  // Statistics
+  int32_t i32_last_dev_nonce;
+  uint32_t u32_requests;
+  uint32_t u32_join_air_time;
+  UTIL_TIMER_Time_t join_time;
+} test_node_t;
+
+// Variables -------------------------------------------------------------------
+// Upper bounds of the time to join, with some margin for the random delays
+static const test_join_bound_t test_join_bounds[] =
+{
+  {  10,  120,  300 },
+  {  50,  900, 1800 },
+  { 200, 2400, 5400 },
+};
+
+static test_node_t test_nodes[TEST_MAX_NODES];
+static test_node_t *node;
+static uint16_t u16_nb_nodes;
+static UTIL_TIMER_Time_t now;
+
+static test_uplink_t test_uplinks[TEST_MAX_UPLINKS];
+static uint16_t u16_uplinks;
+static test_downlink_t test_downlinks[TEST_MAX_DOWNLINKS];
+static uint16_t u16_downlinks;
+static UTIL_TIMER_Time_t gw_rx1_next;
+static UTIL_TIMER_Time_t gw_rx2_next;
+
+static void ( *join_task )( void );
+static bool b_join_task_set;
+
+// Requests of the first node
+static UTIL_TIMER_Time_t request_times[TEST_MAX_REQUESTS];
+static int8_t request_datarates[TEST_MAX_REQUESTS];
+static uint32_t u32_dc_violations;
+static uint32_t u32_dev_nonce_errors;
+
+// Stubs -----------------------------------------------------------------------
+// Only RegionCommonRxBeaconSetup uses the radio, it is not called
+const struct Radio_s Radio;
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return now;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return now - past;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  node->timer_due = TEST_NEVER;
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  node->timer_due = now + node->u32_timer_period;
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  node->timer_due = TEST_NEVER;
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  node->u32_timer_period = NewPeriodValue;
+  return UTIL_TIMER_OK;
+}
+
+void UTIL_SEQ_RegTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Flags, void ( *Task )( void ) )
+{
+  join_task = Task;
+}
+
+void UTIL_SEQ_SetTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Task_Prio )
+{
+  b_join_task_set = true;
+}
+
+uint32_t flash_user_func_get_dev_nonce( void )
+{
+  return node->u32_eeprom_dev_nonce;
+}
+
+EE_Status flash_user_func_set_dev_nonce( uint32_t u32_dev_nonce )
+{
+  node->u32_eeprom_dev_nonce = u32_dev_nonce;
+  node->u32_eeprom_writes++;
+  return EE_OK;
+}
+
+int32_t LmHandlerGetDevNonce( uint16_t *devNonce )
+{
+  *devNonce = node->u16_dev_nonce;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+int32_t LmHandlerSetDevNonce( uint16_t devNonce )
+{
+  node->u16_dev_nonce = devNonce;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerFlagStatus_t LmHandlerJoinStatus( void )
+{
+  return node->b_joined ? LORAMAC_HANDLER_SET : LORAMAC_HANDLER_RESET;
+}
+
+LoRaMacStatus_t LoRaMacQueryNextTxTime( uint8_t size, TimerTime_t *waitTime )
+{
+  *waitTime = 0;
+  if( node->b_busy )
+  {
+    return LORAMAC_STATUS_BUSY;
+  }
+  if( ( int32_t ) ( node->next_tx - now ) > 0 )
+  {
+    *waitTime = node->next_tx - now;
+    return LORAMAC_STATUS_DUTYCYCLE_RESTRICTED;
+  }
+  return LORAMAC_STATUS_OK;
+}
+
+static void test_uplink_start( int8_t i8_datarate, uint8_t u8_size );
+
+LmHandlerErrorStatus_t LmHandlerJoinAtDatarate( ActivationType_t mode, int8_t datarate )
+{
+  if( node->b_busy )
+  {
+    return LORAMAC_HANDLER_BUSY_ERROR;
+  }
+  u32_dc_violations += ( ( int32_t ) ( node->next_tx - now ) > 0 );
+
+  // The MAC increments the DevNonce before the request
+  node->u16_dev_nonce++;
+  u32_dev_nonce_errors += ( node->u16_dev_nonce <= node->i32_last_dev_nonce );
+  u32_dev_nonce_errors += ( node->u16_dev_nonce > node->u32_eeprom_dev_nonce );
+  node->i32_last_dev_nonce = node->u16_dev_nonce;
+
+  if( ( node == &test_nodes[0] ) && ( node->u32_requests < TEST_MAX_REQUESTS ) )
+  {
+    request_times[node->u32_requests] = now;
+    request_datarates[node->u32_requests] = datarate;
+  }
+  node->u32_requests++;
+  node->b_join_request = true;
+  test_uplink_start( datarate, TEST_JOIN_REQ_SIZE );
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+// Functions -------------------------------------------------------------------
+// LoRa time-on-air at 125 kHz, coding rate 4/5, 8 preamble symbols, explicit header [ms]
+static uint32_t test_time_on_air( int8_t i8_datarate, uint8_t u8_size, bool b_crc )
+{
+  int32_t sf = 12 - i8_datarate;
+  int32_t de = ( sf >= 11 ) ? 1 : 0;
+  int32_t bits = ( 8 * u8_size ) - ( 4 * sf ) + 28 + ( b_crc ? 16 : 0 );
+  int32_t symbols = 8 + MAX( ( ( bits + ( 4 * ( sf - 2 * de ) ) - 1 ) / ( 4 * ( sf - 2 * de ) ) ) * 5, 0 );
+
+  // ( 8 + 4.25 + symbols ) symbols of 2^sf / 125 ms
+  return ( uint32_t ) ( ( ( 49 + ( 4 * symbols ) ) << sf ) / 500 );
+}
+
+static void node_enter( test_node_t *n )
+{
+  node = n;
+  join_timer            = n->sched.join_timer;
+  join_stats            = n->sched.join_stats;
+  join_activation_type  = n->sched.join_activation_type;
+  b_running             = n->sched.b_running;
+  b_request_pending     = n->sched.b_request_pending;
+  u8_failures           = n->sched.u8_failures;
+  i8_datarate           = n->sched.i8_datarate;
+  u32_dev_nonce_bound   = n->sched.u32_dev_nonce_bound;
+  start_time            = n->sched.start_time;
+}
+
+static void node_leave( void )
+{
+  node->sched.join_timer            = join_timer;
+  node->sched.join_stats            = join_stats;
+  node->sched.join_activation_type  = join_activation_type;
+  node->sched.b_running             = b_running;
+  node->sched.b_request_pending     = b_request_pending;
+  node->sched.u8_failures           = u8_failures;
+  node->sched.i8_datarate           = i8_datarate;
+  node->sched.u32_dev_nonce_bound   = u32_dev_nonce_bound;
+  node->sched.start_time            = start_time;
+}
+
+static void test_uplink_start( int8_t i8_datarate, uint8_t u8_size )
+{
+  test_uplink_t *uplink = &test_uplinks[u16_uplinks];
+  uint32_t u32_time_on_air = test_time_on_air( i8_datarate, u8_size, true );
+  SysTime_t elapsed = { .Seconds = ( now - node->boot_time ) / 1000 };
+
+  uplink->start       = now;
+  uplink->end         = now + u32_time_on_air;
+  uplink->channel     = test_rand() % TEST_JOIN_CHANNELS;
+  uplink->datarate    = i8_datarate;
+  uplink->b_collided  = false;
+
+  // The uplinks on air for the same channel and datarate, the longest one lasts below 2 s
+  for( uint16_t i = 0; i < TEST_MAX_UPLINKS; i++ )
+  {
+    test_uplink_t *other = &test_uplinks[i];
+
+    if( ( i != u16_uplinks ) && ( other->end > now ) && ( other->start <= now ) &&
+        ( other->channel == uplink->channel ) && ( other->datarate == uplink->datarate ) )
+    {
+      other->b_collided = true;
+      uplink->b_collided = true;
+    }
+  }
+
+  if( u8_size == TEST_JOIN_REQ_SIZE )
+  {
+    node->next_tx = now + ( u32_time_on_air * RegionCommonGetJoinDc( elapsed ) );
+    node->u32_join_air_time += u32_time_on_air;
+  }
+  else
+  {
+    node->next_tx = now + ( u32_time_on_air * TEST_DATA_DUTY_CYCLE );
+  }
+  node->u16_uplink  = u16_uplinks;
+  node->i8_datarate = i8_datarate;
+  node->b_busy      = true;
+  node->tx_end_due  = uplink->end;
+  u16_uplinks       = ( u16_uplinks + 1 ) % TEST_MAX_UPLINKS;
+}
+
+static bool test_gateway_is_free( UTIL_TIMER_Time_t start, UTIL_TIMER_Time_t end )
+{
+  for( uint16_t i = 0; i < TEST_MAX_DOWNLINKS; i++ )
+  {
+    if( ( test_downlinks[i].start < end ) && ( test_downlinks[i].end > start ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_gateway_send( UTIL_TIMER_Time_t start, UTIL_TIMER_Time_t end )
+{
+  test_downlinks[u16_downlinks].start = start;
+  test_downlinks[u16_downlinks].end   = end;
+  u16_downlinks = ( u16_downlinks + 1 ) % TEST_MAX_DOWNLINKS;
+}
+
+// End of an uplink: the gateway answers a join request in RX1, else in RX2
+static void test_on_tx_end( void )
+{
+  test_uplink_t *uplink = &test_uplinks[node->u16_uplink];
+  bool b_received = ( uplink->datarate <= node->i8_max_datarate ) && !uplink->b_collided &&
+                    test_gateway_is_free( uplink->start, uplink->end );
+  UTIL_TIMER_Time_t rx1 = uplink->end + TEST_JOIN_ACCEPT_DELAY1;
+  UTIL_TIMER_Time_t rx2 = uplink->end + TEST_JOIN_ACCEPT_DELAY2;
+  uint32_t u32_rx1_time = test_time_on_air( uplink->datarate, TEST_JOIN_ACCEPT_SIZE, false );
+  uint32_t u32_rx2_time = test_time_on_air( DR_0, TEST_JOIN_ACCEPT_SIZE, false );
+
+  node->tx_end_due = TEST_NEVER;
+  if( !node->b_join_request )
+  {
+    node->b_busy = false;
+    return;
+  }
+
+  node->b_accepted  = false;
+  node->result_due  = rx2 + TEST_RX2_TIMEOUT;
+  if( b_received && ( rx1 >= gw_rx1_next ) && test_gateway_is_free( rx1, rx1 + u32_rx1_time ) )
+  {
+    test_gateway_send( rx1, rx1 + u32_rx1_time );
+    gw_rx1_next       = rx1 + ( u32_rx1_time * TEST_GW_RX1_DUTY_CYCLE );
+    node->b_accepted  = true;
+    node->result_due  = rx1 + u32_rx1_time;
+  }
+  else if( b_received && ( rx2 >= gw_rx2_next ) && test_gateway_is_free( rx2, rx2 + u32_rx2_time ) )
+  {
+    test_gateway_send( rx2, rx2 + u32_rx2_time );
+    gw_rx2_next       = rx2 + ( u32_rx2_time * TEST_GW_RX2_DUTY_CYCLE );
+    node->b_accepted  = true;
+    node->result_due  = rx2 + u32_rx2_time;
+  }
+}
+
+static void test_on_result( void )
+{
+  LmHandlerJoinParams_t params = { .Mode = ACTIVATION_TYPE_OTAA, .Datarate = node->i8_datarate };
+
+  node->result_due      = TEST_NEVER;
+  node->b_busy          = false;
+  node->b_join_request  = false;
+  params.Status         = node->b_accepted ? LORAMAC_HANDLER_SUCCESS : LORAMAC_HANDLER_ERROR;
+  if( node->b_accepted )
+  {
+    node->b_joined  = true;
+    node->join_time = now - node->boot_time;
+    node->data_due  = now + ( test_rand() % TEST_DATA_PERIOD );
+  }
+  base_join_sched_on_join_request( &params );
+}
+
+static void test_on_data( void )
+{
+  if( node->b_busy || ( ( int32_t ) ( node->next_tx - now ) > 0 ) )
+  {
+    node->data_due = node->b_busy ? ( now + TEST_DATA_PERIOD ) : node->next_tx;
+    return;
+  }
+  node->data_due = now + TEST_DATA_PERIOD;
+  test_uplink_start( node->i8_datarate, TEST_DATA_SIZE );
+}
+
+static void test_on_timer( void )
+{
+  node->timer_due = TEST_NEVER;
+  base_join_sched_on_timer( NULL );
+  if( b_join_task_set )
+  {
+    b_join_task_set = false;
+    join_task();
+  }
+}
+
+// Power up: the MAC starts with the DevNonce of the EEPROM, the scheduler starts
+static void test_on_boot( void )
+{
+  node->boot_due    = TEST_NEVER;
+  node->boot_time   = now;
+  node->next_tx     = now;
+  node->b_busy      = false;
+  node->b_joined    = false;
+  node->tx_end_due  = TEST_NEVER;
+  node->result_due  = TEST_NEVER;
+  node->data_due    = TEST_NEVER;
+  base_join_sched_init( ACTIVATION_TYPE_OTAA );
+  base_join_sched_start();
+}
+
+static void test_nodes_init( uint16_t u16_count )
+{
+  memset( test_nodes, 0, sizeof( test_nodes ) );
+  memset( test_uplinks, 0, sizeof( test_uplinks ) );
+  memset( test_downlinks, 0, sizeof( test_downlinks ) );
+  u16_nb_nodes    = u16_count;
+  u16_uplinks     = 0;
+  u16_downlinks   = 0;
+  gw_rx1_next     = 0;
+  gw_rx2_next     = 0;
+  now             = 1000;
+  for( uint16_t i = 0; i < u16_count; i++ )
+  {
+    test_nodes[i].boot_due            = now + ( test_rand() % TEST_BOOT_SPREAD );
+    test_nodes[i].timer_due           = TEST_NEVER;
+    test_nodes[i].tx_end_due          = TEST_NEVER;
+    test_nodes[i].result_due          = TEST_NEVER;
+    test_nodes[i].data_due            = TEST_NEVER;
+    test_nodes[i].i8_max_datarate     = test_rand() % ( DR_5 + 1 );
+    test_nodes[i].i32_last_dev_nonce  = -1;
+  }
+}
+
+/**
+  * @brief  Runs the events of the nodes in time order.
+  * @param[in] end Time of the end of the simulation.
+  * @param[in] reboot_period Mean time between two reboots of the first node, 0: never.
+  */
+static void test_run( UTIL_TIMER_Time_t end, uint32_t reboot_period )
+{
+  UTIL_TIMER_Time_t reboot_due = ( reboot_period > 0 ) ? ( now + 1 + test_rand() % ( 2 * reboot_period ) ) : TEST_NEVER;
+
+  while( true )
+  {
+    UTIL_TIMER_Time_t next = end;
+    test_node_t *n = NULL;
+
+    for( uint16_t i = 0; i < u16_nb_nodes; i++ )
+    {
+      test_node_t *candidate = &test_nodes[i];
+      UTIL_TIMER_Time_t due = MIN( MIN( candidate->boot_due, candidate->timer_due ),
+                                   MIN( MIN( candidate->tx_end_due, candidate->result_due ), candidate->data_due ) );
+
+      if( due < next )
+      {
+        next = due;
+        n = candidate;
+      }
+    }
+    if( reboot_due < next )
+    {
+      // Power loss, the RAM and the timers are lost
+      now = reboot_due;
+      reboot_due = now + 1 + test_rand() % ( 2 * reboot_period );
+      test_nodes[0].boot_due = now;
+      test_nodes[0].timer_due = TEST_NEVER;
+      test_nodes[0].u16_dev_nonce = 0;
+      continue;
+    }
+    if( n == NULL )
+    {
+      break;
+    }
+
+    now = next;
+    node_enter( n );
+    if( n->boot_due == now )
+    {
+      test_on_boot();
+    }
+    else if( n->tx_end_due == now )
+    {
+      test_on_tx_end();
+    }
+    else if( n->result_due == now )
+    {
+      test_on_result();
+    }
+    else if( n->timer_due == now )
+    {
+      test_on_timer();
+    }
+    else
+    {
+      test_on_data();
+    }
+    node_leave();
+  }
+  now = end;
+}
+
+// One node out of range: back-off, datarate cycle and duty cycle
+static void test_backoff( void )
+{
+  test_node_t *n = &test_nodes[0];
+  base_join_sched_stats_t stats;
+  uint32_t u32_backoff = 0;
+  uint32_t u32_requests = 0;
+
+  test_nodes_init( 1 );
+  n->i8_max_datarate = -1;
+  u32_dc_violations = 0;
+  u32_dev_nonce_errors = 0;
+  test_run( TEST_BACKOFF_DURATION, 0 );
+  stats = n->sched.join_stats;
+  u32_requests = MIN( n->u32_requests, TEST_MAX_REQUESTS );
+
+  printf( "  out of range: %u requests in %lu h, %u postponed by the duty cycle, %u EEPROM writes\n",
+          n->u32_requests, TEST_BACKOFF_DURATION / 3600000, stats.u32_dc_deferred, n->u32_eeprom_writes );
+  CHECK( stats.u32_requests == n->u32_requests );
+  CHECK( stats.u32_joins == 0 );
+  CHECK( stats.u32_dc_deferred > 0 );
+  CHECK( u32_dc_violations == 0 );
+  CHECK( u32_dev_nonce_errors == 0 );
+  CHECK( n->u32_eeprom_writes == DIVC( n->u32_requests, BASE_JOIN_DEV_NONCE_BLOCK ) );
+  CHECK( ( request_times[0] - n->boot_time ) <= BASE_JOIN_START_DELAY_MAX );
+
+  for( uint32_t i = 0; i < u32_requests; i++ )
+  {
+    CHECK( request_datarates[i] == ( BASE_JOIN_DR_FIRST - ( int8_t ) ( i % ( BASE_JOIN_DR_FIRST - BASE_JOIN_DR_LAST + 1 ) ) ) );
+    if( i > 0 )
+    {
+      // The failure is reported when RX2 closes, the time-off starts with the request
+      UTIL_TIMER_Time_t failure = request_times[i - 1] +
+                                  test_time_on_air( request_datarates[i - 1], TEST_JOIN_REQ_SIZE, true ) +
+                                  TEST_JOIN_ACCEPT_DELAY2 + TEST_RX2_TIMEOUT;
+      SysTime_t elapsed = { .Seconds = ( request_times[i - 1] - n->boot_time ) / 1000 };
+      UTIL_TIMER_Time_t time_off = request_times[i - 1] +
+                                   test_time_on_air( request_datarates[i - 1], TEST_JOIN_REQ_SIZE, true ) *
+                                   RegionCommonGetJoinDc( elapsed );
+      UTIL_TIMER_Time_t latest = 0;
+
+      // Doubles per failed request of the datarate cycle only
+      u32_backoff = MIN( ( uint64_t ) BASE_JOIN_BACKOFF_MIN << ( BASE_JOIN_DR_FIRST - request_datarates[i - 1] ),
+                         BASE_JOIN_BACKOFF_MAX );
+      latest = MAX( failure + ( 3 * u32_backoff / 2 ), time_off + BASE_JOIN_DC_JITTER_MAX );
+
+      CHECK( request_times[i] >= ( failure + ( u32_backoff / 2 ) ) );
+      CHECK( request_times[i] >= time_off );
+      CHECK( request_times[i] <= latest );
+    }
+  }
+}
+
+// Reboots of a node out of range, the DevNonces are never sent twice
+static void test_reboots( void )
+{
+  test_node_t *n = &test_nodes[0];
+
+  test_nodes_init( 1 );
+  n->i8_max_datarate = -1;
+  u32_dc_violations = 0;
+  u32_dev_nonce_errors = 0;
+  test_run( TEST_REBOOTS * 1800000UL, 900000 );
+
+  printf( "  reboots every 15 min: %u requests, %u EEPROM writes\n", n->u32_requests, n->u32_eeprom_writes );
+  CHECK( n->u32_requests > TEST_REBOOTS );
+  CHECK( u32_dev_nonce_errors == 0 );
+}
+
+static int compare_times( const void *a, const void *b )
+{
+  UTIL_TIMER_Time_t time_a = *( const UTIL_TIMER_Time_t * ) a;
+  UTIL_TIMER_Time_t time_b = *( const UTIL_TIMER_Time_t * ) b;
+
+  return ( time_a > time_b ) - ( time_a < time_b );
+}
+
+// N nodes powered up together, e.g. after a power outage
+static void test_nodes_join( const test_join_bound_t *bound )
+{
+  static UTIL_TIMER_Time_t join_times[TEST_MAX_NODES];
+  uint16_t u16_count = bound->u16_count;
+  uint32_t u32_joined = 0;
+  uint32_t u32_median = 0;
+  uint32_t u32_p90 = 0;
+  uint64_t u64_air_time = 0;
+
+  test_nodes_init( u16_count );
+  u32_dc_violations = 0;
+  u32_dev_nonce_errors = 0;
+  test_run( TEST_DURATION, 0 );
+
+  for( uint16_t i = 0; i < u16_count; i++ )
+  {
+    u64_air_time += test_nodes[i].u32_join_air_time;
+    if( test_nodes[i].b_joined )
+    {
+      join_times[u32_joined++] = test_nodes[i].join_time;
+      CHECK( test_nodes[i].sched.join_stats.u32_time_to_join <= test_nodes[i].join_time );
+      CHECK( test_nodes[i].sched.join_stats.i8_join_datarate <= test_nodes[i].i8_max_datarate );
+      CHECK( test_nodes[i].sched.b_running == false );
+    }
+  }
+  qsort( join_times, u32_joined, sizeof( join_times[0] ), compare_times );
+  if( u32_joined > 0 )
+  {
+    u32_median = join_times[u32_joined / 2] / 1000;
+    u32_p90 = join_times[( u32_joined * 9 ) / 10] / 1000;
+  }
+
+  printf( "  N=%3u: %5.1f %% joined in %lu h, time to join median %4u s, p90 %5u s, join air time %.1f s per node\n",
+          u16_count, 100.0 * u32_joined / u16_count, TEST_DURATION / 3600000, u32_median, u32_p90,
+          u64_air_time / 1000.0 / u16_count );
+  CHECK( u32_joined == u16_count );
+  CHECK( u32_median <= bound->u32_median_max );
+  CHECK( u32_p90 <= bound->u32_p90_max );
+  CHECK( u32_dc_violations == 0 );
+  CHECK( u32_dev_nonce_errors == 0 );
+}
+
+int main( void )
+{
+  srand1( 1 );
+  test_backoff();
+  test_reboots();
+  for( uint8_t i = 0; i < ( sizeof( test_join_bounds ) / sizeof( test_join_bounds[0] ) ); i++ )
+  {
+    test_nodes_join( &test_join_bounds[i] );
+  }
+
+  return TEST_END();
+}
@@ -0,0 +1,243 @@
+/**
+* @file test_base_tx_power.c
+* @brief Fading link simulation of the TX power control (base_tx_power.c).
+*
+* base_tx_power.c is included and fed in the order of LoRaMacProcess():
+* OnTxData, OnLinkCheck, OnRxData. The region limits come from RegionEU868.c.
+* The uplink margin is the link margin at full power (test_margins), minus the
+* EIRP step of the level in use, plus a slow shadowing (TEST_SHADOWING_SIGMA,
+* same in both directions) and a fast fading per frame (TEST_FADING_SIGMA).
+* The gateway answers the link checks of the uplinks it receives and sends a
+* downlink on TEST_DOWNLINK_PERCENT of them. For each margin, 20000
+* unconfirmed uplinks of 400 ms are sent at the level commanded by the network
+* (TX_POWER_0, then TEST_ADR_POWER from TEST_ADR_UPLINK on) and with the controller:
+* - the controller draws less charge per uplink delivered
+* - it delivers at most TEST_MAX_LOSS_INCREASE fewer uplinks
+* - every level it sets is valid in EU868, never above the level last
+*   commanded by the network (LinkADRReq at TEST_ADR_UPLINK)
+* - base_tx_power_get_charge_per_uplink() only counts the losses it knows,
+*   it is never above the charge per uplink really delivered
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <math.h>
+#include "test.h"
+#include "radio.h"
+#include "base_tx_power.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_UPLINKS                                20000
+#define TEST_TIME_ON_AIR                            400
+#define TEST_SHADOWING_SIGMA                        4.0                               // [dB]
+#define TEST_SHADOWING_CORRELATION                  0.98                              // From one uplink to the next
+#define TEST_FADING_SIGMA                           2.0                               // [dB]
+#define TEST_DOWNLINK_PERCENT                       5
+#define TEST_NOISE_FLOOR                            ( -120 )                          // [dBm]
+#define TEST_DEMOD_FLOOR                            ( -137 )                          // Downlink level at a null margin [dBm]
+#define TEST_MAX_LOSS_INCREASE                      0.005
+#define TEST_ADR_UPLINK                             ( TEST_UPLINKS / 2 )
+#define TEST_ADR_POWER                              TX_POWER_3
+
+typedef struct
+{
+  uint32_t u32_delivered;
+  uint32_t u32_levels[8];
+  uint64_t u64_charge;
+  uint32_t u32_charge_reported;
+} test_result_t;
+
+// Variables -------------------------------------------------------------------
+static const int8_t test_margins[] = { 15, 25, 35 };
+
+static int8_t i8_radio_power              = TX_POWER_0;
+static int8_t i8_network_power            = TX_POWER_0;
+static bool b_link_check_requested        = false;
+static bool b_power_valid                 = true;
+static double shadowing                   = 0.0;
+
+// Stubs -----------------------------------------------------------------------
+int32_t LmHandlerGetActiveRegion( LoRaMacRegion_t *region )
+{
+  *region = LORAMAC_REGION_EU868;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+int32_t LmHandlerGetTxPower( int8_t *txPower )
+{
+  *txPower = i8_radio_power;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+// The MAC checks the level as MIB_CHANNELS_TX_POWER does
+int32_t LmHandlerSetTxPower( int8_t txPower )
+{
+  VerifyParams_t verify = { .TxPower = txPower };
+
+  if( !RegionVerify( LORAMAC_REGION_EU868, &verify, PHY_TX_POWER ) )
+  {
+    b_power_valid = false;
+    return LORAMAC_HANDLER_ERROR;
+  }
+  b_power_valid &= ( txPower >= i8_network_power );
+  i8_radio_power = txPower;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+LmHandlerErrorStatus_t LmHandlerLinkCheckReq( void )
+{
+  b_link_check_requested = true;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+// Only RegionCommonRxBeaconSetup uses the radio, it is not called
+const struct Radio_s Radio;
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return 0;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return 0 - past;
+}
+
+// Functions -------------------------------------------------------------------
+// Normal random number, Box-Muller
+static double test_normal( void )
+{
+  double u1 = ( ( test_rand() >> 8 ) + 1.0 ) / 16777217.0;
+  double u2 = ( test_rand() >> 8 ) / 16777216.0;
+
+  return sqrt( -2.0 * log( u1 ) ) * cos( 2.0 * M_PI * u2 );
+}
+
+// Margin of a frame above the demodulation floor [dB], the level costs BASE_TX_POWER_STEP per index
+static double test_frame_margin( int8_t i8_margin, int8_t i8_power )
+{
+  return i8_margin - ( BASE_TX_POWER_STEP * i8_power ) + shadowing + ( TEST_FADING_SIGMA * test_normal() );
+}
+
+static void test_downlink( int8_t i8_margin )
+{
+  LmHandlerRxParams_t rx_params = { .IsMcpsIndication = 1, .Status = LORAMAC_EVENT_INFO_STATUS_OK, .RxSlot = RX_SLOT_WIN_1 };
+  double level = TEST_DEMOD_FLOOR + test_frame_margin( i8_margin, TX_POWER_0 );
+
+  rx_params.Rssi  = ( int16_t ) MAX( level, TEST_NOISE_FLOOR );
+  rx_params.Snr   = ( int8_t ) MIN( level - TEST_NOISE_FLOOR, 10 );
+  base_tx_power_on_rx_data( &rx_params );
+}
+
+/**
+  * @brief  Sends TEST_UPLINKS unconfirmed uplinks over the fading link.
+  * @param[in] i8_margin Link margin at TX_POWER_0 [dB].
+  * @param[in] b_control false: the level of the network only, the controller keeps the statistics.
+  */
+static test_result_t test_link( int8_t i8_margin, bool b_control )
+{
+  test_result_t result = { 0 };
+  base_tx_power_stats_t stats;
+
+  test_rand_state = 1;
+  shadowing = 0.0;
+  i8_radio_power = TX_POWER_0;
+  i8_network_power = TX_POWER_0;
+  b_link_check_requested = false;
+  memset( &tx_power_stats, 0, sizeof( tx_power_stats ) );
+  base_tx_power_init();
+
+  for( uint32_t i = 0; i < TEST_UPLINKS; i++ )
+  {
+    LmHandlerTxParams_t tx_params = { .IsMcpsConfirm = 1, .Status = LORAMAC_EVENT_INFO_STATUS_OK,
+                                      .MsgType = LORAMAC_HANDLER_UNCONFIRMED_MSG, .NbRetries = 1,
+                                      .TxTimeOnAir = TEST_TIME_ON_AIR };
+    LmHandlerLinkCheckParams_t link_check = { .Status = LORAMAC_EVENT_INFO_STATUS_RX2_TIMEOUT };
+    bool b_link_check = false;
+    bool b_delivered = false;
+    double margin;
+
+    // LinkADRReq: the network lowers the highest power allowed
+    if( i == TEST_ADR_UPLINK )
+    {
+      i8_network_power = TEST_ADR_POWER;
+      i8_radio_power = TEST_ADR_POWER;
+    }
+
+    shadowing = ( TEST_SHADOWING_CORRELATION * shadowing ) +
+                ( sqrt( 1.0 - TEST_SHADOWING_CORRELATION * TEST_SHADOWING_CORRELATION ) * TEST_SHADOWING_SIGMA * test_normal() );
+    if( b_control )
+    {
+      base_tx_power_on_tx_request();
+    }
+    b_link_check = b_link_check_requested;
+    b_link_check_requested = false;
+
+    margin = test_frame_margin( i8_margin, i8_radio_power );
+    b_delivered = ( margin >= 0.0 );
+    result.u32_delivered += b_delivered;
+    result.u32_levels[i8_radio_power]++;
+
+    tx_params.TxPower = i8_radio_power;
+    base_tx_power_on_tx_done( &tx_params );
+    if( b_link_check )
+    {
+      if( b_delivered )
+      {
+        link_check.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+        link_check.DemodMargin = ( uint8_t ) MIN( margin, 254.0 );
+        link_check.NbGateways = 1;
+      }
+      base_tx_power_on_link_check( &link_check );
+    }
+    if( b_delivered && ( b_link_check || ( ( test_rand() % 100 ) < TEST_DOWNLINK_PERCENT ) ) )
+    {
+      test_downlink( i8_margin );
+    }
+  }
+
+  base_tx_power_get_stats( &stats );
+  CHECK( stats.u32_uplinks == TEST_UPLINKS );
+  CHECK( stats.u32_lost <= ( TEST_UPLINKS - result.u32_delivered ) );
+  result.u64_charge = stats.u64_charge;
+  result.u32_charge_reported = base_tx_power_get_charge_per_uplink();
+
+  return result;
+}
+
+static void test_margin( int8_t i8_margin )
+{
+  test_result_t fixed = test_link( i8_margin, false );
+  test_result_t control;
+  double fixed_charge = ( double ) fixed.u64_charge / fixed.u32_delivered;
+  double control_charge;
+
+  b_power_valid = true;
+  control = test_link( i8_margin, true );
+  control_charge = ( double ) control.u64_charge / control.u32_delivered;
+
+  printf( "  %d dB: %5.0f -> %5.0f uC per uplink delivered, %6.2f%% -> %6.2f%% delivered, levels", i8_margin,
+          fixed_charge, control_charge, 100.0 * fixed.u32_delivered / TEST_UPLINKS,
+          100.0 * control.u32_delivered / TEST_UPLINKS );
+  for( uint8_t i = 0; i < 8; i++ )
+  {
+    printf( " %u", control.u32_levels[i] );
+  }
+  printf( "\n" );
+
+  CHECK( control_charge < fixed_charge );
+  CHECK( control.u32_delivered >= ( fixed.u32_delivered - ( uint32_t ) ( TEST_MAX_LOSS_INCREASE * TEST_UPLINKS ) ) );
+  CHECK( b_power_valid );
+  CHECK( control.u32_charge_reported <= control_charge );
+  CHECK( fixed.u32_charge_reported <= fixed_charge );
+}
+
+int main( void )
+{
+  for( uint8_t i = 0; i < sizeof( test_margins ); i++ )
+  {
+    test_margin( test_margins[i] );
+  }
+
+  return TEST_END();
+}
@@ -0,0 +1,243 @@
+/**
+* @file test_base_tx_queue.c
+* @brief Tests of the queue of pending uplinks (base_tx_queue.c).
+*
+* base_tx_queue.c is included. Checks:
+* - cyclic reports (timer, app cycle, timeout, backfill) of the same reason
+*   and message type are coalesced into one entry, the count saturates at
+*   UINT8_MAX, events and confirmed uplinks are never coalesced
+* - base_tx_queue_peek() returns the oldest event or confirmed uplink, else
+*   the oldest cyclic report, base_tx_queue_pop() removes that entry only and
+*   keeps the requests pushed in the meantime
+* - a full queue: a cyclic report of a pending type is still coalesced, an
+*   event replaces the oldest cyclic report, any other request is dropped
+* - random requests and uplinks: the queue never holds more than
+*   BASE_TX_QUEUE_SIZE entries, the statistics account for every request
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+
+// base.h needs the device headers, the queue only uses its TX reasons
+#define __BASE_H__
+
+typedef enum
+{
+  TX_REASON_TIMER_EVENT = 0,
+  TX_REASON_USER_BUTTON_EVENT,
+  TX_REASON_INPUT_EVENT,
+  TX_REASON_FUOTA_EVENT,
+  TX_REASON_APP_CYCLE_EVENT,
+  TX_REASON_TIMEOUT_EVENT,
+  TX_REASON_BACKFILL_EVENT,
+
+  TX_REASON_UNDEFINED_EVENT = 0xFF
+} base_tx_reason_t;
+
+#include "base_tx_queue.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_RANDOM_STEPS                           100000
+
+// Variables -------------------------------------------------------------------
+static const base_tx_reason_t test_reasons[] = { TX_REASON_TIMER_EVENT, TX_REASON_USER_BUTTON_EVENT, TX_REASON_INPUT_EVENT,
+                                                 TX_REASON_FUOTA_EVENT, TX_REASON_APP_CYCLE_EVENT, TX_REASON_TIMEOUT_EVENT,
+                                                 TX_REASON_BACKFILL_EVENT };
+
+// Functions -------------------------------------------------------------------
+static bool is_cyclic( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type )
+{
+  return ( msg_type == LORAMAC_HANDLER_UNCONFIRMED_MSG ) &&
+         ( ( tx_reason == TX_REASON_TIMER_EVENT ) || ( tx_reason == TX_REASON_APP_CYCLE_EVENT ) ||
+           ( tx_reason == TX_REASON_TIMEOUT_EVENT ) || ( tx_reason == TX_REASON_BACKFILL_EVENT ) );
+}
+
+// Peeks and pops the next uplink, checks its reason and message type
+static base_tx_queue_entry_t check_next( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type )
+{
+  base_tx_queue_entry_t entry = { 0 };
+
+  CHECK( base_tx_queue_peek( &entry ) );
+  CHECK( entry.tx_reason == tx_reason );
+  CHECK( entry.msg_type == msg_type );
+  base_tx_queue_pop( &entry, true );
+
+  return entry;
+}
+
+static void test_coalescing( void )
+{
+  base_tx_queue_entry_t entry;
+  base_tx_queue_stats_t stats;
+
+  base_tx_queue_init();
+  CHECK( base_tx_queue_is_empty() );
+  CHECK( !base_tx_queue_peek( &entry ) );
+
+  // Cyclic reports of the same reason: one entry
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == 1 );
+
+  // Another reason, a confirmed report and events get their own entries
+  CHECK( base_tx_queue_push( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == 2 );
+  base_tx_queue_get_stats( &stats );
+  CHECK( ( stats.u32_queued == 2 ) && ( stats.u32_coalesced == 2 ) && ( stats.u32_dropped == 0 ) );
+
+  entry = check_next( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  CHECK( entry.u8_coalesced == 2 );
+  entry = check_next( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  CHECK( entry.u8_coalesced == 0 );
+
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == 4 );
+  while( !base_tx_queue_is_empty() )
+  {
+    CHECK( base_tx_queue_peek( &entry ) );
+    CHECK( entry.u8_coalesced == 0 );
+    base_tx_queue_pop( &entry, true );
+  }
+
+  // The count of a long pending report saturates
+  for( uint16_t i = 0; i < 300; i++ )
+  {
+    CHECK( base_tx_queue_push( TX_REASON_BACKFILL_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  }
+  entry = check_next( TX_REASON_BACKFILL_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  CHECK( entry.u8_coalesced == UINT8_MAX );
+  base_tx_queue_get_stats( &stats );
+  CHECK( ( stats.u32_coalesced == ( 2 + 299 ) ) && ( stats.u32_sent == 7 ) );
+}
+
+static void test_priority( void )
+{
+  base_tx_queue_entry_t entry;
+
+  base_tx_queue_init();
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_INPUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMEOUT_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG ) );
+
+  // Events and confirmed uplinks in order of arrival, then the cyclic reports
+  check_next( TX_REASON_INPUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+
+  // An event pushed while the head is sent goes ahead of the cyclic reports
+  CHECK( base_tx_queue_peek( &entry ) );
+  CHECK( base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  base_tx_queue_pop( &entry, true );
+  CHECK( entry.tx_reason == TX_REASON_TIMEOUT_EVENT );
+  CHECK( base_tx_queue_get_count() == 3 );
+
+  check_next( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  check_next( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  check_next( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  CHECK( base_tx_queue_is_empty() );
+
+  // An entry given up counts as dropped
+  CHECK( base_tx_queue_push( TX_REASON_FUOTA_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_peek( &entry ) );
+  base_tx_queue_pop( &entry, false );
+  CHECK( base_tx_queue_is_empty() );
+  CHECK( tx_queue_stats.u32_dropped == 1 );
+  CHECK( tx_queue_stats.u32_sent == 5 );
+}
+
+static void test_full( void )
+{
+  base_tx_queue_stats_t stats;
+
+  // Full of cyclic reports
+  base_tx_queue_init();
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMEOUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_BACKFILL_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == BASE_TX_QUEUE_SIZE );
+
+  // A pending type is still coalesced
+  CHECK( base_tx_queue_push( TX_REASON_TIMEOUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == BASE_TX_QUEUE_SIZE );
+
+  // Events replace the oldest cyclic reports
+  CHECK( base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG ) );
+  CHECK( base_tx_queue_get_count() == BASE_TX_QUEUE_SIZE );
+  base_tx_queue_get_stats( &stats );
+  CHECK( ( stats.u32_queued == 6 ) && ( stats.u32_coalesced == 1 ) && ( stats.u32_dropped == 2 ) );
+
+  // A new cyclic type is dropped
+  CHECK( !base_tx_queue_push( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+
+  // Full of events: one more is dropped too
+  CHECK( base_tx_queue_push( TX_REASON_INPUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( base_tx_queue_push( TX_REASON_FUOTA_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( !base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  CHECK( !base_tx_queue_push( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG ) );
+  base_tx_queue_get_stats( &stats );
+  CHECK( ( stats.u32_queued == 8 ) && ( stats.u32_dropped == 7 ) );
+
+  check_next( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  check_next( TX_REASON_TIMER_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG );
+  check_next( TX_REASON_INPUT_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  check_next( TX_REASON_FUOTA_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  CHECK( base_tx_queue_is_empty() );
+}
+
+static void test_random( void )
+{
+  base_tx_queue_stats_t stats;
+  uint32_t u32_requests = 0;
+  uint32_t u32_rejected = 0;
+
+  base_tx_queue_init();
+  test_rand_state = 1;
+  for( uint32_t step = 0; step < TEST_RANDOM_STEPS; step++ )
+  {
+    base_tx_queue_entry_t entry;
+
+    if( ( test_rand() % 3 ) != 0 )
+    {
+      base_tx_reason_t tx_reason = test_reasons[test_rand() % ( sizeof( test_reasons ) / sizeof( test_reasons[0] ) )];
+      LmHandlerMsgTypes_t msg_type = ( ( test_rand() % 4 ) == 0 ) ? LORAMAC_HANDLER_CONFIRMED_MSG : LORAMAC_HANDLER_UNCONFIRMED_MSG;
+
+      u32_requests++;
+      u32_rejected += !base_tx_queue_push( tx_reason, msg_type );
+    }
+    else if( base_tx_queue_peek( &entry ) )
+    {
+      // The head is an event or a confirmed uplink whenever one is pending
+      bool b_event_pending = false;
+
+      for( uint8_t i = 0; i < u8_tx_queue_count; i++ )
+      {
+        b_event_pending |= !is_cyclic( tx_queue[i].tx_reason, tx_queue[i].msg_type );
+      }
+      CHECK( b_event_pending == !is_cyclic( entry.tx_reason, entry.msg_type ) );
+      base_tx_queue_pop( &entry, ( test_rand() % 8 ) != 0 );
+    }
+    CHECK( base_tx_queue_get_count() <= BASE_TX_QUEUE_SIZE );
+
+    base_tx_queue_get_stats( &stats );
+    CHECK( stats.u32_queued + stats.u32_coalesced + u32_rejected == u32_requests );
+    CHECK( stats.u32_queued == base_tx_queue_get_count() + stats.u32_sent + ( stats.u32_dropped - u32_rejected ) );
+  }
+  printf( "  %u requests: %u queued, %u coalesced, %u dropped, %u sent\n", u32_requests, stats.u32_queued,
+          stats.u32_coalesced, stats.u32_dropped, stats.u32_sent );
+}
+
+int main( void )
+{
+  test_coalescing();
+  test_priority();
+  test_full();
+  test_random();
+
+  return TEST_END();
+}
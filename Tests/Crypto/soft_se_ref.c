@@ -0,0 +1,24 @@
+/**
+* @file soft_se_ref.c
+* @brief soft-se.c before the key schedule cache under other names, the
+*        reference for the output and the time of the cached secure element.
+**/
+
+#define SecureElementInit                           RefSecureElementInit
+#define SecureElementDeleteDerivedKeys              RefSecureElementDeleteDerivedKeys
+#define SecureElementRestoreNvmCtx                  RefSecureElementRestoreNvmCtx
+#define SecureElementGetNvmCtx                      RefSecureElementGetNvmCtx
+#define SecureElementSetKey                         RefSecureElementSetKey
+#define SecureElementSetObjHandler                  RefSecureElementSetObjHandler
+#define SecureElementComputeAesCmac                 RefSecureElementComputeAesCmac
+#define SecureElementVerifyAesCmac                  RefSecureElementVerifyAesCmac
+#define SecureElementAesEncrypt                     RefSecureElementAesEncrypt
+#define SecureElementDeriveAndStoreKey              RefSecureElementDeriveAndStoreKey
+#define SecureElementProcessJoinAccept              RefSecureElementProcessJoinAccept
+#define SecureElementRandomNumber                   RefSecureElementRandomNumber
+#define SecureElementSetDevEui                      RefSecureElementSetDevEui
+#define SecureElementGetDevEui                      RefSecureElementGetDevEui
+#define SecureElementSetJoinEui                     RefSecureElementSetJoinEui
+#define SecureElementGetJoinEui                     RefSecureElementGetJoinEui
+
+#include "Reference/soft-se.c"
@@ -0,0 +1,25 @@
+/**
+* @file soft_se_ref.h
+* @brief soft-se.c without the key cache under other names, see soft_se_ref.c.
+**/
+
+#ifndef __SOFT_SE_REF_H__
+#define __SOFT_SE_REF_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+#include "secure-element.h"
+
+// Prototypes ------------------------------------------------------------------
+SecureElementStatus_t RefSecureElementInit( SecureElementNvmEvent seNvmCtxChanged );
+SecureElementStatus_t RefSecureElementSetKey( KeyIdentifier_t keyID, uint8_t *key );
+SecureElementStatus_t RefSecureElementComputeAesCmac( uint8_t *micBxBuffer, uint8_t *buffer, uint16_t size,
+                                                      KeyIdentifier_t keyID, uint32_t *cmac );
+SecureElementStatus_t RefSecureElementVerifyAesCmac( uint8_t *buffer, uint16_t size, uint32_t expectedCmac,
+                                                     KeyIdentifier_t keyID );
+SecureElementStatus_t RefSecureElementAesEncrypt( uint8_t *buffer, uint16_t size, KeyIdentifier_t keyID,
+                                                  uint8_t *encBuffer );
+SecureElementStatus_t RefSecureElementDeriveAndStoreKey( Version_t version, uint8_t *input, KeyIdentifier_t rootKeyID,
+                                                         KeyIdentifier_t targetKeyID );
+
+#endif /* __SOFT_SE_REF_H__ */
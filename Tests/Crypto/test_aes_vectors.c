@@ -0,0 +1,247 @@
+/**
+* @file test_aes_vectors.c
+* @brief Known answer tests of lorawan_aes.c and cmac.c.
+*
+* Built twice by the Makefile: with the byte oriented rounds and with
+* HAVE_UINT_32T, which selects the T-table rounds of the Cortex-M3/M4 build.
+* - FIPS-197 appendix B, C.1 and C.3
+* - 10000 chained encryptions of a zero block, compared with openssl
+* - RFC 4493 section 4, subkeys and the four examples, with both key setups
+* - encryption in place and on unaligned buffers
+* With TEST_BENCH the time of the key setup, of one block and of a CMAC is
+* printed instead, "make bench" also prints the object sizes of both rounds.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "test.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+// Variables -------------------------------------------------------------------
+static const uint8_t fips_b_key[16] =
+{
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t fips_b_in[16] =
+{
+  0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d, 0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34
+};
+static const uint8_t fips_b_out[16] =
+{
+  0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb, 0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32
+};
+static const uint8_t fips_c1_out[16] =
+{
+  0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+static const uint8_t fips_c3_out[16] =
+{
+  0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+};
+// openssl enc -aes-128-cbc -nopad, zero IV, 10000 zero blocks: the last block is E^10000( 0 )
+static const uint8_t chain_128_out[16] =
+{
+  0x4a, 0x1f, 0x22, 0x7d, 0x5d, 0x20, 0xb6, 0x89, 0xbb, 0xd9, 0x57, 0xeb, 0xd4, 0xa6, 0xc0, 0x17
+};
+static const uint8_t chain_256_out[16] =
+{
+  0x8e, 0x88, 0xa2, 0x64, 0x25, 0x2d, 0x25, 0x87, 0x70, 0x1f, 0x68, 0x43, 0xd8, 0xff, 0xc0, 0x64
+};
+
+static const uint8_t rfc4493_msg[64] =
+{
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const uint8_t rfc4493_k1[16] =
+{
+  0xfb, 0xee, 0xd6, 0x18, 0x35, 0x71, 0x33, 0x66, 0x7c, 0x85, 0xe0, 0x8f, 0x72, 0x36, 0xa8, 0xde
+};
+static const uint8_t rfc4493_k2[16] =
+{
+  0xf7, 0xdd, 0xac, 0x30, 0x6a, 0xe2, 0x66, 0xcc, 0xf9, 0x0b, 0xc1, 0x1e, 0xe4, 0x6d, 0x51, 0x3b
+};
+static const uint32_t rfc4493_len[4] = { 0, 16, 40, 64 };
+static const uint8_t rfc4493_mac[4][16] =
+{
+  { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 },
+  { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c },
+  { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 },
+  { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe },
+};
+
+// Functions -------------------------------------------------------------------
+static void test_fips197( void )
+{
+  lorawan_aes_context ctx;
+  uint8_t key[32];
+  uint8_t in[16];
+  uint8_t out[16];
+
+  memset( &ctx, 0, sizeof( ctx ) );
+  CHECK( lorawan_aes_set_key( fips_b_key, 16, &ctx ) == 0 );
+  CHECK( lorawan_aes_encrypt( fips_b_in, out, &ctx ) == 0 );
+  CHECK_MEM( out, fips_b_out, 16 );
+
+  for( int i = 0; i < 32; i++ )
+  {
+    key[i] = ( uint8_t ) i;
+  }
+  for( int i = 0; i < 16; i++ )
+  {
+    in[i] = ( uint8_t ) ( ( i << 4 ) | i );
+  }
+
+  CHECK( lorawan_aes_set_key( key, 16, &ctx ) == 0 );
+  lorawan_aes_encrypt( in, out, &ctx );
+  CHECK_MEM( out, fips_c1_out, 16 );
+
+  CHECK( lorawan_aes_set_key( key, 32, &ctx ) == 0 );
+  lorawan_aes_encrypt( in, out, &ctx );
+  CHECK_MEM( out, fips_c3_out, 16 );
+}
+
+static void test_chain( void )
+{
+  lorawan_aes_context ctx;
+  uint8_t key[32];
+  uint8_t block[16];
+
+  for( int i = 0; i < 32; i++ )
+  {
+    key[i] = ( uint8_t ) i;
+  }
+
+  memset( block, 0, sizeof( block ) );
+  lorawan_aes_set_key( key, 16, &ctx );
+  for( int i = 0; i < 10000; i++ )
+  {
+    lorawan_aes_encrypt( block, block, &ctx );
+  }
+  CHECK_MEM( block, chain_128_out, 16 );
+
+  memset( block, 0, sizeof( block ) );
+  lorawan_aes_set_key( key, 32, &ctx );
+  for( int i = 0; i < 10000; i++ )
+  {
+    lorawan_aes_encrypt( block, block, &ctx );
+  }
+  CHECK_MEM( block, chain_256_out, 16 );
+}
+
+static void test_unaligned( void )
+{
+  lorawan_aes_context ctx;
+  uint8_t in[16 + 3];
+  uint8_t out[16 + 3];
+
+  lorawan_aes_set_key( fips_b_key, 16, &ctx );
+  for( int offset = 0; offset < 4; offset++ )
+  {
+    memcpy( in + offset, fips_b_in, 16 );
+    lorawan_aes_encrypt( in + offset, out + ( 3 - offset ), &ctx );
+    CHECK_MEM( out + ( 3 - offset ), fips_b_out, 16 );
+
+    lorawan_aes_encrypt( in + offset, in + offset, &ctx );
+    CHECK_MEM( in + offset, fips_b_out, 16 );
+  }
+}
+
+static void test_rfc4493( void )
+{
+  AES_CMAC_CTX cmac;
+  AES_CMAC_SUBKEYS subkeys;
+  lorawan_aes_context aes;
+  uint8_t mac[16];
+
+  memset( &aes, 0, sizeof( aes ) );
+  lorawan_aes_set_key( fips_b_key, 16, &aes );
+  AES_CMAC_DeriveSubkeys( &aes, &subkeys );
+  CHECK_MEM( subkeys.K1, rfc4493_k1, 16 );
+  CHECK_MEM( subkeys.K2, rfc4493_k2, 16 );
+
+  for( int i = 0; i < 4; i++ )
+  {
+    // Key expanded by the CMAC context
+    AES_CMAC_Init( &cmac );
+    AES_CMAC_SetKey( &cmac, fips_b_key );
+    AES_CMAC_Update( &cmac, rfc4493_msg, rfc4493_len[i] );
+    AES_CMAC_Final( mac, &cmac );
+    CHECK_MEM( mac, rfc4493_mac[i], 16 );
+
+    // Pre-keyed schedule and subkeys, as used by the secure element
+    AES_CMAC_Init( &cmac );
+    AES_CMAC_SetKeySchedule( &cmac, &aes, &subkeys );
+    AES_CMAC_Update( &cmac, rfc4493_msg, rfc4493_len[i] );
+    AES_CMAC_Final( mac, &cmac );
+    CHECK_MEM( mac, rfc4493_mac[i], 16 );
+
+    // The same message fed in pieces of 1..7 bytes
+    AES_CMAC_Init( &cmac );
+    AES_CMAC_SetKeySchedule( &cmac, &aes, NULL );
+    for( uint32_t pos = 0, step = 1; pos < rfc4493_len[i]; pos += step, step = ( step % 7 ) + 1 )
+    {
+      AES_CMAC_Update( &cmac, rfc4493_msg + pos, ( pos + step <= rfc4493_len[i] ) ? step : ( rfc4493_len[i] - pos ) );
+    }
+    AES_CMAC_Final( mac, &cmac );
+    CHECK_MEM( mac, rfc4493_mac[i], 16 );
+  }
+}
+
+#if defined( TEST_BENCH )
+static void bench( const char *name, uint32_t runs )
+{
+  static lorawan_aes_context ctx;
+  AES_CMAC_CTX cmac;
+  AES_CMAC_SUBKEYS subkeys;
+  uint8_t block[16] = { 0 };
+  double start;
+
+  lorawan_aes_set_key( fips_b_key, 16, &ctx );
+  AES_CMAC_DeriveSubkeys( &ctx, &subkeys );
+  start = test_cpu_time();
+  for( uint32_t i = 0; i < runs; i++ )
+  {
+    switch( name[0] )
+    {
+      case 'k':
+        lorawan_aes_set_key( block, 16, &ctx );
+        break;
+      case 'b':
+        lorawan_aes_encrypt( block, block, &ctx );
+        break;
+      default:
+        AES_CMAC_Init( &cmac );
+        AES_CMAC_SetKeySchedule( &cmac, &ctx, &subkeys );
+        AES_CMAC_Update( &cmac, rfc4493_msg, sizeof( rfc4493_msg ) );
+        AES_CMAC_Final( block, &cmac );
+        break;
+    }
+  }
+  printf( "  %-10s %8.3f us\n", name, ( test_cpu_time() - start ) * 1e6 / runs );
+}
+#endif /* TEST_BENCH */
+
+int main( void )
+{
+#if defined( TEST_BENCH )
+  // Host CPU time, relative figures between the byte and the T-table rounds
+#if defined( HAVE_UINT_32T ) && !defined( AES_ENC_BYTE_ROUNDS )
+  printf( "AES T-table rounds, context %u bytes\n", ( unsigned ) sizeof( lorawan_aes_context ) );
+#else
+  printf( "AES byte rounds, context %u bytes\n", ( unsigned ) sizeof( lorawan_aes_context ) );
+#endif /* HAVE_UINT_32T */
+  bench( "key setup", 1000000 );
+  bench( "block", 2000000 );
+  bench( "cmac 64", 500000 );
+#else
+  test_fips197();
+  test_chain();
+  test_unaligned();
+  test_rfc4493();
+#endif /* TEST_BENCH */
+
+  return TEST_END();
+}
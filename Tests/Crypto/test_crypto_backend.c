@@ -0,0 +1,306 @@
+/**
+* @file test_crypto_backend.c
+* @brief Conformance tests and benchmark of the crypto backends (crypto_backend.h).
+*
+* Built once per backend by the Makefile, LORAWAN_CRYPTO_BACKEND_SOFT and
+* LORAWAN_CRYPTO_BACKEND_HOST. The host backend runs the code of the STM32WL
+* peripheral backend (crypto_backend.c) on the software model of the engine.
+* Every result is compared with lorawan_aes.c and cmac.c used directly:
+* - ECB, CTR and CMAC for all sizes up to several engine batches
+* - CTR in place and on unaligned buffers, CMAC with and without the B0 block
+* - RFC 4493 examples
+* - engine failures are reported and the CMAC subkeys are not cached
+* With TEST_BENCH the time per operation is printed instead.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "test.h"
+#include "crypto_backend.h"
+#include "lorawan_aes.h"
+#include "cmac.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_SIZE                               ( CRYPTO_ENGINE_BATCH_BLOCKS * 16 * 3 + 7 )
+
+// Variables -------------------------------------------------------------------
+static const uint8_t rfc4493_key[16] =
+{
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t rfc4493_msg[64] =
+{
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+static const uint16_t rfc4493_len[4] = { 0, 16, 40, 64 };
+static const uint8_t rfc4493_mac[4][16] =
+{
+  { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 },
+  { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c },
+  { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 },
+  { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe },
+};
+
+#if ( LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT )
+static bool b_engine_fail = false;
+static uint32_t u32_engine_calls = 0;
+
+// The engine is linked with -Wl,--wrap=CryptoAesEngineEncrypt to inject failures
+SecureElementStatus_t __real_CryptoAesEngineEncrypt( const uint32_t *keyWords, const uint32_t *ivWords,
+                                                     const uint32_t *input, uint32_t *output, uint16_t blocks );
+
+SecureElementStatus_t __wrap_CryptoAesEngineEncrypt( const uint32_t *keyWords, const uint32_t *ivWords,
+                                                     const uint32_t *input, uint32_t *output, uint16_t blocks )
+{
+  u32_engine_calls++;
+  if( b_engine_fail )
+  {
+    return SECURE_ELEMENT_FAIL_ENCRYPT;
+  }
+  return __real_CryptoAesEngineEncrypt( keyWords, ivWords, input, output, blocks );
+}
+#endif /* LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT */
+
+// Functions -------------------------------------------------------------------
+static void fill_random( uint8_t *buffer, uint16_t size )
+{
+  for( uint16_t i = 0; i < size; i++ )
+  {
+    buffer[i] = ( uint8_t ) test_rand();
+  }
+}
+
+static void ref_ctr( const uint8_t *key, const uint8_t *a_block, uint8_t *buffer, uint16_t size )
+{
+  lorawan_aes_context aes;
+  uint8_t ctr[16];
+  uint8_t s_block[16];
+
+  memset( &aes, 0, sizeof( aes ) );
+  lorawan_aes_set_key( key, 16, &aes );
+  memcpy( ctr, a_block, 16 );
+  for( uint16_t pos = 0; pos < size; pos++ )
+  {
+    if( ( pos % 16 ) == 0 )
+    {
+      lorawan_aes_encrypt( ctr, s_block, &aes );
+      ctr[15]++;
+    }
+    buffer[pos] ^= s_block[pos % 16];
+  }
+}
+
+static void ref_cmac( const uint8_t *key, const uint8_t *b0, const uint8_t *buffer, uint16_t size, uint8_t *mac )
+{
+  AES_CMAC_CTX cmac;
+
+  AES_CMAC_Init( &cmac );
+  AES_CMAC_SetKey( &cmac, key );
+  if( b0 != NULL )
+  {
+    AES_CMAC_Update( &cmac, b0, 16 );
+  }
+  AES_CMAC_Update( &cmac, buffer, size );
+  AES_CMAC_Final( mac, &cmac );
+}
+
+static void test_ecb( void )
+{
+  CryptoKey_t key;
+  lorawan_aes_context aes;
+  uint8_t raw_key[16];
+  static uint8_t in[TEST_MAX_SIZE];
+  static uint8_t out[TEST_MAX_SIZE];
+  static uint8_t ref[TEST_MAX_SIZE];
+
+  for( uint16_t size = 16; size < TEST_MAX_SIZE; size += 16 )
+  {
+    fill_random( raw_key, 16 );
+    fill_random( in, size );
+    memset( &aes, 0, sizeof( aes ) );
+    lorawan_aes_set_key( raw_key, 16, &aes );
+    for( uint16_t b = 0; b < size; b += 16 )
+    {
+      lorawan_aes_encrypt( in + b, ref + b, &aes );
+    }
+
+    CHECK( CryptoBackendSetKey( raw_key, &key ) == SECURE_ELEMENT_SUCCESS );
+    CHECK( CryptoBackendEcbEncrypt( &key, in, size, out ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( out, ref, size );
+
+    // In place
+    CHECK( CryptoBackendEcbEncrypt( &key, in, size, in ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( in, ref, size );
+  }
+}
+
+static void test_ctr( void )
+{
+  CryptoKey_t key;
+  uint8_t raw_key[16];
+  uint8_t a_block[16];
+  static uint8_t data[TEST_MAX_SIZE + 3];
+  static uint8_t ref[TEST_MAX_SIZE];
+
+  for( uint16_t size = 0; size < TEST_MAX_SIZE; size++ )
+  {
+    uint8_t *buffer = data + ( size % 4 );
+
+    fill_random( raw_key, 16 );
+    fill_random( a_block, 16 );
+    a_block[15] = ( uint8_t ) ( 0xF0 + ( size % 16 ) );  // Counter byte wraps within the message
+    fill_random( buffer, size );
+    memcpy( ref, buffer, size );
+    ref_ctr( raw_key, a_block, ref, size );
+
+    CHECK( CryptoBackendSetKey( raw_key, &key ) == SECURE_ELEMENT_SUCCESS );
+    CHECK( CryptoBackendCtrCrypt( &key, a_block, buffer, size ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( buffer, ref, size );
+  }
+}
+
+static void test_cmac( void )
+{
+  CryptoKey_t key;
+  uint8_t raw_key[16];
+  uint8_t b0[16];
+  uint8_t mac[16];
+  uint8_t ref[16];
+  static uint8_t data[TEST_MAX_SIZE];
+
+  // RFC 4493, also with the first block passed as B0
+  CHECK( CryptoBackendSetKey( rfc4493_key, &key ) == SECURE_ELEMENT_SUCCESS );
+  for( int i = 0; i < 4; i++ )
+  {
+    CHECK( CryptoBackendCmac( &key, NULL, rfc4493_msg, rfc4493_len[i], mac ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( mac, rfc4493_mac[i], 16 );
+    if( rfc4493_len[i] >= 16 )
+    {
+      CHECK( CryptoBackendCmac( &key, rfc4493_msg, rfc4493_msg + 16, rfc4493_len[i] - 16, mac ) == SECURE_ELEMENT_SUCCESS );
+      CHECK_MEM( mac, rfc4493_mac[i], 16 );
+    }
+  }
+
+  for( uint16_t size = 0; size < TEST_MAX_SIZE; size++ )
+  {
+    fill_random( raw_key, 16 );
+    fill_random( b0, 16 );
+    fill_random( data, size );
+    CHECK( CryptoBackendSetKey( raw_key, &key ) == SECURE_ELEMENT_SUCCESS );
+
+    ref_cmac( raw_key, NULL, data, size, ref );
+    CHECK( CryptoBackendCmac( &key, NULL, data, size, mac ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( mac, ref, 16 );
+
+    // Second run on the cached subkeys
+    ref_cmac( raw_key, b0, data, size, ref );
+    CHECK( CryptoBackendCmac( &key, b0, data, size, mac ) == SECURE_ELEMENT_SUCCESS );
+    CHECK_MEM( mac, ref, 16 );
+  }
+}
+
+static void test_errors( void )
+{
+  CryptoKey_t key;
+
+  CHECK( CryptoBackendSetKey( NULL, &key ) == SECURE_ELEMENT_ERROR_NPE );
+  CHECK( CryptoBackendSetKey( rfc4493_key, NULL ) == SECURE_ELEMENT_ERROR_NPE );
+
+#if ( LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT )
+  uint8_t block[16] = { 0 };
+  uint8_t mac[16];
+
+  CHECK( CryptoBackendSetKey( rfc4493_key, &key ) == SECURE_ELEMENT_SUCCESS );
+
+  // A failed subkey derivation is reported and not cached
+  b_engine_fail    = true;
+  u32_engine_calls = 0;
+  CHECK( CryptoBackendCmac( &key, NULL, rfc4493_msg, 64, mac ) == SECURE_ELEMENT_FAIL_ENCRYPT );
+  CHECK( u32_engine_calls == 1 );
+  CHECK( key.SubkeysValid == false );
+  CHECK( CryptoBackendEcbEncrypt( &key, block, 16, block ) == SECURE_ELEMENT_FAIL_ENCRYPT );
+  CHECK( CryptoBackendCtrCrypt( &key, block, block, 16 ) == SECURE_ELEMENT_FAIL_ENCRYPT );
+
+  b_engine_fail = false;
+  CHECK( CryptoBackendCmac( &key, NULL, rfc4493_msg, 64, mac ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( key.SubkeysValid == true );
+  CHECK_MEM( mac, rfc4493_mac[3], 16 );
+
+  // A failure after the subkeys is reported as well
+  b_engine_fail = true;
+  CHECK( CryptoBackendCmac( &key, NULL, rfc4493_msg, 64, mac ) == SECURE_ELEMENT_FAIL_ENCRYPT );
+
+  // The chaining stops at the first failed batch and the MAC is left alone
+  {
+    static uint8_t data[TEST_MAX_SIZE];
+    uint8_t unchanged[16];
+
+    memset( mac, 0xA5, sizeof( mac ) );
+    memcpy( unchanged, mac, sizeof( mac ) );
+    for( uint16_t size = 64; size <= sizeof( data ); size += sizeof( data ) - 64 )
+    {
+      u32_engine_calls = 0;
+      CHECK( CryptoBackendCmac( &key, block, data, size, mac ) == SECURE_ELEMENT_FAIL_ENCRYPT );
+      CHECK( u32_engine_calls == 1 );
+      CHECK_MEM( mac, unchanged, 16 );
+    }
+  }
+  b_engine_fail = false;
+#endif /* LORAWAN_CRYPTO_BACKEND != LORAWAN_CRYPTO_BACKEND_SOFT */
+}
+
+#if defined( TEST_BENCH )
+static void bench( const char *name, uint16_t size, uint32_t runs )
+{
+  CryptoKey_t key;
+  static uint8_t data[256];
+  uint8_t mac[16];
+  double start;
+
+  CryptoBackendSetKey( rfc4493_key, &key );
+  start = test_cpu_time();
+  for( uint32_t i = 0; i < runs; i++ )
+  {
+    switch( name[1] )
+    {
+      case 'c':
+        CryptoBackendEcbEncrypt( &key, data, size, data );
+        break;
+      case 't':
+        CryptoBackendCtrCrypt( &key, rfc4493_msg, data, size );
+        break;
+      default:
+        CryptoBackendCmac( &key, rfc4493_msg, data, size, mac );
+        break;
+    }
+  }
+  printf( "  %-5s %3u bytes: %8.3f us\n", name, size, ( test_cpu_time() - start ) * 1e6 / runs );
+}
+#endif /* TEST_BENCH */
+
+int main( void )
+{
+  printf( "Crypto backend %d\n", LORAWAN_CRYPTO_BACKEND );
+  CHECK( CryptoBackendInit() == SECURE_ELEMENT_SUCCESS );
+
+#if defined( TEST_BENCH )
+  // Host CPU time, relative figures between the backends and the sizes
+  bench( "ecb", 16, 200000 );
+  bench( "ecb", 128, 50000 );
+  bench( "ctr", 16, 200000 );
+  bench( "ctr", 51, 100000 );
+  bench( "ctr", 242, 20000 );
+  bench( "cmac", 12, 200000 );
+  bench( "cmac", 64, 100000 );
+  bench( "cmac", 242, 20000 );
+#else
+  test_ecb();
+  test_ctr();
+  test_cmac();
+  test_errors();
+#endif /* TEST_BENCH */
+
+  return TEST_END();
+}
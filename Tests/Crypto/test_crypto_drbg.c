@@ -0,0 +1,224 @@
+/**
+* @file test_crypto_drbg.c
+* @brief Known answer and statistical tests of the random generator (crypto_drbg.c).
+*
+* crypto_drbg.c is included, every known answer starts from a new generator:
+* - NIST CAVS CTR_DRBG AES-128, no derivation function, no reseed, count 0
+* - a reseed, and a seed longer than CRYPTO_DRBG_SEED_SIZE absorbed in chunks,
+*   the answers of a Python model of SP 800-90A
+* - a short request is the start of a long one from the same state
+* - CryptoDrbgGenerate() refuses before the first seed and NULL pointers
+* - CryptoDrbgNeedsSeed() after CRYPTO_DRBG_RESEED_INTERVAL requests
+* - 1 MB of output: bits, runs, byte and byte pair frequencies, serial
+*   correlation of the bytes, inside fixed bounds of about 5 sigma
+**/
+
+// Includes --------------------------------------------------------------------
+#include <math.h>
+#include <stdbool.h>
+#include "test.h"
+#include "crypto_drbg.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_STAT_SIZE                              ( 1024UL * 1024UL )
+#define TEST_STAT_REQUEST                           4096U
+#define TEST_STAT_SIGMAS                            5.0
+
+// Variables -------------------------------------------------------------------
+static const uint8_t nist_entropy[32] =
+{
+  0xce, 0x50, 0xf3, 0x3d, 0xa5, 0xd4, 0xc1, 0xd3, 0xd4, 0x00, 0x4e, 0xb3, 0x52, 0x44, 0xb7, 0xf2,
+  0xcd, 0x7f, 0x2e, 0x50, 0x76, 0xfb, 0xf6, 0x78, 0x0a, 0x7f, 0xf6, 0x34, 0xb2, 0x49, 0xa5, 0xfc
+};
+
+static const uint8_t nist_returned[64] =
+{
+  0x65, 0x45, 0xc0, 0x52, 0x9d, 0x37, 0x24, 0x43, 0xb3, 0x92, 0xce, 0xb3, 0xae, 0x3a, 0x99, 0xa3,
+  0x0f, 0x96, 0x3e, 0xaf, 0x31, 0x32, 0x80, 0xf1, 0xd1, 0xa1, 0xe8, 0x7f, 0x9d, 0xb3, 0x73, 0xd3,
+  0x61, 0xe7, 0x5d, 0x18, 0x01, 0x82, 0x66, 0x49, 0x9c, 0xcc, 0xd6, 0x4d, 0x9b, 0xbb, 0x8d, 0xe0,
+  0x18, 0x5f, 0x21, 0x33, 0x83, 0x08, 0x0f, 0xad, 0xde, 0xc4, 0x6b, 0xae, 0x1f, 0x78, 0x4e, 0x5a
+};
+
+// Instantiated with 0x00 to 0x1f, reseeded with 0x80 to 0x9f
+static const uint8_t reseed_returned[64] =
+{
+  0xa2, 0x1d, 0x76, 0x64, 0x46, 0x6e, 0xdb, 0x3c, 0xcf, 0x1a, 0xdb, 0xb7, 0x64, 0xab, 0x79, 0x72,
+  0x45, 0x2e, 0x9d, 0x94, 0x06, 0x69, 0x58, 0x79, 0xa7, 0x70, 0x9b, 0x20, 0x7e, 0xd4, 0x4a, 0x4e,
+  0x7a, 0x92, 0x75, 0x64, 0xdf, 0x37, 0x87, 0x93, 0x7a, 0xc1, 0xad, 0x40, 0xef, 0x04, 0x5e, 0x40,
+  0x9a, 0x2c, 0x7d, 0x3d, 0x6a, 0x70, 0x5c, 0x2c, 0x7e, 0x05, 0x88, 0x27, 0x39, 0xfc, 0x73, 0xa7
+};
+
+// Seed ( 7 * i + 3 ) & 0xff of 72 bytes: two full chunks and a padded one
+static const uint8_t chunked_returned[20] =
+{
+  0xc2, 0xab, 0x79, 0x0e, 0xd1, 0x2c, 0x40, 0x30, 0xd5, 0x3b, 0x4c, 0x99, 0x8b, 0x00, 0x96, 0xb8,
+  0x01, 0x9c, 0x62, 0xe8
+};
+
+static uint8_t stat_data[TEST_STAT_SIZE];
+static uint32_t pair_counts[65536];
+
+// Functions -------------------------------------------------------------------
+static void drbg_reset( void )
+{
+  memset( &DrbgCtx, 0, sizeof( DrbgCtx ) );
+}
+
+static void test_known_answers( void )
+{
+  uint8_t seed[72];
+  uint8_t out[64];
+  uint8_t prefix[20];
+
+  drbg_reset();
+  CHECK( CryptoDrbgSeed( nist_entropy, sizeof( nist_entropy ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK_MEM( out, nist_returned, sizeof( out ) );
+
+  drbg_reset();
+  for( uint8_t i = 0; i < 32; i++ )
+  {
+    seed[i] = i;
+    seed[32 + i] = ( uint8_t ) ( 0x80 + i );
+  }
+  CHECK( CryptoDrbgSeed( seed, 32 ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgSeed( &seed[32], 32 ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK_MEM( out, reseed_returned, sizeof( out ) );
+
+  for( uint8_t i = 0; i < sizeof( seed ); i++ )
+  {
+    seed[i] = ( uint8_t ) ( 7 * i + 3 );
+  }
+  drbg_reset();
+  CHECK( CryptoDrbgSeed( seed, sizeof( seed ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( prefix, sizeof( prefix ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK_MEM( prefix, chunked_returned, sizeof( prefix ) );
+
+  // The request size only decides where the output stops
+  drbg_reset();
+  CHECK( CryptoDrbgSeed( seed, sizeof( seed ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK_MEM( out, chunked_returned, sizeof( prefix ) );
+}
+
+static void test_states( void )
+{
+  uint8_t seed[CRYPTO_DRBG_SEED_SIZE] = { 0x42 };
+  uint8_t out[4];
+
+  drbg_reset();
+  CHECK( CryptoDrbgNeedsSeed() );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_ERROR );
+  CHECK( CryptoDrbgSeed( NULL, sizeof( seed ) ) == SECURE_ELEMENT_ERROR_NPE );
+  CHECK( CryptoDrbgNeedsSeed() );
+
+  CHECK( CryptoDrbgSeed( seed, sizeof( seed ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgGenerate( NULL, sizeof( out ) ) == SECURE_ELEMENT_ERROR_NPE );
+  for( uint32_t i = 0; i < CRYPTO_DRBG_RESEED_INTERVAL - 1; i++ )
+  {
+    CryptoDrbgGenerate( out, sizeof( out ) );
+  }
+  CHECK( CryptoDrbgNeedsSeed() == false );
+  CHECK( CryptoDrbgGenerate( out, sizeof( out ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgNeedsSeed() );
+  CHECK( CryptoDrbgSeed( seed, sizeof( seed ) ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( CryptoDrbgNeedsSeed() == false );
+}
+
+// Bounds of a normally distributed figure
+static bool in_bounds( double value, double mean, double sigma )
+{
+  return fabs( value - mean ) < ( TEST_STAT_SIGMAS * sigma );
+}
+
+static void test_statistics( void )
+{
+  const double n_bits = TEST_STAT_SIZE * 8.0;
+  uint32_t byte_counts[256] = { 0 };
+  uint32_t ones = 0;
+  uint32_t runs = 1;
+  uint8_t last_bit;
+  double chi2 = 0.0;
+  double sum = 0.0;
+  double sum_sq = 0.0;
+  double sum_next = 0.0;
+
+  drbg_reset();
+  CHECK( CryptoDrbgSeed( nist_entropy, sizeof( nist_entropy ) ) == SECURE_ELEMENT_SUCCESS );
+  for( uint32_t pos = 0; pos < TEST_STAT_SIZE; pos += TEST_STAT_REQUEST )
+  {
+    CHECK( CryptoDrbgGenerate( &stat_data[pos], TEST_STAT_REQUEST ) == SECURE_ELEMENT_SUCCESS );
+  }
+
+  // Monobit and runs of equal bits
+  last_bit = stat_data[0] & 1;
+  for( uint32_t i = 0; i < TEST_STAT_SIZE; i++ )
+  {
+    for( uint8_t b = 0; b < 8; b++ )
+    {
+      uint8_t bit = ( stat_data[i] >> b ) & 1;
+
+      ones += bit;
+      runs += ( bit != last_bit );
+      last_bit = bit;
+    }
+  }
+  {
+    double pi = ones / n_bits;
+
+    CHECK( in_bounds( ones, n_bits / 2, sqrt( n_bits ) / 2 ) );
+    CHECK( in_bounds( runs, 2 * n_bits * pi * ( 1 - pi ) + 1, 2 * sqrt( 2 * n_bits ) * pi * ( 1 - pi ) ) );
+  }
+
+  // Byte frequencies: chi-square of 255 degrees of freedom, too even is as wrong as too uneven
+  for( uint32_t i = 0; i < TEST_STAT_SIZE; i++ )
+  {
+    byte_counts[stat_data[i]]++;
+  }
+  for( uint16_t v = 0; v < 256; v++ )
+  {
+    double expected = TEST_STAT_SIZE / 256.0;
+
+    chi2 += ( byte_counts[v] - expected ) * ( byte_counts[v] - expected ) / expected;
+  }
+  CHECK( in_bounds( chi2, 255, sqrt( 2 * 255 ) ) );
+
+  // Frequencies of the non overlapping byte pairs: 65535 degrees of freedom
+  chi2 = 0.0;
+  for( uint32_t i = 0; i < TEST_STAT_SIZE; i += 2 )
+  {
+    pair_counts[( stat_data[i] << 8 ) | stat_data[i + 1]]++;
+  }
+  for( uint32_t v = 0; v < 65536; v++ )
+  {
+    double expected = TEST_STAT_SIZE / 2 / 65536.0;
+
+    chi2 += ( pair_counts[v] - expected ) * ( pair_counts[v] - expected ) / expected;
+  }
+  CHECK( in_bounds( chi2, 65535, sqrt( 2 * 65535 ) ) );
+
+  // Serial correlation of each byte with the next one
+  for( uint32_t i = 0; i < TEST_STAT_SIZE; i++ )
+  {
+    sum += stat_data[i];
+    sum_sq += ( double ) stat_data[i] * stat_data[i];
+    sum_next += ( double ) stat_data[i] * stat_data[( i + 1 ) % TEST_STAT_SIZE];
+  }
+  {
+    double correlation = ( TEST_STAT_SIZE * sum_next - sum * sum ) / ( TEST_STAT_SIZE * sum_sq - sum * sum );
+
+    CHECK( in_bounds( correlation, 0, 1 / sqrt( TEST_STAT_SIZE ) ) );
+  }
+}
+
+int main( void )
+{
+  test_known_answers();
+  test_states();
+  test_statistics();
+
+  return TEST_END();
+}
@@ -0,0 +1,195 @@
+/**
+* @file test_soft_se.c
+* @brief Tests of the key schedule cache of the soft secure element (soft-se.c).
+*
+* The cached secure element and the one of the original tree (soft_se_ref.c)
+* get the same random sequence of calls and must give the same results:
+* - SecureElementSetKey() and SecureElementDeriveAndStoreKey() on more keys
+*   than the cache holds, the cached schedules must follow the new keys
+* - SecureElementComputeAesCmac() with and without B0 block
+* - SecureElementVerifyAesCmac() with the right and a wrong MIC
+* - SecureElementAesEncrypt() of 1 to 4 blocks
+* SecureElementSetRandomSeed() keeps the seed of the previous boot until the
+* first random number, then SecureElementGetRandomSeed() gives a new one, also
+* after a seed mixed into the running generator.
+* With TEST_BENCH the time of the secure element calls of one uplink and of one
+* downlink is printed for both instead.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "secure-element.h"
+#include "soft_se_ref.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_SIZE                               64
+#define TEST_KEYS                                   ( sizeof( test_keys ) / sizeof( test_keys[0] ) )
+
+// Variables -------------------------------------------------------------------
+// More keys than KEY_CACHE_SIZE, the multicast keys take the other paths of soft-se.c
+static const KeyIdentifier_t test_keys[] =
+{
+  APP_KEY, NWK_KEY, NWK_S_KEY, APP_S_KEY, MC_ROOT_KEY, MC_KE_KEY, MC_KEY_0, MC_APP_S_KEY_0
+};
+
+// Functions -------------------------------------------------------------------
+static uint32_t radio_random( void )
+{
+  return test_rand();
+}
+
+// soft-se.c only draws random numbers from the radio
+const struct Radio_s Radio = { .Random = radio_random };
+
+void GetUniqueId( uint8_t *id )
+{
+  for( uint8_t i = 0; i < 8; i++ )
+  {
+    id[i] = ( uint8_t ) ( 0x10 + i );
+  }
+}
+
+static void fill_random( uint8_t *buffer, uint16_t size )
+{
+  for( uint16_t i = 0; i < size; i++ )
+  {
+    buffer[i] = ( uint8_t ) test_rand();
+  }
+}
+
+static void test_random_calls( uint32_t calls )
+{
+  uint8_t b0[16];
+  uint8_t data[TEST_MAX_SIZE];
+  uint8_t out[TEST_MAX_SIZE];
+  uint8_t ref_out[TEST_MAX_SIZE];
+  uint32_t cmac;
+  uint32_t ref_cmac;
+  Version_t version = { .Value = 0x01000300 };
+
+  for( uint32_t i = 0; i < calls; i++ )
+  {
+    KeyIdentifier_t key_id = test_keys[test_rand() % TEST_KEYS];
+    uint16_t size = ( uint16_t ) ( test_rand() % ( TEST_MAX_SIZE + 1 ) );
+    uint8_t *micBx = ( test_rand() & 1 ) ? b0 : NULL;
+
+    fill_random( b0, sizeof( b0 ) );
+    fill_random( data, sizeof( data ) );
+    switch( test_rand() % 6 )
+    {
+      case 0:
+        CHECK( SecureElementSetKey( key_id, data ) == RefSecureElementSetKey( key_id, data ) );
+        break;
+      case 1:
+      {
+        KeyIdentifier_t target_id = test_keys[test_rand() % TEST_KEYS];
+
+        CHECK( SecureElementDeriveAndStoreKey( version, data, key_id, target_id )
+               == RefSecureElementDeriveAndStoreKey( version, data, key_id, target_id ) );
+        break;
+      }
+      case 2:
+      case 3:
+        cmac = 0;
+        ref_cmac = 0;
+        CHECK( SecureElementComputeAesCmac( micBx, data, size, key_id, &cmac )
+               == RefSecureElementComputeAesCmac( micBx, data, size, key_id, &ref_cmac ) );
+        CHECK( cmac == ref_cmac );
+        break;
+      case 4:
+        ref_cmac = 0;
+        RefSecureElementComputeAesCmac( NULL, data, size, key_id, &ref_cmac );
+        ref_cmac ^= ( test_rand() & 1 );
+        CHECK( SecureElementVerifyAesCmac( data, size, ref_cmac, key_id )
+               == RefSecureElementVerifyAesCmac( data, size, ref_cmac, key_id ) );
+        break;
+      default:
+        size = ( uint16_t ) ( 16 * ( 1 + test_rand() % 4 ) );
+        memset( out, 0, sizeof( out ) );
+        memset( ref_out, 0, sizeof( ref_out ) );
+        CHECK( SecureElementAesEncrypt( data, size, key_id, out )
+               == RefSecureElementAesEncrypt( data, size, key_id, ref_out ) );
+        CHECK_MEM( out, ref_out, size );
+        break;
+    }
+  }
+}
+
+static void test_random_seed( void )
+{
+  uint8_t saved[SE_RANDOM_SEED_SIZE];
+  uint8_t seed[SE_RANDOM_SEED_SIZE];
+  uint8_t next[SE_RANDOM_SEED_SIZE];
+  uint32_t random_num = 0;
+
+  CHECK( SecureElementSetRandomSeed( NULL ) == SECURE_ELEMENT_ERROR_NPE );
+  CHECK( SecureElementGetRandomSeed( NULL ) == SECURE_ELEMENT_ERROR_NPE );
+
+  // Before the first random number: kept for the seeding
+  fill_random( saved, sizeof( saved ) );
+  CHECK( SecureElementSetRandomSeed( saved ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( SecureElementGetRandomSeed( seed ) == SECURE_ELEMENT_SUCCESS );
+  CHECK_MEM( seed, saved, sizeof( seed ) );
+  CHECK( SecureElementRandomNumber( &random_num ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( SecureElementGetRandomSeed( seed ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( memcmp( seed, saved, sizeof( seed ) ) != 0 );
+
+  // Seeded: mixed in, the seed for the next boot is replaced
+  CHECK( SecureElementSetRandomSeed( saved ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( SecureElementGetRandomSeed( next ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( memcmp( next, saved, sizeof( next ) ) != 0 );
+  CHECK( memcmp( next, seed, sizeof( next ) ) != 0 );
+}
+
+#if defined( TEST_BENCH )
+/**
+  * @brief  Secure element calls of LoRaMacCrypto.c for a 51 byte uplink and downlink:
+  *         the FRMPayload and the FOpts block by block, the MIC over B0 and the message
+  */
+static void bench( const char *name, bool b_ref, uint32_t runs )
+{
+  static uint8_t data[TEST_MAX_SIZE];
+  uint8_t b0[16] = { 0x49 };
+  uint32_t cmac = 0;
+  double start = test_cpu_time();
+
+  for( uint32_t i = 0; i < runs; i++ )
+  {
+    for( uint8_t block = 0; block < 4; block++ )
+    {
+      ( b_ref ? RefSecureElementAesEncrypt : SecureElementAesEncrypt )( b0, 16, APP_S_KEY, &data[block * 16] );
+    }
+    ( b_ref ? RefSecureElementAesEncrypt : SecureElementAesEncrypt )( b0, 16, NWK_S_KEY, data );
+    if( name[0] == 'u' )
+    {
+      ( b_ref ? RefSecureElementComputeAesCmac : SecureElementComputeAesCmac )( b0, data, 64, NWK_S_KEY, &cmac );
+    }
+    else
+    {
+      ( b_ref ? RefSecureElementVerifyAesCmac : SecureElementVerifyAesCmac )( data, 64, cmac, NWK_S_KEY );
+    }
+  }
+  printf( "  %-8s %-9s %8.3f us\n", name, b_ref ? "reference" : "cached", ( test_cpu_time() - start ) * 1e6 / runs );
+}
+#endif /* TEST_BENCH */
+
+int main( void )
+{
+  CHECK( SecureElementInit( NULL ) == SECURE_ELEMENT_SUCCESS );
+  CHECK( RefSecureElementInit( NULL ) == SECURE_ELEMENT_SUCCESS );
+
+#if defined( TEST_BENCH )
+  // Host CPU time, relative figures between the cached and the reference element
+  bench( "uplink", true, 200000 );
+  bench( "uplink", false, 200000 );
+  bench( "downlink", true, 200000 );
+  bench( "downlink", false, 200000 );
+#else
+  test_random_seed();
+  test_random_calls( 100000 );
+#endif /* TEST_BENCH */
+
+  return TEST_END();
+}
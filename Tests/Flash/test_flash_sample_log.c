@@ -0,0 +1,458 @@
+/**
+* @file test_flash_sample_log.c
+* @brief Tests of the store-and-forward sample log (flash_sample_log.c).
+*
+* flash_sample_log.c is included, its pages are mapped at
+* FLASH_SAMPLE_LOG_START_ADDRESS. The flash stub programs double-words like the
+* STM32WL: only erased double-words, whole pages erased. A reset clears the
+* state of the module and runs flash_sample_log_init() on the flash content.
+* Checks:
+* - the CRC-8 of the records is the CRC-8 (polynomial 0x07) of bytes 1..7,
+*   a record with one or two bits flipped is never read
+* - the samples are packed and unpacked with the ranges and escape values of
+*   flash_sample_log.h
+* - the samples come back oldest first over several peeks, a peek without
+*   confirm returns the same samples again, the ages are within a minute
+* - the read position and the pending count survive a reset, the records
+*   written before it have an unknown age
+* - the log wraps over its pages, the oldest samples are lost, the rest comes
+*   back in order and the pending count matches the samples read
+* - a torn record is skipped, a failed program leaves the log unchanged
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "test.h"
+#include "utilities.h"
+#include "stm32_systime.h"
+#include "eeprom_emul_types.h"
+
+// HAL definitions used by flash_sample_log.c, the flash interface needs the device headers
+#define __FLASH_INTERFACE_H
+#define __EEPROM_H__
+#define __IO                                        volatile
+#define FLASH_BASE                                  0x08000000U
+
+typedef enum
+{
+  HAL_OK = 0,
+  HAL_ERROR
+} HAL_StatusTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock( void );
+HAL_StatusTypeDef HAL_FLASH_Lock( void );
+HAL_StatusTypeDef FI_WriteDoubleWord( uint32_t Address, uint64_t Data );
+EE_Status FI_PageErase( uint32_t Page, uint16_t NbPages );
+void FI_CacheFlush( void );
+
+#include "flash_sample_log.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_LOG_SIZE                               ( FLASH_SAMPLE_LOG_PAGES_NUMBER * FLASH_SAMPLE_LOG_PAGE_SIZE )
+#define TEST_MAX_SAMPLES                            ( TEST_LOG_SIZE / 8 )
+#define TEST_PEEK_SIZE                              20
+#define TEST_SAMPLE_PERIOD                          90                                // [s]
+#define TEST_UNKNOWN                                ( ( int16_t ) TEMPERATURE_UNKNOWN )
+
+// Variables -------------------------------------------------------------------
+__IO uint32_t ErasingOnGoing = 0;
+
+static uint8_t *flash_log = NULL;
+static bool b_locked = true;
+static bool b_program_fails = false;
+static bool b_program_torn = false;
+static uint32_t u32_programs = 0;
+static uint32_t u32_erases = 0;
+static uint32_t u32_now_s = 1000000;
+
+static uint32_t u32_next_sample = 0;                 // Number of the next sample appended
+static uint32_t sample_times[TEST_MAX_SAMPLES];      // Time of each sample appended since the last test_log_reset()
+
+// Stubs -----------------------------------------------------------------------
+HAL_StatusTypeDef HAL_FLASH_Unlock( void )
+{
+  b_locked = false;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock( void )
+{
+  b_locked = true;
+  return HAL_OK;
+}
+
+// A double-word is only programmed when erased, a torn program leaves its lowest 0 bit at 1
+HAL_StatusTypeDef FI_WriteDoubleWord( uint32_t Address, uint64_t Data )
+{
+  uint64_t *dw = ( uint64_t * ) ( uintptr_t ) Address;
+
+  CHECK( !b_locked );
+  CHECK( ( Address >= FLASH_SAMPLE_LOG_START_ADDRESS ) && ( Address < ( FLASH_SAMPLE_LOG_START_ADDRESS + TEST_LOG_SIZE ) ) );
+  CHECK( ( Address % 8 ) == 0 );
+  if( b_program_fails )
+  {
+    return HAL_ERROR;
+  }
+  CHECK( *dw == FLASH_SAMPLE_LOG_ERASED );
+
+  *dw = b_program_torn ? ( Data | ( ~Data & ( Data + 1 ) ) ) : Data;
+  u32_programs++;
+  return HAL_OK;
+}
+
+EE_Status FI_PageErase( uint32_t Page, uint16_t NbPages )
+{
+  uint32_t u32_address = FLASH_BASE + ( Page * FLASH_SAMPLE_LOG_PAGE_SIZE );
+
+  CHECK( !b_locked );
+  CHECK( NbPages == 1 );
+  CHECK( ( u32_address >= FLASH_SAMPLE_LOG_START_ADDRESS ) && ( u32_address < ( FLASH_SAMPLE_LOG_START_ADDRESS + TEST_LOG_SIZE ) ) );
+
+  memset( ( void * ) ( uintptr_t ) u32_address, 0xFF, FLASH_SAMPLE_LOG_PAGE_SIZE );
+  u32_erases++;
+  return EE_OK;
+}
+
+void FI_CacheFlush( void )
+{
+}
+
+SysTime_t SysTimeGet( void )
+{
+  SysTime_t time = { .Seconds = u32_now_s, .SubSeconds = 0 };
+
+  return time;
+}
+
+// Functions -------------------------------------------------------------------
+// CRC-8, polynomial 0x07, of the bytes 1..7 of a record, MSB first
+static uint8_t test_crc8( uint64_t u64_record )
+{
+  uint8_t u8_crc = 0;
+
+  for( uint8_t byte = 1; byte < 8; byte++ )
+  {
+    for( int8_t bit = 7; bit >= 0; bit-- )
+    {
+      bool b_in = ( ( u64_record >> ( byte * 8 + bit ) ) & 1 ) != 0;
+      bool b_top = ( u8_crc & 0x80 ) != 0;
+
+      u8_crc = ( uint8_t ) ( u8_crc << 1 );
+      if( b_in != b_top )
+      {
+        u8_crc ^= 0x07;
+      }
+    }
+  }
+
+  return u8_crc;
+}
+
+// Sample number n, the NTC temperature and the supply voltage carry n
+static app_sample_t test_sample( uint32_t u32_number )
+{
+  app_sample_t sample = { .i16_ntc_temperature      = ( int16_t ) ( ( u32_number % 4000 ) - 2000 ),
+                          .i16_HDC2080_temperature  = ( int16_t ) ( u32_number / 4000 ),
+                          .u8_HDC2080_humidity      = ( uint8_t ) ( u32_number % 101 ),
+                          .u16_supply_voltage       = ( uint16_t ) ( 1000 + ( ( u32_number % 256 ) * 20 ) ) };
+
+  return sample;
+}
+
+static bool test_sample_equal( const app_sample_t *a, const app_sample_t *b )
+{
+  return ( a->i16_ntc_temperature == b->i16_ntc_temperature ) && ( a->i16_HDC2080_temperature == b->i16_HDC2080_temperature ) &&
+         ( a->u8_HDC2080_humidity == b->u8_HDC2080_humidity ) && ( a->u16_supply_voltage == b->u16_supply_voltage );
+}
+
+static void test_append( uint32_t u32_count )
+{
+  for( uint32_t i = 0; i < u32_count; i++ )
+  {
+    app_sample_t sample = test_sample( u32_next_sample );
+
+    u32_now_s += TEST_SAMPLE_PERIOD;
+    CHECK( flash_sample_log_append( &sample ) );
+    sample_times[u32_next_sample % TEST_MAX_SAMPLES] = u32_now_s;
+    u32_next_sample++;
+  }
+}
+
+// Power up: the state of the module is lost, the flash is kept
+static void test_reboot( void )
+{
+  u32_write_pos       = 0;
+  u32_read_pos        = 0;
+  u32_oldest_pos      = 0;
+  u32_boot_pos        = 0;
+  u32_peek_end_pos    = 0;
+  u32_pending         = 0;
+  u32_time_base_s     = 0;
+  b_time_base_in_page = false;
+  flash_sample_log_init();
+}
+
+// An erased log
+static void test_log_reset( void )
+{
+  memset( flash_log, 0xFF, TEST_LOG_SIZE );
+  u32_next_sample = 0;
+  test_reboot();
+  CHECK( flash_sample_log_is_empty() );
+}
+
+/**
+  * @brief  Drains the log in peeks of u8_peek_size samples.
+  * @param[in] u32_first Number of the oldest sample expected.
+  * @param[in] u32_boot First sample appended after the last reboot, the older ones have an unknown age.
+  * @return Number of samples read
+  */
+static uint32_t test_drain( uint8_t u8_peek_size, uint32_t u32_first, uint32_t u32_boot )
+{
+  app_sample_t samples[UINT8_MAX];
+  uint32_t ages[UINT8_MAX];
+  uint32_t u32_read = 0;
+  uint8_t u8_count;
+
+  while( ( u8_count = flash_sample_log_peek( samples, ages, u8_peek_size ) ) != 0 )
+  {
+    for( uint8_t i = 0; i < u8_count; i++ )
+    {
+      uint32_t u32_number = u32_first + u32_read + i;
+      app_sample_t expected = test_sample( u32_number );
+
+      CHECK( test_sample_equal( &samples[i], &expected ) );
+      if( u32_number < u32_boot )
+      {
+        CHECK( ages[i] == FLASH_SAMPLE_LOG_AGE_UNKNOWN );
+      }
+      else
+      {
+        uint32_t u32_age = u32_now_s - sample_times[u32_number % TEST_MAX_SAMPLES];
+
+        CHECK( ( ages[i] >= u32_age ) && ( ages[i] < ( u32_age + 60 ) ) );
+      }
+    }
+    CHECK( flash_sample_log_confirm_peek() );
+    u32_read += u8_count;
+  }
+  CHECK( flash_sample_log_is_empty() );
+
+  return u32_read;
+}
+
+static void test_crc( void )
+{
+  test_rand_state = 1;
+  for( uint32_t n = 0; n < 2000; n++ )
+  {
+    uint64_t u64_payload = ( ( ( uint64_t ) test_rand() << 32 ) | test_rand() ) >> 10;
+    flash_sample_log_record_type_t type = ( flash_sample_log_record_type_t ) ( test_rand() % 4 );
+    uint64_t u64_record = flash_sample_log_make_record( type, u64_payload );
+    flash_sample_log_record_type_t read_type = FLASH_SAMPLE_LOG_RECORD_HEADER;
+    uint64_t u64_read = 0;
+
+    CHECK( ( uint8_t ) u64_record == test_crc8( u64_record ) );
+
+    // Written at the first slot of the log
+    memset( flash_log, 0xFF, 8 );
+    memcpy( flash_log, &u64_record, 8 );
+    CHECK( flash_sample_log_read_record( 0, &read_type, &u64_read ) );
+    CHECK( ( read_type == type ) && ( u64_read == u64_payload ) );
+
+    // One and two bits flipped
+    for( uint8_t a = 0; ( a < 64 ) && ( n < 20 ); a++ )
+    {
+      for( uint8_t b = a; b < 64; b++ )
+      {
+        uint64_t u64_flipped = u64_record ^ ( 1ULL << a ) ^ ( ( a != b ) ? ( 1ULL << b ) : 0 );
+
+        memcpy( flash_log, &u64_flipped, 8 );
+        CHECK( !flash_sample_log_read_record( 0, &read_type, &u64_read ) );
+      }
+    }
+  }
+  memset( flash_log, 0xFF, 8 );
+}
+
+static void test_pack( void )
+{
+  static const struct
+  {
+    app_sample_t sample;
+    app_sample_t unpacked;
+  } cases[] =
+  {
+    { { 215, -40, 3010, 45 },                                     { 215, -40, 3020, 45 } },
+    { { 2047, -2047, 1000, 100 },                                 { 2047, -2047, 1000, 100 } },
+    { { 3000, -3000, 6100, 101 },                                 { 2047, TEST_UNKNOWN, 6100, APP_SAMPLES_HUMIDITY_INVALID } },
+    { { TEST_UNKNOWN, ( int16_t ) TEMPERATURE_OVERFLOW, 900, 0 }, { TEST_UNKNOWN, TEST_UNKNOWN, 1000, 0 } },
+    { { ( int16_t ) TEMPERATURE_UNDERFLOW, 0, 9999, 255 },        { TEST_UNKNOWN, 0, 1000 + 255 * 20, APP_SAMPLES_HUMIDITY_INVALID } },
+    { { -1, 1, 1009, 1 },                                         { -1, 1, 1000, 1 } },
+    { { -1, 1, 1010, 1 },                                         { -1, 1, 1020, 1 } },
+  };
+
+  for( uint8_t i = 0; i < sizeof( cases ) / sizeof( cases[0] ); i++ )
+  {
+    app_sample_t unpacked;
+    uint32_t u32_offset_min = 0;
+
+    flash_sample_log_unpack_sample( flash_sample_log_pack_sample( &cases[i].sample, 12345 ), &unpacked, &u32_offset_min );
+    CHECK( test_sample_equal( &unpacked, &cases[i].unpacked ) );
+    CHECK( u32_offset_min == 12345 );
+  }
+}
+
+static void test_drain_and_backfill( void )
+{
+  app_sample_t samples[TEST_PEEK_SIZE];
+  uint32_t ages[TEST_PEEK_SIZE];
+  uint32_t u32_boot;
+
+  test_log_reset();
+  CHECK( flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE ) == 0 );
+  CHECK( flash_sample_log_confirm_peek() );
+
+  // A peek without confirm: the same samples again
+  test_append( 50 );
+  CHECK( !flash_sample_log_is_empty() );
+  CHECK( flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE ) == TEST_PEEK_SIZE );
+  CHECK( flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE ) == TEST_PEEK_SIZE );
+  CHECK( flash_sample_log_peek( samples, ages, 0 ) == 0 );
+  CHECK( flash_sample_log_confirm_peek() );
+  CHECK( u32_pending == 50 );
+  CHECK( test_drain( TEST_PEEK_SIZE, 0, 0 ) == 50 );
+
+  // Partly drained, then a reset: the rest comes back with an unknown age
+  test_append( 100 );
+  CHECK( flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE ) == TEST_PEEK_SIZE );
+  CHECK( flash_sample_log_confirm_peek() );
+  u32_boot = u32_next_sample;
+  test_reboot();
+  CHECK( u32_pending == 100 - TEST_PEEK_SIZE );
+  test_append( 30 );
+  CHECK( test_drain( 7, 50 + TEST_PEEK_SIZE, u32_boot ) == ( 100 - TEST_PEEK_SIZE + 30 ) );
+
+  // Drained log after a reset
+  test_reboot();
+  CHECK( flash_sample_log_is_empty() );
+  CHECK( flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE ) == 0 );
+
+  // Time base records: one per page and after more than FLASH_SAMPLE_LOG_MAX_OFFSET_MIN minutes
+  test_append( 2 );
+  u32_now_s += ( FLASH_SAMPLE_LOG_MAX_OFFSET_MIN + 1 ) * 60;
+  test_append( 2 );
+  CHECK( test_drain( TEST_PEEK_SIZE, u32_next_sample - 4, u32_boot ) == 4 );
+}
+
+static void test_wrap( void )
+{
+  uint32_t u32_capacity = FLASH_SAMPLE_LOG_PAGES_NUMBER * ( FLASH_SAMPLE_LOG_SLOTS_PER_PAGE - 2 );
+  uint32_t u32_count = 3 * u32_capacity + 77;
+  uint32_t u32_read = 0;
+  uint32_t u32_pending_before = 0;
+
+  // Nothing drained: the newest samples still in flash come back in order
+  test_log_reset();
+  u32_programs = 0;
+  u32_erases = 0;
+  test_append( u32_count );
+  printf( "  %u samples: %.3f double-words programmed per sample, %u page erases\n", u32_count,
+          ( double ) u32_programs / u32_count, u32_erases );
+  CHECK( u32_erases == ( ( u32_count - 1 ) / ( FLASH_SAMPLE_LOG_SLOTS_PER_PAGE - 2 ) ) );
+  CHECK( u32_pending <= u32_capacity );
+  CHECK( u32_pending > ( u32_capacity - 2 * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE ) );
+
+  u32_pending_before = u32_pending;
+  test_reboot();
+  CHECK( u32_pending == u32_pending_before );
+  u32_read = test_drain( UINT8_MAX, u32_count - u32_pending_before, u32_count );
+  CHECK( u32_read == u32_pending_before );
+
+  // Draining slower than appending, across several wraps
+  for( uint32_t round = 0; round < 40; round++ )
+  {
+    app_sample_t samples[TEST_PEEK_SIZE];
+    uint32_t ages[TEST_PEEK_SIZE];
+    uint32_t u32_expected;
+    uint8_t u8_count;
+
+    // The pending samples are the newest ones
+    test_append( 150 );
+    u32_expected = u32_next_sample - u32_pending;
+    u8_count = flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE );
+    CHECK( u8_count == TEST_PEEK_SIZE );
+    for( uint8_t i = 0; i < u8_count; i++ )
+    {
+      app_sample_t expected = test_sample( u32_expected + i );
+
+      CHECK( test_sample_equal( &samples[i], &expected ) );
+    }
+    CHECK( flash_sample_log_confirm_peek() );
+  }
+  u32_read = u32_pending;
+  CHECK( test_drain( UINT8_MAX, u32_next_sample - u32_pending, 0 ) == u32_read );
+}
+
+static void test_faults( void )
+{
+  app_sample_t sample = test_sample( 0 );
+  uint32_t u32_pending_before;
+
+  // A failed program: not appended, the next append uses the same slot
+  test_log_reset();
+  test_append( 10 );
+  b_program_fails = true;
+  CHECK( !flash_sample_log_append( &sample ) );
+  b_program_fails = false;
+  CHECK( u32_pending == 10 );
+  test_append( 5 );
+  CHECK( test_drain( TEST_PEEK_SIZE, 0, 0 ) == 15 );
+
+  // A record torn by a reset: skipped by the peeks and by the count of the init
+  test_append( 10 );
+  b_program_torn = true;
+  sample = test_sample( 999999 );
+  CHECK( flash_sample_log_append( &sample ) );
+  b_program_torn = false;
+  u32_pending_before = u32_pending - 1;
+  test_reboot();
+  CHECK( u32_pending == u32_pending_before );
+  test_append( 5 );
+  {
+    app_sample_t samples[TEST_PEEK_SIZE];
+    uint32_t ages[TEST_PEEK_SIZE];
+    uint8_t u8_count = flash_sample_log_peek( samples, ages, TEST_PEEK_SIZE );
+
+    CHECK( u8_count == 15 );
+    for( uint8_t i = 0; i < u8_count; i++ )
+    {
+      app_sample_t expected = test_sample( 15 + i );
+
+      CHECK( test_sample_equal( &samples[i], &expected ) );
+    }
+    CHECK( flash_sample_log_confirm_peek() );
+  }
+  CHECK( flash_sample_log_is_empty() );
+}
+
+int main( void )
+{
+  flash_log = mmap( ( void * ) ( uintptr_t ) FLASH_SAMPLE_LOG_START_ADDRESS, TEST_LOG_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+  if( flash_log != ( uint8_t * ) ( uintptr_t ) FLASH_SAMPLE_LOG_START_ADDRESS )
+  {
+    printf( "  the log pages cannot be mapped at 0x%08X\n", FLASH_SAMPLE_LOG_START_ADDRESS );
+    return EXIT_FAILURE;
+  }
+
+  test_crc();
+  test_pack();
+  test_drain_and_backfill();
+  test_wrap();
+  test_faults();
+
+  return TEST_END();
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Old and new images of the delta patch test (test_delta_patch.c)
+
+    delta_images.py edit|random|same out_dir
+
+writes out_dir/<name>.old and out_dir/<name>.new, the same bytes on every host:
+- edit:   a firmware-like image and a new build with inserted, removed and
+          relocated code, changed constants and a longer end
+- random: a new image which has nothing in common with the old one
+- same:   the same image again
+"""
+
+import os
+import random
+import struct
+import sys
+
+
+def firmware(rng, size):
+    """Thumb-like code: a few frequent half-words, literal pools of addresses"""
+    out = bytearray()
+    opcodes = [rng.getrandbits(16) for _ in range(64)]
+    while len(out) < size:
+        if rng.random() < 0.05:
+            for _ in range(rng.randint(1, 6)):
+                out += struct.pack("<I", 0x08000000 + rng.getrandbits(16) * 4)
+        else:
+            out += struct.pack("<H", rng.choice(opcodes))
+    return out[:size]
+
+
+def edit(rng, old):
+    new = bytearray(old)
+    # Relocated literals: the addresses of a region move by 0x40
+    for pos in range(4096, 8192, 4):
+        value = struct.unpack_from("<I", new, pos)[0]
+        if (value >> 24) == 0x08:
+            struct.pack_into("<I", new, pos, value + 0x40)
+    # A changed constant every now and then
+    for _ in range(20):
+        pos = rng.randrange(len(new))
+        new[pos] ^= 1 << rng.randrange(8)
+    # New function, removed function, longer end
+    new[10000:10000] = firmware(rng, 700)
+    del new[15000:15300]
+    new += firmware(rng, 1500)
+    return bytes(new)
+
+
+def main():
+    name, out_dir = sys.argv[1], sys.argv[2]
+    rng = random.Random(name)
+
+    if name == "edit":
+        old = bytes(firmware(rng, 24000))
+        new = edit(rng, old)
+    elif name == "random":
+        old = bytes(firmware(rng, 6000))
+        new = bytes(rng.getrandbits(8) for _ in range(5000))
+    elif name == "same":
+        old = bytes(firmware(rng, 4321))
+        new = old
+    else:
+        sys.exit("unknown image pair " + name)
+
+    os.makedirs(out_dir, exist_ok=True)
+    with open(os.path.join(out_dir, name + ".old"), "wb") as f:
+        f.write(old)
+    with open(os.path.join(out_dir, name + ".new"), "wb") as f:
+        f.write(new)
+
+
+if __name__ == "__main__":
+    main()
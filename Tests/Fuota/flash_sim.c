@@ -0,0 +1,126 @@
+/**
+* @file flash_sim.c
+* @brief Simulated STM32WL flash behind the FragDecoder callbacks.
+*
+* The flash is programmed in double-words, a programmed double-word can only
+* be written again after its page is erased. A write to programmed
+* double-words is counted like the firmware does it: erase the page, then
+* program the old content of the page and the new data again.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <string.h>
+#include "flash_sim.h"
+
+// Variables -------------------------------------------------------------------
+static uint8_t flash[FLASH_SIM_SIZE];
+static uint8_t programmed[FLASH_SIM_SIZE / 8];
+static flash_sim_stats_t stats;
+
+// Prototypes ------------------------------------------------------------------
+static uint8_t flash_sim_erase( uint32_t addr, uint32_t size );
+static uint8_t flash_sim_write( uint32_t addr, uint8_t *data, uint32_t size );
+static uint8_t flash_sim_read( uint32_t addr, uint8_t *data, uint32_t size );
+
+FragDecoderCallbacks_t flash_sim_callbacks =
+{
+  .FragDecoderErase = flash_sim_erase,
+  .FragDecoderWrite = flash_sim_write,
+  .FragDecoderRead  = flash_sim_read,
+};
+
+// Functions -------------------------------------------------------------------
+void flash_sim_reset( void )
+{
+  memset( flash, 0xFF, sizeof( flash ) );
+  memset( programmed, 0, sizeof( programmed ) );
+  memset( &stats, 0, sizeof( stats ) );
+}
+
+const uint8_t *flash_sim_data( void )
+{
+  return flash;
+}
+
+flash_sim_stats_t flash_sim_get_stats( void )
+{
+  return stats;
+}
+
+static uint8_t flash_sim_erase( uint32_t addr, uint32_t size )
+{
+  stats.u32_erase_calls++;
+  if( ( size == 0 ) || ( addr + size > FLASH_SIM_SIZE ) )
+  {
+    stats.u32_range_errors++;
+    return ( uint8_t ) -1;
+  }
+
+  for( uint32_t page = addr / FLASH_SIM_PAGE_SIZE; page <= ( addr + size - 1 ) / FLASH_SIM_PAGE_SIZE; page++ )
+  {
+    memset( &flash[page * FLASH_SIM_PAGE_SIZE], 0xFF, FLASH_SIM_PAGE_SIZE );
+    memset( &programmed[page * FLASH_SIM_PAGE_SIZE / 8], 0, FLASH_SIM_PAGE_SIZE / 8 );
+    stats.u32_page_erases++;
+  }
+  return 0;
+}
+
+static uint8_t flash_sim_write( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  stats.u32_write_calls++;
+  if( ( size == 0 ) || ( addr + size > FLASH_SIM_SIZE ) )
+  {
+    stats.u32_range_errors++;
+    return ( uint8_t ) -1;
+  }
+
+  for( uint32_t page = addr / FLASH_SIM_PAGE_SIZE; page <= ( addr + size - 1 ) / FLASH_SIM_PAGE_SIZE; page++ )
+  {
+    uint32_t lo = ( addr > page * FLASH_SIM_PAGE_SIZE ) ? addr : ( page * FLASH_SIM_PAGE_SIZE );
+    uint32_t hi = ( ( addr + size ) < ( page + 1 ) * FLASH_SIM_PAGE_SIZE ) ? ( addr + size ) : ( ( page + 1 ) * FLASH_SIM_PAGE_SIZE );
+    uint8_t b_rewrite = 0;
+
+    for( uint32_t dw = lo / 8; dw < ( hi + 7 ) / 8; dw++ )
+    {
+      b_rewrite |= programmed[dw];
+    }
+
+    if( b_rewrite )
+    {
+      // Erase the page and restore the double-words not covered by the write
+      stats.u32_page_erases++;
+      for( uint32_t dw = page * FLASH_SIM_PAGE_SIZE / 8; dw < ( page + 1 ) * FLASH_SIM_PAGE_SIZE / 8; dw++ )
+      {
+        if( programmed[dw] && ( ( dw * 8 < lo ) || ( dw * 8 + 8 > hi ) ) )
+        {
+          stats.u32_dw_programs++;
+        }
+      }
+    }
+
+    for( uint32_t dw = lo / 8; dw < ( hi + 7 ) / 8; dw++ )
+    {
+      if( !programmed[dw] || !b_rewrite || ( dw * 8 >= lo && dw * 8 + 8 <= hi ) )
+      {
+        stats.u32_dw_programs++;
+      }
+      programmed[dw] = 1;
+    }
+  }
+
+  memcpy( &flash[addr], data, size );
+  return 0;
+}
+
+static uint8_t flash_sim_read( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  stats.u32_read_calls++;
+  if( addr + size > FLASH_SIM_SIZE )
+  {
+    stats.u32_range_errors++;
+    return ( uint8_t ) -1;
+  }
+
+  memcpy( data, &flash[addr], size );
+  return 0;
+}
@@ -0,0 +1,37 @@
+/**
+* @file flash_sim.h
+* @brief Simulated STM32WL flash behind the FragDecoder callbacks.
+**/
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+#include "FragDecoder.h"
+#include "sfu_fwimg_regions.h"
+
+// Definitions -----------------------------------------------------------------
+#define FLASH_SIM_PAGE_SIZE                         2048
+#define FLASH_SIM_SIZE                              SFU_SLOT_DWL_1_SIZE
+
+// Typedefs --------------------------------------------------------------------
+typedef struct flash_sim_stats_s
+{
+  uint32_t u32_erase_calls;                 // FragDecoderErase calls
+  uint32_t u32_write_calls;                 // FragDecoderWrite calls
+  uint32_t u32_read_calls;                  // FragDecoderRead calls
+  uint32_t u32_dw_programs;                 // Double-words programmed, including the ones restored after a page erase
+  uint32_t u32_page_erases;                 // Pages erased, by the erase callback or to rewrite programmed double-words
+  uint32_t u32_range_errors;                // Calls outside of the download slot, refused
+} flash_sim_stats_t;
+
+// Variables -------------------------------------------------------------------
+extern FragDecoderCallbacks_t flash_sim_callbacks;
+
+// Prototypes ------------------------------------------------------------------
+void flash_sim_reset( void );
+const uint8_t *flash_sim_data( void );
+flash_sim_stats_t flash_sim_get_stats( void );
+
+#endif /* __FLASH_SIM_H__ */
@@ -0,0 +1,16 @@
+/**
+* @file frag_decoder_ref.c
+* @brief FragDecoder.c of the original tree under other names, the reference
+*        for the output of the reworked decoder.
+**/
+
+// The original file got these from the firmware headers
+#include <stddef.h>
+#include "stm32_mem.h"
+
+#define FragDecoderInit                             RefFragDecoderInit
+#define FragDecoderGetMaxFileSize                   RefFragDecoderGetMaxFileSize
+#define FragDecoderProcess                          RefFragDecoderProcess
+#define FragDecoderGetStatus                        RefFragDecoderGetStatus
+
+#include "Reference/FragDecoder.c"
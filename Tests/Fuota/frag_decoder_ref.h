@@ -0,0 +1,18 @@
+/**
+* @file frag_decoder_ref.h
+* @brief FragDecoder.c of the original tree under other names, see frag_decoder_ref.c.
+**/
+
+#ifndef __FRAG_DECODER_REF_H__
+#define __FRAG_DECODER_REF_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+#include "FragDecoder.h"
+
+// Prototypes ------------------------------------------------------------------
+void RefFragDecoderInit( uint16_t fragNb, uint8_t fragSize, FragDecoderCallbacks_t *callbacks );
+int32_t RefFragDecoderProcess( uint16_t fragCounter, uint8_t *rawData );
+FragDecoderStatus_t RefFragDecoderGetStatus( void );
+
+#endif /* __FRAG_DECODER_REF_H__ */
@@ -0,0 +1,74 @@
+/**
+* @file frag_encoder.c
+* @brief Encoder of the LoRaWAN fragmented data block transport (TS004).
+*
+* Written from the specification, chapter "Fragmentation algorithm", and not
+* from FragDecoder.c, so that the tests do not share a mistake with the
+* decoder. Fragments 1..N are the file rows, fragment N + n is the XOR of the
+* rows selected by parity row n.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <string.h>
+#include "frag_encoder.h"
+
+// Functions -------------------------------------------------------------------
+static int32_t frag_encoder_prbs23( int32_t x )
+{
+  int32_t b0 = x & 1;
+  int32_t b1 = ( x & 32 ) >> 5;
+
+  return ( x >> 1 ) + ( ( b0 ^ b1 ) << 22 );
+}
+
+/**
+  * @brief  Selects the rows XORed into the coded fragment N + n, one byte per row
+  */
+void frag_encoder_parity_row( uint16_t u16_n, uint16_t u16_nb, uint8_t *row )
+{
+  int32_t m = u16_nb;
+  int32_t x = 1 + 1001 * ( int32_t ) u16_n;
+  int32_t mm = ( ( m & ( m - 1 ) ) == 0 ) ? 1 : 0;  // m is a power of two
+  int32_t nb_coeff = 0;
+
+  memset( row, 0, u16_nb );
+  while( nb_coeff < ( m / 2 ) )
+  {
+    int32_t r = 1 << 16;
+
+    while( r >= m )
+    {
+      x = frag_encoder_prbs23( x );
+      r = x % ( m + mm );
+    }
+    row[r] = 1;
+    nb_coeff++;
+  }
+}
+
+/**
+  * @brief  Builds the fragment with the given counter, 1..N uncoded, above N coded
+  */
+void frag_encoder_fragment( const uint8_t *file, uint16_t u16_nb, uint8_t u8_size, uint16_t u16_counter, uint8_t *fragment )
+{
+  static uint8_t row[UINT16_MAX];
+
+  if( u16_counter <= u16_nb )
+  {
+    memcpy( fragment, &file[( u16_counter - 1 ) * u8_size], u8_size );
+    return;
+  }
+
+  frag_encoder_parity_row( u16_counter - u16_nb, u16_nb, row );
+  memset( fragment, 0, u8_size );
+  for( uint16_t i = 0; i < u16_nb; i++ )
+  {
+    if( row[i] != 0 )
+    {
+      for( uint8_t j = 0; j < u8_size; j++ )
+      {
+        fragment[j] ^= file[i * u8_size + j];
+      }
+    }
+  }
+}
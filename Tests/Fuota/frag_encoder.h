@@ -0,0 +1,17 @@
+/**
+* @file frag_encoder.h
+* @brief Encoder of the LoRaWAN fragmented data block transport (TS004), the
+*        sending side of FragDecoder.c for the host tests.
+**/
+
+#ifndef __FRAG_ENCODER_H__
+#define __FRAG_ENCODER_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+
+// Prototypes ------------------------------------------------------------------
+void frag_encoder_parity_row( uint16_t u16_n, uint16_t u16_nb, uint8_t *row );
+void frag_encoder_fragment( const uint8_t *file, uint16_t u16_nb, uint8_t u8_size, uint16_t u16_counter, uint8_t *fragment );
+
+#endif /* __FRAG_ENCODER_H__ */
@@ -0,0 +1,296 @@
+/**
+* @file test_delta_patch.c
+* @brief Tests of DeltaPatch.c with the patches of FuotaDelta/fuota_delta.py.
+*
+* The Makefile builds the images with delta_images.py and the patches with
+* fuota_delta.py into TEST_DELTA_DIR. For each image pair:
+* - the patch rebuilds the new image, also with the padding of the last fragment
+* - a wrong magic, a new image larger than the slot and a truncated patch are
+*   rejected by the header check, nothing is written
+* - a patch for another old image is rejected before anything is written
+* - a wrong hash of the new image, flipped and missing bytes of the body and
+*   random bodies never give DELTA_PATCH_SUCCESS with a wrong image
+* - a failing callback gives DELTA_PATCH_ERROR_IO or _HEADER
+* - the patch is never read past its end and the new image is written in
+*   order and inside the slot
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdlib.h>
+#include "test.h"
+#include "DeltaPatch.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_IMAGE_SIZE                         32768
+#define TEST_FRAG_PADDING                           37
+#define TEST_BODY_FLIPS                             3000
+#define TEST_RANDOM_BODIES                          2000
+
+typedef struct
+{
+  uint8_t Data[TEST_MAX_IMAGE_SIZE];
+  uint32_t Size;
+} test_image_t;
+
+// Variables -------------------------------------------------------------------
+static test_image_t old_image;
+static test_image_t new_image;
+static test_image_t patch;
+static test_image_t written;
+
+static uint32_t u32_slot_size;
+static int32_t i32_fail_countdown = -1;
+static uint32_t u32_callbacks;
+static uint32_t u32_range_errors;
+
+// Functions -------------------------------------------------------------------
+static bool callback_fails( void )
+{
+  u32_callbacks++;
+  if( i32_fail_countdown == 0 )
+  {
+    return true;
+  }
+  if( i32_fail_countdown > 0 )
+  {
+    i32_fail_countdown--;
+  }
+  return false;
+}
+
+static uint8_t read_patch( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  if( ( addr + size ) > patch.Size )
+  {
+    u32_range_errors++;
+    return -1;
+  }
+  if( callback_fails() )
+  {
+    return -1;
+  }
+  memcpy( data, &patch.Data[addr], size );
+  return 0;
+}
+
+// A corrupt old image size is refused like the flash driver refuses an address outside the slot
+static uint8_t read_old( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  if( ( ( addr + size ) > old_image.Size ) || callback_fails() )
+  {
+    return -1;
+  }
+  memcpy( data, &old_image.Data[addr], size );
+  return 0;
+}
+
+static uint8_t write_new( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  if( ( addr != written.Size ) || ( ( addr + size ) > u32_slot_size ) )
+  {
+    u32_range_errors++;
+    return -1;
+  }
+  if( callback_fails() )
+  {
+    return -1;
+  }
+  memcpy( &written.Data[addr], data, size );
+  written.Size += size;
+  return 0;
+}
+
+static uint8_t read_new( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  if( ( addr + size ) > written.Size )
+  {
+    u32_range_errors++;
+    return -1;
+  }
+  if( callback_fails() )
+  {
+    return -1;
+  }
+  memcpy( data, &written.Data[addr], size );
+  return 0;
+}
+
+static DeltaPatchCallbacks_t callbacks = { read_patch, read_old, write_new, read_new };
+
+static void load( const char *name, const char *ext, test_image_t *image )
+{
+  char path[256];
+  FILE *file;
+
+  snprintf( path, sizeof( path ), "%s/%s.%s", TEST_DELTA_DIR, name, ext );
+  file = fopen( path, "rb" );
+  if( file == NULL )
+  {
+    printf( "%s: missing, run the tests with make\n", path );
+    exit( 1 );
+  }
+  image->Size = ( uint32_t ) fread( image->Data, 1, sizeof( image->Data ), file );
+  fclose( file );
+}
+
+static void put_uint32( uint8_t *data, uint32_t u32_value )
+{
+  for( uint8_t i = 0; i < 4; i++ )
+  {
+    data[i] = ( uint8_t ) ( u32_value >> ( 8 * i ) );
+  }
+}
+
+/**
+  * @brief  Applies the patch to the old image into a slot of u32_slot_size bytes
+  */
+static DeltaPatchStatus_t apply( uint32_t u32_patch_size, uint32_t *new_size )
+{
+  DeltaPatchStatus_t status;
+
+  written.Size = 0;
+  u32_callbacks = 0;
+  *new_size = 0;
+  status = DeltaPatchApply( u32_patch_size, u32_slot_size, &callbacks, new_size );
+  CHECK( u32_range_errors == 0 );
+  u32_range_errors = 0;
+  return status;
+}
+
+// A rejected patch may leave a partial image, an accepted one must be the new image
+static bool apply_is_safe( uint32_t u32_patch_size )
+{
+  uint32_t new_size;
+
+  if( apply( u32_patch_size, &new_size ) != DELTA_PATCH_SUCCESS )
+  {
+    return true;
+  }
+  return ( new_size == new_image.Size ) && ( memcmp( written.Data, new_image.Data, new_image.Size ) == 0 );
+}
+
+static void test_apply( void )
+{
+  uint32_t new_size;
+  uint32_t u32_patch_size = patch.Size;
+
+  // As received: the last fragment is padded
+  for( uint8_t i = 0; i < 2; i++ )
+  {
+    for( u32_slot_size = new_image.Size; u32_slot_size <= new_image.Size + 1000; u32_slot_size += 1000 )
+    {
+      CHECK( DeltaPatchCheckHeader( patch.Data, u32_patch_size, u32_slot_size ) );
+      CHECK( apply( u32_patch_size, &new_size ) == DELTA_PATCH_SUCCESS );
+      CHECK( new_size == new_image.Size );
+      CHECK( written.Size == new_image.Size );
+      CHECK_MEM( written.Data, new_image.Data, new_image.Size );
+    }
+    memset( &patch.Data[patch.Size], 0, TEST_FRAG_PADDING );
+    u32_patch_size += TEST_FRAG_PADDING;
+  }
+}
+
+static void test_rejected( void )
+{
+  uint32_t new_size;
+  uint32_t u32_body_size = patch.Size - DELTA_PATCH_HEADER_SIZE;
+  test_image_t *good = malloc( sizeof( test_image_t ) );
+
+  memcpy( good, &patch, sizeof( patch ) );
+  u32_slot_size = new_image.Size;
+
+  // Header: magic, slot size, truncated patch
+  patch.Data[0] ^= 0x01;
+  CHECK( DeltaPatchCheckHeader( patch.Data, patch.Size, u32_slot_size ) == false );
+  CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_ERROR_HEADER );
+  patch.Data[0] ^= 0x01;
+  u32_slot_size = new_image.Size - 1;
+  CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_ERROR_HEADER );
+  u32_slot_size = new_image.Size;
+  CHECK( apply( patch.Size - 1, &new_size ) == DELTA_PATCH_ERROR_HEADER );
+  CHECK( apply( DELTA_PATCH_HEADER_SIZE - 1, &new_size ) == DELTA_PATCH_ERROR_HEADER );
+  CHECK( written.Size == 0 );
+
+  // Made for another old image
+  old_image.Data[old_image.Size / 2] ^= 0x80;
+  CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_ERROR_OLD_IMAGE );
+  CHECK( written.Size == 0 );
+  old_image.Data[old_image.Size / 2] ^= 0x80;
+  put_uint32( &patch.Data[4], old_image.Size + 1 );
+  CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_ERROR_IO );
+  CHECK( written.Size == 0 );
+  memcpy( &patch, good, sizeof( patch ) );
+
+  // Wrong hash of the new image: rebuilt, but refused
+  patch.Data[DELTA_PATCH_HEADER_SIZE - 1] ^= 0x01;
+  CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_ERROR_HASH );
+  memcpy( &patch, good, sizeof( patch ) );
+
+  // Body shorter than the commands
+  for( uint32_t cut = 1; ( cut < 64 ) && ( cut < u32_body_size ); cut += 7 )
+  {
+    put_uint32( &patch.Data[12], u32_body_size - cut );
+    CHECK( apply( patch.Size, &new_size ) != DELTA_PATCH_SUCCESS );
+  }
+  memcpy( &patch, good, sizeof( patch ) );
+
+  // Flipped bits in the body
+  for( uint32_t i = 0; i < TEST_BODY_FLIPS; i++ )
+  {
+    uint32_t pos = DELTA_PATCH_HEADER_SIZE + ( test_rand() % u32_body_size );
+    uint8_t mask = ( uint8_t ) ( 1 << ( test_rand() % 8 ) );
+
+    patch.Data[pos] ^= mask;
+    CHECK( apply_is_safe( patch.Size ) );
+    patch.Data[pos] ^= mask;
+  }
+
+  // Random bodies behind a valid header
+  for( uint32_t i = 0; i < TEST_RANDOM_BODIES; i++ )
+  {
+    for( uint32_t pos = DELTA_PATCH_HEADER_SIZE; pos < patch.Size; pos++ )
+    {
+      patch.Data[pos] = ( uint8_t ) test_rand();
+    }
+    CHECK( apply_is_safe( patch.Size ) );
+  }
+  memcpy( &patch, good, sizeof( patch ) );
+
+  // Every callback failing in turn
+  {
+    uint32_t u32_calls;
+
+    CHECK( apply( patch.Size, &new_size ) == DELTA_PATCH_SUCCESS );
+    u32_calls = u32_callbacks;
+    for( uint32_t n = 0; n < u32_calls; n++ )
+    {
+      DeltaPatchStatus_t status;
+
+      i32_fail_countdown = ( int32_t ) n;
+      status = apply( patch.Size, &new_size );
+      CHECK( status == ( ( n == 0 ) ? DELTA_PATCH_ERROR_HEADER : DELTA_PATCH_ERROR_IO ) );
+    }
+    i32_fail_countdown = -1;
+  }
+
+  free( good );
+}
+
+int main( void )
+{
+  static const char *names[] = { "edit", "random", "same" };
+
+  for( uint8_t i = 0; i < sizeof( names ) / sizeof( names[0] ); i++ )
+  {
+    load( names[i], "old", &old_image );
+    load( names[i], "new", &new_image );
+    load( names[i], "patch", &patch );
+    printf( "  %-6s old %5u bytes, new %5u bytes, patch %5u bytes\n", names[i], old_image.Size, new_image.Size,
+            patch.Size );
+    test_apply();
+    test_rejected();
+  }
+
+  return TEST_END();
+}
@@ -0,0 +1,691 @@
+/**
+* @file test_fuota.c
+* @brief End-to-end tests, fuzzer and benchmark of the fragmentation package
+*        (LmhpFragmentation.c, FragDecoder.c).
+*
+* The fragments are built by frag_encoder.c and go through the package into
+* the decoder and the simulated flash of flash_sim.c:
+* - package commands, FragStatusAns and the multicast group filter
+* - sessions with lost, duplicated and late fragments, the image is compared
+*   byte for byte when the decoder reports it complete
+* - FragDecoderProcess() returns the same as the original decoder
+* - random downlinks, the answers stay in the application buffer and the
+*   decoder stays in the download slot
+* With TEST_FUZZ only the random downlinks run, many more of them, the
+* Makefile builds it with the sanitizers. With TEST_BENCH the decode time,
+* the peak stack and the flash operations of both decoders are printed instead.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "test.h"
+#include "LmHandler.h"
+#include "LmhpFragmentation.h"
+#include "frag_encoder.h"
+#include "frag_decoder_ref.h"
+#include "flash_sim.h"
+
+// Definitions -----------------------------------------------------------------
+#define APP_BUFFER_SIZE                             242
+#define APP_BUFFER_GUARD                            16
+#define TEST_MAX_STREAM                             ( 4 * FRAG_MAX_NB )
+
+#if defined( TEST_FUZZ )
+#define FUZZ_RUNS                                   2000000
+#else
+#define FUZZ_RUNS                                   20000
+#endif /* TEST_FUZZ */
+
+#define BENCH_STACK_PAINT                           32768
+
+// Typedefs --------------------------------------------------------------------
+typedef struct fuota_link_s
+{
+  uint16_t u16_nb;                          // FragNb
+  uint8_t u8_size;                          // FragSize
+  uint8_t u8_padding;                       // Padding at the end of the last fragment
+  uint16_t u16_redundancy;                  // Coded fragments sent after the file
+  uint8_t u8_loss;                          // Lost fragments [%]
+  uint8_t u8_dup;                           // Duplicated fragments [%]
+  uint8_t u8_late;                          // Fragments received after the next one [%]
+} fuota_link_t;
+
+// Variables -------------------------------------------------------------------
+static const fuota_link_t links[] =
+{
+  { 10, 50, 0, 2, 0, 0, 0 },                // No loss
+  { 1, 1, 0, 2, 0, 0, 0 },                  // Smallest file
+  { 20, 48, 7, 10, 10, 5, 5 },
+  { 100, 100, 99, 30, 10, 5, 5 },
+  { 50, 20, 3, 40, 30, 10, 10 },            // Heavy loss
+  { FRAG_MAX_NB, FRAG_MAX_SIZE, 0, FRAG_MAX_REDUNDANCY, 8, 2, 2 },  // Largest file
+};
+
+static LmhPackage_t *package;
+static LmhpFragmentationParams_t params;
+static uint8_t app_buffer[APP_BUFFER_SIZE + APP_BUFFER_GUARD];
+static uint8_t u8_app_buffer_size;
+static uint8_t answer[APP_BUFFER_SIZE];
+static uint8_t u8_answer_size;
+static bool b_done;
+static uint32_t u32_done_size;
+static void ( *timer_callback )( void *context );
+
+static uint8_t file[FRAG_MAX_NB * FRAG_MAX_SIZE];
+static uint16_t stream[TEST_MAX_STREAM];
+static uint8_t ref_flash[FLASH_SIM_SIZE];
+
+// Prototypes ------------------------------------------------------------------
+static uint8_t ref_flash_erase( uint32_t addr, uint32_t size );
+static uint8_t ref_flash_write( uint32_t addr, uint8_t *data, uint32_t size );
+static uint8_t ref_flash_read( uint32_t addr, uint8_t *data, uint32_t size );
+
+static FragDecoderCallbacks_t ref_flash_callbacks =
+{
+  .FragDecoderErase = ref_flash_erase,
+  .FragDecoderWrite = ref_flash_write,
+  .FragDecoderRead  = ref_flash_read,
+};
+
+// Stubs -----------------------------------------------------------------------
+// The delay timer of the delayed answers expires as soon as it is started
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  timer_callback = Callback;
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  timer_callback( NULL );
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+int32_t LmHandlerGetDutyCycleEnable( bool *dutyCycleEnable )
+{
+  *dutyCycleEnable = true;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+int32_t LmHandlerSetDutyCycleEnable( bool dutyCycleEnable )
+{
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+// The multicast address is the group identifier in the tests, McGroupBitMask has 4 groups
+uint8_t LoRaMacMcChannelGetGroupId( uint32_t mcAddress )
+{
+  return ( mcAddress < 4 ) ? ( uint8_t ) mcAddress : 0xFF;
+}
+
+// Functions -------------------------------------------------------------------
+static LmHandlerErrorStatus_t on_send( LmHandlerAppData_t *appData, LmHandlerMsgTypes_t isTxConfirmed,
+                                       TimerTime_t *nextTxIn, bool allowDelayedTx )
+{
+  if( appData->BufferSize > u8_app_buffer_size )
+  {
+    CHECK( appData->BufferSize <= u8_app_buffer_size );
+    return LORAMAC_HANDLER_ERROR;
+  }
+  memcpy( answer, appData->Buffer, appData->BufferSize );
+  u8_answer_size = appData->BufferSize;
+  return LORAMAC_HANDLER_SUCCESS;
+}
+
+static void on_done( int32_t status, uint32_t size )
+{
+  b_done = true;
+  u32_done_size = size;
+}
+
+static uint8_t ref_flash_erase( uint32_t addr, uint32_t size )
+{
+  memset( &ref_flash[addr], 0xFF, size );
+  return 0;
+}
+
+static uint8_t ref_flash_write( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  memcpy( &ref_flash[addr], data, size );
+  return 0;
+}
+
+static uint8_t ref_flash_read( uint32_t addr, uint8_t *data, uint32_t size )
+{
+  memcpy( data, &ref_flash[addr], size );
+  return 0;
+}
+
+static void package_init( uint8_t u8_buffer_size )
+{
+  params.DecoderCallbacks = flash_sim_callbacks;
+  params.OnDone = on_done;
+  u8_app_buffer_size = u8_buffer_size;
+  memset( app_buffer, 0xEE, sizeof( app_buffer ) );
+
+  package = LmhpFragmentationPackageFactory();
+  package->OnSendRequest = on_send;
+  package->Init( &params, app_buffer, u8_buffer_size );
+}
+
+static bool app_buffer_guard_ok( void )
+{
+  for( uint16_t i = u8_app_buffer_size; i < sizeof( app_buffer ); i++ )
+  {
+    if( app_buffer[i] != 0xEE )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void downlink( uint8_t *buffer, uint8_t size, uint8_t multicast, uint32_t dev_addr )
+{
+  McpsIndication_t indication;
+
+  memset( &indication, 0, sizeof( indication ) );
+  indication.Port       = 201;
+  indication.Multicast  = multicast;
+  indication.DevAddress = dev_addr;
+  indication.Buffer     = buffer;
+  indication.BufferSize = size;
+  indication.RxData     = true;
+  u8_answer_size = 0;
+  package->OnMcpsIndicationProcess( &indication );
+}
+
+/**
+  * @brief  Sends a FragSessionSetupReq and returns the status of the answer
+  */
+static uint8_t session_setup( uint8_t u8_index, uint8_t u8_mc_mask, uint8_t u8_control, const fuota_link_t *link )
+{
+  uint8_t req[11] =
+  {
+    0x02, ( uint8_t ) ( ( u8_index << 4 ) | u8_mc_mask ), ( uint8_t ) link->u16_nb, ( uint8_t ) ( link->u16_nb >> 8 ),
+    link->u8_size, u8_control, link->u8_padding, 0x04, 0x03, 0x02, 0x01
+  };
+
+  downlink( req, sizeof( req ), 0, 0 );
+  CHECK( ( u8_answer_size == 2 ) && ( answer[0] == 0x02 ) );
+  return answer[1];
+}
+
+static void send_fragment( uint8_t u8_index, uint16_t u16_counter, const fuota_link_t *link, uint8_t multicast, uint32_t dev_addr )
+{
+  uint8_t dl[3 + FRAG_MAX_SIZE];
+
+  dl[0] = 0x08;
+  dl[1] = ( uint8_t ) u16_counter;
+  dl[2] = ( uint8_t ) ( ( u8_index << 6 ) | ( ( u16_counter >> 8 ) & 0x3F ) );
+  frag_encoder_fragment( file, link->u16_nb, link->u8_size, u16_counter, &dl[3] );
+  downlink( dl, 3 + link->u8_size, multicast, dev_addr );
+}
+
+static void make_file( const fuota_link_t *link )
+{
+  uint32_t u32_size = ( uint32_t ) link->u16_nb * link->u8_size;
+
+  for( uint32_t i = 0; i < u32_size; i++ )
+  {
+    file[i] = ( uint8_t ) test_rand();
+  }
+  memset( &file[u32_size - link->u8_padding], 0, link->u8_padding );
+}
+
+/**
+  * @brief  Fragment counters in the order of reception
+  */
+static uint16_t make_stream( const fuota_link_t *link )
+{
+  uint16_t n = 0;
+
+  for( uint16_t c = 1; c <= link->u16_nb + link->u16_redundancy; c++ )
+  {
+    if( ( test_rand() % 100 ) < link->u8_loss )
+    {
+      continue;
+    }
+    stream[n++] = c;
+    if( ( test_rand() % 100 ) < link->u8_dup )
+    {
+      stream[n++] = c;
+    }
+  }
+
+  for( uint16_t i = 0; i + 1 < n; i++ )
+  {
+    if( ( test_rand() % 100 ) < link->u8_late )
+    {
+      uint16_t c = stream[i];
+
+      stream[i] = stream[i + 1];
+      stream[i + 1] = c;
+      i++;
+    }
+  }
+  return n;
+}
+
+/**
+  * @brief  Uncoded fragments the decoder counts as lost, the late ones included
+  */
+static uint16_t stream_lost( const fuota_link_t *link, uint16_t n )
+{
+  uint16_t u16_last = 0;
+  uint16_t u16_rx = 0;
+
+  for( uint16_t i = 0; i < n; i++ )
+  {
+    if( ( stream[i] <= link->u16_nb ) && ( stream[i] > u16_last ) )
+    {
+      u16_rx++;
+    }
+    if( stream[i] > u16_last )
+    {
+      u16_last = stream[i];
+    }
+  }
+  return link->u16_nb - u16_rx;
+}
+
+static void test_commands( void )
+{
+  const fuota_link_t link = { 10, 10, 0, 5, 0, 0, 0 };
+  fuota_link_t bad_link = link;
+  uint8_t req[4];
+
+  package_init( APP_BUFFER_SIZE );
+  flash_sim_reset();
+  make_file( &link );
+  b_done = false;
+
+  // PackageVersionReq, not answered on multicast
+  req[0] = 0x00;
+  downlink( req, 1, 0, 0 );
+  CHECK( ( u8_answer_size == 3 ) && ( answer[0] == 0x00 ) && ( answer[1] == 3 ) && ( answer[2] == 1 ) );
+  downlink( req, 1, 1, 0 );
+  CHECK( u8_answer_size == 0 );
+
+  // Refused setups
+  bad_link.u16_nb = 0;
+  CHECK( session_setup( 1, 0, 0, &bad_link ) == ( ( 1 << 6 ) | 0x02 ) );
+  bad_link.u16_nb = FRAG_MAX_NB + 1;
+  bad_link.u8_size = 1;
+  CHECK( session_setup( 1, 0, 0, &bad_link ) == ( ( 1 << 6 ) | 0x02 ) );
+  CHECK( session_setup( 1, 0, 1 << 3, &link ) == ( ( 1 << 6 ) | 0x01 ) );
+
+  // Session 2 for multicast group 1
+  CHECK( session_setup( 2, 1 << 1, 0, &link ) == ( 2 << 6 ) );
+  for( uint16_t c = 1; c <= 4; c++ )
+  {
+    send_fragment( 2, c, &link, 1, 1 );
+  }
+  send_fragment( 2, 5, &link, 1, 0 );   // Group 0 is not in the mask
+  send_fragment( 2, 5, &link, 1, 7 );   // Unknown multicast address
+  send_fragment( 1, 5, &link, 0, 0 );   // Session 1 was refused
+
+  // FragStatusReq with participants = 1, the answer is delayed
+  req[0] = 0x01;
+  req[1] = ( 2 << 1 ) | 1;
+  downlink( req, 2, 0, 0 );
+  CHECK( u8_answer_size == 0 );
+  package->Process();
+  package->Process();
+  CHECK( ( u8_answer_size == 5 ) && ( answer[0] == 0x01 ) );
+  CHECK( ( answer[1] == 4 ) && ( answer[2] == ( 2 << 6 ) ) && ( answer[3] == 0 ) && ( answer[4] == 0 ) );
+
+  // The fragments after the lost ones
+  for( uint16_t c = 8; c <= link.u16_nb + link.u16_redundancy; c++ )
+  {
+    send_fragment( 2, c, &link, 1, 1 );
+  }
+  send_fragment( 2, link.u16_nb + link.u16_redundancy, &link, 1, 1 );
+  CHECK( b_done );
+  CHECK( u32_done_size == 100 );
+  CHECK_MEM( flash_sim_data(), file, 100 );
+
+  // FragSessionDeleteReq, then for a session that does not exist
+  req[0] = 0x03;
+  req[1] = 2;
+  downlink( req, 2, 0, 0 );
+  CHECK( ( u8_answer_size == 2 ) && ( answer[0] == 0x03 ) && ( answer[1] == 0x02 ) );
+  downlink( req, 2, 0, 0 );
+  CHECK( ( u8_answer_size == 2 ) && ( answer[1] == ( 0x04 | 0x02 ) ) );
+
+  // Truncated commands end the parsing
+  req[0] = 0x00;
+  req[1] = 0x02;
+  req[2] = 0x00;
+  downlink( req, 3, 0, 0 );
+  CHECK( u8_answer_size == 3 );
+  CHECK( flash_sim_get_stats().u32_range_errors == 0 );
+}
+
+/**
+  * @brief  Runs a session through the package, returns true if the image is complete
+  */
+static bool run_session( const fuota_link_t *link, uint8_t u8_index )
+{
+  uint16_t n;
+
+  make_file( link );
+  n = make_stream( link );
+  b_done = false;
+
+  CHECK( session_setup( u8_index, 0, 0, link ) == ( u8_index << 6 ) );
+  for( uint16_t i = 0; i < n; i++ )
+  {
+    send_fragment( u8_index, stream[i], link, 0, 0 );
+  }
+  // The package reports the end of the session with the next fragment
+  if( n > 0 )
+  {
+    send_fragment( u8_index, stream[n - 1], link, 0, 0 );
+  }
+
+  if( b_done && ( FragDecoderGetStatus().MatrixError == 0 ) )
+  {
+    CHECK( u32_done_size == ( uint32_t ) link->u16_nb * link->u8_size - link->u8_padding );
+    CHECK_MEM( flash_sim_data(), file, u32_done_size );
+    return true;
+  }
+  return false;
+}
+
+static void test_sessions( void )
+{
+  package_init( APP_BUFFER_SIZE );
+  flash_sim_reset();
+
+  for( uint32_t l = 0; l < sizeof( links ) / sizeof( links[0] ); l++ )
+  {
+    const fuota_link_t *link = &links[l];
+    uint32_t runs = ( link->u16_nb == FRAG_MAX_NB ) ? 5 : 50;
+    uint32_t decoded = 0;
+
+    for( uint32_t r = 0; r < runs; r++ )
+    {
+      decoded += run_session( link, r % 4 ) ? 1 : 0;
+    }
+
+    printf( "  FragNb %3u FragSize %3u loss %2u%%: %2u/%2u sessions decoded\n",
+            link->u16_nb, link->u8_size, link->u8_loss, decoded, runs );
+    CHECK( decoded > 0 );
+    if( link->u8_loss == 0 )
+    {
+      CHECK( decoded == runs );
+    }
+  }
+  CHECK( flash_sim_get_stats().u32_range_errors == 0 );
+}
+
+static void test_reference( void )
+{
+  static uint8_t fragment[FRAG_MAX_SIZE];
+  static uint8_t ref_fragment[FRAG_MAX_SIZE];
+
+  for( uint32_t l = 0; l < sizeof( links ) / sizeof( links[0] ); l++ )
+  {
+    const fuota_link_t *link = &links[l];
+
+    for( uint32_t r = 0; r < 20; r++ )
+    {
+      int32_t status = FRAG_SESSION_ONGOING;
+      int32_t ref_status = FRAG_SESSION_ONGOING;
+      uint16_t n;
+
+      make_file( link );
+      n = make_stream( link );
+      // The original decoder overflows its arrays above FRAG_MAX_REDUNDANCY lost fragments
+      if( stream_lost( link, n ) > FRAG_MAX_REDUNDANCY )
+      {
+        continue;
+      }
+
+      flash_sim_reset();
+      FragDecoderInit( link->u16_nb, link->u8_size, &flash_sim_callbacks );
+      RefFragDecoderInit( link->u16_nb, link->u8_size, &ref_flash_callbacks );
+      for( uint16_t i = 0; ( i < n ) && ( ref_status == FRAG_SESSION_ONGOING ); i++ )
+      {
+        FragDecoderStatus_t s;
+        FragDecoderStatus_t ref_s;
+
+        frag_encoder_fragment( file, link->u16_nb, link->u8_size, stream[i], fragment );
+        memcpy( ref_fragment, fragment, link->u8_size );
+        status = FragDecoderProcess( stream[i], fragment );
+        ref_status = RefFragDecoderProcess( stream[i], ref_fragment );
+        CHECK( status == ref_status );
+
+        s = FragDecoderGetStatus();
+        ref_s = RefFragDecoderGetStatus();
+        CHECK( ( s.FragNbRx == ref_s.FragNbRx ) && ( s.FragNbLost == ref_s.FragNbLost ) &&
+               ( s.FragNbLastRx == ref_s.FragNbLastRx ) && ( s.MatrixError == ref_s.MatrixError ) );
+      }
+
+      if( ( status >= 0 ) && ( FragDecoderGetStatus().MatrixError == 0 ) )
+      {
+        CHECK_MEM( flash_sim_data(), file, ( uint32_t ) link->u16_nb * link->u8_size );
+        CHECK_MEM( ref_flash, file, ( uint32_t ) link->u16_nb * link->u8_size );
+      }
+    }
+  }
+}
+
+static void fuzz_put( uint8_t *dl, uint16_t *p, uint16_t size, uint8_t value )
+{
+  if( *p < size )
+  {
+    dl[( *p )++] = value;
+  }
+}
+
+/**
+  * @brief  Random downlinks, the commands are valid more often than random bytes would be
+  */
+static void test_fuzz( uint32_t runs )
+{
+  static uint8_t dl[255];
+  bool b_guard_ok = true;
+
+  flash_sim_reset();
+  for( uint32_t r = 0; r < runs; r++ )
+  {
+    uint16_t size = test_rand() % 256;
+    uint16_t p = 0;
+
+    if( ( r % 1000 ) == 0 )
+    {
+      package_init( ( uint8_t ) ( 1 + test_rand() % APP_BUFFER_SIZE ) );
+    }
+
+    while( p < size )
+    {
+      uint32_t k = test_rand() % 16;
+
+      if( k == 0 )
+      {
+        uint16_t nb = 1 + test_rand() % ( FRAG_MAX_NB + 8 );
+
+        fuzz_put( dl, &p, size, 0x02 );
+        fuzz_put( dl, &p, size, ( uint8_t ) test_rand() );
+        fuzz_put( dl, &p, size, ( uint8_t ) nb );
+        fuzz_put( dl, &p, size, ( uint8_t ) ( nb >> 8 ) );
+        fuzz_put( dl, &p, size, ( uint8_t ) ( 1 + test_rand() % ( FRAG_MAX_SIZE + 8 ) ) );
+        fuzz_put( dl, &p, size, ( uint8_t ) ( test_rand() & 0x07 ) );
+        for( uint8_t i = 0; i < 5; i++ )
+        {
+          fuzz_put( dl, &p, size, ( uint8_t ) test_rand() );
+        }
+      }
+      else if( k < 6 )
+      {
+        uint16_t counter = test_rand() % ( 2 * FRAG_MAX_NB );
+        uint16_t payload = test_rand() % ( FRAG_MAX_SIZE + 8 );
+
+        fuzz_put( dl, &p, size, 0x08 );
+        fuzz_put( dl, &p, size, ( uint8_t ) counter );
+        fuzz_put( dl, &p, size, ( uint8_t ) ( ( counter >> 8 ) | ( test_rand() & 0xC0 ) ) );
+        for( uint16_t i = 0; i < payload; i++ )
+        {
+          fuzz_put( dl, &p, size, ( uint8_t ) test_rand() );
+        }
+      }
+      else
+      {
+        fuzz_put( dl, &p, size, ( k < 12 ) ? ( uint8_t ) ( test_rand() % 4 ) : ( uint8_t ) test_rand() );
+        fuzz_put( dl, &p, size, ( uint8_t ) test_rand() );
+      }
+    }
+
+    downlink( dl, ( uint8_t ) size, ( test_rand() % 4 ) == 0, test_rand() % 6 );
+    if( ( test_rand() % 16 ) == 0 )
+    {
+      package->Process();
+      package->Process();
+    }
+    b_guard_ok &= app_buffer_guard_ok();
+  }
+
+  printf( "  %u random downlinks\n", runs );
+  CHECK( b_guard_ok );
+  CHECK( flash_sim_get_stats().u32_range_errors == 0 );
+}
+
+#if defined( TEST_BENCH )
+static uintptr_t stack_area;
+
+static void __attribute__( ( noinline ) ) stack_paint( void )
+{
+  volatile uint8_t area[BENCH_STACK_PAINT];
+
+  for( uint32_t i = 0; i < BENCH_STACK_PAINT; i++ )
+  {
+    area[i] = 0xA5;
+  }
+  stack_area = ( uintptr_t ) area;
+}
+
+// Stack used below the caller of stack_paint() since it was called
+static uint32_t stack_peak( void )
+{
+  volatile uint8_t *area = ( volatile uint8_t * ) stack_area;
+  uint32_t i = 0;
+
+  while( ( i < BENCH_STACK_PAINT ) && ( area[i] == 0xA5 ) )
+  {
+    i++;
+  }
+  return BENCH_STACK_PAINT - i;
+}
+
+static void __attribute__( ( noinline ) ) bench_decode( bool b_ref, uint16_t n, uint8_t *fragments, uint8_t u8_size )
+{
+  int32_t status = FRAG_SESSION_ONGOING;
+
+  for( uint16_t i = 0; ( i < n ) && ( status == FRAG_SESSION_ONGOING ); i++ )
+  {
+    uint8_t *fragment = &fragments[( uint32_t ) i * u8_size];
+
+    status = b_ref ? RefFragDecoderProcess( stream[i], fragment ) : FragDecoderProcess( stream[i], fragment );
+  }
+}
+
+static void bench( const fuota_link_t *link, uint32_t runs )
+{
+  static uint8_t fragments[TEST_MAX_STREAM * FRAG_MAX_SIZE];
+
+  printf( "  FragNb %3u FragSize %3u loss %2u%%, per session:\n", link->u16_nb, link->u8_size, link->u8_loss );
+  for( int ref = 1; ref >= 0; ref-- )
+  {
+    flash_sim_stats_t total = { 0 };
+    uint32_t u32_stack = 0;
+    uint32_t u32_fragments = 0;
+    double time = 0;
+
+    test_rand_state = 1;
+    for( uint32_t r = 0; r < runs; r++ )
+    {
+      uint16_t n;
+      flash_sim_stats_t stats;
+      double start;
+
+      make_file( link );
+      n = make_stream( link );
+      for( uint16_t i = 0; i < n; i++ )
+      {
+        frag_encoder_fragment( file, link->u16_nb, link->u8_size, stream[i], &fragments[( uint32_t ) i * link->u8_size] );
+      }
+
+      flash_sim_reset();
+      stack_paint();
+      start = test_cpu_time();
+      if( ref )
+      {
+        RefFragDecoderInit( link->u16_nb, link->u8_size, &flash_sim_callbacks );
+      }
+      else
+      {
+        FragDecoderInit( link->u16_nb, link->u8_size, &flash_sim_callbacks );
+      }
+      bench_decode( ref, n, fragments, link->u8_size );
+      time += test_cpu_time() - start;
+      if( stack_peak() > u32_stack )
+      {
+        u32_stack = stack_peak();
+      }
+
+      stats = flash_sim_get_stats();
+      total.u32_erase_calls += stats.u32_erase_calls;
+      total.u32_write_calls += stats.u32_write_calls;
+      total.u32_read_calls  += stats.u32_read_calls;
+      total.u32_dw_programs += stats.u32_dw_programs;
+      total.u32_page_erases += stats.u32_page_erases;
+      u32_fragments += n;
+    }
+
+    printf( "    %-9s %8.3f ms, %6.2f us/fragment, peak stack %5u bytes\n", ref ? "original" : "current",
+            time * 1e3 / runs, time * 1e6 / u32_fragments, u32_stack );
+    printf( "    %-9s flash calls %6.1f erase %7.1f write %7.1f read, %8.1f double-words programmed, %6.1f pages erased\n", "",
+            ( double ) total.u32_erase_calls / runs, ( double ) total.u32_write_calls / runs, ( double ) total.u32_read_calls / runs,
+            ( double ) total.u32_dw_programs / runs, ( double ) total.u32_page_erases / runs );
+  }
+}
+#endif /* TEST_BENCH */
+
+int main( void )
+{
+#if defined( TEST_BENCH )
+  // Host CPU time and stack, relative figures between the decoders and the links
+  static const fuota_link_t bench_links[] =
+  {
+    { 100, 100, 0, 20, 10, 0, 0 },
+    { FRAG_MAX_NB, FRAG_MAX_SIZE, 0, FRAG_MAX_REDUNDANCY, 5, 0, 0 },
+    { FRAG_MAX_NB, FRAG_MAX_SIZE, 0, FRAG_MAX_REDUNDANCY, 12, 0, 0 },
+  };
+
+  for( uint32_t l = 0; l < sizeof( bench_links ) / sizeof( bench_links[0] ); l++ )
+  {
+    bench( &bench_links[l], 20 );
+  }
+#elif defined( TEST_FUZZ )
+  test_fuzz( FUZZ_RUNS );
+#else
+  test_commands();
+  test_sessions();
+  test_reference();
+  test_fuzz( FUZZ_RUNS );
+#endif /* TEST_BENCH */
+
+  return TEST_END();
+}
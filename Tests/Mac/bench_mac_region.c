@@ -0,0 +1,265 @@
+/**
+* @file bench_mac_region.c
+* @brief Benchmark of the MAC with and without the single region binding
+*        (REGION_SINGLE_ENABLED, RegionSingle.h).
+*
+* LoRaMac.c is included and driven through whole unconfirmed uplinks of an ABP
+* device on EU868: LoRaMacMcpsRequest(), TX done, RX1 and RX2 without downlink,
+* then LoRaMacProcess() back to idle. The Makefile builds the program with
+* REGION_SINGLE_ENABLED 0 and 1 and prints the code size of LoRaMac.c and
+* Region.c of both builds ("make bench").
+* Each uplink must reach the radio and give a McpsConfirm.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "stm32_systime.h"
+#include "stm32_timer.h"
+#include "LoRaMac.c"
+
+// Definitions -----------------------------------------------------------------
+#define BENCH_UPLINKS                               200000
+#define BENCH_PAYLOAD_SIZE                          12
+// Longer than the time-off of the band after an uplink, no uplink is delayed
+#define BENCH_UPLINK_PERIOD                         600000
+
+// Variables -------------------------------------------------------------------
+static UTIL_TIMER_Time_t now = 1000;
+static uint32_t u32_sends;
+static uint32_t u32_confirms;
+static bool b_process;
+
+// Stubs -----------------------------------------------------------------------
+static void radio_init( RadioEvents_t *events )
+{
+}
+
+static RadioState_t radio_get_status( void )
+{
+  return RF_IDLE;
+}
+
+static void radio_set_channel( uint32_t freq )
+{
+}
+
+static uint32_t radio_random( void )
+{
+  return test_rand();
+}
+
+static void radio_set_rx_config( RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                 uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                                 uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted,
+                                 bool rxContinuous )
+{
+}
+
+static void radio_set_tx_config( RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,
+                                 uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn,
+                                 bool freqHopOn, uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+}
+
+static bool radio_check_rf_frequency( uint32_t frequency )
+{
+  return true;
+}
+
+static void radio_send( uint8_t *buffer, uint8_t size )
+{
+  u32_sends++;
+}
+
+static void radio_sleep( void )
+{
+}
+
+static void radio_rx( uint32_t timeout )
+{
+}
+
+static void radio_set_max_payload_length( RadioModems_t modem, uint8_t max )
+{
+}
+
+static void radio_set_public_network( bool enable )
+{
+}
+
+static uint32_t radio_get_wakeup_time( void )
+{
+  return 1;
+}
+
+const struct Radio_s Radio =
+{
+  .Init = radio_init, .GetStatus = radio_get_status, .SetChannel = radio_set_channel, .Random = radio_random,
+  .SetRxConfig = radio_set_rx_config, .SetTxConfig = radio_set_tx_config, .CheckRfFrequency = radio_check_rf_frequency,
+  .Send = radio_send, .Sleep = radio_sleep, .Standby = radio_sleep, .Rx = radio_rx,
+  .SetMaxPayloadLength = radio_set_max_payload_length, .SetPublicNetwork = radio_set_public_network,
+  .GetWakeupTime = radio_get_wakeup_time
+};
+
+void GetUniqueId( uint8_t *id )
+{
+  memset( id, 0x42, 8 );
+}
+
+// The timers never fire, the bench calls the events of LoRaMac.c in order
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return now;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return now - past;
+}
+
+SysTime_t SysTimeGet( void )
+{
+  SysTime_t sys_time = { .Seconds = now / 1000, .SubSeconds = now % 1000 };
+
+  return sys_time;
+}
+
+SysTime_t SysTimeGetMcuTime( void )
+{
+  return SysTimeGet( );
+}
+
+SysTime_t SysTimeAdd( SysTime_t a, SysTime_t b )
+{
+  return a;
+}
+
+SysTime_t SysTimeSub( SysTime_t a, SysTime_t b )
+{
+  return a;
+}
+
+void SysTimeSet( SysTime_t sysTime )
+{
+}
+
+// Functions -------------------------------------------------------------------
+static void process_notify( void )
+{
+  b_process = true;
+}
+
+static void mcps_confirm( McpsConfirm_t *mcpsConfirm )
+{
+  u32_confirms += ( mcpsConfirm->Status == LORAMAC_EVENT_INFO_STATUS_OK );
+}
+
+static void mcps_indication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void mlme_confirm( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void mlme_indication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static void process( void )
+{
+  while( b_process )
+  {
+    b_process = false;
+    LoRaMacProcess( );
+  }
+}
+
+static void bench_init( void )
+{
+  static LoRaMacPrimitives_t primitives = { mcps_confirm, mcps_indication, mlme_confirm, mlme_indication };
+  static LoRaMacCallback_t callbacks = { NULL, NULL, NULL, process_notify };
+  MibRequestConfirm_t mib;
+
+  CHECK( LoRaMacInitialization( &primitives, &callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_NET_ID;
+  mib.Param.NetID = 0x13;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_DEV_ADDR;
+  mib.Param.DevAddr = 0x26011234;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_NETWORK_ACTIVATION;
+  mib.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+}
+
+// One unconfirmed uplink at DR5 without downlink
+static void uplink( void )
+{
+  static uint8_t payload[BENCH_PAYLOAD_SIZE];
+  McpsReq_t request;
+
+  request.Type = MCPS_UNCONFIRMED;
+  request.Req.Unconfirmed.fPort = 2;
+  request.Req.Unconfirmed.fBuffer = payload;
+  request.Req.Unconfirmed.fBufferSize = sizeof( payload );
+  request.Req.Unconfirmed.Datarate = DR_5;
+  now += BENCH_UPLINK_PERIOD;
+  LoRaMacMcpsRequest( &request, false );
+
+  now += 50;
+  OnRadioTxDone( );
+  process( );
+  now += MacCtx.RxWindow1Delay;
+  OnRxWindow1TimerEvent( NULL );
+  OnRadioRxTimeout( );
+  process( );
+  now += MacCtx.RxWindow2Delay - MacCtx.RxWindow1Delay;
+  OnRxWindow2TimerEvent( NULL );
+  OnRadioRxTimeout( );
+  process( );
+}
+
+int main( void )
+{
+  double start;
+
+  bench_init( );
+  start = test_cpu_time();
+  for( uint32_t i = 0; i < BENCH_UPLINKS; i++ )
+  {
+    uplink( );
+  }
+  // Host CPU time, relative figures between the two builds
+  printf( "  REGION_SINGLE_ENABLED %d: %7.3f us per uplink\n", REGION_SINGLE_ENABLED,
+          ( test_cpu_time() - start ) * 1e6 / BENCH_UPLINKS );
+  CHECK( u32_sends == BENCH_UPLINKS );
+  CHECK( u32_confirms == BENCH_UPLINKS );
+  CHECK( MacCtx.MacState == LORAMAC_IDLE );
+
+  return TEST_END();
+}
@@ -0,0 +1,102 @@
+/**
+* @file mac_access.c
+* @brief Test functions of mac_access.h, included at the end of a LoRaMac.c.
+**/
+
+// Functions -------------------------------------------------------------------
+static uint8_t GetBatteryLevelTest( void )
+{
+  return 200;
+}
+
+static uint16_t GetTemperatureLevelTest( void )
+{
+  return 21;
+}
+
+static void NvmContextChangeTest( LoRaMacNvmCtxModule_t module )
+{
+}
+
+static void McpsConfirmTest( McpsConfirm_t *mcpsConfirm )
+{
+}
+
+static void McpsIndicationTest( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void MlmeConfirmTest( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void MlmeIndicationTest( MlmeIndication_t *mlmeIndication )
+{
+}
+
+LoRaMacStatus_t TestMacInit( void )
+{
+  static LoRaMacPrimitives_t primitives =
+  {
+    McpsConfirmTest, McpsIndicationTest, MlmeConfirmTest, MlmeIndicationTest
+  };
+  static LoRaMacCallback_t callbacks =
+  {
+    GetBatteryLevelTest, GetTemperatureLevelTest, NvmContextChangeTest, NULL
+  };
+  LoRaMacStatus_t status = LoRaMacInitialization( &primitives, &callbacks, LORAMAC_REGION_EU868 );
+
+  // LinkAdrReq is only processed with ADR on
+  MacCtx.NvmCtx->AdrCtrlOn = true;
+  return status;
+}
+
+// As a downlink received in RX1 after an unconfirmed uplink
+void TestMacDownlink( uint8_t *payload, uint8_t u8_size, int8_t snr )
+{
+  LoRaMacCommandsRemoveStickyAnsCmds( );
+  MacCtx.McpsIndication.DeviceTimeAnsReceived = false;
+  ProcessMacCommands( payload, 0, u8_size, snr, RX_SLOT_WIN_1 );
+}
+
+// State after the downlink, then the answers go out with the next uplink
+void TestMacUplink( test_mac_state_t *state )
+{
+  LoRaMacNvmCtx_t *nvm = MacCtx.NvmCtx;
+  GetPhyParams_t get_phy;
+  ChannelParams_t *channels;
+
+  memset( state, 0, sizeof( *state ) );
+  state->Datarate = nvm->MacParams.ChannelsDatarate;
+  state->TxPower = nvm->MacParams.ChannelsTxPower;
+  state->NbTrans = nvm->MacParams.ChannelsNbTrans;
+  state->Rx1DrOffset = nvm->MacParams.Rx1DrOffset;
+  state->Rx2Frequency = nvm->MacParams.Rx2Channel.Frequency;
+  state->Rx2Datarate = nvm->MacParams.Rx2Channel.Datarate;
+  state->ReceiveDelay1 = nvm->MacParams.ReceiveDelay1;
+  state->ReceiveDelay2 = nvm->MacParams.ReceiveDelay2;
+  state->UplinkDwellTime = nvm->MacParams.UplinkDwellTime;
+  state->DownlinkDwellTime = nvm->MacParams.DownlinkDwellTime;
+  state->MaxEirp = nvm->MacParams.MaxEirp;
+  state->MaxDCycle = nvm->MaxDCycle;
+  state->AggregatedDCycle = nvm->AggregatedDCycle;
+  state->DemodMargin = MacCtx.MlmeConfirm.DemodMargin;
+  state->NbGateways = MacCtx.MlmeConfirm.NbGateways;
+  state->b_device_time_ans = MacCtx.McpsIndication.DeviceTimeAnsReceived;
+
+  LoRaMacCommandsSerializeCmds( LORA_MAC_COMMAND_MAX_LENGTH, &state->AnswersSize, state->Answers );
+  LoRaMacCommandsRemoveNoneStickyCmds( );
+  LoRaMacCommandsStickyCmdsPending( &state->b_sticky_pending );
+
+  get_phy.Attribute = PHY_CHANNELS;
+  channels = RegionGetPhyParam( nvm->Region, &get_phy ).Channels;
+  for( uint8_t i = 0; i < EU868_MAX_NB_CHANNELS; i++ )
+  {
+    state->Frequency[i] = channels[i].Frequency;
+    state->Rx1Frequency[i] = channels[i].Rx1Frequency;
+    state->DrRange[i] = channels[i].DrRange.Value;
+    state->Band[i] = channels[i].Band;
+  }
+  get_phy.Attribute = PHY_CHANNELS_MASK;
+  state->ChannelsMask = RegionGetPhyParam( nvm->Region, &get_phy ).ChannelsMask[0];
+}
@@ -0,0 +1,73 @@
+/**
+* @file mac_access.h
+* @brief Access of the tests to the static MAC command parser of LoRaMac.c.
+*
+* mac_access.c is included at the end of the MAC of the tree (mac_new.c) and of
+* the original MAC (mac_ref.c), the functions of the original MAC get the Ref
+* prefix of mac_ref_names.h.
+**/
+
+#ifndef MAC_ACCESS_H
+#define MAC_ACCESS_H
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "LoRaMac.h"
+#include "Region.h"
+
+// Definitions -----------------------------------------------------------------
+// LORA_MAC_COMMAND_MAX_LENGTH of LoRaMac.c
+#define TEST_MAC_ANSWERS_SIZE                       128
+
+/**
+  * @brief  State the MAC commands of a downlink can change
+  */
+typedef struct
+{
+  int8_t Datarate;
+  int8_t TxPower;
+  uint8_t NbTrans;
+  uint8_t Rx1DrOffset;
+  uint32_t Rx2Frequency;
+  uint8_t Rx2Datarate;
+  uint32_t ReceiveDelay1;
+  uint32_t ReceiveDelay2;
+  uint8_t UplinkDwellTime;
+  uint8_t DownlinkDwellTime;
+  float MaxEirp;
+  uint8_t MaxDCycle;
+  uint16_t AggregatedDCycle;
+  uint8_t DemodMargin;
+  uint8_t NbGateways;
+  bool b_device_time_ans;
+  // Answers of the next uplink and sticky answers left after it
+  uint8_t Answers[TEST_MAC_ANSWERS_SIZE];
+  size_t AnswersSize;
+  bool b_sticky_pending;
+  // Channels of the region, field by field as the padding of ChannelParams_t is not set
+  uint32_t Frequency[EU868_MAX_NB_CHANNELS];
+  uint32_t Rx1Frequency[EU868_MAX_NB_CHANNELS];
+  uint8_t DrRange[EU868_MAX_NB_CHANNELS];
+  uint8_t Band[EU868_MAX_NB_CHANNELS];
+  uint16_t ChannelsMask;
+} test_mac_state_t;
+
+// Functions -------------------------------------------------------------------
+/**
+  * @brief  Called by both parsers at the start of every command, macIndex is
+  *         the position of the CID in the MAC commands
+  */
+void TestMacTraceCmd( uint8_t macIndex );
+
+LoRaMacStatus_t TestMacInit( void );
+void TestMacDownlink( uint8_t *payload, uint8_t u8_size, int8_t snr );
+void TestMacUplink( test_mac_state_t *state );
+
+uint8_t RefLoRaMacCommandsGetCmdSize( uint8_t cid );
+LoRaMacStatus_t RefTestMacInit( void );
+void RefTestMacDownlink( uint8_t *payload, uint8_t u8_size, int8_t snr );
+void RefTestMacUplink( test_mac_state_t *state );
+
+#endif /* MAC_ACCESS_H */
@@ -0,0 +1,8 @@
+/**
+* @file mac_commands_ref.c
+* @brief LoRaMacCommands.c of the original tree, all global names with the Ref prefix.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "mac_ref_names.h"
+#include "Reference/LoRaMacCommands.c"
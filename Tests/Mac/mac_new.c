@@ -0,0 +1,14 @@
+/**
+* @file mac_new.c
+* @brief LoRaMac.c of the tree with the test functions of mac_access.h.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "LoRaMacCommands.h"
+#include "mac_access.h"
+
+// Every command start goes through the size of the command
+#define LoRaMacCommandsGetCmdSize( cid )            ( TestMacTraceCmd( macIndex ), LoRaMacCommandsGetCmdSize( cid ) )
+
+#include "LoRaMac.c"
+#include "mac_access.c"
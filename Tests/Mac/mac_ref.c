@@ -0,0 +1,17 @@
+/**
+* @file mac_ref.c
+* @brief LoRaMac.c of the original tree with the test functions of mac_access.h,
+*        all global names with the Ref prefix.
+**/
+
+// Includes --------------------------------------------------------------------
+#include "mac_ref_names.h"
+#include "Reference/LoRaMacCommands.h"
+#include "mac_access.h"
+
+// Every command start goes through the size of the command
+#undef LoRaMacCommandsGetCmdSize
+#define LoRaMacCommandsGetCmdSize( cid )            ( TestMacTraceCmd( macIndex ), RefLoRaMacCommandsGetCmdSize( cid ) )
+
+#include "Reference/LoRaMac.c"
+#include "mac_access.c"
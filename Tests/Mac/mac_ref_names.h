@@ -0,0 +1,49 @@
+/**
+* @file mac_ref_names.h
+* @brief Ref prefix of the global names of the original LoRaMac.c and
+*        LoRaMacCommands.c (Reference/), they link next to the ones of the tree.
+**/
+
+#ifndef MAC_REF_NAMES_H
+#define MAC_REF_NAMES_H
+
+#define LoRaMacChannelAdd                           RefLoRaMacChannelAdd
+#define LoRaMacChannelRemove                        RefLoRaMacChannelRemove
+#define LoRaMacDeInitialization                     RefLoRaMacDeInitialization
+#define LoRaMacInitialization                       RefLoRaMacInitialization
+#define LoRaMacIsBusy                               RefLoRaMacIsBusy
+#define LoRaMacMcChannelDelete                      RefLoRaMacMcChannelDelete
+#define LoRaMacMcChannelGetGroupId                  RefLoRaMacMcChannelGetGroupId
+#define LoRaMacMcChannelSetup                       RefLoRaMacMcChannelSetup
+#define LoRaMacMcChannelSetupRxParams               RefLoRaMacMcChannelSetupRxParams
+#define LoRaMacMcpsRequest                          RefLoRaMacMcpsRequest
+#define LoRaMacMibGetRequestConfirm                 RefLoRaMacMibGetRequestConfirm
+#define LoRaMacMibSetRequestConfirm                 RefLoRaMacMibSetRequestConfirm
+#define LoRaMacMlmeRequest                          RefLoRaMacMlmeRequest
+#define LoRaMacProcess                              RefLoRaMacProcess
+#define LoRaMacQueryTxPossible                      RefLoRaMacQueryTxPossible
+#define LoRaMacStart                                RefLoRaMacStart
+#define LoRaMacStop                                 RefLoRaMacStop
+#define LoRaMacTestSetDutyCycleOn                   RefLoRaMacTestSetDutyCycleOn
+#define LoRaMacRadioEvents                          RefLoRaMacRadioEvents
+#define RxDoneParams                                RefRxDoneParams
+#define TxDoneParams                                RefTxDoneParams
+
+#define LoRaMacCommandsAddCmd                       RefLoRaMacCommandsAddCmd
+#define LoRaMacCommandsGetCmd                       RefLoRaMacCommandsGetCmd
+#define LoRaMacCommandsGetCmdSize                   RefLoRaMacCommandsGetCmdSize
+#define LoRaMacCommandsGetNvmCtx                    RefLoRaMacCommandsGetNvmCtx
+#define LoRaMacCommandsGetSizeSerializedCmds        RefLoRaMacCommandsGetSizeSerializedCmds
+#define LoRaMacCommandsInit                         RefLoRaMacCommandsInit
+#define LoRaMacCommandsRemoveCmd                    RefLoRaMacCommandsRemoveCmd
+#define LoRaMacCommandsRemoveNoneStickyCmds         RefLoRaMacCommandsRemoveNoneStickyCmds
+#define LoRaMacCommandsRemoveStickyAnsCmds          RefLoRaMacCommandsRemoveStickyAnsCmds
+#define LoRaMacCommandsRestoreNvmCtx                RefLoRaMacCommandsRestoreNvmCtx
+#define LoRaMacCommandsSerializeCmds                RefLoRaMacCommandsSerializeCmds
+#define LoRaMacCommandsStickyCmdsPending            RefLoRaMacCommandsStickyCmdsPending
+
+#define TestMacInit                                 RefTestMacInit
+#define TestMacDownlink                             RefTestMacDownlink
+#define TestMacUplink                               RefTestMacUplink
+
+#endif /* MAC_REF_NAMES_H */
@@ -0,0 +1,438 @@
+/**
+* @file test_mac_commands.c
+* @brief Tests of the MAC command parser of LoRaMac.c (MacCmdHandlers[]) and of
+*        the slots of LoRaMacCommands.c against the original tree (Reference/).
+*
+* Both MACs replay the same FOpts/port 0 downlinks, each followed by an uplink,
+* and must give the same:
+* - positions of the parsed commands, so the same parsed length
+* - answers of the uplink and sticky answers left after it
+* - MAC parameters, link check, device time and channels of the region
+* The downlinks are
+* - recorded downlinks of a network server: ADR, channel plan, RX settings,
+*   link check and device time answers, truncated tails, unknown commands
+* - random sequences of well-formed commands, cut at random and with random
+*   unknown commands
+* - LoRaMacCommandsGetCmdSize() of all the CIDs
+* The commands ignored by the MAC (answers without request, a second LinkAdrReq
+* block) are the one intended difference: the original parser skips their CID
+* only and parses their payload as commands, the tree skips the whole command.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "stm32_systime.h"
+#include "stm32_timer.h"
+#include "LoRaMacCommands.h"
+#include "LoRaMacConfirmQueue.h"
+#include "Region.h"
+#include "mac_access.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_FRAME_SIZE                         64
+#define TEST_MAX_FRAMES                             32
+#define TEST_RANDOM_SEQUENCES                       2000
+
+typedef struct
+{
+  uint8_t Size;
+  uint8_t Data[TEST_MAX_FRAME_SIZE];
+  int8_t Snr;
+  // Pending MLME request of the downlink, MLME_UNKNOWN for none
+  Mlme_t Request;
+} test_downlink_t;
+
+typedef struct
+{
+  uint8_t Count;
+  uint8_t Starts[TEST_MAX_FRAME_SIZE];
+} test_trace_t;
+
+typedef struct
+{
+  test_trace_t Trace;
+  test_mac_state_t State;
+} test_result_t;
+
+// Variables -------------------------------------------------------------------
+// Channel plan, RX2 869.525 MHz, DR3, ADR and device status
+static const test_downlink_t recorded[] =
+{
+  { 6, { 0x03, 0x51, 0x07, 0x00, 0x01, 0x06 }, 7, MLME_UNKNOWN },
+  { 30, { 0x07, 0x03, 0x18, 0x4F, 0x84, 0x50, 0x07, 0x04, 0xE8, 0x56, 0x84, 0x50, 0x07, 0x05, 0xB8, 0x5E, 0x84, 0x50,
+          0x07, 0x06, 0x88, 0x66, 0x84, 0x50, 0x07, 0x07, 0x58, 0x6E, 0x84, 0x50 }, 5, MLME_UNKNOWN },
+  { 7, { 0x05, 0x03, 0xD2, 0xAD, 0x84, 0x08, 0x01 }, -3, MLME_UNKNOWN },
+  { 10, { 0x03, 0x50, 0xFF, 0x00, 0x01, 0x03, 0x50, 0xFF, 0x00, 0x61 }, 2, MLME_UNKNOWN },
+  { 3, { 0x02, 0x14, 0x03 }, 9, MLME_LINK_CHECK },
+  { 6, { 0x0D, 0x10, 0x32, 0x54, 0x76, 0x80 }, 9, MLME_DEVICE_TIME },
+  { 9, { 0x04, 0x07, 0x0A, 0x03, 0x28, 0x76, 0x84, 0x06, 0x09 }, -12, MLME_UNKNOWN },
+  // Wrong channel, frequency and datarate: negative answers
+  { 16, { 0x07, 0x10, 0x18, 0x4F, 0x84, 0x50, 0x07, 0x03, 0x00, 0x00, 0x10, 0x50, 0x05, 0x7F, 0x01, 0x02 }, 0, MLME_UNKNOWN },
+  { 10, { 0x03, 0x5F, 0x00, 0x00, 0x01, 0x0A, 0x00, 0x28, 0x76, 0x84 }, 1, MLME_UNKNOWN },
+  // Truncated tails
+  { 4, { 0x06, 0x07, 0x03, 0x18 }, 4, MLME_UNKNOWN },
+  { 5, { 0x08, 0x02, 0x05, 0x03, 0xD2 }, 4, MLME_UNKNOWN },
+  { 8, { 0x03, 0x51, 0x07, 0x00, 0x01, 0x03, 0x51, 0x07 }, 4, MLME_UNKNOWN },
+  { 1, { 0x0D }, 4, MLME_DEVICE_TIME },
+  // Unknown commands stop the parsing
+  { 5, { 0x06, 0x80, 0x06, 0x04, 0x00 }, 4, MLME_UNKNOWN },
+  { 4, { 0x00, 0x06, 0x04, 0x00 }, 4, MLME_UNKNOWN },
+  { 4, { 0x04, 0x01, 0xFF, 0x06 }, 4, MLME_UNKNOWN },
+  { 3, { 0x06, 0x0E, 0x06 }, 4, MLME_UNKNOWN },
+  // Class B commands, class B is not enabled
+  { 9, { 0x11, 0x28, 0x76, 0x84, 0x03, 0x13, 0x28, 0x76, 0x84 }, 4, MLME_UNKNOWN },
+  // Uplink without downlink, the sticky answers are sent again
+  { 0, { 0 }, 0, MLME_UNKNOWN },
+};
+
+// Commands which are never ignored, LinkCheckAns and DeviceTimeAns come with their request
+static const uint8_t random_cids[] =
+{
+  SRV_MAC_LINK_CHECK_ANS, SRV_MAC_DUTY_CYCLE_REQ, SRV_MAC_RX_PARAM_SETUP_REQ, SRV_MAC_DEV_STATUS_REQ,
+  SRV_MAC_NEW_CHANNEL_REQ, SRV_MAC_RX_TIMING_SETUP_REQ, SRV_MAC_TX_PARAM_SETUP_REQ, SRV_MAC_DL_CHANNEL_REQ,
+  SRV_MAC_DEVICE_TIME_ANS, SRV_MAC_PING_SLOT_CHANNEL_REQ, SRV_MAC_BEACON_FREQ_REQ
+};
+
+static test_trace_t trace;
+
+// Stubs -----------------------------------------------------------------------
+static uint32_t radio_random( void )
+{
+  return test_rand();
+}
+
+static void radio_init( RadioEvents_t *events )
+{
+}
+
+static void radio_set_public_network( bool enable )
+{
+}
+
+static void radio_sleep( void )
+{
+}
+
+static bool radio_check_rf_frequency( uint32_t frequency )
+{
+  return true;
+}
+
+static uint32_t radio_get_wakeup_time( void )
+{
+  return 1;
+}
+
+// The MAC commands and LoRaMacInitialization() only use these functions of the radio
+const struct Radio_s Radio =
+{
+  .Init = radio_init, .Random = radio_random, .SetPublicNetwork = radio_set_public_network, .Sleep = radio_sleep,
+  .CheckRfFrequency = radio_check_rf_frequency, .GetWakeupTime = radio_get_wakeup_time
+};
+
+void GetUniqueId( uint8_t *id )
+{
+  memset( id, 0x42, 8 );
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return 100000;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return 100000 - past;
+}
+
+// The clock stands still, the device time answers set it
+static SysTime_t sys_time = { .Seconds = 1000, .SubSeconds = 0 };
+
+SysTime_t SysTimeAdd( SysTime_t a, SysTime_t b )
+{
+  SysTime_t c = { .Seconds = a.Seconds + b.Seconds, .SubSeconds = a.SubSeconds + b.SubSeconds };
+
+  if( c.SubSeconds >= 1000 )
+  {
+    c.Seconds++;
+    c.SubSeconds -= 1000;
+  }
+  return c;
+}
+
+SysTime_t SysTimeSub( SysTime_t a, SysTime_t b )
+{
+  SysTime_t c = { .Seconds = a.Seconds - b.Seconds, .SubSeconds = a.SubSeconds - b.SubSeconds };
+
+  if( c.SubSeconds < 0 )
+  {
+    c.Seconds--;
+    c.SubSeconds += 1000;
+  }
+  return c;
+}
+
+void SysTimeSet( SysTime_t sysTime )
+{
+  sys_time = sysTime;
+}
+
+SysTime_t SysTimeGet( void )
+{
+  return sys_time;
+}
+
+SysTime_t SysTimeGetMcuTime( void )
+{
+  SysTime_t mcu_time = { .Seconds = 1000, .SubSeconds = 0 };
+
+  return mcu_time;
+}
+
+// Functions -------------------------------------------------------------------
+void TestMacTraceCmd( uint8_t macIndex )
+{
+  if( trace.Count < TEST_MAX_FRAME_SIZE )
+  {
+    trace.Starts[trace.Count++] = macIndex;
+  }
+}
+
+static void add_request( Mlme_t request )
+{
+  MlmeConfirmQueue_t confirm = { .Request = request, .Status = LORAMAC_EVENT_INFO_STATUS_ERROR };
+
+  if( request != MLME_UNKNOWN )
+  {
+    LoRaMacConfirmQueueAdd( &confirm );
+  }
+}
+
+static void clear_requests( void )
+{
+  while( LoRaMacConfirmQueueGetCnt( ) > 0 )
+  {
+    LoRaMacConfirmQueueRemoveFirst( );
+  }
+}
+
+/**
+  * @brief  Replays the downlinks through one MAC, each one followed by an uplink
+  */
+static void replay( bool b_ref, const test_downlink_t *downlinks, uint8_t u8_count, test_result_t *results )
+{
+  GetNvmCtxParams_t params;
+  void *region_ctx = RegionGetNvmCtx( LORAMAC_REGION_EU868, &params );
+
+  // The region only sets up its default channels, the others would be left from the last replay
+  memset( region_ctx, 0, params.nvmCtxSize );
+  CHECK( ( b_ref ? RefTestMacInit : TestMacInit )( ) == LORAMAC_STATUS_OK );
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    uint8_t frame[TEST_MAX_FRAME_SIZE];
+
+    // The parsers may read the frame, never write it
+    memcpy( frame, downlinks[i].Data, sizeof( frame ) );
+    memset( &trace, 0, sizeof( trace ) );
+    add_request( downlinks[i].Request );
+    ( b_ref ? RefTestMacDownlink : TestMacDownlink )( frame, downlinks[i].Size, downlinks[i].Snr );
+    clear_requests( );
+    CHECK_MEM( frame, downlinks[i].Data, sizeof( frame ) );
+    results[i].Trace = trace;
+    ( b_ref ? RefTestMacUplink : TestMacUplink )( &results[i].State );
+  }
+}
+
+static void compare( const test_downlink_t *downlinks, uint8_t u8_count )
+{
+  static test_result_t ref_results[TEST_MAX_FRAMES];
+  static test_result_t results[TEST_MAX_FRAMES];
+
+  memset( ref_results, 0, sizeof( ref_results ) );
+  memset( results, 0, sizeof( results ) );
+  replay( true, downlinks, u8_count, ref_results );
+  replay( false, downlinks, u8_count, results );
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    CHECK( results[i].Trace.Count == ref_results[i].Trace.Count );
+    CHECK_MEM( results[i].Trace.Starts, ref_results[i].Trace.Starts, sizeof( results[i].Trace.Starts ) );
+    CHECK( results[i].State.AnswersSize == ref_results[i].State.AnswersSize );
+    CHECK_MEM( results[i].State.Answers, ref_results[i].State.Answers, sizeof( results[i].State.Answers ) );
+    CHECK( results[i].State.b_sticky_pending == ref_results[i].State.b_sticky_pending );
+    // MAC parameters, link check, device time and channels
+    CHECK_MEM( &results[i].State, &ref_results[i].State, sizeof( test_mac_state_t ) );
+  }
+}
+
+static void test_cmd_sizes( void )
+{
+  for( uint16_t cid = 0; cid < 256; cid++ )
+  {
+    CHECK( LoRaMacCommandsGetCmdSize( ( uint8_t ) cid ) == RefLoRaMacCommandsGetCmdSize( ( uint8_t ) cid ) );
+  }
+}
+
+static void test_recorded( void )
+{
+  uint8_t u8_count = sizeof( recorded ) / sizeof( recorded[0] );
+
+  compare( recorded, u8_count );
+  // Every downlink on its own, from a new MAC
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    compare( &recorded[i], 1 );
+  }
+}
+
+static void random_downlink( test_downlink_t *downlink )
+{
+  uint8_t pos = 0;
+
+  memset( downlink, 0, sizeof( *downlink ) );
+  downlink->Snr = ( int8_t ) ( test_rand() % 40 ) - 20;
+  downlink->Request = MLME_UNKNOWN;
+
+  // At most one block of LinkAdrReq, at the start like the network servers put it
+  if( test_rand() & 1 )
+  {
+    uint8_t u8_block = 1 + test_rand() % 3;
+
+    for( uint8_t i = 0; i < u8_block; i++ )
+    {
+      downlink->Data[pos++] = SRV_MAC_LINK_ADR_REQ;
+      downlink->Data[pos++] = ( uint8_t ) test_rand();
+      downlink->Data[pos++] = ( uint8_t ) test_rand();
+      downlink->Data[pos++] = ( test_rand() & 1 ) ? 0x00 : ( uint8_t ) test_rand();
+      downlink->Data[pos++] = ( uint8_t ) test_rand() & 0x7F;
+    }
+  }
+
+  while( pos < TEST_MAX_FRAME_SIZE - 8 )
+  {
+    uint8_t cid = random_cids[test_rand() % sizeof( random_cids )];
+    uint8_t u8_size = LoRaMacCommandsGetCmdSize( cid );
+
+    if( ( test_rand() % 8 ) == 0 )
+    {
+      break;
+    }
+    // Only one request can be pending, the answer to the other one would be ignored
+    if( ( cid == SRV_MAC_LINK_CHECK_ANS ) || ( cid == SRV_MAC_DEVICE_TIME_ANS ) )
+    {
+      Mlme_t request = ( cid == SRV_MAC_LINK_CHECK_ANS ) ? MLME_LINK_CHECK : MLME_DEVICE_TIME;
+
+      if( ( downlink->Request != MLME_UNKNOWN ) && ( downlink->Request != request ) )
+      {
+        continue;
+      }
+      downlink->Request = request;
+    }
+    downlink->Data[pos] = cid;
+    for( uint8_t i = 1; i < u8_size; i++ )
+    {
+      downlink->Data[pos + i] = ( uint8_t ) test_rand();
+    }
+    // The DlChannelReq of the regions index their channels without a check
+    if( cid == SRV_MAC_DL_CHANNEL_REQ )
+    {
+      downlink->Data[pos + 1] %= EU868_MAX_NB_CHANNELS;
+    }
+    pos += u8_size;
+  }
+
+  // Unknown command or truncated tail
+  switch( test_rand() % 4 )
+  {
+    case 0:
+      downlink->Data[pos++] = ( uint8_t ) ( 0x14 + test_rand() % 0xEC );
+      downlink->Data[pos++] = SRV_MAC_DEV_STATUS_REQ;
+      break;
+    case 1:
+      pos = ( pos > 0 ) ? ( uint8_t ) ( test_rand() % pos ) : 0;
+      break;
+    default:
+      break;
+  }
+  downlink->Size = pos;
+}
+
+static void test_random( void )
+{
+  static test_downlink_t downlinks[TEST_MAX_FRAMES];
+
+  for( uint32_t n = 0; n < TEST_RANDOM_SEQUENCES; n++ )
+  {
+    uint8_t u8_count = 1 + test_rand() % TEST_MAX_FRAMES;
+
+    for( uint8_t i = 0; i < u8_count; i++ )
+    {
+      random_downlink( &downlinks[i] );
+    }
+    compare( downlinks, u8_count );
+  }
+}
+
+/**
+  * @brief  Ignored commands: the tree skips them whole and parses the next
+  *         command, the original parser goes on inside them
+  */
+static void test_ignored( void )
+{
+  static const test_downlink_t ignored[] =
+  {
+    // LinkCheckAns without LinkCheckReq, then DevStatusReq
+    { 4, { 0x02, 0x06, 0x06, 0x06 }, 3, MLME_UNKNOWN },
+    // DeviceTimeAns without DeviceTimeReq, then DevStatusReq
+    { 7, { 0x0D, 0x06, 0x06, 0x06, 0x06, 0x06, 0x06 }, 3, MLME_UNKNOWN },
+    // Second LinkAdrReq block, then DutyCycleReq
+    { 13, { 0x03, 0x51, 0x07, 0x00, 0x01, 0x06, 0x03, 0x04, 0x07, 0x06, 0x01, 0x04, 0x05 }, 3, MLME_UNKNOWN },
+  };
+  static const uint8_t starts[][8] =
+  {
+    { 0, 3 },
+    { 0, 6 },
+    { 0, 5, 6, 11 },
+  };
+  static const uint8_t counts[] = { 2, 2, 4 };
+  test_result_t result;
+
+  for( uint8_t i = 0; i < sizeof( ignored ) / sizeof( ignored[0] ); i++ )
+  {
+    replay( false, &ignored[i], 1, &result );
+    CHECK( result.Trace.Count == counts[i] );
+    CHECK_MEM( result.Trace.Starts, starts[i], counts[i] );
+  }
+}
+
+int main( void )
+{
+  test_cmd_sizes();
+  test_recorded();
+  test_random();
+  test_ignored();
+
+  return TEST_END();
+}
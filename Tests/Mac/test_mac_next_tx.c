@@ -0,0 +1,400 @@
+/**
+* @file test_mac_next_tx.c
+* @brief Simulation of the uplink scheduling with LoRaMacQueryNextTxTime().
+*
+* LoRaMac.c is included and driven through whole unconfirmed uplinks of an ABP
+* device on EU868 at DR0 with 51 bytes, the band time-off of the 1 % duty cycle
+* is the limit. Cyclic events every SIM_CYCLE_PERIOD and random button events
+* ask for uplinks until SIM_UPLINKS are delivered:
+* - sending blindly, every event wakes up and tries the uplink, the rejected
+*   sends are counted
+* - with the query, as app.c: the events wait for the band, the cyclic timer
+*   fires at the later of one interval and the band release
+* - the query gives the MAC's own verdict and wait on every attempt
+* - a short payload is never allowed later than a long one, and is accepted
+*   at the wait the query reports for it
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "stm32_systime.h"
+#include "stm32_timer.h"
+#include "LoRaMac.c"
+
+// Definitions -----------------------------------------------------------------
+#define SIM_UPLINKS                                 300
+#define SIM_PAYLOAD_SIZE                            51
+#define SIM_CYCLE_PERIOD                            20000
+#define SIM_BUTTON_MEAN_PERIOD                      120000
+#define SIM_NO_EVENT                                UINT32_MAX
+
+typedef struct
+{
+  uint32_t u32_wakeups;        // Timer events, the button events come on top
+  uint32_t u32_buttons;
+  uint32_t u32_rejected;
+  uint32_t u32_delivered;
+  UTIL_TIMER_Time_t duration;
+} sim_result_t;
+
+// Variables -------------------------------------------------------------------
+static UTIL_TIMER_Time_t now = 1000;
+static uint32_t u32_sends;
+static bool b_process;
+
+// Stubs -----------------------------------------------------------------------
+static void radio_init( RadioEvents_t *events )
+{
+}
+
+static RadioState_t radio_get_status( void )
+{
+  return RF_IDLE;
+}
+
+static void radio_set_channel( uint32_t freq )
+{
+}
+
+static uint32_t radio_random( void )
+{
+  return test_rand();
+}
+
+static void radio_set_rx_config( RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                 uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                                 uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted,
+                                 bool rxContinuous )
+{
+}
+
+static void radio_set_tx_config( RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,
+                                 uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen, bool crcOn,
+                                 bool freqHopOn, uint8_t hopPeriod, bool iqInverted, uint32_t timeout )
+{
+}
+
+static bool radio_check_rf_frequency( uint32_t frequency )
+{
+  return true;
+}
+
+static void radio_send( uint8_t *buffer, uint8_t size )
+{
+  u32_sends++;
+}
+
+static void radio_sleep( void )
+{
+}
+
+static void radio_rx( uint32_t timeout )
+{
+}
+
+static void radio_set_max_payload_length( RadioModems_t modem, uint8_t max )
+{
+}
+
+static void radio_set_public_network( bool enable )
+{
+}
+
+static uint32_t radio_get_wakeup_time( void )
+{
+  return 1;
+}
+
+const struct Radio_s Radio =
+{
+  .Init = radio_init, .GetStatus = radio_get_status, .SetChannel = radio_set_channel, .Random = radio_random,
+  .SetRxConfig = radio_set_rx_config, .SetTxConfig = radio_set_tx_config, .CheckRfFrequency = radio_check_rf_frequency,
+  .Send = radio_send, .Sleep = radio_sleep, .Standby = radio_sleep, .Rx = radio_rx,
+  .SetMaxPayloadLength = radio_set_max_payload_length, .SetPublicNetwork = radio_set_public_network,
+  .GetWakeupTime = radio_get_wakeup_time
+};
+
+void GetUniqueId( uint8_t *id )
+{
+  memset( id, 0x42, 8 );
+}
+
+// The timers never fire, the simulation calls the events of LoRaMac.c in order
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return now;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return now - past;
+}
+
+SysTime_t SysTimeGet( void )
+{
+  SysTime_t sys_time = { .Seconds = now / 1000, .SubSeconds = now % 1000 };
+
+  return sys_time;
+}
+
+SysTime_t SysTimeGetMcuTime( void )
+{
+  return SysTimeGet( );
+}
+
+SysTime_t SysTimeAdd( SysTime_t a, SysTime_t b )
+{
+  return a;
+}
+
+SysTime_t SysTimeSub( SysTime_t a, SysTime_t b )
+{
+  return a;
+}
+
+void SysTimeSet( SysTime_t sysTime )
+{
+}
+
+// Functions -------------------------------------------------------------------
+static void process_notify( void )
+{
+  b_process = true;
+}
+
+static void mcps_confirm( McpsConfirm_t *mcpsConfirm )
+{
+}
+
+static void mcps_indication( McpsIndication_t *mcpsIndication )
+{
+}
+
+static void mlme_confirm( MlmeConfirm_t *mlmeConfirm )
+{
+}
+
+static void mlme_indication( MlmeIndication_t *mlmeIndication )
+{
+}
+
+static void process( void )
+{
+  while( b_process )
+  {
+    b_process = false;
+    LoRaMacProcess( );
+  }
+}
+
+static void sim_init( void )
+{
+  static LoRaMacPrimitives_t primitives = { mcps_confirm, mcps_indication, mlme_confirm, mlme_indication };
+  static LoRaMacCallback_t callbacks = { NULL, NULL, NULL, process_notify };
+  MibRequestConfirm_t mib;
+
+  CHECK( LoRaMacInitialization( &primitives, &callbacks, LORAMAC_REGION_EU868 ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_NET_ID;
+  mib.Param.NetID = 0x13;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_DEV_ADDR;
+  mib.Param.DevAddr = 0x26011234;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  mib.Type = MIB_NETWORK_ACTIVATION;
+  mib.Param.NetworkActivation = ACTIVATION_TYPE_ABP;
+  CHECK( LoRaMacMibSetRequestConfirm( &mib ) == LORAMAC_STATUS_OK );
+  CHECK( LoRaMacStart( ) == LORAMAC_STATUS_OK );
+  LoRaMacTestSetDutyCycleOn( true );
+}
+
+// Wait of the query for an uplink of u8_size bytes, 0 if the MAC allows it now
+static TimerTime_t query( uint8_t u8_size )
+{
+  TimerTime_t wait_time = 0;
+  LoRaMacStatus_t status = LoRaMacQueryNextTxTime( u8_size, &wait_time );
+
+  CHECK( ( status == LORAMAC_STATUS_OK ) || ( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED ) );
+  CHECK( ( status == LORAMAC_STATUS_OK ) == ( wait_time == 0 ) );
+  return wait_time;
+}
+
+/**
+  * @brief  Requests an unconfirmed uplink at DR0 and, once accepted, runs it through RX1 and RX2 to MAC idle.
+  *         The verdict and the wait of the MAC must be the ones of the query just before.
+  * @retval true if the MAC accepted the uplink.
+  */
+static bool uplink( uint8_t u8_size )
+{
+  static uint8_t payload[SIM_PAYLOAD_SIZE];
+  TimerTime_t wait_time = query( u8_size );
+  McpsReq_t request;
+  LoRaMacStatus_t status;
+
+  request.Type = MCPS_UNCONFIRMED;
+  request.Req.Unconfirmed.fPort = 2;
+  request.Req.Unconfirmed.fBuffer = payload;
+  request.Req.Unconfirmed.fBufferSize = u8_size;
+  request.Req.Unconfirmed.Datarate = DR_0;
+  status = LoRaMacMcpsRequest( &request, false );
+  if( status != LORAMAC_STATUS_OK )
+  {
+    CHECK( status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED );
+    CHECK( wait_time != 0 );
+    CHECK( request.ReqReturn.DutyCycleWaitTime == wait_time );
+    return false;
+  }
+  CHECK( wait_time == 0 );
+
+  now += MacCtx.TxTimeOnAir;
+  OnRadioTxDone( );
+  process( );
+  now += MacCtx.RxWindow1Delay;
+  OnRxWindow1TimerEvent( NULL );
+  OnRadioRxTimeout( );
+  process( );
+  now += MacCtx.RxWindow2Delay - MacCtx.RxWindow1Delay;
+  OnRxWindow2TimerEvent( NULL );
+  OnRadioRxTimeout( );
+  process( );
+  CHECK( MacCtx.MacState == LORAMAC_IDLE );
+  return true;
+}
+
+static UTIL_TIMER_Time_t button_delay( void )
+{
+  return 1000 + ( test_rand() % ( 2 * SIM_BUTTON_MEAN_PERIOD ) );
+}
+
+/**
+  * @brief  Runs the cyclic and button events until SIM_UPLINKS are delivered.
+  * @param[in] b_query false: every event tries the uplink, true: the events wait for the band as app.c does.
+  */
+static sim_result_t simulate( bool b_query )
+{
+  sim_result_t result = { 0 };
+  UTIL_TIMER_Time_t start;
+  UTIL_TIMER_Time_t cycle_start;
+  UTIL_TIMER_Time_t cycle_event;
+  UTIL_TIMER_Time_t button_event;
+  UTIL_TIMER_Time_t queue_event = SIM_NO_EVENT;
+  bool b_pending = false;
+
+  sim_init( );
+  test_rand_state = 1;
+  start = now;
+  cycle_start = now;
+  cycle_event = now;
+  button_event = now + button_delay( );
+
+  while( result.u32_delivered < SIM_UPLINKS )
+  {
+    UTIL_TIMER_Time_t event = MIN( MIN( cycle_event, button_event ), queue_event );
+
+    now = MAX( now, event );
+    if( event == cycle_event )
+    {
+      b_pending = true;
+      cycle_start = now;
+      cycle_event = now + SIM_CYCLE_PERIOD;
+      result.u32_wakeups++;
+    }
+    else if( event == button_event )
+    {
+      b_pending = true;
+      button_event = now + button_delay( );
+      result.u32_buttons++;
+    }
+    else
+    {
+      queue_event = SIM_NO_EVENT;
+      result.u32_wakeups++;
+    }
+
+    // The button and the cycle share one queue entry, a wait already on the queue timer is not shortened
+    if( !b_pending || ( b_query && ( queue_event != SIM_NO_EVENT ) ) )
+    {
+      continue;
+    }
+    if( b_query && ( query( SIM_PAYLOAD_SIZE ) != 0 ) )
+    {
+      queue_event = now + query( SIM_PAYLOAD_SIZE );
+      continue;
+    }
+    if( !uplink( SIM_PAYLOAD_SIZE ) )
+    {
+      result.u32_rejected++;
+      continue;
+    }
+    b_pending = false;
+    result.u32_delivered++;
+    if( b_query )
+    {
+      cycle_event = MAX( cycle_start + SIM_CYCLE_PERIOD, now + query( SIM_PAYLOAD_SIZE ) );
+    }
+  }
+  result.duration = now - start;
+
+  return result;
+}
+
+static void test_schedule( void )
+{
+  sim_result_t blind = simulate( false );
+  sim_result_t queried = simulate( true );
+
+  printf( "  blind:      %u timer wakeups, %u buttons, %u rejected sends, %u uplinks in %.1f h\n", blind.u32_wakeups,
+          blind.u32_buttons, blind.u32_rejected, blind.u32_delivered, blind.duration / 3600000.0 );
+  printf( "  with query: %u timer wakeups, %u buttons, %u rejected sends, %u uplinks in %.1f h\n", queried.u32_wakeups,
+          queried.u32_buttons, queried.u32_rejected, queried.u32_delivered, queried.duration / 3600000.0 );
+  CHECK( blind.u32_rejected > 0 );
+  CHECK( queried.u32_rejected == 0 );
+  CHECK( queried.u32_wakeups < blind.u32_wakeups );
+  // Same throughput: the band is the limit of both
+  CHECK( queried.duration <= ( blind.duration + blind.duration / 100 ) );
+}
+
+static void test_sizes( void )
+{
+  sim_init( );
+  for( uint16_t i = 0; i < 200; i++ )
+  {
+    TimerTime_t short_wait = query( 1 );
+    TimerTime_t long_wait = query( SIM_PAYLOAD_SIZE );
+
+    CHECK( short_wait <= long_wait );
+    now += ( i & 1 ) ? short_wait : long_wait;
+    CHECK( uplink( ( i & 1 ) ? 1 : SIM_PAYLOAD_SIZE ) );
+    now += test_rand() % 5000;
+  }
+}
+
+int main( void )
+{
+  test_schedule( );
+  test_sizes( );
+
+  return TEST_END();
+}
@@ -0,0 +1,308 @@
+/**
+* @file test_mac_rx_calibration.c
+* @brief Tests of the RX windows timing calibration (LoRaMacRxCalibration.c).
+*
+* - the default windows until LORAMAC_RX_CALIBRATION_MIN_SAMPLES downlinks
+* - bias and drift of exact samples, the drift only from samples of several
+*   RX delays
+* - the window is never wider than the default one
+* - LORAMAC_RX_CALIBRATION_MAX_FAILURES failures in a row restart the
+*   calibration, a sample in between clears them, failures of the default
+*   windows are ignored
+* - replay of the windows of 5000 uplinks, built with RegionCommon.c as the
+*   MAC does: RX1 at DR5/DR3 after 1 s, RX2 at DR0 after 2 s, 15 % downlinks
+*   in RX1 and 3 % in RX2, 20 ppm drift, -2 ms bias, 0.3 ms jitter. The
+*   samples and failures are the ones of ProcessRxCalibration() in LoRaMac.c.
+*   Every downlink is received and RX1 listens shorter than with the default
+*   windows. A 6 ms step of the timing halfway loses at most
+*   LORAMAC_RX_CALIBRATION_MAX_FAILURES downlinks.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "RegionCommon.h"
+#include "LoRaMacRxCalibration.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_MAX_RX_ERROR                           10
+#define TEST_MIN_RX_SYMBOLS                         6
+#define TEST_PREAMBLE_SYMBOLS                       8
+#define TEST_WAKEUP_TIME                            3
+#define TEST_RX1_DELAY                              1000
+#define TEST_RX2_DELAY                              2000
+#define TEST_UPLINKS                                5000
+#define TEST_BIAS_US                                -2000
+#define TEST_DRIFT_PPM                              20
+#define TEST_JITTER_US                              300
+#define TEST_STEP_US                                6000
+
+typedef struct
+{
+  uint32_t u32_downlinks;
+  uint32_t u32_received;
+  uint32_t u32_lost_after_step;
+  double rx1_listen_ms;
+  double rx2_listen_ms;
+} replay_result_t;
+
+// Variables -------------------------------------------------------------------
+// Symbol times [ns] of SF7, SF9 and SF12 at 125 kHz
+static const uint32_t symbol_time_dr5 = 1024000;
+static const uint32_t symbol_time_dr3 = 4096000;
+static const uint32_t symbol_time_dr0 = 32768000;
+
+// Stubs -----------------------------------------------------------------------
+// Only RegionCommonRxBeaconSetup uses the radio, it is not called
+const struct Radio_s Radio;
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return 0;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return 0 - past;
+}
+
+// Functions -------------------------------------------------------------------
+static void test_default_window( void )
+{
+  int32_t correction;
+  uint32_t rx_error;
+
+  LoRaMacRxCalibrationReset( );
+  for( uint8_t i = 0; i < LORAMAC_RX_CALIBRATION_MIN_SAMPLES; i++ )
+  {
+    CHECK( LoRaMacRxCalibrationIsActive( ) == false );
+    CHECK( LoRaMacRxCalibrationGetWindow( TEST_RX1_DELAY, TEST_MAX_RX_ERROR, &correction, &rx_error ) == false );
+    CHECK( ( correction == 0 ) && ( rx_error == TEST_MAX_RX_ERROR ) );
+    LoRaMacRxCalibrationAddSample( TEST_RX1_DELAY, -3 );
+  }
+  CHECK( LoRaMacRxCalibrationIsActive( ) );
+  CHECK( LoRaMacRxCalibrationGetWindow( TEST_RX1_DELAY, TEST_MAX_RX_ERROR, &correction, &rx_error ) );
+  CHECK( correction == -3 );
+  // The weighted sums truncate, the bias may round off by up to 1 ms
+  CHECK( ( rx_error >= LORAMAC_RX_CALIBRATION_MARGIN ) && ( rx_error <= ( LORAMAC_RX_CALIBRATION_MARGIN + 1 ) ) );
+
+  // Never wider than the default window
+  LoRaMacRxCalibrationAddSample( TEST_RX1_DELAY, 40 );
+  CHECK( LoRaMacRxCalibrationGetWindow( TEST_RX1_DELAY, TEST_MAX_RX_ERROR, &correction, &rx_error ) );
+  CHECK( rx_error == TEST_MAX_RX_ERROR );
+}
+
+static void test_fit( void )
+{
+  static const uint32_t delays[] = { 1000, 2000, 5000, 6000 };
+  int32_t correction;
+  uint32_t rx_error;
+
+  // 1000 ppm and -4 ms: -3 ms at 1 s, +2 ms at 6 s
+  LoRaMacRxCalibrationReset( );
+  for( uint8_t i = 0; i < 40; i++ )
+  {
+    uint32_t delay = delays[i % 4];
+
+    LoRaMacRxCalibrationAddSample( delay, -4 + ( int32_t ) ( delay / 1000 ) );
+  }
+  for( uint8_t i = 0; i < 4; i++ )
+  {
+    CHECK( LoRaMacRxCalibrationGetWindow( delays[i], TEST_MAX_RX_ERROR, &correction, &rx_error ) );
+    CHECK( correction == ( -4 + ( int32_t ) ( delays[i] / 1000 ) ) );
+    CHECK( rx_error <= ( LORAMAC_RX_CALIBRATION_MARGIN + 1 ) );
+  }
+
+  // A single RX delay does not tell the drift from the bias, the correction is the same for all delays
+  LoRaMacRxCalibrationReset( );
+  for( uint8_t i = 0; i < 40; i++ )
+  {
+    LoRaMacRxCalibrationAddSample( TEST_RX1_DELAY, 5 );
+  }
+  for( uint8_t i = 0; i < 4; i++ )
+  {
+    CHECK( LoRaMacRxCalibrationGetWindow( delays[i], TEST_MAX_RX_ERROR, &correction, &rx_error ) );
+    CHECK( correction == 5 );
+  }
+}
+
+static void test_failure_count( void )
+{
+  LoRaMacRxCalibrationReset( );
+  for( uint8_t i = 0; i < 2 * LORAMAC_RX_CALIBRATION_MAX_FAILURES; i++ )
+  {
+    LoRaMacRxCalibrationAddFailure( );
+  }
+  for( uint8_t i = 0; i < LORAMAC_RX_CALIBRATION_MIN_SAMPLES; i++ )
+  {
+    LoRaMacRxCalibrationAddSample( TEST_RX1_DELAY, 1 );
+  }
+  CHECK( LoRaMacRxCalibrationIsActive( ) );
+
+  for( uint8_t i = 0; i < 10; i++ )
+  {
+    for( uint8_t j = 0; j < ( LORAMAC_RX_CALIBRATION_MAX_FAILURES - 1 ); j++ )
+    {
+      LoRaMacRxCalibrationAddFailure( );
+    }
+    LoRaMacRxCalibrationAddSample( TEST_RX1_DELAY, 1 );
+  }
+  CHECK( LoRaMacRxCalibrationIsActive( ) );
+
+  for( uint8_t j = 0; j < LORAMAC_RX_CALIBRATION_MAX_FAILURES; j++ )
+  {
+    CHECK( LoRaMacRxCalibrationIsActive( ) );
+    LoRaMacRxCalibrationAddFailure( );
+  }
+  CHECK( LoRaMacRxCalibrationIsActive( ) == false );
+}
+
+// Roughly normal timing jitter [us]
+static int32_t jitter( void )
+{
+  int32_t sum = 0;
+
+  for( uint8_t i = 0; i < 12; i++ )
+  {
+    sum += ( int32_t ) ( test_rand() % 2001 ) - 1000;
+  }
+  return ( sum * TEST_JITTER_US ) / 1000;
+}
+
+/**
+  * @brief  Opens one RX window as LoRaMac.c does and feeds the calibration as ProcessRxCalibration() does.
+  * @param[in] u32_delay Nominal RX delay [ms].
+  * @param[in] u32_symbol_time Symbol time of the window [ns].
+  * @param[in] b_downlink A downlink starts in this window.
+  * @param[in] i32_timing_us Start of the downlink after the nominal RX delay [us].
+  * @param[out] listen_ms Time the radio listens until the preamble is detected or the window times out.
+  * @retval true if the downlink is received.
+  */
+static bool rx_window( uint32_t u32_delay, uint32_t u32_symbol_time, bool b_downlink, int32_t i32_timing_us,
+                       double *listen_ms )
+{
+  const int64_t symbol_us = u32_symbol_time / 1000;
+  int32_t correction;
+  uint32_t rx_error;
+  uint32_t window_timeout;
+  int32_t window_offset;
+  int64_t window_delay;
+  int64_t listen_start_us;
+  int64_t listen_end_us;
+  int64_t preamble_us = ( ( int64_t ) u32_delay * 1000 ) + i32_timing_us;
+  int64_t detected_us;
+  uint32_t detect_time;
+  uint32_t preamble_delay;
+
+  LoRaMacRxCalibrationGetWindow( u32_delay, TEST_MAX_RX_ERROR, &correction, &rx_error );
+  RegionCommonComputeRxWindowParameters( u32_symbol_time, TEST_MIN_RX_SYMBOLS, rx_error, TEST_WAKEUP_TIME,
+                                         &window_timeout, &window_offset );
+  window_delay = ( int64_t ) u32_delay + correction + window_offset;
+  listen_start_us = ( window_delay + TEST_WAKEUP_TIME ) * 1000;
+  listen_end_us = listen_start_us + ( window_timeout * symbol_us );
+
+  // The radio needs TEST_MIN_RX_SYMBOLS symbols of the preamble within the window
+  detected_us = MAX( listen_start_us, preamble_us ) + ( TEST_MIN_RX_SYMBOLS * symbol_us );
+  if( !b_downlink || ( detected_us > ( preamble_us + ( TEST_PREAMBLE_SYMBOLS * symbol_us ) ) ) ||
+      ( detected_us > listen_end_us ) )
+  {
+    *listen_ms += ( listen_end_us - listen_start_us ) / 1000.0;
+    return false;
+  }
+  *listen_ms += ( detected_us - listen_start_us ) / 1000.0;
+
+  // ProcessRxCalibration(): timestamps in ms
+  preamble_delay = ( uint32_t ) ( detected_us / 1000 );
+  detect_time = ( ( TEST_MIN_RX_SYMBOLS * ( u32_symbol_time / 1000 ) ) + 500 ) / 1000;
+  if( preamble_delay <= ( window_delay + TEST_WAKEUP_TIME + detect_time ) )
+  {
+    if( window_offset < -( int32_t ) ( TEST_WAKEUP_TIME + 1 ) )
+    {
+      LoRaMacRxCalibrationAddFailure( );
+    }
+    return true;
+  }
+  LoRaMacRxCalibrationAddSample( u32_delay, ( int32_t ) ( preamble_delay - detect_time - u32_delay ) );
+  return true;
+}
+
+/**
+  * @brief  Replays the RX windows of TEST_UPLINKS uplinks, every downlink is expected (ACK).
+  * @param[in] b_calibrated false: the default windows, the calibration is reset before each uplink.
+  * @param[in] b_step Timing step of TEST_STEP_US halfway.
+  */
+static replay_result_t replay( bool b_calibrated, bool b_step )
+{
+  replay_result_t result = { 0 };
+
+  test_rand_state = 1;
+  LoRaMacRxCalibrationReset( );
+  for( uint32_t i = 0; i < TEST_UPLINKS; i++ )
+  {
+    uint32_t u32_downlink = test_rand() % 100;
+    uint32_t u32_symbol_time = ( test_rand() & 1 ) ? symbol_time_dr5 : symbol_time_dr3;
+    int32_t i32_bias = TEST_BIAS_US + ( ( b_step && ( i >= ( TEST_UPLINKS / 2 ) ) ) ? TEST_STEP_US : 0 );
+    bool b_rx1 = ( u32_downlink < 15 );
+    bool b_rx2 = ( u32_downlink >= 15 ) && ( u32_downlink < 18 );
+    bool b_received;
+
+    if( !b_calibrated )
+    {
+      LoRaMacRxCalibrationReset( );
+    }
+    b_received = rx_window( TEST_RX1_DELAY, u32_symbol_time, b_rx1,
+                            i32_bias + ( TEST_DRIFT_PPM * TEST_RX1_DELAY ) / 1000 + jitter(), &result.rx1_listen_ms );
+    if( !b_received )
+    {
+      b_received = rx_window( TEST_RX2_DELAY, symbol_time_dr0, b_rx2,
+                              i32_bias + ( TEST_DRIFT_PPM * TEST_RX2_DELAY ) / 1000 + jitter(), &result.rx2_listen_ms );
+    }
+    if( b_rx1 || b_rx2 )
+    {
+      result.u32_downlinks++;
+      result.u32_received += b_received;
+      if( !b_received )
+      {
+        // Expected downlink missed by both windows
+        LoRaMacRxCalibrationAddFailure( );
+        result.u32_lost_after_step += ( i >= ( TEST_UPLINKS / 2 ) );
+      }
+    }
+  }
+  result.rx1_listen_ms /= TEST_UPLINKS;
+  result.rx2_listen_ms /= TEST_UPLINKS;
+
+  return result;
+}
+
+static void test_replay( void )
+{
+  replay_result_t fixed = replay( false, false );
+  replay_result_t calibrated = replay( true, false );
+  replay_result_t step = replay( true, true );
+
+  printf( "  default windows: RX1 %.1f ms, RX2 %.1f ms per uplink, %u of %u downlinks\n", fixed.rx1_listen_ms,
+          fixed.rx2_listen_ms, fixed.u32_received, fixed.u32_downlinks );
+  printf( "  calibrated:      RX1 %.1f ms, RX2 %.1f ms per uplink, %u of %u downlinks\n", calibrated.rx1_listen_ms,
+          calibrated.rx2_listen_ms, calibrated.u32_received, calibrated.u32_downlinks );
+  printf( "  %d ms step:       %u of %u downlinks, %u lost after the step\n", TEST_STEP_US / 1000,
+          step.u32_received, step.u32_downlinks, step.u32_lost_after_step );
+  CHECK( fixed.u32_received == fixed.u32_downlinks );
+  CHECK( calibrated.u32_received == calibrated.u32_downlinks );
+  CHECK( calibrated.rx1_listen_ms < fixed.rx1_listen_ms );
+  CHECK( calibrated.rx2_listen_ms <= fixed.rx2_listen_ms );
+  CHECK( step.u32_lost_after_step <= LORAMAC_RX_CALIBRATION_MAX_FAILURES );
+  CHECK( ( step.u32_downlinks - step.u32_received ) == step.u32_lost_after_step );
+  CHECK( LoRaMacRxCalibrationIsActive( ) );
+}
+
+int main( void )
+{
+  test_default_window( );
+  test_fit( );
+  test_failure_count( );
+  test_replay( );
+
+  return TEST_END();
+}
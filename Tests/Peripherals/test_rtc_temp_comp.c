@@ -0,0 +1,189 @@
+/**
+* @file test_rtc_temp_comp.c
+* @brief Tests of the RTC temperature compensation (rtc_temp_comp.c).
+*
+* rtc_temp_comp.c is included, HAL_RTCEx_SetSmoothCalib() keeps the CALP and
+* CALM values it is given. For every temperature from -40 to 125 degC:
+* - the frequency error is the parabola of RTC_TEMP_COEFFICIENT and
+*   RTC_TEMP_TURNOVER within 1 ppb
+* - the correction CALP * 512 - CALM is the error in steps of 2^-20 rounded to
+*   the nearest, half steps away from zero, the residual error stays within
+*   half a step (0.477 ppm)
+* - CALP is set for a slow crystal only, CALM is then 512 - steps
+* - the register is only written when CALP or CALM change
+* - invalid temperatures (TEMPERATURE_UNKNOWN, out of range) keep the
+*   calibration, a failed write is repeated with the next temperature
+* TEST_RTC_TEMP_COEFFICIENT replaces the coefficient of lorawan_conf.h, with
+* a positive one the crystal runs fast and only CALM is used.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+#include "test.h"
+#include "utilities.h"
+#include "lorawan_conf.h"
+
+#ifdef TEST_RTC_TEMP_COEFFICIENT
+#undef RTC_TEMP_COEFFICIENT
+#define RTC_TEMP_COEFFICIENT                        TEST_RTC_TEMP_COEFFICIENT
+#endif
+
+// Definitions -----------------------------------------------------------------
+// HAL definitions used by rtc_temp_comp.c, stm32wlxx_hal_rtc_ex.h
+#define RTC_SMOOTHCALIB_PERIOD_32SEC                0x00000000u
+#define RTC_SMOOTHCALIB_PLUSPULSES_SET              0x00008000u
+#define RTC_SMOOTHCALIB_PLUSPULSES_RESET            0x00000000u
+
+#define TEMPERATURE_UNKNOWN                         ( ( int16_t ) 0x8000 )
+#define TEST_STEP_PPB                               ( 1e9 / ( 1 << 20 ) )
+
+typedef enum
+{
+  HAL_OK = 0,
+  HAL_ERROR
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+  uint32_t Instance;
+} RTC_HandleTypeDef;
+
+// Variables -------------------------------------------------------------------
+RTC_HandleTypeDef hrtc;
+
+static uint32_t u32_reg_plus          = RTC_SMOOTHCALIB_PLUSPULSES_RESET;
+static uint32_t u32_reg_minus         = 0;
+static uint32_t u32_writes            = 0;
+static bool b_write_fails             = false;
+
+HAL_StatusTypeDef HAL_RTCEx_SetSmoothCalib( RTC_HandleTypeDef *rtc, uint32_t period, uint32_t plus, uint32_t minus );
+
+#include "rtc_temp_comp.c"
+
+// Stubs -----------------------------------------------------------------------
+HAL_StatusTypeDef HAL_RTCEx_SetSmoothCalib( RTC_HandleTypeDef *rtc, uint32_t period, uint32_t plus, uint32_t minus )
+{
+  CHECK( rtc == &hrtc );
+  CHECK( period == RTC_SMOOTHCALIB_PERIOD_32SEC );
+  CHECK( ( plus == RTC_SMOOTHCALIB_PLUSPULSES_SET ) || ( plus == RTC_SMOOTHCALIB_PLUSPULSES_RESET ) );
+  CHECK( minus <= RTC_TEMP_COMP_CALM_MAX );
+
+  if( b_write_fails )
+  {
+    return HAL_ERROR;
+  }
+  u32_reg_plus  = plus;
+  u32_reg_minus = minus;
+  u32_writes++;
+  return HAL_OK;
+}
+
+// Functions -------------------------------------------------------------------
+// Correction of the register [steps of 2^-20], positive speeds the clock up
+static int32_t test_correction( void )
+{
+  return ( ( u32_reg_plus == RTC_SMOOTHCALIB_PLUSPULSES_SET ) ? RTC_TEMP_COMP_CALP_PULSES : 0 ) - ( int32_t ) u32_reg_minus;
+}
+
+static void test_temperatures( void )
+{
+  double max_residual = 0.0;
+  uint32_t u32_calp = 0;
+
+  for( int16_t i16_temperature = RTC_TEMP_COMP_MIN_TEMPERATURE; i16_temperature <= RTC_TEMP_COMP_MAX_TEMPERATURE; i16_temperature++ )
+  {
+    double delta = ( i16_temperature - RTC_TEMP_TURNOVER * 10.0 ) / 10.0;
+    double error = RTC_TEMP_COEFFICIENT * 1000.0 * delta * delta;
+    int32_t i32_error = 0;
+    int32_t i32_steps = 0;
+
+    rtc_temp_comp_update( i16_temperature );
+    i32_error = rtc_temp_comp_get_error();
+    CHECK( fabs( i32_error - error ) <= 1.0 );
+
+    // Rounded to the nearest of the error the module works with
+    i32_steps = ( int32_t ) lround( -i32_error / TEST_STEP_PPB );
+    CHECK( test_correction() == i32_steps );
+    CHECK( ( u32_reg_plus == RTC_SMOOTHCALIB_PLUSPULSES_SET ) == ( i32_steps > 0 ) );
+    u32_calp += ( u32_reg_plus == RTC_SMOOTHCALIB_PLUSPULSES_SET );
+
+    // Residual of the crystal error
+    max_residual = MAX( max_residual, fabs( error + test_correction() * TEST_STEP_PPB ) );
+  }
+
+  printf( "  coefficient %.4f ppm/degC^2: %u of %u temperatures with CALP, residual error up to %.3f ppm, %u writes\n",
+          RTC_TEMP_COEFFICIENT, u32_calp, RTC_TEMP_COMP_MAX_TEMPERATURE - RTC_TEMP_COMP_MIN_TEMPERATURE + 1,
+          max_residual / 1000.0, u32_writes );
+  CHECK( max_residual <= ( TEST_STEP_PPB / 2 ) + 1.0 );
+  CHECK( ( RTC_TEMP_COEFFICIENT > 0 ) || ( u32_calp > 0 ) );
+  CHECK( ( RTC_TEMP_COEFFICIENT < 0 ) || ( u32_calp == 0 ) );
+}
+
+// The steps around the turnover temperature: CALP only from one step on
+static void test_turnover( void )
+{
+  int16_t i16_turnover = RTC_TEMP_COMP_TURNOVER;
+  int16_t i16_first = i16_turnover;
+
+  rtc_temp_comp_update( i16_turnover );
+  CHECK( rtc_temp_comp_get_error() == 0 );
+  CHECK( u32_reg_plus == RTC_SMOOTHCALIB_PLUSPULSES_RESET );
+  CHECK( u32_reg_minus == 0 );
+
+  // First temperature above the turnover with a correction of one step
+  while( test_correction() == 0 )
+  {
+    rtc_temp_comp_update( ++i16_first );
+  }
+  CHECK( abs( test_correction() ) == 1 );
+  CHECK( fabs( rtc_temp_comp_get_error() ) >= ( TEST_STEP_PPB / 2 ) );
+  CHECK( ( u32_reg_plus == RTC_SMOOTHCALIB_PLUSPULSES_SET ) == ( RTC_TEMP_COEFFICIENT < 0 ) );
+  CHECK( ( RTC_TEMP_COEFFICIENT > 0 ) || ( u32_reg_minus == ( RTC_TEMP_COMP_CALP_PULSES - 1 ) ) );
+  CHECK( ( RTC_TEMP_COEFFICIENT < 0 ) || ( u32_reg_minus == 1 ) );
+
+  rtc_temp_comp_update( i16_first - 1 );
+  CHECK( fabs( rtc_temp_comp_get_error() ) < ( TEST_STEP_PPB / 2 ) );
+  CHECK( test_correction() == 0 );
+
+  // Same on the other side of the parabola
+  rtc_temp_comp_update( ( 2 * i16_turnover ) - i16_first );
+  CHECK( abs( test_correction() ) == 1 );
+}
+
+static void test_writes( void )
+{
+  uint32_t u32_count = 0;
+  int32_t i32_correction = 0;
+
+  rtc_temp_comp_update( -400 );
+  i32_correction = test_correction();
+  u32_count = u32_writes;
+
+  // Same temperature, invalid ones: the register is kept
+  rtc_temp_comp_update( -400 );
+  rtc_temp_comp_update( TEMPERATURE_UNKNOWN );
+  rtc_temp_comp_update( RTC_TEMP_COMP_MIN_TEMPERATURE - 1 );
+  rtc_temp_comp_update( RTC_TEMP_COMP_MAX_TEMPERATURE + 1 );
+  CHECK( u32_writes == u32_count );
+  CHECK( test_correction() == i32_correction );
+
+  // A failed write is repeated with the next temperature
+  b_write_fails = true;
+  rtc_temp_comp_update( 1250 );
+  CHECK( test_correction() == i32_correction );
+  b_write_fails = false;
+  rtc_temp_comp_update( 1250 );
+  CHECK( u32_writes == ( u32_count + 1 ) );
+  CHECK( test_correction() != i32_correction );
+}
+
+int main( void )
+{
+  test_temperatures();
+  test_turnover();
+  test_writes();
+
+  return TEST_END();
+}
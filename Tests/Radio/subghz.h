@@ -0,0 +1,96 @@
+/**
+* @file subghz.h
+* @brief Host replacement of Core/Inc/subghz.h with the SUBGHZ types of
+*        stm32wlxx_hal_subghz.h, the test implements the SPI transactions.
+**/
+
+#ifndef __SUBGHZ_H__
+#define __SUBGHZ_H__
+
+// Includes --------------------------------------------------------------------
+#include "main.h"
+
+// Definitions -----------------------------------------------------------------
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_SUBGHZ_CAD_CLEAR                      = 0x00U,
+  HAL_SUBGHZ_CAD_DETECTED                   = 0x01U,
+} HAL_SUBGHZ_CadStatusTypeDef;
+
+typedef struct
+{
+  uint8_t DeepSleep;
+} SUBGHZ_HandleTypeDef;
+
+typedef enum
+{
+  RADIO_SET_SLEEP                           = 0x84U,
+  RADIO_SET_STANDBY                         = 0x80U,
+  RADIO_SET_FS                              = 0xC1U,
+  RADIO_SET_TX                              = 0x83U,
+  RADIO_SET_RX                              = 0x82U,
+  RADIO_SET_RXDUTYCYCLE                     = 0x94U,
+  RADIO_SET_CAD                             = 0xC5U,
+  RADIO_SET_TXCONTINUOUSWAVE                = 0xD1U,
+  RADIO_SET_TXCONTINUOUSPREAMBLE            = 0xD2U,
+  RADIO_SET_PACKETTYPE                      = 0x8AU,
+  RADIO_SET_RFFREQUENCY                     = 0x86U,
+  RADIO_SET_TXPARAMS                        = 0x8EU,
+  RADIO_SET_PACONFIG                        = 0x95U,
+  RADIO_SET_CADPARAMS                       = 0x88U,
+  RADIO_SET_BUFFERBASEADDRESS               = 0x8FU,
+  RADIO_SET_MODULATIONPARAMS                = 0x8BU,
+  RADIO_SET_PACKETPARAMS                    = 0x8CU,
+  RADIO_RESET_STATS                         = 0x00U,
+  RADIO_CFG_DIOIRQ                          = 0x08U,
+  RADIO_CLR_IRQSTATUS                       = 0x02U,
+  RADIO_CALIBRATE                           = 0x89U,
+  RADIO_CALIBRATEIMAGE                      = 0x98U,
+  RADIO_SET_REGULATORMODE                   = 0x96U,
+  RADIO_SET_TCXOMODE                        = 0x97U,
+  RADIO_SET_TXFALLBACKMODE                  = 0x93U,
+  RADIO_SET_RFSWITCHMODE                    = 0x9DU,
+  RADIO_SET_STOPRXTIMERONPREAMBLE           = 0x9FU,
+  RADIO_SET_LORASYMBTIMEOUT                 = 0xA0U,
+  RADIO_CLR_ERROR                           = 0x07U
+} SUBGHZ_RadioSetCmd_t;
+
+typedef enum
+{
+  RADIO_GET_STATUS                          = 0xC0U,
+  RADIO_GET_PACKETTYPE                      = 0x11U,
+  RADIO_GET_RXBUFFERSTATUS                  = 0x13U,
+  RADIO_GET_PACKETSTATUS                    = 0x14U,
+  RADIO_GET_RSSIINST                        = 0x15U,
+  RADIO_GET_STATS                           = 0x10U,
+  RADIO_GET_IRQSTATUS                       = 0x12U,
+  RADIO_GET_ERROR                           = 0x17U
+} SUBGHZ_RadioGetCmd_t;
+
+// External variables ----------------------------------------------------------
+extern SUBGHZ_HandleTypeDef hsubghz;
+
+// Prototypes ------------------------------------------------------------------
+void MX_SUBGHZ_Init( void );
+void HAL_Delay( uint32_t Delay );
+
+HAL_StatusTypeDef HAL_SUBGHZ_ExecSetCmd( SUBGHZ_HandleTypeDef *hsubghz, SUBGHZ_RadioSetCmd_t Command, uint8_t *pBuffer, uint16_t Size );
+HAL_StatusTypeDef HAL_SUBGHZ_ExecGetCmd( SUBGHZ_HandleTypeDef *hsubghz, SUBGHZ_RadioGetCmd_t Command, uint8_t *pBuffer, uint16_t Size );
+HAL_StatusTypeDef HAL_SUBGHZ_WriteBuffer( SUBGHZ_HandleTypeDef *hsubghz, uint8_t Offset, uint8_t *pBuffer, uint16_t Size );
+HAL_StatusTypeDef HAL_SUBGHZ_ReadBuffer( SUBGHZ_HandleTypeDef *hsubghz, uint8_t Offset, uint8_t *pBuffer, uint16_t Size );
+HAL_StatusTypeDef HAL_SUBGHZ_WriteRegisters( SUBGHZ_HandleTypeDef *hsubghz, uint16_t Address, uint8_t *pBuffer, uint16_t Size );
+HAL_StatusTypeDef HAL_SUBGHZ_ReadRegisters( SUBGHZ_HandleTypeDef *hsubghz, uint16_t Address, uint8_t *pBuffer, uint16_t Size );
+
+// Interrupt callbacks, defined by radio_driver.c
+void HAL_SUBGHZ_TxCpltCallback( SUBGHZ_HandleTypeDef *hsubghz );
+void HAL_SUBGHZ_RxTxTimeoutCallback( SUBGHZ_HandleTypeDef *hsubghz );
+
+#endif /* __SUBGHZ_H__ */
@@ -0,0 +1,493 @@
+/**
+* @file test_radio_shadow.c
+* @brief SPI count of the radio driver (radio.c, radio_driver.c) and checks of
+*        its configuration shadow.
+*
+* The SUBGHZ HAL is replaced by a model of the radio: it keeps the parameters
+* of the last configuration commands, forgets them on a reset (MX_SUBGHZ_Init)
+* and on a sleep without warm start, and the modulation and packet parameters
+* on a packet type command. The radio is driven as LoRaMac.c and RegionEU868.c
+* do for a class A uplink: SetChannel, SetTxConfig, Send, Sleep on TX done,
+* then RX1 and RX2 with Standby, SetChannel, SetRxConfig, Rx and Sleep on the
+* timeout. Checks:
+* - each SetTx and SetRx finds the radio configured: packet type, modulation,
+*   packet parameters, frequency, interrupts, and for SetTx the PA and TX
+*   parameters, with the values of the window (frequency, SF, payload size,
+*   interrupt mask)
+* - the same after a reset (SUBGRF_Init), after a sleep without warm start,
+*   after an FSK uplink between two LoRa ones and after a switch of the modem
+*   to FSK and back without a window in between
+* - the uplinks of the steady state send fewer commands than the first one
+* With TEST_RADIO_REFERENCE the driver before the shadow (Reference/) is
+* built, the checks of the radio are the same. Both print the SPI
+* transactions per uplink.
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "radio_driver.h"
+#include "subghz.h"
+#include "radio_board_if.h"
+#include "stm32_timer.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_UPLINKS                                30
+#define TEST_PAYLOAD_SIZE                           25
+#define TEST_TX_POWER                               14                                // [dBm]
+#define TEST_RX2_FREQUENCY                          869525000
+#define TEST_RX2_SF                                 12
+#define TEST_MAX_RX_WINDOW                          3000
+#define TEST_FSK_DATARATE                           50000
+
+// SPI bytes: opcode, address or offset, status byte of the reads, data
+#define TEST_CMD_OVERHEAD                           1
+#define TEST_GET_OVERHEAD                           2
+#define TEST_REG_OVERHEAD                           3
+#define TEST_BUF_OVERHEAD                           2
+
+typedef enum
+{
+  TEST_CFG_PACKET_TYPE = 0,
+  TEST_CFG_MODULATION,
+  TEST_CFG_PACKET,
+  TEST_CFG_FREQUENCY,
+  TEST_CFG_DIO_IRQ,
+  TEST_CFG_PA,
+  TEST_CFG_TX,
+
+  TEST_CFG_NBR
+} test_cfg_t;
+
+typedef struct
+{
+  uint8_t u8_size;                                  // 0: not configured since the reset
+  uint8_t params[16];
+} test_cfg_cmd_t;
+
+typedef struct
+{
+  uint32_t u32_commands;
+  uint32_t u32_registers;
+  uint32_t u32_buffers;
+  uint32_t u32_bytes;
+  uint32_t u32_config[TEST_CFG_NBR];                // Configuration commands sent
+} test_spi_t;
+
+// What SetTx or SetRx has to find in the radio
+typedef struct
+{
+  uint8_t u8_packet_type;
+  uint32_t u32_frequency;
+  uint8_t u8_sf;                                    // LoRa only
+  uint8_t u8_payload_size;                          // TX only
+  uint16_t u16_irq_mask;
+} test_window_t;
+
+// Variables -------------------------------------------------------------------
+SUBGHZ_HandleTypeDef hsubghz;
+
+static const uint32_t test_channels[] = { 868100000, 868300000, 868500000 };
+
+static test_cfg_cmd_t radio_cfg[TEST_CFG_NBR];
+static test_spi_t spi;
+static test_window_t window;
+static uint32_t u32_tx_done;
+static uint32_t u32_rx_timeouts;
+static RadioEvents_t radio_events;
+
+// Stubs -----------------------------------------------------------------------
+static void test_radio_reset( void )
+{
+  memset( radio_cfg, 0, sizeof( radio_cfg ) );
+}
+
+static void test_radio_configure( test_cfg_t cfg, const uint8_t *params, uint16_t size )
+{
+  CHECK( size <= sizeof( radio_cfg[cfg].params ) );
+  memcpy( radio_cfg[cfg].params, params, size );
+  radio_cfg[cfg].u8_size = ( uint8_t ) size;
+  spi.u32_config[cfg]++;
+}
+
+static bool test_radio_configured( test_cfg_t cfg )
+{
+  return ( radio_cfg[cfg].u8_size != 0 );
+}
+
+// The radio starts the window with the configuration it holds
+static void test_radio_start( bool b_tx )
+{
+  uint32_t u32_channel = ( uint32_t ) ( ( ( uint64_t ) window.u32_frequency << 25 ) / 32000000UL );
+  const uint8_t *frequency = radio_cfg[TEST_CFG_FREQUENCY].params;
+  const uint8_t *irq = radio_cfg[TEST_CFG_DIO_IRQ].params;
+
+  CHECK( test_radio_configured( TEST_CFG_PACKET_TYPE ) );
+  CHECK( test_radio_configured( TEST_CFG_MODULATION ) );
+  CHECK( test_radio_configured( TEST_CFG_PACKET ) );
+  CHECK( test_radio_configured( TEST_CFG_FREQUENCY ) );
+  CHECK( test_radio_configured( TEST_CFG_DIO_IRQ ) );
+  CHECK( !b_tx || test_radio_configured( TEST_CFG_PA ) );
+  CHECK( !b_tx || test_radio_configured( TEST_CFG_TX ) );
+
+  CHECK( radio_cfg[TEST_CFG_PACKET_TYPE].params[0] == window.u8_packet_type );
+  CHECK( ( ( ( uint32_t ) frequency[0] << 24 ) | ( ( uint32_t ) frequency[1] << 16 ) |
+           ( ( uint32_t ) frequency[2] << 8 ) | frequency[3] ) == u32_channel );
+  CHECK( ( ( ( uint16_t ) irq[0] << 8 ) | irq[1] ) == window.u16_irq_mask );
+  if( window.u8_packet_type == PACKET_TYPE_LORA )
+  {
+    CHECK( radio_cfg[TEST_CFG_MODULATION].params[0] == window.u8_sf );
+    CHECK( !b_tx || ( radio_cfg[TEST_CFG_PACKET].params[3] == window.u8_payload_size ) );
+  }
+  else
+  {
+    CHECK( !b_tx || ( radio_cfg[TEST_CFG_PACKET].params[6] == window.u8_payload_size ) );
+  }
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_ExecSetCmd( SUBGHZ_HandleTypeDef *handle, SUBGHZ_RadioSetCmd_t Command, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_commands++;
+  spi.u32_bytes += TEST_CMD_OVERHEAD + Size;
+
+  switch( Command )
+  {
+    case RADIO_SET_PACKETTYPE:
+      // The parameters of the previous packet type do not apply
+      radio_cfg[TEST_CFG_MODULATION].u8_size = 0;
+      radio_cfg[TEST_CFG_PACKET].u8_size = 0;
+      test_radio_configure( TEST_CFG_PACKET_TYPE, pBuffer, Size );
+      break;
+    case RADIO_SET_MODULATIONPARAMS:
+      test_radio_configure( TEST_CFG_MODULATION, pBuffer, Size );
+      break;
+    case RADIO_SET_PACKETPARAMS:
+      test_radio_configure( TEST_CFG_PACKET, pBuffer, Size );
+      break;
+    case RADIO_SET_RFFREQUENCY:
+      test_radio_configure( TEST_CFG_FREQUENCY, pBuffer, Size );
+      break;
+    case RADIO_CFG_DIOIRQ:
+      test_radio_configure( TEST_CFG_DIO_IRQ, pBuffer, Size );
+      break;
+    case RADIO_SET_PACONFIG:
+      test_radio_configure( TEST_CFG_PA, pBuffer, Size );
+      break;
+    case RADIO_SET_TXPARAMS:
+      test_radio_configure( TEST_CFG_TX, pBuffer, Size );
+      break;
+    case RADIO_SET_SLEEP:
+      // Without warm start the radio loses its configuration
+      if( ( pBuffer[0] & ( 1 << 2 ) ) == 0 )
+      {
+        test_radio_reset();
+      }
+      break;
+    case RADIO_SET_TX:
+      test_radio_start( true );
+      break;
+    case RADIO_SET_RX:
+      test_radio_start( false );
+      break;
+    default:
+      break;
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_ExecGetCmd( SUBGHZ_HandleTypeDef *handle, SUBGHZ_RadioGetCmd_t Command, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_commands++;
+  spi.u32_bytes += TEST_GET_OVERHEAD + Size;
+  memset( pBuffer, 0, Size );
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_WriteRegisters( SUBGHZ_HandleTypeDef *handle, uint16_t Address, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_registers++;
+  spi.u32_bytes += TEST_REG_OVERHEAD + Size;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_ReadRegisters( SUBGHZ_HandleTypeDef *handle, uint16_t Address, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_registers++;
+  spi.u32_bytes += TEST_REG_OVERHEAD + 1 + Size;
+  memset( pBuffer, 0, Size );
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_WriteBuffer( SUBGHZ_HandleTypeDef *handle, uint8_t Offset, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_buffers++;
+  spi.u32_bytes += TEST_BUF_OVERHEAD + Size;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SUBGHZ_ReadBuffer( SUBGHZ_HandleTypeDef *handle, uint8_t Offset, uint8_t *pBuffer, uint16_t Size )
+{
+  spi.u32_buffers++;
+  spi.u32_bytes += TEST_BUF_OVERHEAD + 1 + Size;
+  memset( pBuffer, 0, Size );
+  return HAL_OK;
+}
+
+// HAL_SUBGHZ_Init() resets the radio
+void MX_SUBGHZ_Init( void )
+{
+  test_radio_reset();
+}
+
+void HAL_Delay( uint32_t Delay )
+{
+}
+
+int32_t RBI_Init( void )
+{
+  return 0;
+}
+
+int32_t RBI_ConfigRFSwitch( RBI_Switch_TypeDef Config )
+{
+  return 0;
+}
+
+int32_t RBI_GetTxConfig( void )
+{
+  return RBI_CONF_RFO;
+}
+
+int32_t RBI_GetWakeUpTime( void )
+{
+  return RF_WAKEUP_TIME;
+}
+
+int32_t RBI_IsTCXO( void )
+{
+  return IS_TCXO_SUPPORTED;
+}
+
+int32_t RBI_IsDCDC( void )
+{
+  return IS_DCDC_SUPPORTED;
+}
+
+// The TX and RX timeouts are raised by the test
+UTIL_TIMER_Status_t UTIL_TIMER_Create( UTIL_TIMER_Object_t *TimerObject, uint32_t PeriodValue, UTIL_TIMER_Mode_t Mode,
+                                       void ( *Callback )( void * ), void *Argument )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Start( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_Stop( UTIL_TIMER_Object_t *TimerObject )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Status_t UTIL_TIMER_SetPeriod( UTIL_TIMER_Object_t *TimerObject, uint32_t NewPeriodValue )
+{
+  return UTIL_TIMER_OK;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return 0;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return 0 - past;
+}
+
+// Functions -------------------------------------------------------------------
+// LoRaMac.c: the radio sleeps after the TX and after each RX window of class A
+static void on_tx_done( void )
+{
+  u32_tx_done++;
+  Radio.Sleep();
+}
+
+static void on_rx_timeout( void )
+{
+  u32_rx_timeouts++;
+  Radio.Sleep();
+}
+
+// LoRaMacInitialization()
+static void test_init( void )
+{
+  radio_events.TxDone = on_tx_done;
+  radio_events.RxTimeout = on_rx_timeout;
+  Radio.Init( &radio_events );
+  Radio.SetPublicNetwork( true );
+  Radio.Sleep();
+}
+
+// RxWindowSetup() with RegionEU868RxConfig()
+static void test_rx_window( uint32_t u32_frequency, uint8_t u8_sf, uint16_t u16_symbols )
+{
+  uint32_t u32_timeouts = u32_rx_timeouts;
+
+  window = ( test_window_t ) { .u8_packet_type = PACKET_TYPE_LORA, .u32_frequency = u32_frequency, .u8_sf = u8_sf,
+                               .u16_irq_mask = IRQ_RADIO_ALL };
+  Radio.Standby();
+  CHECK( Radio.GetStatus() == RF_IDLE );
+  Radio.SetChannel( u32_frequency );
+  Radio.SetRxConfig( MODEM_LORA, 0, u8_sf, 1, 0, 8, u16_symbols, false, 0, false, 0, 0, true, false );
+  Radio.SetMaxPayloadLength( MODEM_LORA, 255 );
+  Radio.Rx( TEST_MAX_RX_WINDOW );
+
+  // No downlink
+  HAL_SUBGHZ_RxTxTimeoutCallback( &hsubghz );
+  CHECK( u32_rx_timeouts == ( u32_timeouts + 1 ) );
+}
+
+/**
+  * @brief  One class A uplink: RegionEU868TxConfig(), Send, RX1 and RX2.
+  * @param[in] u8_sf LoRa spreading factor, 0 for the FSK datarate (DR7)
+  * @return SPI transactions of the uplink
+  */
+static test_spi_t test_uplink( uint32_t u32_frequency, uint8_t u8_sf )
+{
+  uint8_t payload[TEST_PAYLOAD_SIZE] = { 0 };
+  uint32_t u32_tx = u32_tx_done;
+
+  memset( &spi, 0, sizeof( spi ) );
+  window = ( test_window_t ) { .u32_frequency = u32_frequency, .u8_sf = u8_sf, .u8_payload_size = TEST_PAYLOAD_SIZE,
+                               .u16_irq_mask = IRQ_TX_DONE | IRQ_RX_TX_TIMEOUT };
+  Radio.SetChannel( u32_frequency );
+  if( u8_sf == 0 )
+  {
+    window.u8_packet_type = PACKET_TYPE_GFSK;
+    Radio.SetTxConfig( MODEM_FSK, TEST_TX_POWER, 25000, 0, TEST_FSK_DATARATE, 0, 5, false, true, 0, 0, false, 4000 );
+    Radio.SetMaxPayloadLength( MODEM_FSK, TEST_PAYLOAD_SIZE );
+  }
+  else
+  {
+    window.u8_packet_type = PACKET_TYPE_LORA;
+    Radio.SetTxConfig( MODEM_LORA, TEST_TX_POWER, 0, 0, u8_sf, 1, 8, false, true, 0, 0, false, 4000 );
+    Radio.SetMaxPayloadLength( MODEM_LORA, TEST_PAYLOAD_SIZE );
+  }
+  Radio.Send( payload, TEST_PAYLOAD_SIZE );
+  HAL_SUBGHZ_TxCpltCallback( &hsubghz );
+  CHECK( u32_tx_done == ( u32_tx + 1 ) );
+
+  // RX1 on the uplink channel at the uplink datarate (RX1DROffset 0), RX2 on the default channel
+  test_rx_window( u32_frequency, ( u8_sf == 0 ) ? 7 : u8_sf, 12 );
+  test_rx_window( TEST_RX2_FREQUENCY, TEST_RX2_SF, 8 );
+
+  return spi;
+}
+
+static void test_print( const char *name, const test_spi_t *result )
+{
+  printf( "  %-28s %2u commands, %2u register accesses, %u buffer accesses, %3u SPI bytes\n", name,
+          result->u32_commands, result->u32_registers, result->u32_buffers, result->u32_bytes );
+}
+
+static bool test_all_configured( const test_spi_t *result )
+{
+  for( uint8_t i = 0; i < TEST_CFG_NBR; i++ )
+  {
+    if( result->u32_config[i] == 0 )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Uplinks at DR5 over the 3 default channels
+static void test_steady_state( void )
+{
+  test_spi_t first;
+  test_spi_t steady = { 0 };
+
+  test_init();
+  first = test_uplink( test_channels[0], 7 );
+
+  for( uint32_t i = 1; i < TEST_UPLINKS; i++ )
+  {
+    test_spi_t uplink = test_uplink( test_channels[i % 3], 7 );
+
+    if( i > 3 )
+    {
+      CHECK( memcmp( &uplink, &steady, sizeof( steady ) ) == 0 );
+    }
+    steady = uplink;
+  }
+
+  test_print( "first uplink after init:", &first );
+  test_print( "uplink in steady state:", &steady );
+#ifndef TEST_RADIO_REFERENCE
+  CHECK( steady.u32_commands < first.u32_commands );
+  CHECK( steady.u32_config[TEST_CFG_PACKET_TYPE] == 0 );
+  CHECK( steady.u32_config[TEST_CFG_PA] == 0 );
+#endif
+}
+
+// SUBGRF_Init() resets the radio, the same uplink configures it again
+static void test_reinit( void )
+{
+  test_spi_t uplink;
+
+  test_uplink( test_channels[0], 7 );
+  test_uplink( test_channels[0], 7 );
+  test_init();
+  uplink = test_uplink( test_channels[0], 7 );
+  CHECK( uplink.u32_config[TEST_CFG_FREQUENCY] > 0 );
+  CHECK( uplink.u32_config[TEST_CFG_MODULATION] > 0 );
+}
+
+// A sleep without warm start loses the configuration
+static void test_cold_sleep( void )
+{
+  SleepParams_t params = { 0 };
+  test_spi_t uplink;
+
+  test_uplink( test_channels[1], 9 );
+  test_uplink( test_channels[1], 9 );
+  SUBGRF_SetSleep( params );
+  uplink = test_uplink( test_channels[1], 9 );
+  CHECK( test_all_configured( &uplink ) );
+  test_print( "uplink after a cold sleep:", &uplink );
+}
+
+// An FSK uplink between two LoRa uplinks of the same channel: FSK for the TX, LoRa again for RX1
+static void test_packet_type( void )
+{
+  test_spi_t uplink;
+
+  test_uplink( test_channels[2], 7 );
+  test_uplink( test_channels[2], 7 );
+  uplink = test_uplink( test_channels[2], 0 );
+  CHECK( uplink.u32_config[TEST_CFG_PACKET_TYPE] >= 2 );
+  CHECK( uplink.u32_config[TEST_CFG_MODULATION] >= 2 );
+  CHECK( uplink.u32_config[TEST_CFG_PACKET] >= 2 );
+  test_print( "FSK uplink between LoRa:", &uplink );
+
+  // The modem switched forth and back between two windows of the same modulation (SF12 of RX2)
+  Radio.SetModem( MODEM_FSK );
+  uplink = test_uplink( TEST_RX2_FREQUENCY, TEST_RX2_SF );
+  CHECK( uplink.u32_config[TEST_CFG_MODULATION] > 0 );
+}
+
+int main( void )
+{
+#ifdef TEST_RADIO_REFERENCE
+  printf( "  radio_driver.c before the shadow\n" );
+#endif
+  test_steady_state();
+  test_reinit();
+  test_cold_sleep();
+  test_packet_type();
+
+  return TEST_END();
+}
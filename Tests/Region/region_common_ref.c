@@ -0,0 +1,31 @@
+/**
+* @file region_common_ref.c
+* @brief RegionCommon.c before the channels cache (Reference/), all global names
+*        with the Ref prefix. It is built with the RegionCommon.h of the tree and
+*        leaves the Cache parameter unused.
+**/
+
+// Definitions -----------------------------------------------------------------
+#define RegionCommonGetJoinDc                       RefRegionCommonGetJoinDc
+#define RegionCommonChanVerifyDr                    RefRegionCommonChanVerifyDr
+#define RegionCommonValueInRange                    RefRegionCommonValueInRange
+#define RegionCommonChanDisable                     RefRegionCommonChanDisable
+#define RegionCommonCountChannels                   RefRegionCommonCountChannels
+#define RegionCommonChanMaskCopy                    RefRegionCommonChanMaskCopy
+#define RegionCommonSetBandTxDone                   RefRegionCommonSetBandTxDone
+#define RegionCommonUpdateBandTimeOff               RefRegionCommonUpdateBandTimeOff
+#define RegionCommonParseLinkAdrReq                 RefRegionCommonParseLinkAdrReq
+#define RegionCommonLinkAdrReqVerifyParams          RefRegionCommonLinkAdrReqVerifyParams
+#define RegionCommonComputeSymbolTimeLoRa           RefRegionCommonComputeSymbolTimeLoRa
+#define RegionCommonComputeSymbolTimeFsk            RefRegionCommonComputeSymbolTimeFsk
+#define RegionCommonComputeRxWindowParameters       RefRegionCommonComputeRxWindowParameters
+#define RegionCommonComputeTxPower                  RefRegionCommonComputeTxPower
+#define RegionCommonRxBeaconSetup                   RefRegionCommonRxBeaconSetup
+#define RegionCommonCountNbOfEnabledChannels        RefRegionCommonCountNbOfEnabledChannels
+#define RegionCommonIdentifyChannels                RefRegionCommonIdentifyChannels
+#define RegionCommonRxConfigPrint                   RefRegionCommonRxConfigPrint
+#define RegionCommonTxConfigPrint                   RefRegionCommonTxConfigPrint
+
+// Includes --------------------------------------------------------------------
+#include "region_common_ref.h"
+#include "Reference/RegionCommon.c"
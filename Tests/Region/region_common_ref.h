@@ -0,0 +1,18 @@
+/**
+* @file region_common_ref.h
+* @brief RegionCommon.c before the channels cache (Reference/), the functions of
+*        the channel selection with the Ref prefix.
+**/
+
+#ifndef REGION_COMMON_REF_H
+#define REGION_COMMON_REF_H
+
+#include "RegionCommon.h"
+
+LoRaMacStatus_t RefRegionCommonIdentifyChannels( RegionCommonIdentifyChannelsParam_t* identifyChannelsParam,
+                                                 TimerTime_t* aggregatedTimeOff, uint8_t* enabledChannels,
+                                                 uint8_t* nbEnabledChannels, uint8_t* nbRestrictedChannels,
+                                                 TimerTime_t* nextTxDelay );
+void RefRegionCommonSetBandTxDone( Band_t* band, TimerTime_t lastTxAirTime, bool joined, SysTime_t elapsedTimeSinceStartup );
+
+#endif
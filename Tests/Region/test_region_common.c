@@ -0,0 +1,290 @@
+/**
+* @file test_region_common.c
+* @brief Replay of the channel selection of RegionCommon.c against the one
+*        before the channels cache (region_common_ref.c).
+*
+* A random walk over 16 channels and 6 bands, with channels added and removed,
+* channels mask changes, restored bands, join state, duty cycle and aggregated
+* time-off changes and uplinks of random time-on-air. Each channel selection
+* runs RegionCommonIdentifyChannels() of both implementations, the one of the
+* tree with a RegionCommonChannelsCache_t reset as the regions do:
+* - status, wait time, aggregated time-off and the usable channels are the same
+* - the bands (credits, update time, readiness) are the same after the
+*   selection and after RegionCommonSetBandTxDone()
+* - the tree reads the timer at most as often as the reference
+* The device restarts every TEST_UPTIME. Bands set up after 46 days of uptime
+* are the one difference, the reference wraps their credits (test_late_init).
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "radio.h"
+#include "RegionCommon.h"
+#include "region_common_ref.h"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_STEPS                                  200000
+#define TEST_NB_CHANNELS                            16
+#define TEST_NB_BANDS                               6
+#define TEST_JOIN_CHANNELS                          0x0007
+// Uptime before the device restarts, the timer of the credits wraps after 49.7 days
+#define TEST_UPTIME                                 ( 20UL * 24 * 3600000 )
+
+// Variables -------------------------------------------------------------------
+static const uint16_t band_duty_cycles[TEST_NB_BANDS] = { 1000, 100, 10, 100, 1000, 1 };
+
+static ChannelParams_t channels[TEST_NB_CHANNELS];
+static Band_t bands[TEST_NB_BANDS];
+static Band_t ref_bands[TEST_NB_BANDS];
+static RegionCommonChannelsCache_t cache;
+static uint16_t channels_mask;
+
+static UTIL_TIMER_Time_t now = 1000;
+static uint32_t u32_timer_reads;
+
+// Stubs -----------------------------------------------------------------------
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  u32_timer_reads++;
+  return now;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  u32_timer_reads++;
+  return now - past;
+}
+
+// Only RegionCommonRxBeaconSetup uses the radio, it is not called
+const struct Radio_s Radio;
+
+// Functions -------------------------------------------------------------------
+// Random channel of one of the bands, the datarate range within DR0 to DR7
+static void channel_add( uint8_t id )
+{
+  uint8_t min = test_rand() % 8;
+
+  RegionCommonChannelsCacheReset( &cache );
+  channels[id].Frequency = 868100000 + ( id * 200000 );
+  channels[id].Rx1Frequency = 0;
+  channels[id].DrRange.Fields.Min = min;
+  channels[id].DrRange.Fields.Max = min + ( test_rand() % ( 8 - min ) );
+  channels[id].Band = test_rand() % TEST_NB_BANDS;
+}
+
+static void channel_remove( uint8_t id )
+{
+  RegionCommonChannelsCacheReset( &cache );
+  channels[id] = ( ChannelParams_t ){ 0, 0, { 0 }, 0 };
+}
+
+// The bands as InitDefaults sets them up, also for a restored context
+static void bands_init( void )
+{
+  RegionCommonChannelsCacheReset( &cache );
+  memset( bands, 0, sizeof( bands ) );
+  for( uint8_t i = 0; i < TEST_NB_BANDS; i++ )
+  {
+    bands[i].DCycle = band_duty_cycles[i];
+    bands[i].TxMaxPower = 16;
+  }
+  memcpy( ref_bands, bands, sizeof( bands ) );
+}
+
+static bool bands_equal( void )
+{
+  for( uint8_t i = 0; i < TEST_NB_BANDS; i++ )
+  {
+    if( ( bands[i].DCycle != ref_bands[i].DCycle ) ||
+        ( bands[i].LastBandUpdateTime != ref_bands[i].LastBandUpdateTime ) ||
+        ( bands[i].TimeCredits != ref_bands[i].TimeCredits ) ||
+        ( bands[i].MaxTimeCredits != ref_bands[i].MaxTimeCredits ) ||
+        ( bands[i].ReadyForTransmission != ref_bands[i].ReadyForTransmission ) )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static UTIL_TIMER_Time_t random_delay( void )
+{
+  uint32_t u32_kind = test_rand() % 100;
+
+  if( u32_kind < 60 )
+  {
+    return test_rand() % 60000;
+  }
+  if( u32_kind < 95 )
+  {
+    return test_rand() % 3600000;
+  }
+  return test_rand() % 36000000;
+}
+
+static void test_replay( void )
+{
+  RegionCommonCountNbOfEnabledChannelsParams_t count_params = { 0 };
+  RegionCommonIdentifyChannelsParam_t identify_params = { 0 };
+  TimerTime_t aggregated_time_off = 0;
+  TimerTime_t last_aggregated_tx = 0;
+  UTIL_TIMER_Time_t startup = now;
+  uint32_t u32_timer_reads_tree = 0;
+  uint32_t u32_timer_reads_ref = 0;
+  uint32_t u32_selections = 0;
+  uint32_t u32_uplinks = 0;
+  uint32_t u32_restarts = 0;
+  double hours = 0.0;
+  bool b_joined = false;
+  bool b_duty_cycle = true;
+  bool b_last_tx_join = false;
+
+  for( uint8_t id = 0; id < TEST_NB_CHANNELS; id++ )
+  {
+    channel_add( id );
+  }
+  channels_mask = 0xFFFF;
+  bands_init();
+
+  count_params.Channels = channels;
+  count_params.ChannelsMask = &channels_mask;
+  count_params.MaxNbChannels = TEST_NB_CHANNELS;
+  count_params.JoinChannels = TEST_JOIN_CHANNELS;
+
+  identify_params.MaxBands = TEST_NB_BANDS;
+  identify_params.CountNbOfEnabledChannelsParam = &count_params;
+
+  for( uint32_t step = 0; step < TEST_STEPS; step++ )
+  {
+    uint32_t u32_event = test_rand() % 1000;
+    uint8_t enabled[TEST_NB_CHANNELS], ref_enabled[TEST_NB_CHANNELS];
+    uint8_t nb_enabled, ref_nb_enabled, nb_restricted, ref_nb_restricted;
+    TimerTime_t time_off, ref_time_off, delay, ref_delay;
+    LoRaMacStatus_t status, ref_status;
+    UTIL_TIMER_Time_t step_delay = random_delay();
+
+    // Restart: the clock starts again and InitDefaults sets up the bands
+    if( ( now - startup + step_delay ) > TEST_UPTIME )
+    {
+      now = 1000;
+      startup = now;
+      bands_init();
+      b_joined = false;
+      b_last_tx_join = false;
+      aggregated_time_off = 0;
+      last_aggregated_tx = 0;
+      u32_restarts++;
+    }
+
+    // Changes between the channel selections
+    if( u32_event < 10 )
+    {
+      channel_add( test_rand() % TEST_NB_CHANNELS );
+    }
+    else if( u32_event < 20 )
+    {
+      channel_remove( 3 + ( test_rand() % ( TEST_NB_CHANNELS - 3 ) ) );
+    }
+    else if( u32_event < 40 )
+    {
+      channels_mask = ( uint16_t ) test_rand() | TEST_JOIN_CHANNELS;
+    }
+    else if( u32_event < 42 )
+    {
+      bands_init();
+    }
+    else if( u32_event < 52 )
+    {
+      b_joined = !b_joined;
+    }
+    else if( u32_event < 57 )
+    {
+      b_duty_cycle = !b_duty_cycle;
+    }
+    else if( u32_event < 67 )
+    {
+      aggregated_time_off = test_rand() % 600000;
+      last_aggregated_tx = now;
+    }
+
+    now += step_delay;
+    hours += step_delay / 3600000.0;
+    count_params.Joined = b_joined;
+    count_params.Datarate = test_rand() % 8;
+    count_params.Bands = bands;
+    identify_params.AggrTimeOff = aggregated_time_off;
+    identify_params.LastAggrTx = last_aggregated_tx;
+    identify_params.DutyCycleEnabled = b_duty_cycle;
+    identify_params.LastTxIsJoinRequest = b_last_tx_join;
+    identify_params.ElapsedTimeSinceStartUp.Seconds = ( now - startup ) / 1000;
+    identify_params.ElapsedTimeSinceStartUp.SubSeconds = 0;
+    identify_params.ExpectedTimeOnAir = 1 + ( test_rand() % 3000 );
+
+    count_params.Cache = &cache;
+    u32_timer_reads = 0;
+    time_off = aggregated_time_off;
+    status = RegionCommonIdentifyChannels( &identify_params, &time_off, enabled, &nb_enabled, &nb_restricted, &delay );
+    u32_timer_reads_tree += u32_timer_reads;
+
+    count_params.Cache = NULL;
+    count_params.Bands = ref_bands;
+    u32_timer_reads = 0;
+    ref_time_off = aggregated_time_off;
+    ref_status = RefRegionCommonIdentifyChannels( &identify_params, &ref_time_off, ref_enabled, &ref_nb_enabled,
+                                                  &ref_nb_restricted, &ref_delay );
+    u32_timer_reads_ref += u32_timer_reads;
+    u32_selections++;
+
+    CHECK( status == ref_status );
+    CHECK( time_off == ref_time_off );
+    CHECK( delay == ref_delay );
+    CHECK( nb_enabled == ref_nb_enabled );
+    CHECK( nb_restricted == ref_nb_restricted );
+    CHECK_MEM( enabled, ref_enabled, nb_enabled );
+    CHECK( bands_equal() );
+
+    // Uplink on one of the usable channels
+    if( ( status == LORAMAC_STATUS_OK ) && ( ( test_rand() % 4 ) != 0 ) )
+    {
+      uint8_t band = channels[enabled[test_rand() % nb_enabled]].Band;
+      SysTime_t elapsed = identify_params.ElapsedTimeSinceStartUp;
+
+      now += identify_params.ExpectedTimeOnAir;
+      RegionCommonSetBandTxDone( &bands[band], identify_params.ExpectedTimeOnAir, b_joined, elapsed );
+      RefRegionCommonSetBandTxDone( &ref_bands[band], identify_params.ExpectedTimeOnAir, b_joined, elapsed );
+      CHECK( bands_equal() );
+      aggregated_time_off = time_off;
+      b_last_tx_join = !b_joined;
+      u32_uplinks++;
+    }
+  }
+
+  printf( "  %u channel selections, %u uplinks over %.0f h, %u restarts\n", u32_selections, u32_uplinks, hours,
+          u32_restarts );
+  printf( "  timer reads per selection: %.2f, before the channels cache %.2f\n",
+          ( double ) u32_timer_reads_tree / u32_selections, ( double ) u32_timer_reads_ref / u32_selections );
+  CHECK( u32_timer_reads_tree <= u32_timer_reads_ref );
+}
+
+// The one difference: bands set up after 46 days of uptime. The reference adds the whole uptime to the
+// maximum credits of the new bands and wraps, the tree gives them the maximum.
+static void test_late_init( void )
+{
+  now = 0xF0000000;
+  bands_init();
+  RegionCommonUpdateBandTimeOff( true, bands, TEST_NB_BANDS, true, false, ( SysTime_t ){ 0 }, 1000 );
+  for( uint8_t i = 0; i < TEST_NB_BANDS; i++ )
+  {
+    CHECK( bands[i].TimeCredits == bands[i].MaxTimeCredits );
+    CHECK( bands[i].ReadyForTransmission );
+  }
+}
+
+int main( void )
+{
+  test_replay();
+  test_late_init();
+
+  return TEST_END();
+}
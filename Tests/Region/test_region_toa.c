@@ -0,0 +1,159 @@
+/**
+* @file test_region_toa.c
+* @brief Tests of the time-on-air tables of the regions (REGION_COMMON_TOA_*).
+*
+* radio_toa.c holds RadioTimeOnAir() and its helpers as the Makefile cuts them
+* out of radio.c. For every region, datarate and PHY payload size 0 to 255:
+* - RegionXXGetTimeOnAir() gives the time of RadioTimeOnAir() with the uplink
+*   parameters of the region: coding rate 4/5, 8 preamble symbols, explicit
+*   header and CRC on, or 5 preamble bytes at the FSK datarate
+* - the datarates of the table never reach Radio.TimeOnAir
+* - a size above 255 gives the time of its low byte, as the radio takes an uint8_t
+* - a datarate outside of the region gives 0 without asking the radio
+**/
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include "test.h"
+#include "utilities.h"
+#include "radio.h"
+#include "radio_driver.h"
+#include "RegionAS923.h"
+#include "RegionAU915.h"
+#include "RegionCN470.h"
+#include "RegionCN779.h"
+#include "RegionEU433.h"
+#include "RegionEU868.h"
+#include "RegionIN865.h"
+#include "RegionKR920.h"
+#include "RegionRU864.h"
+#include "RegionUS915.h"
+#include "radio_toa.c"
+
+// Definitions -----------------------------------------------------------------
+#define TEST_FSK_DATARATE                           50
+#define TEST_REGION( name, table_rows )                                                             \
+  { #name, RegionGetTimeOnAir##name, Datarates##name, Bandwidths##name,                            \
+    sizeof( Datarates##name ) / sizeof( Datarates##name[0] ), table_rows }
+
+typedef struct
+{
+  const char *Name;
+  TimerTime_t ( *GetTimeOnAir )( int8_t datarate, uint16_t pktLen );
+  const uint8_t *Datarates;
+  const uint32_t *Bandwidths;
+  uint8_t NbDatarates;
+  uint8_t NbTableRows;
+} test_region_t;
+
+// The regions name their functions RegionXXGetTimeOnAir
+#define RegionGetTimeOnAirAS923                     RegionAS923GetTimeOnAir
+#define RegionGetTimeOnAirAU915                     RegionAU915GetTimeOnAir
+#define RegionGetTimeOnAirCN470                     RegionCN470GetTimeOnAir
+#define RegionGetTimeOnAirCN779                     RegionCN779GetTimeOnAir
+#define RegionGetTimeOnAirEU433                     RegionEU433GetTimeOnAir
+#define RegionGetTimeOnAirEU868                     RegionEU868GetTimeOnAir
+#define RegionGetTimeOnAirIN865                     RegionIN865GetTimeOnAir
+#define RegionGetTimeOnAirKR920                     RegionKR920GetTimeOnAir
+#define RegionGetTimeOnAirRU864                     RegionRU864GetTimeOnAir
+#define RegionGetTimeOnAirUS915                     RegionUS915GetTimeOnAir
+
+// Variables -------------------------------------------------------------------
+// Rows of the tables: the uplink datarates of each region
+static const test_region_t test_regions[] =
+{
+  TEST_REGION( AS923, 8 ),
+  TEST_REGION( AU915, 7 ),
+  TEST_REGION( CN470, 6 ),
+  TEST_REGION( CN779, 8 ),
+  TEST_REGION( EU433, 8 ),
+  TEST_REGION( EU868, 8 ),
+  TEST_REGION( IN865, 8 ),
+  TEST_REGION( KR920, 6 ),
+  TEST_REGION( RU864, 8 ),
+  TEST_REGION( US915, 5 ),
+};
+
+static uint32_t u32_radio_calls;
+
+// Stubs -----------------------------------------------------------------------
+static uint32_t radio_time_on_air( RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                   uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn )
+{
+  u32_radio_calls++;
+  return RadioTimeOnAir( modem, bandwidth, datarate, coderate, preambleLen, fixLen, payloadLen, crcOn );
+}
+
+// The regions only ask the radio for the time-on-air
+const struct Radio_s Radio = { .TimeOnAir = radio_time_on_air };
+
+// Duty cycle bookkeeping of RegionCommon.c, not called by the test
+UTIL_TIMER_Time_t UTIL_TIMER_GetCurrentTime( void )
+{
+  return 0;
+}
+
+UTIL_TIMER_Time_t UTIL_TIMER_GetElapsedTime( UTIL_TIMER_Time_t past )
+{
+  return 0 - past;
+}
+
+// Functions -------------------------------------------------------------------
+static uint32_t bandwidth_index( uint32_t u32_bandwidth )
+{
+  return ( u32_bandwidth == 500000 ) ? 2 : ( ( u32_bandwidth == 250000 ) ? 1 : 0 );
+}
+
+// Uplink time-on-air of RegionXXGetTimeOnAir() before the tables
+static uint32_t radio_uplink_time( const test_region_t *region, uint8_t dr, uint8_t u8_size )
+{
+  uint32_t u32_bandwidth = bandwidth_index( region->Bandwidths[dr] );
+
+  if( region->Datarates[dr] == TEST_FSK_DATARATE )
+  {
+    return RadioTimeOnAir( MODEM_FSK, u32_bandwidth, region->Datarates[dr] * 1000, 0, 5, false, u8_size, true );
+  }
+  return RadioTimeOnAir( MODEM_LORA, u32_bandwidth, region->Datarates[dr], 1, 8, false, u8_size, true );
+}
+
+static void test_region( const test_region_t *region )
+{
+  uint32_t u32_failures = test_failures;
+
+  for( uint8_t dr = 0; dr < region->NbDatarates; dr++ )
+  {
+    // RFU datarates
+    if( region->Datarates[dr] == 0 )
+    {
+      continue;
+    }
+    u32_radio_calls = 0;
+    for( uint16_t size = 0; size < REGION_COMMON_TOA_TABLE_SIZE; size++ )
+    {
+      CHECK( region->GetTimeOnAir( ( int8_t ) dr, size ) == radio_uplink_time( region, dr, ( uint8_t ) size ) );
+    }
+    for( uint16_t size = REGION_COMMON_TOA_TABLE_SIZE; size < 2 * REGION_COMMON_TOA_TABLE_SIZE; size += 17 )
+    {
+      CHECK( region->GetTimeOnAir( ( int8_t ) dr, size ) == radio_uplink_time( region, dr, ( uint8_t ) size ) );
+    }
+    CHECK( ( dr >= region->NbTableRows ) || ( u32_radio_calls == 0 ) );
+  }
+
+  u32_radio_calls = 0;
+  CHECK( region->GetTimeOnAir( -1, 23 ) == 0 );
+  CHECK( region->GetTimeOnAir( ( int8_t ) region->NbDatarates, 23 ) == 0 );
+  CHECK( region->GetTimeOnAir( INT8_MAX, 23 ) == 0 );
+  CHECK( u32_radio_calls == 0 );
+  printf( "  %s: %u datarates in the table, %s\n", region->Name, region->NbTableRows,
+          ( test_failures == u32_failures ) ? "same as radio.c" : "DIFFERENT" );
+}
+
+int main( void )
+{
+  for( uint8_t i = 0; i < sizeof( test_regions ) / sizeof( test_regions[0] ); i++ )
+  {
+    test_region( &test_regions[i] );
+  }
+
+  return TEST_END();
+}
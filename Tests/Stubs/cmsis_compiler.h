@@ -0,0 +1,35 @@
+/**
+* @file cmsis_compiler.h
+* @brief Host replacement of the CMSIS compiler header for the host tests.
+**/
+
+#ifndef __CMSIS_COMPILER_H
+#define __CMSIS_COMPILER_H
+
+// Definitions -----------------------------------------------------------------
+#ifndef __INLINE
+#define __INLINE                                    inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE                             static inline
+#endif
+#ifndef __STATIC_FORCEINLINE
+#define __STATIC_FORCEINLINE                        static inline
+#endif
+#ifndef __weak
+#define __weak                                      __attribute__( ( weak ) )
+#endif
+#ifndef __WEAK
+#define __WEAK                                      __attribute__( ( weak ) )
+#endif
+#ifndef __PACKED
+#define __PACKED                                    __attribute__( ( packed ) )
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED( x )                              __attribute__( ( aligned( x ) ) )
+#endif
+#ifndef __NOP
+#define __NOP()
+#endif
+
+#endif /* __CMSIS_COMPILER_H */
@@ -0,0 +1,13 @@
+/**
+* @file main.h
+* @brief Host replacement of Core/Inc/main.h, the HAL is not built on the host.
+**/
+
+#ifndef __MAIN_H__
+#define __MAIN_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif /* __MAIN_H__ */
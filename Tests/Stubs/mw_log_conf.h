@@ -0,0 +1,12 @@
+/**
+* @file mw_log_conf.h
+* @brief Host replacement of LoRaWAN/Target/mw_log_conf.h, the middleware traces are off.
+**/
+
+#ifndef __MW_LOG_CONF_H__
+#define __MW_LOG_CONF_H__
+
+// Definitions -----------------------------------------------------------------
+#define MW_LOG( TS, VL, ... )
+
+#endif /* __MW_LOG_CONF_H__ */
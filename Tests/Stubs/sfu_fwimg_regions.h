@@ -0,0 +1,22 @@
+/**
+* @file sfu_fwimg_regions.h
+* @brief Host replacement of the secure firmware update slot definitions.
+*
+* The download slot holds the largest file of the fragmentation decoder,
+* rounded up to whole flash pages.
+**/
+
+#ifndef __SFU_FWIMG_REGIONS_H__
+#define __SFU_FWIMG_REGIONS_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+
+// Definitions -----------------------------------------------------------------
+#define SLOT_DWL_1                                  0
+#define SFU_SLOT_DWL_1_SIZE                         ( 27 * 2048 )
+
+static const uint32_t SlotStartAdd[1] = { 0 };
+static const uint32_t SlotEndAdd[1]   = { SFU_SLOT_DWL_1_SIZE - 1 };
+
+#endif /* __SFU_FWIMG_REGIONS_H__ */
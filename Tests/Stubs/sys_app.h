@@ -0,0 +1,24 @@
+/**
+* @file sys_app.h
+* @brief Host replacement of Core/Inc/sys_app.h, the application traces are off.
+**/
+
+#ifndef __SYS_APP_H__
+#define __SYS_APP_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+
+// Definitions -----------------------------------------------------------------
+#define APP_PPRINTF( ... )
+#define APP_TPRINTF( ... )
+#define APP_PRINTF( ... )
+#define APP_LOG( TS, VL, ... )
+
+// Key traces of soft-se.c, KEY_LOG_ENABLED is set by lorawan_conf.h
+#define UTIL_ADV_TRACE_COND_FSend( ... )
+
+// Prototypes ------------------------------------------------------------------
+void GetUniqueId( uint8_t *id );
+
+#endif /* __SYS_APP_H__ */
@@ -0,0 +1,41 @@
+/**
+* @file utilities_conf.h
+* @brief Host replacement of Core/Inc/utilities_conf.h for the host tests.
+**/
+
+#ifndef __UTILITIES_CONF_H__
+#define __UTILITIES_CONF_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+
+// Definitions -----------------------------------------------------------------
+#define VLEVEL_OFF                                  0
+#define VLEVEL_ALWAYS                               0
+#define VLEVEL_L                                    1
+#define VLEVEL_M                                    2
+#define VLEVEL_H                                    3
+
+#define TS_OFF                                      0
+#define TS_ON                                       1
+#define T_REG_OFF                                   0
+
+#define UTIL_PLACE_IN_SECTION( __x__ )
+#undef ALIGN
+#define ALIGN( n )                                  __attribute__( ( aligned( n ) ) )
+
+// The host tests are single threaded
+#define UTILS_INIT_CRITICAL_SECTION()
+#define UTILS_ENTER_CRITICAL_SECTION()
+#define UTILS_EXIT_CRITICAL_SECTION()
+
+#define UTIL_SEQ_INIT_CRITICAL_SECTION()            UTILS_INIT_CRITICAL_SECTION()
+#define UTIL_SEQ_ENTER_CRITICAL_SECTION()           UTILS_ENTER_CRITICAL_SECTION()
+#define UTIL_SEQ_EXIT_CRITICAL_SECTION()            UTILS_EXIT_CRITICAL_SECTION()
+#define UTIL_SEQ_MEMSET8( dest, value, size )       memset( dest, value, size )
+
+// The firmware header provides the memory utilities to its includers
+#include "stm32_mem.h"
+
+#endif /* __UTILITIES_CONF_H__ */
@@ -0,0 +1,65 @@
+/**
+* @file test.h
+* @brief Minimal check macros of the host tests.
+*
+* The tests are built and run with "make -C Tests", see Tests/Makefile.
+**/
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Definitions -----------------------------------------------------------------
+static int test_failures = 0;
+static int test_checks = 0;
+
+#define CHECK( cond )                                                               \
+  do                                                                                \
+  {                                                                                 \
+    test_checks++;                                                                  \
+    if( !( cond ) )                                                                 \
+    {                                                                               \
+      test_failures++;                                                              \
+      printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #cond );           \
+    }                                                                               \
+  } while( 0 )
+
+#define CHECK_MEM( a, b, size )                                                     \
+  do                                                                                \
+  {                                                                                 \
+    test_checks++;                                                                  \
+    if( memcmp( ( a ), ( b ), ( size ) ) != 0 )                                     \
+    {                                                                               \
+      test_failures++;                                                              \
+      printf( "%s:%d: CHECK_MEM( %s, %s ) failed\n", __FILE__, __LINE__, #a, #b );  \
+    }                                                                               \
+  } while( 0 )
+
+// Returns the exit code of the test program
+#define TEST_END()                                                                  \
+  ( printf( "%s: %d checks, %d failed\n", __FILE__, test_checks, test_failures ),   \
+    ( test_failures == 0 ) ? 0 : 1 )
+
+// Host CPU time [s], for the benchmarks
+static inline double test_cpu_time( void )
+{
+  return ( double ) clock() / CLOCKS_PER_SEC;
+}
+
+// Deterministic pseudo random numbers, the same on every host
+static uint32_t test_rand_state = 1;
+
+static inline uint32_t test_rand( void )
+{
+  test_rand_state ^= test_rand_state << 13;
+  test_rand_state ^= test_rand_state >> 17;
+  test_rand_state ^= test_rand_state << 5;
+  return test_rand_state;
+}
+
+#endif /* __TEST_H__ */
@@ -14,13 +14,23 @@
 
 // Includes --------------------------------------------------------------------
 #include <stdbool.h>
+#include "LmHandlerTypes.h"
+#include "base.h"
 // Definitions -----------------------------------------------------------------
 #define APP_APPLICATION_NAME_STR                "ELV-BM-TRX1 JPT Lora Test"
 #define APP_APPLICATION_VERSION_STR             "1.0.0"
 #define APP_LORAWAN_PORT                        10                              // LoRaWAN User application port. Do not use 224. It is reserved for certification.
+#define APP_LORAWAN_BATCH_PORT                  11                              // LoRaWAN port for uplinks carrying a batch of buffered samples
+#define APP_LORAWAN_AGGREGATE_PORT              12                              // LoRaWAN port for uplinks carrying min/max/mean of buffered samples
+#define APP_LORAWAN_COMPRESSED_PORT             13                              // LoRaWAN port for uplinks carrying compressed series of buffered samples
 #define APP_LORAWAN_ADR_STATE                   LORAMAC_HANDLER_ADR_ON          // LoRaWAN Adaptive Data Rate. Please note that when ADR is enabled the end-device should be static.
 #define APP_LORAWAN_DATA_RATE                   DR_0                            // LoRaWAN Default data Rate Data Rate. Please note that LORAWAN_DEFAULT_DATA_RATE is used only when LORAWAN_ADR_STATE is disabled.
-#define APP_LORAMAC_CHECK_BUSY_INTERVAL         200
+#define APP_LORAWAN_BACKFILL_PORT               14                              // LoRaWAN port for uplinks carrying samples from the flash sample log
+#define APP_BACKFILL_INTERVAL                   60000                           // Minimum time between two backfill uplinks [ms], the MAC duty cycle is respected on top
+#define APP_BACKFILL_MAX_SAMPLES                24                              // Maximum number of logged samples per backfill uplink
+#define APP_BACKFILL_RECORD_SIZE                9                               // Age in minutes (2) + NTC temp (2) + HDC2080 temp (2) + humidity (1) + supply voltage (2)
+#define APP_SINGLE_MEASUREMENT_SIZE             5                               // NTC temp (2) + HDC2080 temp (2) + humidity (1)
+#define APP_TX_QUEUE_BUSY_RETRY                 1000                            // Retry period of the TX queue if the MAC refuses the uplink while idle, e.g. Class B beacon or ping slot reservation [ms]
 
 // Exported types --------------------------------------------------------------
 // Exported macro --------------------------------------------------------------
@@ -28,8 +38,17 @@
 void app_init( void );
 
 void app_send_tx_data_cb( void );
+void app_on_tx_queue_timer_event_cb( void *context );
 void app_set_lorawan_payload( void );
-void app_check_loramac_cb( void *context );
+uint8_t app_set_lorawan_header( LmHandlerAppData_t *app_data, base_tx_reason_t tx_reason );
+void app_set_lorawan_measurement( LmHandlerAppData_t *app_data, uint8_t u8_payload_idx );
+uint8_t app_get_lorawan_payload_size( void );
+void app_on_loramac_idle( void );
+void app_release_measurement( bool b_delivered );
+void app_keep_measurement( void );
+
+void app_send_backfill_cb( void );
+void app_on_backfill_timer_event_cb( void *context );
 
 void app_post_join( void );
 void app_post_loramac_busy( void );
@@ -42,6 +61,7 @@ void app_on_tx_timer_event_cb( void *context );
 
 void app_set_dutycycle( uint32_t value );
 uint32_t app_get_dutycycle( void );
+void app_restart_tx_timer( void );
 
 void app_exit_stop_mode( void );
 void app_enable_irqs( void );
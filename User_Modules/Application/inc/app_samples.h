@@ -0,0 +1,74 @@
+/**
+* @file app_samples.h
+* @brief Header file for the application sample ring buffer.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __APP_SAMPLES_H
+#define __APP_SAMPLES_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+
+// Definitions -----------------------------------------------------------------
+#define APP_SAMPLES_RING_SIZE                   64                              // Number of samples kept in RAM between two uplinks
+#define APP_SAMPLES_BODY_HEADER_SIZE            3                               // Sample count (1 byte) + sample interval in seconds (2 bytes)
+#define APP_SAMPLES_BATCH_RECORD_SIZE           7                               // NTC temp (2) + HDC2080 temp (2) + humidity (1) + supply voltage (2)
+#define APP_SAMPLES_AGGREGATE_BODY_SIZE         ( APP_SAMPLES_BODY_HEADER_SIZE + 21 ) // min/max/mean for NTC temp (6), HDC2080 temp (6), humidity (3), supply voltage (6)
+
+#define APP_SAMPLES_HUMIDITY_INVALID            0xFF                            // Humidity value of a sample taken without ELV-AM-TH1
+
+// Exported types --------------------------------------------------------------
+typedef enum
+{
+  APP_UPLINK_MODE_SINGLE = 0,   // One measurement per uplink, taken at send time
+  APP_UPLINK_MODE_BATCH,        // All buffered samples, as many as the current datarate allows
+  APP_UPLINK_MODE_AGGREGATE,    // min/max/mean over all buffered samples
+  APP_UPLINK_MODE_COMPRESSED,   // All buffered samples as delta-of-delta coded series (app_ts_codec.h)
+
+  APP_UPLINK_MODE_NBR
+} app_uplink_mode_t;
+
+typedef struct app_sample_s
+{
+  int16_t i16_ntc_temperature;      // Temperature of the external NTC sensor [0.1 °C]
+  int16_t i16_HDC2080_temperature;  // Temperature from the I2C sensor [0.1 °C]
+  uint16_t u16_supply_voltage;      // Supply voltage [mV]
+  uint8_t u8_HDC2080_humidity;      // Relative humidity from the I2C sensor [%]
+} app_sample_t;
+
+// Exported macro --------------------------------------------------------------
+// Exported functions ----------------------------------------------------------
+void app_samples_init( void );
+void app_samples_start( uint32_t u32_interval_ms );
+void app_samples_stop( void );
+bool app_samples_is_running( void );
+
+bool app_samples_measure( app_sample_t *sample );
+void app_samples_take( void );
+void app_samples_push( const app_sample_t *sample );
+uint8_t app_samples_get_count( void );
+void app_samples_clear( void );
+void app_samples_release( bool b_delivered );
+void app_samples_keep( void );
+
+uint8_t app_samples_encode_batch( uint8_t *buffer, uint8_t u8_max_size );
+uint8_t app_samples_encode_aggregate( uint8_t *buffer, uint8_t u8_max_size );
+uint8_t app_samples_encode_compressed( uint8_t *buffer, uint8_t u8_max_size );
+uint8_t app_samples_get_encoded_size( app_uplink_mode_t uplink_mode, uint8_t u8_max_size );
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+  * @}
+  */
+
+#endif /* __APP_SAMPLES_H */
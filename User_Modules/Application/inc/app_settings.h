@@ -15,6 +15,7 @@
 // Includes --------------------------------------------------------------------
 #include "eeprom_emul_types.h"
 #include "flash_user_func.h"
+#include "app_samples.h"
 #include <stdbool.h>
 // Definitions -----------------------------------------------------------------
 #define APP_DL_PORT                 10
@@ -23,10 +24,14 @@
 #define APP_DEVICE_ID               0x01
 
 #define APP_DUTYCYCLE_DEFAULT       30000 // 30 seconds
+#define APP_SAMPLE_INTERVAL_DEFAULT 0     // 0 = no sampling between uplinks
+#define APP_UPLINK_MODE_DEFAULT     APP_UPLINK_MODE_SINGLE
 
 // SETTINGS - APP_DEFAULT - START
-#define APP_SETTING_DEFAULT         {                        \
-                                      APP_DUTYCYCLE_DEFAULT, \
+#define APP_SETTING_DEFAULT         {                              \
+                                      APP_DUTYCYCLE_DEFAULT,       \
+                                      APP_SAMPLE_INTERVAL_DEFAULT, \
+                                      APP_UPLINK_MODE_DEFAULT,     \
                                     }
 // SETTINGS - APP_DEFAULT - END
 
@@ -34,6 +39,8 @@
 typedef struct
 {
   uint32_t u32_app_dutycycle;
+  uint32_t u32_app_sample_interval;
+  uint32_t u32_app_uplink_mode;
 } application_settings_t;
 
 // Exported macro --------------------------------------------------------------
@@ -0,0 +1,55 @@
+/**
+* @file app_ts_codec.h
+* @brief Header file for the time series codec of batched sensor uplinks.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __APP_TS_CODEC_H
+#define __APP_TS_CODEC_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+
+// Definitions -----------------------------------------------------------------
+// A series is encoded as:
+//   Byte 0:  series id (app_ts_series_id_t)
+//   Token 0: first value, zig-zag varint
+//   Token 1: first delta, zig-zag varint (only if the series has more than one value)
+//   Then one token per further value or per run of values:
+//     varint( zigzag( delta-of-delta ) << 1 )      delta-of-delta != 0
+//     varint( ( ( run - 1 ) << 1 ) | 1 )          run of delta-of-delta == 0
+// The number of values is not part of the series, it is sent once for all series.
+#define APP_TS_CODEC_VARINT_MAX_SIZE            5
+
+// Exported types --------------------------------------------------------------
+typedef enum
+{
+  APP_TS_SERIES_NTC_TEMPERATURE = 0x01,
+  APP_TS_SERIES_HDC2080_TEMPERATURE,
+  APP_TS_SERIES_HDC2080_HUMIDITY,
+  APP_TS_SERIES_SUPPLY_VOLTAGE,
+} app_ts_series_id_t;
+
+// Exported macro --------------------------------------------------------------
+// Exported functions ----------------------------------------------------------
+uint16_t app_ts_codec_get_series_size( const int16_t *values, uint8_t u8_count );
+uint16_t app_ts_codec_encode_series( uint8_t *buffer, app_ts_series_id_t series_id, const int16_t *values, uint8_t u8_count );
+
+uint32_t app_ts_codec_zigzag( int32_t i32_value );
+uint8_t app_ts_codec_get_varint_size( uint32_t u32_value );
+uint8_t app_ts_codec_put_varint( uint8_t *buffer, uint32_t u32_value );
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+  * @}
+  */
+
+#endif /* __APP_TS_CODEC_H */
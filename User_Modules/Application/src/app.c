@@ -19,20 +19,29 @@
 #include "stm32_seq.h"
 #include <stdbool.h>
 #include <stdint.h>
-#include "user_timer.h"
 #include "stm32_lpm_if.h"
 #include <stdio.h>
 #include "adc_if.h"
 #include "i2c.h"
 #include "ELV-AM-TH1.h"
+#include "app_samples.h"
+#include "flash_sample_log.h"
+#include "utilities.h"
+#include "base_tx_queue.h"
+#include "base_tx_power.h"
+#include "sys_app.h"
 
 // Definitions -----------------------------------------------------------------
 // Typedefs --------------------------------------------------------------------
 // Variables -------------------------------------------------------------------
 static application_settings_t app_settings              = APP_SETTING_DEFAULT;
 static UTIL_TIMER_Object_t app_tx_timer;
-static UTIL_TIMER_Object_t app_check_loramac_timer;
-static uint32_t remaining_time_tx_timer                 = 0;
+static UTIL_TIMER_Object_t app_backfill_timer;
+static UTIL_TIMER_Object_t app_tx_queue_timer;
+static UTIL_TIMER_Time_t app_cycle_start               = 0;      // Time of the last cyclic event, the next one is one interval later
+static app_sample_t single_sample;                                // Measurement of the last single mode payload
+static bool b_single_sample_pending                     = false;
+static bool b_wait_for_loramac_idle                     = false;  // app_post_loramac_busy() is due when the MAC gets idle
 
 base_callbacks_t base_app_cb =
 {
@@ -41,6 +50,7 @@ base_callbacks_t base_app_cb =
   .base_user_button_event                               = app_user_button_event,
   .base_enable_irqs                                     = app_enable_irqs,
   .base_disable_irqs                                    = app_disable_irqs,
+  .base_loramac_idle                                    = app_on_loramac_idle,
 };
 
 static lpm_callbacks_t lpm_app_cb =
@@ -56,6 +66,7 @@ void app_init( void )
 
   lpm_init_cb( &lpm_app_cb );
   flash_user_func_init( false );
+  flash_sample_log_init();
 
   app_eeprom_get_settings( &app_settings );
   app_settings_print( app_settings );
@@ -63,21 +74,25 @@ void app_init( void )
   // Init the ELV-AM-TH1 depending hardware
   elv_am_th1_init();
 
+  // Sampling between uplinks, independent of the uplink interval
+  app_samples_init();
+
   // registriere neuen Task im scheduler (enum taskid, ?, callback)
   UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_lora_tx_task ), UTIL_SEQ_RFU, app_send_tx_data_cb );
 
   // UTIL_SEQ_SetTask(enum id, enum prio)
 
   // neuer Timer (timerdaten, ?  ,einmalig, callback, null)
-  UTIL_TIMER_Create( &app_check_loramac_timer,  0xFFFFFFFFU, UTIL_TIMER_ONESHOT, app_check_loramac_cb, NULL );
-
-  // wecker einstellen (timerdaten, intervall [ms])
-  UTIL_TIMER_SetPeriod( &app_check_loramac_timer, APP_LORAMAC_CHECK_BUSY_INTERVAL );
+  UTIL_TIMER_Create( &app_tx_timer,  0xFFFFFFFFU, UTIL_TIMER_ONESHOT, app_on_tx_timer_event_cb, NULL );
 
-  // timer starten(timerdaten)
-  // UTIL_TIMER_Start( &app_check_loramac_timer);
+  // Uplinks which the MAC can not take right now stay queued and are retried when the MAC allows it
+  base_tx_queue_init();
+  UTIL_TIMER_Create( &app_tx_queue_timer,  0xFFFFFFFFU, UTIL_TIMER_ONESHOT, app_on_tx_queue_timer_event_cb, NULL );
 
-  UTIL_TIMER_Create( &app_tx_timer,  0xFFFFFFFFU, UTIL_TIMER_ONESHOT, app_on_tx_timer_event_cb, NULL );
+  // Samples which could not be sent are kept in the flash sample log and sent later by the backfill task
+  UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_app_backfill_task ), UTIL_SEQ_RFU, app_send_backfill_cb );
+  UTIL_TIMER_Create( &app_backfill_timer,  0xFFFFFFFFU, UTIL_TIMER_ONESHOT, app_on_backfill_timer_event_cb, NULL );
+  UTIL_TIMER_SetPeriod( &app_backfill_timer, APP_BACKFILL_INTERVAL );
 
   // bei TTN anmelden
   base_init( &base_app_cb, APP_LORAWAN_ADR_STATE, APP_LORAWAN_DATA_RATE );
@@ -86,23 +101,98 @@ void app_init( void )
 
 void app_send_tx_data_cb( void )
 {
+  base_tx_queue_entry_t entry;
   UTIL_TIMER_Time_t next_tx_in = 0;
+  LmHandlerErrorStatus_t ret;
+
+  if( !base_tx_queue_peek( &entry ) )
+  {
+    return;
+  }
+  UTIL_TIMER_Stop( &app_tx_queue_timer );
+
+  // While the band is in its time-off the MAC would reject the uplink, wait for the band instead
+  next_tx_in = base_get_next_tx_in( app_get_lorawan_payload_size() );
+  if( next_tx_in == 0 )
+  {
+    base_set_tx_reason( entry.tx_reason );
+    base_set_lora_msg_type( entry.msg_type );
+
+    app_set_lorawan_payload();
+    ret = base_tx( &next_tx_in );
+  }
+  else
+  {
+    ret = LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED;
+  }
 
-  app_set_lorawan_payload();
-  UTIL_TIMER_Start( &app_check_loramac_timer );
-  base_tx( &next_tx_in );
+  if( ( ret == LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED ) || ( ret == LORAMAC_HANDLER_BUSY_ERROR ) )
+  {
+    // Keep the entry and its samples, the payload is built again when the MAC allows the next uplink:
+    // after the duty cycle wait time or, if the MAC is busy, when it reports idle
+    app_keep_measurement();
+    if( ret == LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED )
+    {
+      UTIL_TIMER_SetPeriod( &app_tx_queue_timer, MAX( next_tx_in, 1 ) );
+      UTIL_TIMER_Start( &app_tx_queue_timer );
+    }
+    else if( !LoRaMacIsBusy() )
+    {
+      // Refused by the Class B beacon/ping slot reservation or an uplink collision, no idle event follows
+      UTIL_TIMER_SetPeriod( &app_tx_queue_timer, APP_TX_QUEUE_BUSY_RETRY );
+      UTIL_TIMER_Start( &app_tx_queue_timer );
+    }
+  }
+  else
+  {
+    base_tx_queue_pop( &entry, ret == LORAMAC_HANDLER_SUCCESS );
+    app_release_measurement( ret == LORAMAC_HANDLER_SUCCESS );
+  }
+
+  // The MAC reports the end of the uplink through app_on_loramac_idle(). Without an uplink in progress the
+  // follow-up is done right away.
+  if( ( ret == LORAMAC_HANDLER_SUCCESS ) || LoRaMacIsBusy() )
+  {
+    b_wait_for_loramac_idle = true;
+  }
+  else
+  {
+    app_post_loramac_busy();
+  }
+
+  if( ret != LORAMAC_HANDLER_SUCCESS )
+  {
+    return;
+  }
+
+  // The network is reachable again: send what was logged while it was not
+  if( !UTIL_TIMER_IsRunning( &app_backfill_timer ) && !flash_sample_log_is_empty() )
+  {
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, APP_BACKFILL_INTERVAL );
+    UTIL_TIMER_Start( &app_backfill_timer );
+  }
+}
+
+void app_on_tx_queue_timer_event_cb( void *context )
+{
+  UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_lora_tx_task ), CFG_SEQ_Prio_0 );
 }
 
 void app_set_lorawan_payload( void )
 {
   LmHandlerAppData_t *app_data = base_get_app_data_ptr();
 
-  app_data->Port = APP_LORAWAN_PORT;
+  uint8_t u8_payload_idx = app_set_lorawan_header( app_data, base_get_tx_reason() );
+
+  app_set_lorawan_measurement( app_data, u8_payload_idx );
+}
 
+uint8_t app_set_lorawan_header( LmHandlerAppData_t *app_data, base_tx_reason_t tx_reason )
+{
   uint8_t u8_payload_idx = 0;
 
   // Byte 0: TX-Reason
-  app_data->Buffer[u8_payload_idx++] = base_get_tx_reason();
+  app_data->Buffer[u8_payload_idx++] = tx_reason;
 
   // Byte 1: TX Power (dBm)
   int8_t i8_tx_power = 0;
@@ -120,50 +210,242 @@ void app_set_lorawan_payload( void )
   app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( battery >> 8 );
   app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( battery );
 
-  if( elv_am_th1_is_present() )
+  return u8_payload_idx;
+}
+
+void app_set_lorawan_measurement( LmHandlerAppData_t *app_data, uint8_t u8_payload_idx )
+{
+  uint8_t u8_max_size = base_get_max_app_payload_size();
+  uint8_t u8_body_size = 0;
+
+  if( app_samples_is_running() && ( app_settings.u32_app_uplink_mode != APP_UPLINK_MODE_SINGLE ) && ( u8_max_size > u8_payload_idx ) )
+  {
+    // Nothing sampled since the last uplink (e.g. button event right after an uplink): take a sample now
+    if( app_samples_get_count() == 0 )
+    {
+      app_samples_take();
+    }
+
+    if( app_settings.u32_app_uplink_mode == APP_UPLINK_MODE_BATCH )
+    {
+      u8_body_size = app_samples_encode_batch( &app_data->Buffer[u8_payload_idx], u8_max_size - u8_payload_idx );
+      app_data->Port = APP_LORAWAN_BATCH_PORT;
+    }
+    else if( app_settings.u32_app_uplink_mode == APP_UPLINK_MODE_COMPRESSED )
+    {
+      u8_body_size = app_samples_encode_compressed( &app_data->Buffer[u8_payload_idx], u8_max_size - u8_payload_idx );
+      app_data->Port = APP_LORAWAN_COMPRESSED_PORT;
+    }
+    else
+    {
+      u8_body_size = app_samples_encode_aggregate( &app_data->Buffer[u8_payload_idx], u8_max_size - u8_payload_idx );
+      app_data->Port = APP_LORAWAN_AGGREGATE_PORT;
+    }
+
+    if( u8_body_size != 0 )
+    {
+      app_data->BufferSize = u8_payload_idx + u8_body_size;
+      return;
+    }
+  }
+
+  // Single measurement taken at send time
+  app_data->Port = APP_LORAWAN_PORT;
+
+  if( app_samples_measure( &single_sample ) )
   {
-    th1_data_values_t t_th1_data_values = { 0 };
-    elv_am_th1_do_measurements( &t_th1_data_values );
+    b_single_sample_pending = true;
 
-    //APP_LOG( TS_OFF, VLEVEL_L, "Check Value:     %5u %%\r\n", t_th1_data_values.u8_HDC2080_humidity );
+    //APP_LOG( TS_OFF, VLEVEL_L, "Check Value:     %5u %%\r\n", single_sample.u8_HDC2080_humidity );
 
     //app_data->Buffer[u8_payload_idx++] = 0x02;                                                            // Datatype: Temperature
-    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( t_th1_data_values.i16_ntc_temperature >> 8 );      // Temperature [High Byte]
-    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( t_th1_data_values.i16_ntc_temperature );           // Temperature [Low Byte]
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( single_sample.i16_ntc_temperature >> 8 );          // Temperature [High Byte]
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( single_sample.i16_ntc_temperature );               // Temperature [Low Byte]
 
     //app_data->Buffer[u8_payload_idx++] = 0x03;                                                            // Datatype: Temperature + Relative Humidity
-    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( t_th1_data_values.i16_HDC2080_temperature >> 8 );  // Temperature [High Byte]
-    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( t_th1_data_values.i16_HDC2080_temperature );       // Temperature [Low Byte]
-    app_data->Buffer[u8_payload_idx++] = t_th1_data_values.u8_HDC2080_humidity;                           // Relative Humidity
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( single_sample.i16_HDC2080_temperature >> 8 );      // Temperature [High Byte]
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( single_sample.i16_HDC2080_temperature );           // Temperature [Low Byte]
+    app_data->Buffer[u8_payload_idx++] = single_sample.u8_HDC2080_humidity;                               // Relative Humidity
   }
 
-  app_data->BufferSize = u8_payload_idx;  // Watch out! The maximum payload size must not exceed 51 bytes!
+  app_data->BufferSize = u8_payload_idx;  // Watch out! The single measurement payload must not exceed 51 bytes (DR0)!
 }
 
-void app_check_loramac_cb( void *context )
+/**
+  * @brief  Size of the payload app_set_lorawan_payload() builds with the samples buffered now.
+  *         Nothing is measured or encoded, the size decides how long the band time-off delays the uplink.
+  * @retval Payload size [bytes]
+  */
+uint8_t app_get_lorawan_payload_size( void )
 {
-  if( LoRaMacIsBusy() )
+  uint8_t u8_max_size = base_get_max_app_payload_size();
+  uint8_t u8_body_size = 0;
+
+  if( app_samples_is_running() && ( app_settings.u32_app_uplink_mode != APP_UPLINK_MODE_SINGLE ) && ( u8_max_size > BASE_HEADER_LENGTH ) )
   {
-    UTIL_TIMER_Start( &app_check_loramac_timer );
+    u8_body_size = app_samples_get_encoded_size( ( app_uplink_mode_t ) app_settings.u32_app_uplink_mode, u8_max_size - BASE_HEADER_LENGTH );
   }
-  else
+
+  // Single measurement taken at send time, see app_set_lorawan_measurement()
+  if( ( u8_body_size == 0 ) && elv_am_th1_is_present() )
   {
+    u8_body_size = APP_SINGLE_MEASUREMENT_SIZE;
+  }
+
+  return BASE_HEADER_LENGTH + u8_body_size;
+}
+
+void app_on_loramac_idle( void )
+{
+  if( b_wait_for_loramac_idle )
+  {
+    b_wait_for_loramac_idle = false;
     app_post_loramac_busy();
   }
+  else if( !base_tx_queue_is_empty() && !UTIL_TIMER_IsRunning( &app_tx_queue_timer ) )
+  {
+    // The MAC was busy with another uplink (e.g. backfill), the queue can go on now
+    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_lora_tx_task ), CFG_SEQ_Prio_0 );
+  }
+}
+
+void app_release_measurement( bool b_delivered )
+{
+  app_samples_release( b_delivered );
+
+  if( b_single_sample_pending && !b_delivered )
+  {
+    flash_sample_log_append( &single_sample );
+  }
+  b_single_sample_pending = false;
+}
+
+void app_keep_measurement( void )
+{
+  app_samples_keep();
+  b_single_sample_pending = false;   // A new single measurement is taken with the next attempt
+}
+
+void app_send_backfill_cb( void )
+{
+  LmHandlerAppData_t *app_data = base_get_app_data_ptr();
+  app_sample_t samples[APP_BACKFILL_MAX_SAMPLES];
+  uint32_t u32_ages_s[APP_BACKFILL_MAX_SAMPLES];
+  UTIL_TIMER_Time_t next_tx_in = 0;
+  uint8_t u8_max_size = base_get_max_app_payload_size();
+  uint8_t u8_max_samples = 0;
+  uint8_t u8_count = 0;
+  uint8_t u8_payload_idx = 0;
+
+  // Queued uplinks go first, the backfill only uses the air time left over
+  if( LoRaMacIsBusy() || !base_get_is_joined() || !base_tx_queue_is_empty() )
+  {
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, APP_BACKFILL_INTERVAL );
+    UTIL_TIMER_Start( &app_backfill_timer );
+    return;
+  }
+
+  if( u8_max_size > ( BASE_HEADER_LENGTH + 1 ) )
+  {
+    u8_max_samples = MIN( ( u8_max_size - BASE_HEADER_LENGTH - 1 ) / APP_BACKFILL_RECORD_SIZE, APP_BACKFILL_MAX_SAMPLES );
+  }
+
+  // The peek leaves the log as it is until flash_sample_log_confirm_peek()
+  u8_count = flash_sample_log_peek( samples, u32_ages_s, u8_max_samples );
+  if( u8_count == 0 )
+  {
+    return;
+  }
+
+  next_tx_in = base_get_next_tx_in( BASE_HEADER_LENGTH + 1 + ( u8_count * APP_BACKFILL_RECORD_SIZE ) );
+  if( next_tx_in != 0 )
+  {
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, MAX( next_tx_in, APP_BACKFILL_INTERVAL ) );
+    UTIL_TIMER_Start( &app_backfill_timer );
+    return;
+  }
+
+  app_data->Port = APP_LORAWAN_BACKFILL_PORT;
+  u8_payload_idx = app_set_lorawan_header( app_data, TX_REASON_BACKFILL_EVENT );
+  app_data->Buffer[u8_payload_idx++] = u8_count;
+
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    uint16_t u16_age_min = ( u32_ages_s[i] == FLASH_SAMPLE_LOG_AGE_UNKNOWN ) ? 0xFFFF : ( uint16_t ) MIN( u32_ages_s[i] / 60, 0xFFFE );
+
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( u16_age_min >> 8 );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( u16_age_min );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( ( uint16_t ) samples[i].i16_ntc_temperature >> 8 );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( samples[i].i16_ntc_temperature );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( ( uint16_t ) samples[i].i16_HDC2080_temperature >> 8 );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( samples[i].i16_HDC2080_temperature );
+    app_data->Buffer[u8_payload_idx++] = samples[i].u8_HDC2080_humidity;
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( samples[i].u16_supply_voltage >> 8 );
+    app_data->Buffer[u8_payload_idx++] = ( uint8_t ) ( samples[i].u16_supply_voltage );
+  }
+  app_data->BufferSize = u8_payload_idx;
+
+  base_set_lora_msg_type( LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  LmHandlerErrorStatus_t ret = base_tx( &next_tx_in );
+
+  if( ret == LORAMAC_HANDLER_SUCCESS )
+  {
+    flash_sample_log_confirm_peek();
+    if( flash_sample_log_is_empty() )
+    {
+      return;
+    }
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, APP_BACKFILL_INTERVAL );
+  }
+  else if( ret == LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED )
+  {
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, MAX( next_tx_in, APP_BACKFILL_INTERVAL ) );
+  }
+  else
+  {
+    UTIL_TIMER_SetPeriod( &app_backfill_timer, APP_BACKFILL_INTERVAL );
+  }
+  UTIL_TIMER_Start( &app_backfill_timer );
+}
+
+void app_on_backfill_timer_event_cb( void *context )
+{
+  UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_app_backfill_task ), CFG_SEQ_Prio_0 );
 }
 
 void app_post_join( void )
 {
+  app_samples_start( app_settings.u32_app_sample_interval );
   app_on_tx_timer_event_cb( NULL );
 }
 
 void app_post_loramac_busy( void )
 {
+  base_tx_queue_stats_t tx_queue_stats;
+  base_tx_power_stats_t tx_power_stats;
+
   base_set_tx_reason( TX_REASON_UNDEFINED_EVENT );
 
-  user_timer_restart( &app_tx_timer, &remaining_time_tx_timer, app_get_dutycycle() );
+  base_tx_queue_get_stats( &tx_queue_stats );
+  APP_LOG( TS_OFF, VLEVEL_L, "TX queue: %u queued, %u coalesced, %u dropped, %u sent, %u pending\r\n",
+           tx_queue_stats.u32_queued, tx_queue_stats.u32_coalesced, tx_queue_stats.u32_dropped,
+           tx_queue_stats.u32_sent, base_tx_queue_get_count() );
+
+  // Charge per uplink delivered, to compare the TX power strategies
+  base_tx_power_get_stats( &tx_power_stats );
+  APP_LOG( TS_OFF, VLEVEL_L, "TX power: %u uC per uplink, %u uplinks, %u lost, %u link checks, %u steps up, %u steps down\r\n",
+           base_tx_power_get_charge_per_uplink(), tx_power_stats.u32_uplinks, tx_power_stats.u32_lost,
+           tx_power_stats.u32_link_checks, tx_power_stats.u32_steps_up, tx_power_stats.u32_steps_down );
+
+  app_restart_tx_timer();
 
   base_enable_irqs();
+
+  // Requests which came in during the uplink, unless they already wait for the duty cycle
+  if( !base_tx_queue_is_empty() && !UTIL_TIMER_IsRunning( &app_tx_queue_timer ) )
+  {
+    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_lora_tx_task ), CFG_SEQ_Prio_0 );
+  }
 }
 
 void app_process_downlink( uint8_t port, uint8_t *buffer, uint8_t buffer_size )
@@ -173,7 +455,7 @@ void app_process_downlink( uint8_t port, uint8_t *buffer, uint8_t buffer_size )
     case APP_DL_PORT:
       app_settings_process_dl( buffer, buffer_size ); // Process the downlink data
       app_eeprom_get_settings( &app_settings ); // Load the new stored application settings
-      remaining_time_tx_timer = 0;              // Set the variable to zero to use the new duty cycle
+      app_samples_start( app_settings.u32_app_sample_interval );  // Restart sampling with the new interval
       app_settings_print( app_settings );       // Print the new application settings over UART
       break;
     default:
@@ -183,11 +465,9 @@ void app_process_downlink( uint8_t port, uint8_t *buffer, uint8_t buffer_size )
 
 void app_user_button_event( void )
 {
-  UTIL_TIMER_GetRemainingTime( &app_tx_timer, &remaining_time_tx_timer );
   UTIL_TIMER_Stop( &app_tx_timer );
 
-  base_set_tx_reason( TX_REASON_USER_BUTTON_EVENT );
-  base_set_lora_msg_type( LORAMAC_HANDLER_CONFIRMED_MSG );
+  base_tx_queue_push( TX_REASON_USER_BUTTON_EVENT, LORAMAC_HANDLER_CONFIRMED_MSG );
 
   // start LoRaWAN transmit task
   UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_lora_tx_task ), CFG_SEQ_Prio_0 );
@@ -201,10 +481,11 @@ void app_cyclic_event( void )
 
 void app_on_tx_timer_event_cb( void *context )
 {
+  app_cycle_start = UTIL_TIMER_GetCurrentTime();
+
   base_disable_irqs();
 
-  base_set_tx_reason( TX_REASON_APP_CYCLE_EVENT );
-  base_set_lora_msg_type( LORAMAC_HANDLER_UNCONFIRMED_MSG );
+  base_tx_queue_push( TX_REASON_APP_CYCLE_EVENT, LORAMAC_HANDLER_UNCONFIRMED_MSG );
 
   app_cyclic_event();
 }
@@ -216,14 +497,32 @@ void app_set_dutycycle( uint32_t value )
 
 uint32_t app_get_dutycycle( void )
 {
-  if( app_settings.u32_app_dutycycle > BASE_DUTYCYCLE_CORRECTION_MS )
+  return app_settings.u32_app_dutycycle;
+}
+
+void app_restart_tx_timer( void )
+{
+  UTIL_TIMER_Time_t elapsed = UTIL_TIMER_GetElapsedTime( app_cycle_start );
+  UTIL_TIMER_Time_t delay = 0;
+
+  if( app_get_dutycycle() == 0 )
   {
-    return app_settings.u32_app_dutycycle - BASE_DUTYCYCLE_CORRECTION_MS;
+    UTIL_TIMER_Stop( &app_tx_timer );
+    return;
   }
-  else
+
+  // One interval after the start of the cycle, independent of how long the uplink kept the MAC busy
+  if( app_get_dutycycle() > elapsed )
   {
-    return app_settings.u32_app_dutycycle;
+    delay = app_get_dutycycle() - elapsed;
   }
+
+  // Not before the MAC allows the uplink, so the event does not wake up for a rejected send. The samples taken
+  // until then can make the payload larger, app_send_tx_data_cb() asks again with the payload it builds.
+  delay = MAX( delay, base_get_next_tx_in( app_get_lorawan_payload_size() ) );
+
+  UTIL_TIMER_SetPeriod( &app_tx_timer, MAX( delay, 1 ) );
+  UTIL_TIMER_Start( &app_tx_timer );
 }
 
 void app_exit_stop_mode( void )
@@ -234,12 +533,12 @@ void app_exit_stop_mode( void )
 
 void app_enable_irqs( void )
 {
-  user_timer_restart( &app_tx_timer, &remaining_time_tx_timer, app_get_dutycycle() );
+  app_restart_tx_timer();
   base_enable_irqs();
 }
 
 void app_disable_irqs( void )
 {
-  user_timer_stop( &app_tx_timer, &remaining_time_tx_timer );
+  UTIL_TIMER_Stop( &app_tx_timer );
   base_disable_irqs();
 }
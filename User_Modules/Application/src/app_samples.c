@@ -0,0 +1,515 @@
+/**
+* @file app_samples.c
+* @brief Source file for the application sample ring buffer.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "app_samples.h"
+#include "base.h"
+#include "utilities_def.h"
+#include "stm32_seq.h"
+#include "stm32_timer.h"
+#include "utilities.h"
+#include "app_ts_codec.h"
+#include "flash_sample_log.h"
+#include "ELV-AM-TH1.h"
+#include "rtc_temp_comp.h"
+
+// Definitions -----------------------------------------------------------------
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+static app_sample_t sample_ring[APP_SAMPLES_RING_SIZE];
+static uint8_t u8_ring_head                             = 0;  // Index of the next free slot
+static uint8_t u8_ring_count                            = 0;  // Number of valid samples in the ring
+static uint8_t u8_pending_count                         = 0;  // Oldest samples written into the last uplink payload
+static uint16_t u16_sample_interval_s                   = 0;
+static UTIL_TIMER_Object_t app_sample_timer;
+
+// Prototypes ------------------------------------------------------------------
+static void app_samples_timer_cb( void *context );
+static const app_sample_t* app_samples_peek( uint8_t u8_index );
+static void app_samples_drop( uint8_t u8_number );
+static uint8_t app_samples_put_header( uint8_t *buffer, uint8_t u8_count );
+static uint8_t app_samples_put_i16( uint8_t *buffer, int16_t i16_value );
+static bool app_samples_is_temperature_valid( int16_t i16_temperature );
+static void app_samples_get_series( app_ts_series_id_t series_id, int16_t *values, uint8_t u8_count );
+static uint16_t app_samples_get_compressed_size( uint8_t u8_count );
+static uint8_t app_samples_get_batch_count( uint8_t u8_count, uint8_t u8_max_size );
+static uint8_t app_samples_get_compressed_count( uint8_t u8_max_size );
+
+// Exported functions ----------------------------------------------------------
+void app_samples_init( void )
+{
+  UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_app_sample_task ), UTIL_SEQ_RFU, app_samples_take );
+
+  UTIL_TIMER_Create( &app_sample_timer, 0xFFFFFFFFU, UTIL_TIMER_PERIODIC, app_samples_timer_cb, NULL );
+
+  app_samples_clear();
+}
+
+void app_samples_start( uint32_t u32_interval_ms )
+{
+  UTIL_TIMER_Stop( &app_sample_timer );
+
+  if( u32_interval_ms != 0 )
+  {
+    u16_sample_interval_s = ( uint16_t ) ( u32_interval_ms / 1000 );
+    UTIL_TIMER_SetPeriod( &app_sample_timer, u32_interval_ms );
+    UTIL_TIMER_Start( &app_sample_timer );
+  }
+  else
+  {
+    u16_sample_interval_s = 0;
+  }
+}
+
+void app_samples_stop( void )
+{
+  UTIL_TIMER_Stop( &app_sample_timer );
+  u16_sample_interval_s = 0;
+}
+
+bool app_samples_is_running( void )
+{
+  return ( u16_sample_interval_s != 0 );
+}
+
+/**
+  * @brief  Measures with the ELV-AM-TH1 and compensates the RTC with its
+  *         temperature, see rtc_temp_comp.h
+  * @return false without the ELV-AM-TH1, the sample is left unchanged
+  */
+bool app_samples_measure( app_sample_t *sample )
+{
+  th1_data_values_t t_th1_data_values = { 0 };
+
+  if( !elv_am_th1_is_present() )
+  {
+    return false;
+  }
+
+  elv_am_th1_do_measurements( &t_th1_data_values );
+  rtc_temp_comp_update( t_th1_data_values.i16_HDC2080_temperature );
+
+  sample->i16_ntc_temperature       = t_th1_data_values.i16_ntc_temperature;
+  sample->i16_HDC2080_temperature   = t_th1_data_values.i16_HDC2080_temperature;
+  sample->u8_HDC2080_humidity       = t_th1_data_values.u8_HDC2080_humidity;
+  sample->u16_supply_voltage        = t_th1_data_values.u16_operating_voltage;
+
+  return true;
+}
+
+void app_samples_take( void )
+{
+  app_sample_t t_sample = { 0 };
+
+  if( !app_samples_measure( &t_sample ) )
+  {
+    t_sample.i16_ntc_temperature      = ( int16_t ) TEMPERATURE_UNKNOWN;
+    t_sample.i16_HDC2080_temperature  = ( int16_t ) TEMPERATURE_UNKNOWN;
+    t_sample.u8_HDC2080_humidity      = APP_SAMPLES_HUMIDITY_INVALID;
+    t_sample.u16_supply_voltage       = base_get_supply_level();
+  }
+
+  app_samples_push( &t_sample );
+}
+
+void app_samples_push( const app_sample_t *sample )
+{
+  sample_ring[u8_ring_head] = *sample;
+  u8_ring_head = ( u8_ring_head + 1 ) % APP_SAMPLES_RING_SIZE;
+
+  // When the ring is full the oldest sample is overwritten
+  if( u8_ring_count < APP_SAMPLES_RING_SIZE )
+  {
+    u8_ring_count++;
+  }
+}
+
+uint8_t app_samples_get_count( void )
+{
+  return u8_ring_count;
+}
+
+void app_samples_clear( void )
+{
+  u8_ring_head      = 0;
+  u8_ring_count     = 0;
+  u8_pending_count  = 0;
+}
+
+/**
+  * @brief  Removes the samples of the last encoded payload from the ring.
+  *         Samples which could not be handed to the MAC are moved to the flash sample log.
+  * @param[in] b_delivered true if the payload was accepted by the MAC.
+  * @retval None
+  */
+void app_samples_release( bool b_delivered )
+{
+  if( !b_delivered )
+  {
+    for( uint8_t i = 0; i < u8_pending_count; i++ )
+    {
+      flash_sample_log_append( app_samples_peek( i ) );
+    }
+  }
+
+  app_samples_drop( u8_pending_count );
+  u8_pending_count = 0;
+}
+
+/**
+  * @brief  The uplink was postponed: the pending samples stay buffered and are encoded again with the next attempt.
+  * @retval None
+  */
+void app_samples_keep( void )
+{
+  u8_pending_count = 0;
+}
+
+/**
+  * @brief  Writes the oldest buffered samples into an uplink payload, see app_samples_release().
+  *         As many samples are written as fit into u8_max_size, the rest stays for the next uplink.
+  * @param[out] buffer Start of the payload body.
+  * @param[in] u8_max_size Number of bytes available at buffer.
+  * @retval Number of bytes written, 0 if nothing fits.
+  */
+uint8_t app_samples_encode_batch( uint8_t *buffer, uint8_t u8_max_size )
+{
+  uint8_t u8_idx = 0;
+  uint8_t u8_count = app_samples_get_batch_count( u8_ring_count, u8_max_size );
+
+  if( u8_count == 0 )
+  {
+    return 0;
+  }
+
+  u8_idx += app_samples_put_header( &buffer[u8_idx], u8_count );
+
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    const app_sample_t *sample = app_samples_peek( i );
+
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], sample->i16_ntc_temperature );
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], sample->i16_HDC2080_temperature );
+    buffer[u8_idx++] = sample->u8_HDC2080_humidity;
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) sample->u16_supply_voltage );
+  }
+
+  u8_pending_count = u8_count;
+
+  return u8_idx;
+}
+
+/**
+  * @brief  Writes min/max/mean of all buffered samples into an uplink payload, see app_samples_release().
+  *         Invalid sensor values are left out of the aggregates.
+  * @param[out] buffer Start of the payload body.
+  * @param[in] u8_max_size Number of bytes available at buffer.
+  * @retval Number of bytes written, 0 if nothing fits.
+  */
+uint8_t app_samples_encode_aggregate( uint8_t *buffer, uint8_t u8_max_size )
+{
+  int16_t i16_ntc_min = INT16_MAX, i16_ntc_max = INT16_MIN;
+  int16_t i16_hdc_min = INT16_MAX, i16_hdc_max = INT16_MIN;
+  uint8_t u8_hum_min  = UINT8_MAX, u8_hum_max  = 0;
+  uint16_t u16_vdd_min = UINT16_MAX, u16_vdd_max = 0;
+  int32_t i32_ntc_sum = 0, i32_hdc_sum = 0;
+  uint32_t u32_hum_sum = 0, u32_vdd_sum = 0;
+  uint8_t u8_ntc_nb = 0, u8_hdc_nb = 0, u8_hum_nb = 0;
+  uint8_t u8_idx = 0;
+
+  if( ( u8_max_size < APP_SAMPLES_AGGREGATE_BODY_SIZE ) || ( u8_ring_count == 0 ) )
+  {
+    return 0;
+  }
+
+  for( uint8_t i = 0; i < u8_ring_count; i++ )
+  {
+    const app_sample_t *sample = app_samples_peek( i );
+
+    if( app_samples_is_temperature_valid( sample->i16_ntc_temperature ) )
+    {
+      i16_ntc_min = MIN( i16_ntc_min, sample->i16_ntc_temperature );
+      i16_ntc_max = MAX( i16_ntc_max, sample->i16_ntc_temperature );
+      i32_ntc_sum += sample->i16_ntc_temperature;
+      u8_ntc_nb++;
+    }
+    if( app_samples_is_temperature_valid( sample->i16_HDC2080_temperature ) )
+    {
+      i16_hdc_min = MIN( i16_hdc_min, sample->i16_HDC2080_temperature );
+      i16_hdc_max = MAX( i16_hdc_max, sample->i16_HDC2080_temperature );
+      i32_hdc_sum += sample->i16_HDC2080_temperature;
+      u8_hdc_nb++;
+    }
+    if( sample->u8_HDC2080_humidity != APP_SAMPLES_HUMIDITY_INVALID )
+    {
+      u8_hum_min = MIN( u8_hum_min, sample->u8_HDC2080_humidity );
+      u8_hum_max = MAX( u8_hum_max, sample->u8_HDC2080_humidity );
+      u32_hum_sum += sample->u8_HDC2080_humidity;
+      u8_hum_nb++;
+    }
+    u16_vdd_min = MIN( u16_vdd_min, sample->u16_supply_voltage );
+    u16_vdd_max = MAX( u16_vdd_max, sample->u16_supply_voltage );
+    u32_vdd_sum += sample->u16_supply_voltage;
+  }
+
+  u8_idx += app_samples_put_header( &buffer[u8_idx], u8_ring_count );
+
+  if( u8_ntc_nb != 0 )
+  {
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], i16_ntc_min );
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], i16_ntc_max );
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) ( i32_ntc_sum / u8_ntc_nb ) );
+  }
+  else
+  {
+    for( uint8_t i = 0; i < 3; i++ )
+    {
+      u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) TEMPERATURE_UNKNOWN );
+    }
+  }
+
+  if( u8_hdc_nb != 0 )
+  {
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], i16_hdc_min );
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], i16_hdc_max );
+    u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) ( i32_hdc_sum / u8_hdc_nb ) );
+  }
+  else
+  {
+    for( uint8_t i = 0; i < 3; i++ )
+    {
+      u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) TEMPERATURE_UNKNOWN );
+    }
+  }
+
+  if( u8_hum_nb != 0 )
+  {
+    buffer[u8_idx++] = u8_hum_min;
+    buffer[u8_idx++] = u8_hum_max;
+    buffer[u8_idx++] = ( uint8_t ) ( u32_hum_sum / u8_hum_nb );
+  }
+  else
+  {
+    buffer[u8_idx++] = APP_SAMPLES_HUMIDITY_INVALID;
+    buffer[u8_idx++] = APP_SAMPLES_HUMIDITY_INVALID;
+    buffer[u8_idx++] = APP_SAMPLES_HUMIDITY_INVALID;
+  }
+
+  u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) u16_vdd_min );
+  u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) u16_vdd_max );
+  u8_idx += app_samples_put_i16( &buffer[u8_idx], ( int16_t ) ( u32_vdd_sum / u8_ring_count ) );
+
+  u8_pending_count = u8_ring_count;
+
+  return u8_idx;
+}
+
+/**
+  * @brief  Writes the oldest buffered samples as compressed series (see app_ts_codec.h), see app_samples_release().
+  *         As many samples are written as fit into u8_max_size, the rest stays for the next uplink.
+  * @param[out] buffer Start of the payload body.
+  * @param[in] u8_max_size Number of bytes available at buffer.
+  * @retval Number of bytes written, 0 if nothing fits.
+  */
+uint8_t app_samples_encode_compressed( uint8_t *buffer, uint8_t u8_max_size )
+{
+  int16_t values[APP_SAMPLES_RING_SIZE];
+  uint8_t u8_low = app_samples_get_compressed_count( u8_max_size );
+  uint16_t u16_idx = 0;
+
+  if( u8_low == 0 )
+  {
+    return 0;
+  }
+
+  u16_idx += app_samples_put_header( &buffer[u16_idx], u8_low );
+
+  for( app_ts_series_id_t series_id = APP_TS_SERIES_NTC_TEMPERATURE; series_id <= APP_TS_SERIES_SUPPLY_VOLTAGE; series_id++ )
+  {
+    app_samples_get_series( series_id, values, u8_low );
+    u16_idx += app_ts_codec_encode_series( &buffer[u16_idx], series_id, values, u8_low );
+  }
+
+  u8_pending_count = u8_low;
+
+  return ( uint8_t ) u16_idx;
+}
+
+/**
+  * @brief  Size of the payload body the encoder of an uplink mode would write now, nothing is written.
+  *         An empty ring is sized as one sample with the largest values, app_set_lorawan_measurement()
+  *         takes one before it encodes.
+  * @param[in] uplink_mode Uplink mode, APP_UPLINK_MODE_SINGLE has no body here.
+  * @param[in] u8_max_size Number of bytes available for the body.
+  * @retval Number of bytes the encoder writes, 0 if nothing fits.
+  */
+uint8_t app_samples_get_encoded_size( app_uplink_mode_t uplink_mode, uint8_t u8_max_size )
+{
+  const int16_t i16_largest = INT16_MIN;
+  uint16_t u16_size = 0;
+  uint8_t u8_count = 0;
+
+  switch( uplink_mode )
+  {
+    case APP_UPLINK_MODE_BATCH:
+      u8_count = app_samples_get_batch_count( MAX( u8_ring_count, 1 ), u8_max_size );
+      if( u8_count != 0 )
+      {
+        u16_size = APP_SAMPLES_BODY_HEADER_SIZE + ( u8_count * APP_SAMPLES_BATCH_RECORD_SIZE );
+      }
+      break;
+    case APP_UPLINK_MODE_AGGREGATE:
+      if( u8_max_size >= APP_SAMPLES_AGGREGATE_BODY_SIZE )
+      {
+        u16_size = APP_SAMPLES_AGGREGATE_BODY_SIZE;
+      }
+      break;
+    case APP_UPLINK_MODE_COMPRESSED:
+      if( u8_ring_count == 0 )
+      {
+        u16_size = APP_SAMPLES_BODY_HEADER_SIZE;
+        for( app_ts_series_id_t series_id = APP_TS_SERIES_NTC_TEMPERATURE; series_id <= APP_TS_SERIES_SUPPLY_VOLTAGE; series_id++ )
+        {
+          u16_size += app_ts_codec_get_series_size( &i16_largest, 1 );
+        }
+        u16_size = ( u16_size <= u8_max_size ) ? u16_size : 0;
+      }
+      else
+      {
+        u8_count = app_samples_get_compressed_count( u8_max_size );
+        u16_size = ( u8_count != 0 ) ? app_samples_get_compressed_size( u8_count ) : 0;
+      }
+      break;
+    case APP_UPLINK_MODE_SINGLE:
+    default:
+      break;
+  }
+
+  return ( uint8_t ) u16_size;
+}
+
+// Private functions -----------------------------------------------------------
+static void app_samples_timer_cb( void *context )
+{
+  // The measurement needs I2C and HAL_Delay(), so it is done in the sequencer and not in the timer IRQ
+  UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_app_sample_task ), CFG_SEQ_Prio_0 );
+}
+
+static const app_sample_t* app_samples_peek( uint8_t u8_index )
+{
+  uint8_t u8_oldest = ( u8_ring_head + APP_SAMPLES_RING_SIZE - u8_ring_count ) % APP_SAMPLES_RING_SIZE;
+
+  return &sample_ring[( u8_oldest + u8_index ) % APP_SAMPLES_RING_SIZE];
+}
+
+static void app_samples_drop( uint8_t u8_number )
+{
+  if( u8_number >= u8_ring_count )
+  {
+    app_samples_clear();
+  }
+  else
+  {
+    u8_ring_count -= u8_number;
+  }
+}
+
+static uint8_t app_samples_put_header( uint8_t *buffer, uint8_t u8_count )
+{
+  buffer[0] = u8_count;
+  buffer[1] = ( uint8_t ) ( u16_sample_interval_s >> 8 );
+  buffer[2] = ( uint8_t ) ( u16_sample_interval_s );
+
+  return APP_SAMPLES_BODY_HEADER_SIZE;
+}
+
+static uint8_t app_samples_put_i16( uint8_t *buffer, int16_t i16_value )
+{
+  buffer[0] = ( uint8_t ) ( ( uint16_t ) i16_value >> 8 );
+  buffer[1] = ( uint8_t ) ( i16_value );
+
+  return 2;
+}
+
+static void app_samples_get_series( app_ts_series_id_t series_id, int16_t *values, uint8_t u8_count )
+{
+  for( uint8_t i = 0; i < u8_count; i++ )
+  {
+    const app_sample_t *sample = app_samples_peek( i );
+
+    switch( series_id )
+    {
+      case APP_TS_SERIES_NTC_TEMPERATURE:
+        values[i] = sample->i16_ntc_temperature;
+        break;
+      case APP_TS_SERIES_HDC2080_TEMPERATURE:
+        values[i] = sample->i16_HDC2080_temperature;
+        break;
+      case APP_TS_SERIES_HDC2080_HUMIDITY:
+        values[i] = sample->u8_HDC2080_humidity;
+        break;
+      case APP_TS_SERIES_SUPPLY_VOLTAGE:
+      default:
+        values[i] = ( int16_t ) sample->u16_supply_voltage;
+        break;
+    }
+  }
+}
+
+static uint16_t app_samples_get_compressed_size( uint8_t u8_count )
+{
+  int16_t values[APP_SAMPLES_RING_SIZE];
+  uint16_t u16_size = APP_SAMPLES_BODY_HEADER_SIZE;
+
+  for( app_ts_series_id_t series_id = APP_TS_SERIES_NTC_TEMPERATURE; series_id <= APP_TS_SERIES_SUPPLY_VOLTAGE; series_id++ )
+  {
+    app_samples_get_series( series_id, values, u8_count );
+    u16_size += app_ts_codec_get_series_size( values, u8_count );
+  }
+
+  return u16_size;
+}
+
+// Number of samples of a batch body of at most u8_max_size bytes
+static uint8_t app_samples_get_batch_count( uint8_t u8_count, uint8_t u8_max_size )
+{
+  if( u8_max_size < ( APP_SAMPLES_BODY_HEADER_SIZE + APP_SAMPLES_BATCH_RECORD_SIZE ) )
+  {
+    return 0;
+  }
+
+  return MIN( u8_count, ( u8_max_size - APP_SAMPLES_BODY_HEADER_SIZE ) / APP_SAMPLES_BATCH_RECORD_SIZE );
+}
+
+// Number of the oldest samples whose compressed body fits into u8_max_size bytes
+static uint8_t app_samples_get_compressed_count( uint8_t u8_max_size )
+{
+  uint8_t u8_low = 0;
+  uint8_t u8_high = u8_ring_count;
+
+  // The encoded size grows with the number of samples, so search the largest count that fits
+  while( u8_low < u8_high )
+  {
+    uint8_t u8_mid = ( u8_low + u8_high + 1 ) / 2;
+
+    if( app_samples_get_compressed_size( u8_mid ) <= u8_max_size )
+    {
+      u8_low = u8_mid;
+    }
+    else
+    {
+      u8_high = u8_mid - 1;
+    }
+  }
+
+  return u8_low;
+}
+
+static bool app_samples_is_temperature_valid( int16_t i16_temperature )
+{
+  return ( ( uint16_t ) i16_temperature < TEMPERATURE_UNKNOWN ) || ( ( uint16_t ) i16_temperature > TEMPERATURE_UNDERFLOW );
+}
@@ -26,6 +26,12 @@ EE_Status app_eeprom_set_defaults( void )
 
   ee_status = EE_WriteVariable32bits( EEPROM_EMU_DUTYCYCLE_ADDRESS, APP_DUTYCYCLE_DEFAULT );
   ee_status = EEPROM_start_cleanup_polling_mode_if_needed( ee_status );
+
+  ee_status = EE_WriteVariable32bits( EEPROM_EMU_SAMPLE_INTERVAL_ADDRESS, APP_SAMPLE_INTERVAL_DEFAULT );
+  ee_status = EEPROM_start_cleanup_polling_mode_if_needed( ee_status );
+
+  ee_status = EE_WriteVariable32bits( EEPROM_EMU_UPLINK_MODE_ADDRESS, APP_UPLINK_MODE_DEFAULT );
+  ee_status = EEPROM_start_cleanup_polling_mode_if_needed( ee_status );
   
   return ee_status;
 }
@@ -35,6 +41,8 @@ EE_Status app_eeprom_set_settings( application_settings_t settings )
   EE_Status ee_status = EE_OK;
 
   ee_status = EEPROM_write_ee_variable_32bits( EEPROM_EMU_DUTYCYCLE_ADDRESS, settings.u32_app_dutycycle );
+  ee_status = EEPROM_write_ee_variable_32bits( EEPROM_EMU_SAMPLE_INTERVAL_ADDRESS, settings.u32_app_sample_interval );
+  ee_status = EEPROM_write_ee_variable_32bits( EEPROM_EMU_UPLINK_MODE_ADDRESS, settings.u32_app_uplink_mode );
   
   return ee_status;
 }
@@ -44,6 +52,8 @@ EE_Status app_eeprom_get_settings( application_settings_t *settings )
   EE_Status ee_status = EE_OK;
 
   ee_status = EEPROM_read_ee_variable_32bits( EEPROM_EMU_DUTYCYCLE_ADDRESS, &settings->u32_app_dutycycle );
+  ee_status = EEPROM_read_ee_variable_32bits( EEPROM_EMU_SAMPLE_INTERVAL_ADDRESS, &settings->u32_app_sample_interval );
+  ee_status = EEPROM_read_ee_variable_32bits( EEPROM_EMU_UPLINK_MODE_ADDRESS, &settings->u32_app_uplink_mode );
   
   return ee_status;
 }
@@ -59,6 +69,15 @@ void app_settings_print( application_settings_t settings )
   {
     APP_LOG( TS_OFF, VLEVEL_L, "Interval: off\r\n" );
   }
+  if( settings.u32_app_sample_interval != 0 )
+  {
+    APP_LOG( TS_OFF, VLEVEL_L, "Sample interval: %u seconds\r\n", settings.u32_app_sample_interval / 1000 );
+  }
+  else
+  {
+    APP_LOG( TS_OFF, VLEVEL_L, "Sample interval: off\r\n" );
+  }
+  APP_LOG( TS_OFF, VLEVEL_L, "Uplink mode: %u\r\n", settings.u32_app_uplink_mode );
   APP_LOG( TS_OFF, VLEVEL_L, "#########################################################\r\n" );
 }
 
@@ -76,5 +95,17 @@ void app_settings_process_dl( uint8_t *buffer, uint8_t buffer_size )
 
       app_eeprom_set_settings( temp_settings );
     }
+    else if( buffer_size == APP_DL_SIZE_THREE_BYTES )
+    {
+      if( buffer[2] < APP_UPLINK_MODE_NBR )
+      {
+        app_eeprom_get_settings( &temp_settings );
+
+        temp_settings.u32_app_sample_interval = ( buffer[1] * 60000 );  // set new sample interval in minutes, 0 = off
+        temp_settings.u32_app_uplink_mode     = buffer[2];              // set new uplink mode
+
+        app_eeprom_set_settings( temp_settings );
+      }
+    }
   }
 }
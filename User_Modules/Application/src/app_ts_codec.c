@@ -0,0 +1,140 @@
+/**
+* @file app_ts_codec.c
+* @brief Source file for the time series codec of batched sensor uplinks.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stddef.h>
+#include "app_ts_codec.h"
+
+// Definitions -----------------------------------------------------------------
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+// Prototypes ------------------------------------------------------------------
+static uint16_t app_ts_codec_process_series( uint8_t *buffer, const int16_t *values, uint8_t u8_count );
+static uint8_t app_ts_codec_put_token( uint8_t *buffer, uint32_t u32_token );
+
+// Exported functions ----------------------------------------------------------
+/**
+  * @brief  Calculates the number of bytes app_ts_codec_encode_series() writes for the given values.
+  * @param[in] values Series values, oldest first.
+  * @param[in] u8_count Number of values.
+  * @retval Encoded size in bytes including the series id.
+  */
+uint16_t app_ts_codec_get_series_size( const int16_t *values, uint8_t u8_count )
+{
+  return 1 + app_ts_codec_process_series( NULL, values, u8_count );
+}
+
+/**
+  * @brief  Encodes a series with delta-of-delta, zig-zag varints and zero runs.
+  * @param[out] buffer Destination, must hold app_ts_codec_get_series_size() bytes.
+  * @param[in] series_id Id written in front of the series.
+  * @param[in] values Series values, oldest first.
+  * @param[in] u8_count Number of values.
+  * @retval Number of bytes written.
+  */
+uint16_t app_ts_codec_encode_series( uint8_t *buffer, app_ts_series_id_t series_id, const int16_t *values, uint8_t u8_count )
+{
+  buffer[0] = ( uint8_t ) series_id;
+
+  return 1 + app_ts_codec_process_series( &buffer[1], values, u8_count );
+}
+
+uint32_t app_ts_codec_zigzag( int32_t i32_value )
+{
+  return ( ( uint32_t ) i32_value << 1 ) ^ ( uint32_t ) ( i32_value >> 31 );
+}
+
+uint8_t app_ts_codec_get_varint_size( uint32_t u32_value )
+{
+  uint8_t u8_size = 1;
+
+  while( u32_value >= 0x80 )
+  {
+    u32_value >>= 7;
+    u8_size++;
+  }
+
+  return u8_size;
+}
+
+uint8_t app_ts_codec_put_varint( uint8_t *buffer, uint32_t u32_value )
+{
+  uint8_t u8_idx = 0;
+
+  while( u32_value >= 0x80 )
+  {
+    buffer[u8_idx++] = ( uint8_t ) ( u32_value | 0x80 );
+    u32_value >>= 7;
+  }
+  buffer[u8_idx++] = ( uint8_t ) u32_value;
+
+  return u8_idx;
+}
+
+// Private functions -----------------------------------------------------------
+/**
+  * @brief  Walks the series once and either writes the tokens or only counts their size.
+  * @param[out] buffer Destination of the tokens, NULL to only count.
+  * @retval Number of token bytes.
+  */
+static uint16_t app_ts_codec_process_series( uint8_t *buffer, const int16_t *values, uint8_t u8_count )
+{
+  uint16_t u16_size = 0;
+  uint32_t u32_zero_run = 0;
+  int32_t i32_prev_delta = 0;
+
+  if( u8_count == 0 )
+  {
+    return 0;
+  }
+
+  u16_size += app_ts_codec_put_token( ( buffer != NULL ) ? &buffer[u16_size] : NULL, app_ts_codec_zigzag( values[0] ) );
+
+  if( u8_count > 1 )
+  {
+    i32_prev_delta = ( int32_t ) values[1] - values[0];
+    u16_size += app_ts_codec_put_token( ( buffer != NULL ) ? &buffer[u16_size] : NULL, app_ts_codec_zigzag( i32_prev_delta ) );
+  }
+
+  for( uint8_t i = 2; i < u8_count; i++ )
+  {
+    int32_t i32_delta = ( int32_t ) values[i] - values[i - 1];
+    int32_t i32_dod = i32_delta - i32_prev_delta;
+
+    i32_prev_delta = i32_delta;
+
+    if( i32_dod == 0 )
+    {
+      u32_zero_run++;
+      continue;
+    }
+
+    if( u32_zero_run != 0 )
+    {
+      u16_size += app_ts_codec_put_token( ( buffer != NULL ) ? &buffer[u16_size] : NULL, ( ( u32_zero_run - 1 ) << 1 ) | 1 );
+      u32_zero_run = 0;
+    }
+    u16_size += app_ts_codec_put_token( ( buffer != NULL ) ? &buffer[u16_size] : NULL, app_ts_codec_zigzag( i32_dod ) << 1 );
+  }
+
+  if( u32_zero_run != 0 )
+  {
+    u16_size += app_ts_codec_put_token( ( buffer != NULL ) ? &buffer[u16_size] : NULL, ( ( u32_zero_run - 1 ) << 1 ) | 1 );
+  }
+
+  return u16_size;
+}
+
+static uint8_t app_ts_codec_put_token( uint8_t *buffer, uint32_t u32_token )
+{
+  if( buffer == NULL )
+  {
+    return app_ts_codec_get_varint_size( u32_token );
+  }
+
+  return app_ts_codec_put_varint( buffer, u32_token );
+}
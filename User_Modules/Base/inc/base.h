@@ -35,14 +35,13 @@
 #define LORAWAN_DEFAULT_DATA_RATE                   DR_0                              // LoRaWAN Default data Rate Data Rate. Please note that LORAWAN_DEFAULT_DATA_RATE is used only when LORAWAN_ADR_STATE is disabled.
 #define LORAWAN_ACTIVE_REGION                       LORAMAC_REGION_EU868              // LoraWAN application configuration (Mw is configured by lorawan_conf.h).
 #define LORAWAN_DEFAULT_CLASS                       CLASS_A                           // LoRaWAN default endNode class port.
-#define LORAWAN_APP_DATA_BUFFER_MAX_SIZE            51                                // User application data buffer size.
+#define LORAWAN_APP_DATA_BUFFER_MAX_SIZE            242                               // User application data buffer size. The usable size depends on the datarate, see base_get_max_app_payload_size().
 #define LORAWAN_DEFAULT_PING_SLOT_PERIODICITY       4                                 // Default Unicast ping slots periodicity.
                                                                                       // Periodicity is equal to 2^LORAWAN_DEFAULT_PING_SLOT_PERIODICITY seconds.
                                                                                       // Example: 2^3 = 8 seconds. The end-device will open an Rx slot every 8 seconds.
 
 #define BASE_HEADER_LENGTH                          5
-#define BASE_DUTYCYCLE_CORRECTION_MS                5000
-#define BASE_JOIN_ATTEMPTS                          3
+#define BASE_JOIN_ATTEMPTS                          3                                 // Join attempts shown by the LEDs after POR, see base_join_sched.h for the retries
 #define LORAWAN_DEFAULT_ACTIVATION_TYPE             ACTIVATION_TYPE_OTAA              // LoRaWAN default activation type
 
 #define POWER_MODULE_PRESENT_THRESHOLD_LOW          50
@@ -59,6 +58,7 @@ typedef struct base_callbacks_s
   void ( *base_user_button_event )( void );
   void ( *base_enable_irqs )( void );
   void ( *base_disable_irqs )( void );
+  void ( *base_loramac_idle )( void );
 } base_callbacks_t;
 
 typedef enum
@@ -69,6 +69,7 @@ typedef enum
   TX_REASON_FUOTA_EVENT,
   TX_REASON_APP_CYCLE_EVENT,
   TX_REASON_TIMEOUT_EVENT,
+  TX_REASON_BACKFILL_EVENT,
   
   TX_REASON_UNDEFINED_EVENT = 0xFF
 } base_tx_reason_t;
@@ -83,6 +84,8 @@ void base_init_lorawan( void );
 void base_join( void );
 LmHandlerErrorStatus_t base_tx( UTIL_TIMER_Time_t *next_tx_in );
 LmHandlerAppData_t* base_get_app_data_ptr( void );
+uint8_t base_get_max_app_payload_size( void );
+UTIL_TIMER_Time_t base_get_next_tx_in( uint8_t u8_size );
 void base_join_ok_cb( void *context );
 void base_join_nok_cb( void *context );
 
@@ -100,7 +103,8 @@ void base_on_join_request( LmHandlerJoinParams_t *join_params );
 void base_on_tx_data( LmHandlerTxParams_t *params );
 void base_on_rx_data( LmHandlerAppData_t *app_data, LmHandlerRxParams_t *params );
 void base_on_mac_process_notify( void );
-void base_join_retry( void );
+void base_on_mac_idle( void );
+void base_join_por_next( void );
 
 void base_set_lorawan_euis_and_key( void );
 
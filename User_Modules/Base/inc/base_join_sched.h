@@ -0,0 +1,50 @@
+/**
+* @file base_join_sched.h
+* @brief Header file for the join scheduler.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/** @addtogroup BASE_JOIN_SCHED
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+#ifndef __BASE_JOIN_SCHED_H__
+#define __BASE_JOIN_SCHED_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "LmHandler.h"
+#include "Region.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_JOIN_DR_FIRST                          DR_5                              // Datarate of the first join request
+#define BASE_JOIN_DR_LAST                           DR_0                              // Datarate after which the cycle starts over at BASE_JOIN_DR_FIRST
+#define BASE_JOIN_START_DELAY_MAX                   3000                              // Random delay before the first join request [ms]
+#define BASE_JOIN_BACKOFF_MIN                       10000                             // Back-off after the first failed join request [ms]
+#define BASE_JOIN_BACKOFF_MAX                       3600000                           // Upper limit of the back-off within a datarate cycle [ms]
+#define BASE_JOIN_DC_JITTER_MAX                     5000                              // Random delay added to the duty cycle wait time [ms]
+#define BASE_JOIN_BUSY_RETRY                        1000                              // Retry period while the MAC is busy [ms]
+#define BASE_JOIN_DEV_NONCE_BLOCK                   16                                // DevNonces reserved per write to the EEPROM
+
+// Typedefs --------------------------------------------------------------------
+typedef struct base_join_sched_stats_s
+{
+  uint32_t u32_requests;                    // Join requests handed over to the MAC
+  uint32_t u32_dc_deferred;                 // Join requests postponed by the duty cycle
+  uint32_t u32_joins;                       // Join accepts received
+  uint32_t u32_time_to_join;                // Time from the start to the last join accept [ms]
+  int8_t i8_join_datarate;                  // Datarate of the last successful join request
+} base_join_sched_stats_t;
+
+// Variables -------------------------------------------------------------------
+// Prototypes ------------------------------------------------------------------
+void base_join_sched_init( ActivationType_t activation_type );
+void base_join_sched_start( void );
+void base_join_sched_stop( void );
+bool base_join_sched_is_running( void );
+void base_join_sched_on_join_request( LmHandlerJoinParams_t *params );
+void base_join_sched_get_stats( base_join_sched_stats_t *stats );
+
+#endif /* __BASE_JOIN_SCHED__ */
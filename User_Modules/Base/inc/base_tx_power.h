@@ -0,0 +1,53 @@
+/**
+* @file base_tx_power.h
+* @brief Header file for the link margin driven TX power control.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/** @addtogroup BASE_TX_POWER
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+#ifndef __BASE_TX_POWER_H__
+#define __BASE_TX_POWER_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "LmHandler.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_TX_POWER_CONTROL_ENABLED               1                                 // 0: the TX power is left to ADR, only the statistics are kept
+#define BASE_TX_POWER_TARGET_MARGIN                 10                                // Link margin to keep above the demodulation floor [dB]
+#define BASE_TX_POWER_LINK_CHECK_PERIOD             16                                // Uplinks between two periodic link checks
+#define BASE_TX_POWER_MAX_STEP_DOWN                 2                                 // TX power levels to lower at most per link check
+#define BASE_TX_POWER_LEVEL_DROP                    6                                 // Drop of the downlink level which raises the TX power [dB]
+#define BASE_TX_POWER_STEP                          2                                 // EIRP difference between two TX power levels [dB]
+
+// Typical supply current of the RFO_LP path per TX power level (TX_POWER_0 = 14 dBm conducted) [uA].
+// Only used for the statistics, adjust to the board.
+#define BASE_TX_POWER_CURRENT_TABLE                 { 22000, 18500, 15500, 13500, 12000, 10500, 9500, 8500 }
+
+// Typedefs --------------------------------------------------------------------
+typedef struct base_tx_power_stats_s
+{
+  uint32_t u32_uplinks;                     // Uplinks transmitted
+  uint32_t u32_lost;                        // Uplinks known as lost (no ACK or no link check answer)
+  uint32_t u32_link_checks;                 // Link checks answered
+  uint32_t u32_steps_up;                    // TX power raised by the controller
+  uint32_t u32_steps_down;                  // TX power lowered by the controller
+  uint64_t u64_charge;                      // Charge drawn by the transmissions [uC]
+} base_tx_power_stats_t;
+
+// Variables -------------------------------------------------------------------
+// Prototypes ------------------------------------------------------------------
+void base_tx_power_init( void );
+void base_tx_power_on_tx_request( void );
+void base_tx_power_on_tx_done( LmHandlerTxParams_t *params );
+void base_tx_power_on_rx_data( LmHandlerRxParams_t *params );
+void base_tx_power_on_link_check( LmHandlerLinkCheckParams_t *params );
+void base_tx_power_get_stats( base_tx_power_stats_t *stats );
+uint32_t base_tx_power_get_charge_per_uplink( void );
+
+#endif /* __BASE_TX_POWER__ */
@@ -0,0 +1,52 @@
+/**
+* @file base_tx_queue.h
+* @brief Header file for the queue of pending uplinks.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/** @addtogroup BASE_TX_QUEUE
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+#ifndef __BASE_TX_QUEUE_H__
+#define __BASE_TX_QUEUE_H__
+
+// Includes --------------------------------------------------------------------
+#include <stdbool.h>
+#include <stdint.h>
+#include "LmHandlerTypes.h"
+#include "base.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_TX_QUEUE_SIZE                          4                                 // Maximum number of pending uplinks
+
+// Typedefs --------------------------------------------------------------------
+// An entry only describes the uplink, the payload is built when it is sent.
+// This way a coalesced cyclic report always carries the latest measurement.
+typedef struct base_tx_queue_entry_s
+{
+  base_tx_reason_t tx_reason;
+  LmHandlerMsgTypes_t msg_type;
+  uint8_t u8_coalesced;                     // Number of requests merged into this entry
+} base_tx_queue_entry_t;
+
+typedef struct base_tx_queue_stats_s
+{
+  uint32_t u32_queued;                      // Requests which got an own entry
+  uint32_t u32_coalesced;                   // Requests merged into a pending entry of the same type
+  uint32_t u32_dropped;                     // Requests or entries discarded (queue full or send error)
+  uint32_t u32_sent;                        // Entries handed over to the MAC
+} base_tx_queue_stats_t;
+
+// Variables -------------------------------------------------------------------
+// Prototypes ------------------------------------------------------------------
+void base_tx_queue_init( void );
+bool base_tx_queue_push( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type );
+bool base_tx_queue_peek( base_tx_queue_entry_t *entry );
+void base_tx_queue_pop( const base_tx_queue_entry_t *entry, bool b_sent );
+bool base_tx_queue_is_empty( void );
+uint8_t base_tx_queue_get_count( void );
+void base_tx_queue_get_stats( base_tx_queue_stats_t *stats );
+
+#endif /* __BASE_TX_QUEUE__ */
@@ -26,6 +26,9 @@
 #include "led.h"
 #include "flash_user_func.h"
 #include "base_signal_led.h"
+#include "base_tx_power.h"
+#include "base_join_sched.h"
+#include "utilities.h"
 
 // Definitions -----------------------------------------------------------------
 // Typedefs --------------------------------------------------------------------
@@ -46,7 +49,9 @@ LmHandlerCallbacks_t LmHandlerCallbacks =
   .OnMacProcess     = base_on_mac_process_notify,
   .OnJoinRequest    = base_on_join_request,
   .OnTxData         = base_on_tx_data,
-  .OnRxData         = base_on_rx_data
+  .OnRxData         = base_on_rx_data,
+  .OnMacIdle        = base_on_mac_idle,
+  .OnLinkCheck      = base_tx_power_on_link_check
 };
 
 LmHandlerParams_t LmHandlerParams =
@@ -89,7 +94,7 @@ void base_init( base_callbacks_t *base_callbacks, bool b_adr_enable, int8_t i8_t
   UTIL_MEM_cpy_8( ( void * )&base_cb, ( const void * )base_callbacks, sizeof( base_callbacks_t ) );
   
   UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_LmHandler_process_task ), UTIL_SEQ_RFU, LmHandlerProcess );
-  UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_initial_join_retry_task ), UTIL_SEQ_RFU, base_join_retry );
+  UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_initial_join_task ), UTIL_SEQ_RFU, base_join_por_next );
 
   base_set_is_por( true );
   base_set_join_attempts( BASE_JOIN_ATTEMPTS );
@@ -99,6 +104,7 @@ void base_init( base_callbacks_t *base_callbacks, bool b_adr_enable, int8_t i8_t
 
   base_power_module_detection();
   base_init_lorawan();
+  base_join_sched_init( ActivationType );
   base_set_lorawan_euis_and_key();
   signal_led_init();
   base_init_periphs();
@@ -124,19 +130,39 @@ void base_init_timer( void )
 
 void base_init_lorawan( void )
 {
+  uint8_t random_seed[SE_RANDOM_SEED_SIZE];
+
+  // The seed of the previous boot goes into the random generator with the radio noise, which
+  // alone is weak right after the reset
+  if( flash_user_func_get_random_seed( random_seed ) )
+  {
+    SecureElementSetRandomSeed( random_seed );
+  }
+
   LoraInfo_Init();
   LmHandlerInit( &LmHandlerCallbacks );
   LmHandlerConfigure( &LmHandlerParams );
+  base_tx_power_init();
+
+  // Seeded by LmHandlerConfigure(), the next boot never starts from the same seed. A reseed every
+  // CRYPTO_DRBG_RESEED_INTERVAL numbers replaces the seed again, that one is not stored
+  if( SecureElementGetRandomSeed( random_seed ) == SECURE_ELEMENT_SUCCESS )
+  {
+    flash_user_func_set_random_seed( random_seed );
+  }
+  memset1( random_seed, 0, sizeof( random_seed ) );
 }
 
 void base_join( void )
 {
   signal_led_start( SIGNAL_LED_ID_JOIN_PROCESS, NULL );
-  LmHandlerJoin( ActivationType );
+  base_join_sched_start();
 }
 
 LmHandlerErrorStatus_t base_tx( UTIL_TIMER_Time_t *next_tx_in )
 {
+  base_tx_power_on_tx_request();
+
   LmHandlerErrorStatus_t ret = LmHandlerSend( &base_app_data, lora_msg_type, next_tx_in, false );
   if ( ret == LORAMAC_HANDLER_SUCCESS )
   {
@@ -144,7 +170,7 @@ LmHandlerErrorStatus_t base_tx( UTIL_TIMER_Time_t *next_tx_in )
   }
   else if( ret == LORAMAC_HANDLER_NO_NETWORK_JOINED )
   {
-//    APP_LOG( TS_OFF, VLEVEL_L, "No network joined. Join...\r\n" );
+//    APP_LOG( TS_OFF, VLEVEL_L, "No network joined. The join scheduler keeps trying.\r\n" );
   }
   else if( ret == LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED )
   {
@@ -163,19 +189,42 @@ LmHandlerAppData_t* base_get_app_data_ptr( void )
   return &base_app_data;
 }
 
+uint8_t base_get_max_app_payload_size( void )
+{
+  LoRaMacTxInfo_t tx_info = { 0 };
+
+  // Only the size information is used, the return value tells whether 0 bytes would fit
+  LoRaMacQueryTxPossible( 0, &tx_info );
+
+  return MIN( tx_info.MaxPossibleApplicationDataSize, LORAWAN_APP_DATA_BUFFER_MAX_SIZE );
+}
+
+UTIL_TIMER_Time_t base_get_next_tx_in( uint8_t u8_size )
+{
+  TimerTime_t next_tx_in = 0;
+
+  // The band credits an uplink costs grow with its time-on-air, so a short payload may go out earlier
+  if( LoRaMacQueryNextTxTime( u8_size, &next_tx_in ) != LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
+  {
+    return 0;
+  }
+
+  return next_tx_in;
+}
+
 void base_join_ok_cb( void *context )
 {
-  if( base_get_is_por() )     // Attempt Join whene coming from POR
+  if( base_get_is_por() )     // Finish the POR join phase
   {
-    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_initial_join_retry_task ), CFG_SEQ_Prio_0 );
+    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_initial_join_task ), CFG_SEQ_Prio_0 );
   }
 }
 
 void base_join_nok_cb( void *context )
 {
-  if( base_get_is_por() )     // Attempt Join whene coming from POR
+  if( base_get_is_por() )     // Show the next join attempt when coming from POR
   {
-    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_initial_join_retry_task ), CFG_SEQ_Prio_0 );
+    UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_initial_join_task ), CFG_SEQ_Prio_0 );
   }
 }
 
@@ -317,6 +366,8 @@ void base_reset_timestamps( void )
 
 void base_on_tx_data( LmHandlerTxParams_t *params )
 {
+  base_tx_power_on_tx_done( params );
+
   if( ( params != NULL ) && ( params->IsMcpsConfirm != 0 ) )
   {
     if( params->MsgType == LORAMAC_HANDLER_CONFIRMED_MSG )
@@ -336,12 +387,16 @@ void base_on_tx_data( LmHandlerTxParams_t *params )
 
 void base_on_join_request( LmHandlerJoinParams_t *join_params )
 {
+  // Schedules the next join request on a failure
+  base_join_sched_on_join_request( join_params );
+
   if( join_params != NULL )
   {
     signal_led_stop( SIGNAL_LED_ID_JOIN_PROCESS, false );
     if( join_params->Status == LORAMAC_HANDLER_SUCCESS )
     {
       base_set_is_joined( true );
+      base_tx_power_init();     // The MAC is back at the default TX power
       if( join_params->Mode == ACTIVATION_TYPE_ABP )
       {
         // ABP
@@ -373,6 +428,7 @@ void base_on_rx_data( LmHandlerAppData_t *app_data, LmHandlerRxParams_t *params
 {
   // OnRxData will be called after OnTxData
   base_reset_timestamps();
+  base_tx_power_on_rx_data( params );
   if( ( app_data != NULL ) && ( params != NULL ) )
   {
     base_cb.base_process_downlink( app_data->Port, app_data->Buffer, app_data->BufferSize );
@@ -384,16 +440,25 @@ void base_on_mac_process_notify( void )
   UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_LmHandler_process_task ), CFG_SEQ_Prio_0 );
 }
 
-void base_join_retry( void )
+void base_on_mac_idle( void )
+{
+  // TX done and RX windows closed, the MAC accepts the next request
+  if( base_cb.base_loramac_idle != NULL )
+  {
+    base_cb.base_loramac_idle();
+  }
+}
+
+void base_join_por_next( void )
 {
   if( base_get_join_attempts() > 0 )
   {
+    // The join scheduler sends the next request after its back-off
     signal_led_start( SIGNAL_LED_ID_JOIN_PROCESS, NULL );
-
-    LmHandlerJoin( ActivationType );
   }
   else
   {
+    // Joined or out of POR attempts: the application starts, a join still missing goes on in the background
     if( base_get_is_por() )
     {
       base_set_is_por( false );
@@ -0,0 +1,240 @@
+/**
+* @file base_join_sched.c
+* @brief Source file for the join scheduler.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+*
+* Sends the OTAA join requests until the network accepts one:
+* - the first request goes out after a random delay, so that devices powered
+*   up together (e.g. after a power outage) do not transmit in lockstep
+* - each failed request moves one datarate from BASE_JOIN_DR_FIRST toward
+*   BASE_JOIN_DR_LAST, a device close to the gateway joins with little air
+*   time, a distant one still gets the range of DR0
+* - the back-off doubles per failed request of a datarate cycle up to
+*   BASE_JOIN_BACKOFF_MAX and is randomized within 50..150 %, it starts over
+*   with each cycle, the join duty cycle slows the requests down over time
+* - a request is never sent before the band credits of the MAC allow it, which
+*   include the join duty cycle of RegionCommonGetJoinDc()
+* The DevNonce counter is restored from the EEPROM, a block of
+* BASE_JOIN_DEV_NONCE_BLOCK values is reserved per write to spare the flash.
+**/
+
+/** @addtogroup BASE_JOIN_SCHED
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+// Includes --------------------------------------------------------------------
+#include "main.h"
+#include "base_join_sched.h"
+#include "LoRaMacHeaderTypes.h"
+#include "stm32_seq.h"
+#include "stm32_timer.h"
+#include "utilities_def.h"
+#include "flash_user_func.h"
+#include "utilities.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_JOIN_REQ_PAYLOAD_SIZE                  ( LORAMAC_JOIN_REQ_MSG_SIZE - LORAMAC_FRAME_PAYLOAD_OVERHEAD_SIZE )
+
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+static UTIL_TIMER_Object_t join_timer;
+static base_join_sched_stats_t join_stats           = { 0 };
+
+static ActivationType_t join_activation_type        = ACTIVATION_TYPE_OTAA;
+static bool b_running                               = false;
+static bool b_request_pending                       = false;                          // Join request in the MAC, result outstanding
+static uint8_t u8_failures                          = 0;                              // Failed join requests since the start
+static int8_t i8_datarate                           = BASE_JOIN_DR_FIRST;
+static uint32_t u32_dev_nonce_bound                 = 0;                              // Highest DevNonce reserved in the EEPROM
+static UTIL_TIMER_Time_t start_time                 = 0;
+
+// Prototypes ------------------------------------------------------------------
+static void base_join_sched_process( void );
+static void base_join_sched_on_timer( void *context );
+static void base_join_sched_schedule( UTIL_TIMER_Time_t delay );
+static void base_join_sched_backoff( void );
+static void base_join_sched_reserve_dev_nonce( void );
+
+/**
+  * @brief  To be called after the LoRaWAN stack is initialized. Restores the
+  *         DevNonce counter of the previous runs.
+  */
+void base_join_sched_init( ActivationType_t activation_type )
+{
+  join_activation_type = activation_type;
+
+  UTIL_SEQ_RegTask( ( 1 << CFG_SEQ_Task_join_task ), UTIL_SEQ_RFU, base_join_sched_process );
+  UTIL_TIMER_Create( &join_timer, 0xFFFFFFFFU, UTIL_TIMER_ONESHOT, base_join_sched_on_timer, NULL );
+
+  // DevNonces up to the bound may have been sent already
+  u32_dev_nonce_bound = flash_user_func_get_dev_nonce();
+  LmHandlerSetDevNonce( ( uint16_t ) u32_dev_nonce_bound );
+
+  b_running         = false;
+  b_request_pending = false;
+}
+
+void base_join_sched_start( void )
+{
+  if( b_running )
+  {
+    return;
+  }
+
+  b_running         = true;
+  u8_failures       = 0;
+  i8_datarate       = BASE_JOIN_DR_FIRST;
+  start_time        = UTIL_TIMER_GetCurrentTime();
+
+  base_join_sched_schedule( ( UTIL_TIMER_Time_t ) randr( 0, BASE_JOIN_START_DELAY_MAX ) );
+}
+
+void base_join_sched_stop( void )
+{
+  b_running = false;
+  UTIL_TIMER_Stop( &join_timer );
+}
+
+bool base_join_sched_is_running( void )
+{
+  return b_running;
+}
+
+/**
+  * @brief  To be called with the result of each join request
+  */
+void base_join_sched_on_join_request( LmHandlerJoinParams_t *params )
+{
+  if( params == NULL )
+  {
+    return;
+  }
+  b_request_pending = false;
+
+  if( params->Status == LORAMAC_HANDLER_SUCCESS )
+  {
+    join_stats.u32_joins++;
+    join_stats.u32_time_to_join = UTIL_TIMER_GetElapsedTime( start_time );
+    join_stats.i8_join_datarate = params->Datarate;
+    base_join_sched_stop();
+  }
+  else if( b_running )
+  {
+    base_join_sched_backoff();
+  }
+}
+
+void base_join_sched_get_stats( base_join_sched_stats_t *stats )
+{
+  *stats = join_stats;
+}
+
+// Private functions -----------------------------------------------------------
+static void base_join_sched_process( void )
+{
+  TimerTime_t dc_wait = 0;
+  LoRaMacStatus_t mac_status = LORAMAC_STATUS_OK;
+
+  if( !b_running || b_request_pending )
+  {
+    return;
+  }
+
+  if( LmHandlerJoinStatus() == LORAMAC_HANDLER_SET )
+  {
+    base_join_sched_stop();
+    return;
+  }
+
+  mac_status = LoRaMacQueryNextTxTime( BASE_JOIN_REQ_PAYLOAD_SIZE, &dc_wait );
+  if( mac_status == LORAMAC_STATUS_DUTYCYCLE_RESTRICTED )
+  {
+    // Devices whose time-off ends together must not send together either
+    join_stats.u32_dc_deferred++;
+    base_join_sched_schedule( dc_wait + ( UTIL_TIMER_Time_t ) randr( 0, BASE_JOIN_DC_JITTER_MAX ) );
+    return;
+  }
+  else if( mac_status == LORAMAC_STATUS_BUSY )
+  {
+    base_join_sched_schedule( BASE_JOIN_BUSY_RETRY );
+    return;
+  }
+
+  base_join_sched_reserve_dev_nonce();
+
+  // Set beforehand, the result of an ABP activation is reported within the call
+  b_request_pending = true;
+  switch( LmHandlerJoinAtDatarate( join_activation_type, i8_datarate ) )
+  {
+    case LORAMAC_HANDLER_SUCCESS:
+      join_stats.u32_requests++;
+      break;
+    case LORAMAC_HANDLER_BUSY_ERROR:
+      b_request_pending = false;
+      base_join_sched_schedule( BASE_JOIN_BUSY_RETRY );
+      break;
+    case LORAMAC_HANDLER_DUTYCYCLE_RESTRICTED:
+      // The next run waits for the band of the new datarate
+      b_request_pending = false;
+      base_join_sched_schedule( BASE_JOIN_BUSY_RETRY );
+      break;
+    default:
+      b_request_pending = false;
+      base_join_sched_backoff();
+      break;
+  }
+}
+
+static void base_join_sched_on_timer( void *context )
+{
+  UTIL_SEQ_SetTask( ( 1 << CFG_SEQ_Task_join_task ), CFG_SEQ_Prio_0 );
+}
+
+static void base_join_sched_schedule( UTIL_TIMER_Time_t delay )
+{
+  UTIL_TIMER_Stop( &join_timer );
+  UTIL_TIMER_SetPeriod( &join_timer, MAX( delay, 1 ) );
+  UTIL_TIMER_Start( &join_timer );
+}
+
+static void base_join_sched_backoff( void )
+{
+  uint32_t u32_backoff = BASE_JOIN_BACKOFF_MIN;
+  uint8_t i = 0;
+
+  if( u8_failures < UINT8_MAX )
+  {
+    u8_failures++;
+  }
+
+  // Doubles per failed request of the datarate cycle. It starts over with each cycle, a device
+  // only in reach at the lowest datarate would otherwise wait hours for its next request there.
+  for( i = 0; ( i < ( BASE_JOIN_DR_FIRST - i8_datarate ) ) && ( u32_backoff < BASE_JOIN_BACKOFF_MAX ); i++ )
+  {
+    u32_backoff *= 2;
+  }
+  u32_backoff = MIN( u32_backoff, BASE_JOIN_BACKOFF_MAX );
+
+  // Step toward the lowest datarate, then start over at the highest one
+  i8_datarate = ( i8_datarate > BASE_JOIN_DR_LAST ) ? ( i8_datarate - 1 ) : BASE_JOIN_DR_FIRST;
+
+  base_join_sched_schedule( ( UTIL_TIMER_Time_t ) ( ( u32_backoff / 2 ) + randr( 0, ( int32_t ) u32_backoff ) ) );
+}
+
+static void base_join_sched_reserve_dev_nonce( void )
+{
+  uint16_t u16_dev_nonce = 0;
+
+  if( LmHandlerGetDevNonce( &u16_dev_nonce ) != LORAMAC_HANDLER_SUCCESS )
+  {
+    return;
+  }
+
+  // The next join request uses the DevNonce + 1, it has to be stored before
+  if( ( ( uint32_t ) u16_dev_nonce + 1 ) > u32_dev_nonce_bound )
+  {
+    u32_dev_nonce_bound = MIN( ( uint32_t ) u16_dev_nonce + BASE_JOIN_DEV_NONCE_BLOCK, UINT16_MAX );
+    flash_user_func_set_dev_nonce( u32_dev_nonce_bound );
+  }
+}
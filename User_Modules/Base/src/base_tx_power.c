@@ -0,0 +1,272 @@
+/**
+* @file base_tx_power.c
+* @brief Source file for the link margin driven TX power control.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+*
+* ADR only lowers the TX power on a LinkADRReq, which some network servers
+* rarely send. This controller keeps the uplink margin reported by the link
+* checks (LinkCheckAns) close to BASE_TX_POWER_TARGET_MARGIN:
+* - a link check is piggybacked on every BASE_TX_POWER_LINK_CHECK_PERIOD-th uplink
+* - the power is lowered by at most BASE_TX_POWER_MAX_STEP_DOWN levels per answer
+* - it is raised at once on a missing ACK or link check answer, or if the
+*   downlink level drops, and a link check follows on the next uplink
+* The power commanded by the network (LinkADRReq, ADR backoff) is the highest
+* level the controller may use, the region limits are checked by the MAC.
+**/
+
+/** @addtogroup BASE_TX_POWER
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+// Includes --------------------------------------------------------------------
+#include "main.h"
+#include "base_tx_power.h"
+#include "Region.h"
+#include "utilities.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_TX_POWER_NONE                          ( -1 )                            // No TX power level known
+#define BASE_TX_POWER_LEVEL_NONE                    INT16_MIN                         // No downlink level known
+#define BASE_TX_POWER_MARGIN_RESERVED               255                               // Reserved value of the margin in LinkCheckAns
+
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+static const uint16_t u16_tx_current[]              = BASE_TX_POWER_CURRENT_TABLE;
+static base_tx_power_stats_t tx_power_stats         = { 0 };
+
+static int8_t i8_power_max                          = TX_POWER_0;                     // Highest TX power (lowest level index) allowed by the network
+static int8_t i8_power_min                          = TX_POWER_0;                     // Lowest TX power (highest level index) allowed by the region
+static int8_t i8_power_set                          = BASE_TX_POWER_NONE;             // TX power level in use
+static int8_t i8_power_checked                      = BASE_TX_POWER_NONE;             // TX power level of the uplink carrying the link check
+static uint8_t u8_uplinks_to_check                  = 0;                              // Uplinks until the next link check, 0: next uplink
+static bool b_link_check_pending                    = false;
+static bool b_uplink_lost                           = false;                          // Loss of the last uplink already accounted
+static int16_t i16_level_ref                        = BASE_TX_POWER_LEVEL_NONE;       // Downlink level after the last link check [dBm]
+static int8_t i8_level_ref_slot                     = 0;                              // RX slot of the reference level
+
+// Prototypes ------------------------------------------------------------------
+static void base_tx_power_set( int8_t i8_power );
+static void base_tx_power_raise( int8_t i8_levels );
+
+void base_tx_power_init( void )
+{
+  LoRaMacRegion_t region = LORAMAC_REGION_EU868;
+  GetPhyParams_t phy_params = { 0 };
+  VerifyParams_t verify = { 0 };
+
+  LmHandlerGetActiveRegion( &region );
+
+  // The network may command any level again after a join
+  phy_params.Attribute  = PHY_DEF_TX_POWER;
+  i8_power_max          = ( int8_t ) RegionGetPhyParam( region, &phy_params ).Value;
+
+  // Weakest level of the region
+  i8_power_min = i8_power_max;
+  verify.TxPower = i8_power_min + 1;
+  while( RegionVerify( region, &verify, PHY_TX_POWER ) )
+  {
+    i8_power_min = verify.TxPower++;
+  }
+
+  i8_power_set          = BASE_TX_POWER_NONE;
+  i8_power_checked      = BASE_TX_POWER_NONE;
+  u8_uplinks_to_check   = 0;
+  b_link_check_pending  = false;
+  b_uplink_lost         = false;
+  i16_level_ref         = BASE_TX_POWER_LEVEL_NONE;
+}
+
+/**
+  * @brief  To be called right before an uplink is requested. Takes over the
+  *         level set by the network and schedules the link checks.
+  */
+void base_tx_power_on_tx_request( void )
+{
+#if ( BASE_TX_POWER_CONTROL_ENABLED == 1 )
+  int8_t i8_power = 0;
+
+  if( LmHandlerGetTxPower( &i8_power ) != LORAMAC_HANDLER_SUCCESS )
+  {
+    return;
+  }
+
+  // Changed by a LinkADRReq or the ADR backoff: the new upper limit
+  if( ( i8_power_set != BASE_TX_POWER_NONE ) && ( i8_power != i8_power_set ) )
+  {
+    i8_power_max = i8_power;
+  }
+  i8_power_set = i8_power;
+
+  if( u8_uplinks_to_check > 0 )
+  {
+    u8_uplinks_to_check--;
+  }
+  else if( !b_link_check_pending && ( LmHandlerLinkCheckReq() == LORAMAC_HANDLER_SUCCESS ) )
+  {
+    b_link_check_pending  = true;
+    i8_power_checked      = i8_power;
+    u8_uplinks_to_check   = BASE_TX_POWER_LINK_CHECK_PERIOD;
+  }
+#endif /* BASE_TX_POWER_CONTROL_ENABLED == 1 */
+}
+
+void base_tx_power_on_tx_done( LmHandlerTxParams_t *params )
+{
+  uint8_t u8_transmissions = 0;
+  uint16_t u16_current = 0;
+
+  if( ( params == NULL ) || ( params->IsMcpsConfirm == 0 ) ||
+      ( params->Status == LORAMAC_EVENT_INFO_STATUS_TX_TIMEOUT ) || ( params->Status == LORAMAC_EVENT_INFO_STATUS_TX_DR_PAYLOAD_SIZE_ERROR ) )
+  {
+    return;
+  }
+
+  // Retransmissions of a confirmed uplink are counted with the time on air of the last one
+  u8_transmissions  = ( params->NbRetries > 0 ) ? params->NbRetries : 1;
+  u16_current       = u16_tx_current[MIN( ( uint8_t ) params->TxPower, ( sizeof( u16_tx_current ) / sizeof( u16_tx_current[0] ) ) - 1 )];
+
+  tx_power_stats.u32_uplinks++;
+  tx_power_stats.u64_charge += ( ( uint64_t ) u16_current * params->TxTimeOnAir * u8_transmissions ) / 1000;
+
+  b_uplink_lost = ( params->MsgType == LORAMAC_HANDLER_CONFIRMED_MSG ) && ( params->AckReceived == 0 );
+  if( b_uplink_lost )
+  {
+    tx_power_stats.u32_lost++;
+#if ( BASE_TX_POWER_CONTROL_ENABLED == 1 )
+    base_tx_power_raise( 1 );
+#endif /* BASE_TX_POWER_CONTROL_ENABLED == 1 */
+  }
+}
+
+void base_tx_power_on_rx_data( LmHandlerRxParams_t *params )
+{
+#if ( BASE_TX_POWER_CONTROL_ENABLED == 1 )
+  int16_t i16_level = 0;
+
+  if( ( params == NULL ) || ( params->Status != LORAMAC_EVENT_INFO_STATUS_OK ) ||
+      ( ( params->RxSlot != RX_SLOT_WIN_1 ) && ( params->RxSlot != RX_SLOT_WIN_2 ) ) )
+  {
+    return;
+  }
+
+  // Below the noise floor the RSSI stays put, the SNR tells the rest
+  i16_level = params->Rssi + ( ( params->Snr < 0 ) ? params->Snr : 0 );
+
+  // The path loss is the same in both directions. RX1 and RX2 differ in
+  // frequency and gateway power, only levels of the same slot are compared.
+  if( i16_level_ref == BASE_TX_POWER_LEVEL_NONE )
+  {
+    i16_level_ref     = i16_level;
+    i8_level_ref_slot = params->RxSlot;
+  }
+  else if( ( params->RxSlot == i8_level_ref_slot ) && ( i16_level <= ( i16_level_ref - BASE_TX_POWER_LEVEL_DROP ) ) )
+  {
+    base_tx_power_raise( ( int8_t ) ( ( i16_level_ref - i16_level ) / BASE_TX_POWER_STEP ) );
+    i16_level_ref = i16_level;
+  }
+#endif /* BASE_TX_POWER_CONTROL_ENABLED == 1 */
+}
+
+void base_tx_power_on_link_check( LmHandlerLinkCheckParams_t *params )
+{
+#if ( BASE_TX_POWER_CONTROL_ENABLED == 1 )
+  int16_t i16_margin = 0;
+  int8_t i8_power = 0;
+
+  if( params == NULL )
+  {
+    return;
+  }
+  b_link_check_pending = false;
+
+  if( params->Status != LORAMAC_EVENT_INFO_STATUS_OK )
+  {
+    // Not accounted yet if the uplink was unconfirmed
+    if( !b_uplink_lost )
+    {
+      tx_power_stats.u32_lost++;
+      base_tx_power_raise( 1 );
+    }
+    return;
+  }
+  tx_power_stats.u32_link_checks++;
+
+  if( ( params->DemodMargin == BASE_TX_POWER_MARGIN_RESERVED ) || ( i8_power_checked == BASE_TX_POWER_NONE ) || ( i8_power_set == BASE_TX_POWER_NONE ) )
+  {
+    return;
+  }
+
+  // Margin the uplink would have at the highest power, then the weakest level keeping the target
+  i16_margin  = ( int16_t ) params->DemodMargin + ( BASE_TX_POWER_STEP * i8_power_checked );
+  i8_power    = ( i16_margin > BASE_TX_POWER_TARGET_MARGIN ) ? ( int8_t ) MIN( ( i16_margin - BASE_TX_POWER_TARGET_MARGIN ) / BASE_TX_POWER_STEP, INT8_MAX ) : TX_POWER_0;
+  i8_power    = MIN( i8_power, i8_power_set + BASE_TX_POWER_MAX_STEP_DOWN );
+
+  if( i8_power > i8_power_set )
+  {
+    tx_power_stats.u32_steps_down++;
+  }
+  else if( i8_power < i8_power_set )
+  {
+    tx_power_stats.u32_steps_up++;
+  }
+  base_tx_power_set( i8_power );
+
+  // New reference for the downlink level
+  i16_level_ref = BASE_TX_POWER_LEVEL_NONE;
+#endif /* BASE_TX_POWER_CONTROL_ENABLED == 1 */
+}
+
+void base_tx_power_get_stats( base_tx_power_stats_t *stats )
+{
+  *stats = tx_power_stats;
+}
+
+/**
+  * @brief  Charge drawn by the transmissions per uplink delivered, to compare
+  *         TX power strategies. Unconfirmed uplinks count as delivered unless
+  *         the link check they carried was not answered.
+  * @retval Charge per uplink delivered [uC], 0 if none was delivered yet.
+  */
+uint32_t base_tx_power_get_charge_per_uplink( void )
+{
+  uint32_t u32_delivered = tx_power_stats.u32_uplinks - tx_power_stats.u32_lost;
+
+  if( u32_delivered == 0 )
+  {
+    return 0;
+  }
+
+  return ( uint32_t ) ( tx_power_stats.u64_charge / u32_delivered );
+}
+
+// Private functions -----------------------------------------------------------
+static void base_tx_power_set( int8_t i8_power )
+{
+  // Never above the power commanded by the network, never below the region limit
+  i8_power = MAX( i8_power, i8_power_max );
+  i8_power = MIN( i8_power, i8_power_min );
+
+  if( ( i8_power != i8_power_set ) && ( LmHandlerSetTxPower( i8_power ) == LORAMAC_HANDLER_SUCCESS ) )
+  {
+    i8_power_set = i8_power;
+  }
+}
+
+static void base_tx_power_raise( int8_t i8_levels )
+{
+  if( i8_power_set == BASE_TX_POWER_NONE )
+  {
+    return;
+  }
+
+  // Already at the highest power: the periodic link checks go on
+  if( i8_power_set > i8_power_max )
+  {
+    tx_power_stats.u32_steps_up++;
+    base_tx_power_set( i8_power_set - MAX( i8_levels, 1 ) );
+
+    // Check the link on the next uplink
+    u8_uplinks_to_check = 0;
+  }
+}
@@ -0,0 +1,226 @@
+/**
+* @file base_tx_queue.c
+* @brief Source file for the queue of pending uplinks.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/** @addtogroup BASE_TX_QUEUE
+* @{
+**/
+/*---------------------------------------------------------------------------*/
+
+// Includes --------------------------------------------------------------------
+#include "main.h"
+#include "base_tx_queue.h"
+#include "utilities_conf.h"
+#include "stm32_mem.h"
+
+// Definitions -----------------------------------------------------------------
+#define BASE_TX_QUEUE_PRIO_LOW                      0                                 // Cyclic reports, coalesced with each other
+#define BASE_TX_QUEUE_PRIO_HIGH                     1                                 // Events and confirmed uplinks, never coalesced
+
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+static base_tx_queue_entry_t tx_queue[BASE_TX_QUEUE_SIZE];                            // Pending uplinks in order of arrival
+static uint8_t u8_tx_queue_count                    = 0;
+static base_tx_queue_stats_t tx_queue_stats         = { 0 };
+
+// Prototypes ------------------------------------------------------------------
+static uint8_t base_tx_queue_get_prio( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type );
+static int8_t base_tx_queue_find_head( void );
+static void base_tx_queue_remove( uint8_t u8_idx );
+
+void base_tx_queue_init( void )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  u8_tx_queue_count = 0;
+  UTIL_MEM_set_8( ( void * )&tx_queue_stats, 0, sizeof( tx_queue_stats ) );
+
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+/**
+  * @brief  Adds an uplink request. May be called from interrupt context.
+  * @param[in] tx_reason Reason which is sent in the payload header.
+  * @param[in] msg_type Confirmed or unconfirmed uplink.
+  * @retval true if the request is pending (own or coalesced entry), false if it was dropped.
+  */
+bool base_tx_queue_push( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type )
+{
+  uint8_t u8_prio = base_tx_queue_get_prio( tx_reason, msg_type );
+  bool b_ret = false;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  // A cyclic report of the same type is already pending: it will carry the latest data anyway
+  if( u8_prio == BASE_TX_QUEUE_PRIO_LOW )
+  {
+    for( uint8_t i = 0; i < u8_tx_queue_count; i++ )
+    {
+      if( ( tx_queue[i].tx_reason == tx_reason ) && ( tx_queue[i].msg_type == msg_type ) )
+      {
+        if( tx_queue[i].u8_coalesced < UINT8_MAX )
+        {
+          tx_queue[i].u8_coalesced++;
+        }
+        tx_queue_stats.u32_coalesced++;
+
+        UTILS_EXIT_CRITICAL_SECTION();
+        return true;
+      }
+    }
+  }
+
+  // Queue full: an event replaces the oldest cyclic report, a cyclic report is dropped
+  if( ( u8_tx_queue_count == BASE_TX_QUEUE_SIZE ) && ( u8_prio == BASE_TX_QUEUE_PRIO_HIGH ) )
+  {
+    for( uint8_t i = 0; i < u8_tx_queue_count; i++ )
+    {
+      if( base_tx_queue_get_prio( tx_queue[i].tx_reason, tx_queue[i].msg_type ) == BASE_TX_QUEUE_PRIO_LOW )
+      {
+        base_tx_queue_remove( i );
+        tx_queue_stats.u32_dropped++;
+        break;
+      }
+    }
+  }
+
+  if( u8_tx_queue_count < BASE_TX_QUEUE_SIZE )
+  {
+    tx_queue[u8_tx_queue_count].tx_reason     = tx_reason;
+    tx_queue[u8_tx_queue_count].msg_type      = msg_type;
+    tx_queue[u8_tx_queue_count].u8_coalesced  = 0;
+    u8_tx_queue_count++;
+    tx_queue_stats.u32_queued++;
+    b_ret = true;
+  }
+  else
+  {
+    tx_queue_stats.u32_dropped++;
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return b_ret;
+}
+
+/**
+  * @brief  Returns the uplink to send next without removing it: the oldest entry of the highest priority.
+  * @param[out] entry Copy of the entry.
+  * @retval false if the queue is empty.
+  */
+bool base_tx_queue_peek( base_tx_queue_entry_t *entry )
+{
+  bool b_ret = false;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  int8_t i8_head = base_tx_queue_find_head();
+  if( i8_head >= 0 )
+  {
+    *entry = tx_queue[i8_head];
+    b_ret = true;
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return b_ret;
+}
+
+/**
+  * @brief  Removes an entry returned by base_tx_queue_peek(). Requests pushed in the meantime stay queued.
+  * @param[in] entry Entry returned by base_tx_queue_peek().
+  * @param[in] b_sent true if the MAC accepted the uplink, false if it is given up.
+  */
+void base_tx_queue_pop( const base_tx_queue_entry_t *entry, bool b_sent )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  for( uint8_t i = 0; i < u8_tx_queue_count; i++ )
+  {
+    if( ( tx_queue[i].tx_reason == entry->tx_reason ) && ( tx_queue[i].msg_type == entry->msg_type ) )
+    {
+      base_tx_queue_remove( i );
+
+      if( b_sent )
+      {
+        tx_queue_stats.u32_sent++;
+      }
+      else
+      {
+        tx_queue_stats.u32_dropped++;
+      }
+      break;
+    }
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+bool base_tx_queue_is_empty( void )
+{
+  return ( u8_tx_queue_count == 0 );
+}
+
+uint8_t base_tx_queue_get_count( void )
+{
+  return u8_tx_queue_count;
+}
+
+void base_tx_queue_get_stats( base_tx_queue_stats_t *stats )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  *stats = tx_queue_stats;
+
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+// Private functions -----------------------------------------------------------
+static uint8_t base_tx_queue_get_prio( base_tx_reason_t tx_reason, LmHandlerMsgTypes_t msg_type )
+{
+  if( msg_type == LORAMAC_HANDLER_CONFIRMED_MSG )
+  {
+    return BASE_TX_QUEUE_PRIO_HIGH;
+  }
+
+  switch( tx_reason )
+  {
+    case TX_REASON_TIMER_EVENT:
+    case TX_REASON_APP_CYCLE_EVENT:
+    case TX_REASON_TIMEOUT_EVENT:
+    case TX_REASON_BACKFILL_EVENT:
+      return BASE_TX_QUEUE_PRIO_LOW;
+    default:
+      return BASE_TX_QUEUE_PRIO_HIGH;
+  }
+}
+
+static int8_t base_tx_queue_find_head( void )
+{
+  int8_t i8_head = -1;
+
+  for( uint8_t i = 0; i < u8_tx_queue_count; i++ )
+  {
+    if( base_tx_queue_get_prio( tx_queue[i].tx_reason, tx_queue[i].msg_type ) == BASE_TX_QUEUE_PRIO_HIGH )
+    {
+      return ( int8_t ) i;
+    }
+    if( i8_head < 0 )
+    {
+      i8_head = ( int8_t ) i;
+    }
+  }
+
+  return i8_head;
+}
+
+static void base_tx_queue_remove( uint8_t u8_idx )
+{
+  for( uint8_t i = u8_idx; ( i + 1 ) < u8_tx_queue_count; i++ )
+  {
+    tx_queue[i] = tx_queue[i + 1];
+  }
+  u8_tx_queue_count--;
+}
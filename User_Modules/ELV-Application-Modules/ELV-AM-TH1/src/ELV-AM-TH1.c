@@ -82,6 +82,7 @@ void elv_am_th1_do_measurements( th1_data_values_t *t_th1_data_values )
 
   // Get operating voltage
   u16_supply_voltage_mv = base_get_supply_level();
+  t_th1_data_values->u16_operating_voltage = u16_supply_voltage_mv;
 
   // Calculate NTC temperature
   t_th1_data_values->i16_ntc_temperature = NTC_103AT_2B_VALUES_get_temperature_2( u16_supply_voltage_mv, u16_ntc_voltage_mv );
@@ -0,0 +1,73 @@
+/**
+* @file flash_sample_log.h
+* @brief Header file for the store-and-forward sample log in flash.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __FLASH_SAMPLE_LOG_H
+#define __FLASH_SAMPLE_LOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "app_samples.h"
+
+/* Exported types ------------------------------------------------------------*/
+// The log uses its own pages in front of the EEPROM emulation pages (START_PAGE_ADDRESS).
+// The linker script keeps the application out of this region.
+#define FLASH_SAMPLE_LOG_START_ADDRESS      0x0801B000U
+#define FLASH_SAMPLE_LOG_PAGES_NUMBER       8U
+#define FLASH_SAMPLE_LOG_PAGE_SIZE          0x800U                                  // FLASH_PAGE_SIZE of the STM32WLE5
+#define FLASH_SAMPLE_LOG_SLOTS_PER_PAGE     ( FLASH_SAMPLE_LOG_PAGE_SIZE / 8U )     // One record per double-word, slot 0 is the page header
+
+#define FLASH_SAMPLE_LOG_AGE_UNKNOWN        0xFFFFFFFFU                             // Age of records written before the last reset
+#define FLASH_SAMPLE_LOG_MAGIC              0x534CU                                 // "SL"
+
+/*
+ * Record format, one double-word per record (bit 0 = LSB):
+ *   Bit  0- 7  CRC-8 (polynomial 0x07) over bits 8-63
+ *   Bit  8- 9  Record type (flash_sample_log_record_type_t)
+ * Page header:
+ *   Bit 10-25  Magic FLASH_SAMPLE_LOG_MAGIC
+ *   Bit 26-57  Page sequence number, the page index is sequence % FLASH_SAMPLE_LOG_PAGES_NUMBER
+ * Sample:
+ *   Bit 10-24  Minutes since the last time base record
+ *   Bit 25-36  NTC temperature [0.1 °C], signed, -2048 = invalid
+ *   Bit 37-48  HDC2080 temperature [0.1 °C], signed, -2048 = invalid
+ *   Bit 49-55  Humidity [%], 127 = invalid
+ *   Bit 56-63  Supply voltage, 20 mV steps above 1000 mV
+ * Time base:
+ *   Bit 10-41  SysTime seconds
+ * Drained mark:
+ *   Bit 10-41  Log position of the first record not yet sent
+ */
+typedef enum
+{
+  FLASH_SAMPLE_LOG_RECORD_HEADER = 0,
+  FLASH_SAMPLE_LOG_RECORD_SAMPLE,
+  FLASH_SAMPLE_LOG_RECORD_TIME_BASE,
+  FLASH_SAMPLE_LOG_RECORD_DRAINED,
+} flash_sample_log_record_type_t;
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions ------------------------------------------------------- */
+void flash_sample_log_init( void );
+bool flash_sample_log_append( const app_sample_t *sample );
+bool flash_sample_log_is_empty( void );
+uint8_t flash_sample_log_peek( app_sample_t *samples, uint32_t *u32_ages_s, uint8_t u8_max_samples );
+bool flash_sample_log_confirm_peek( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+  * @}
+  */
+
+#endif /* __FLASH_SAMPLE_LOG_H */
@@ -17,12 +17,18 @@
 #include <stdbool.h>
 #include "eeprom_emul_types.h"
 /* Exported types ------------------------------------------------------------*/
-#define EEPROM_EMU_DATA_INIT_VALUE    0x00000001
+#define EEPROM_EMU_DATA_INIT_VALUE    0x00000002
+#define FLASH_USER_FUNC_RANDOM_SEED_WORDS   8     // SE_RANDOM_SEED_SIZE in 32 bit variables
 
 typedef enum EEPROM_EMU_VirtTable
 {
   EEPROM_EMU_DATA_INIT_ADDRESS = 0x0001,  // First virtual address
   EEPROM_EMU_DUTYCYCLE_ADDRESS,           // 0x0002
+  EEPROM_EMU_SAMPLE_INTERVAL_ADDRESS,     // 0x0003
+  EEPROM_EMU_UPLINK_MODE_ADDRESS,         // 0x0004
+  EEPROM_EMU_DEVNONCE_ADDRESS,            // 0x0005, kept over a reset to defaults
+  EEPROM_EMU_RANDOM_SEED_ADDRESS,         // 0x0006 to 0x000D
+  EEPROM_EMU_RANDOM_SEED_LAST_ADDRESS = EEPROM_EMU_RANDOM_SEED_ADDRESS + FLASH_USER_FUNC_RANDOM_SEED_WORDS - 1,
   EEPROM_EMU_VirtTable_SIZE   // Used to calculate the number of variables
 } EEPROM_EMU_VirtTable;
 
@@ -32,6 +38,10 @@ EE_Status flash_user_func_init( bool b_force_default );
 EE_Status flash_user_func_reinit( void );
 EE_Status flash_user_func_reset( void );
 EE_Status flash_user_func_eeprom_data_set_default( void );
+uint32_t flash_user_func_get_dev_nonce( void );
+EE_Status flash_user_func_set_dev_nonce( uint32_t u32_dev_nonce );
+bool flash_user_func_get_random_seed( uint8_t *seed );
+EE_Status flash_user_func_set_random_seed( const uint8_t *seed );
 
 /* Private types -------------------------------------------------------------*/
 /* Private constants ---------------------------------------------------------*/
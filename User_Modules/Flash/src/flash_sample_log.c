@@ -0,0 +1,453 @@
+/**
+* @file flash_sample_log.c
+* @brief Source file for the store-and-forward sample log in flash.
+* @author Marcel Maas, Thomas Wiemken, ELV Elektronik AG
+**/
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "flash_sample_log.h"
+#include "flash_interface.h"
+#include "eeprom.h"
+#include "stm32_systime.h"
+#include "ELV-AM-TH1.h"
+
+/* Definitions ---------------------------------------------------------------*/
+#define FLASH_SAMPLE_LOG_ERASED             0xFFFFFFFFFFFFFFFFU
+#define FLASH_SAMPLE_LOG_TEMP_INVALID       ( -2048 )
+#define FLASH_SAMPLE_LOG_HUM_INVALID        127U
+#define FLASH_SAMPLE_LOG_VDD_OFFSET_MV      1000U
+#define FLASH_SAMPLE_LOG_VDD_STEP_MV        20U
+#define FLASH_SAMPLE_LOG_MAX_OFFSET_MIN     0x7FFFU
+
+#define FLASH_SAMPLE_LOG_PAGE_OF( __POS__ )   ( ( ( __POS__ ) / FLASH_SAMPLE_LOG_SLOTS_PER_PAGE ) % FLASH_SAMPLE_LOG_PAGES_NUMBER )
+#define FLASH_SAMPLE_LOG_SLOT_OF( __POS__ )   ( ( __POS__ ) % FLASH_SAMPLE_LOG_SLOTS_PER_PAGE )
+#define FLASH_SAMPLE_LOG_ADDRESS( __POS__ )   ( FLASH_SAMPLE_LOG_START_ADDRESS + ( FLASH_SAMPLE_LOG_PAGE_OF( __POS__ ) * FLASH_SAMPLE_LOG_PAGE_SIZE ) + ( FLASH_SAMPLE_LOG_SLOT_OF( __POS__ ) * 8U ) )
+
+/* Typedefs ------------------------------------------------------------------*/
+/* Variables -----------------------------------------------------------------*/
+extern __IO uint32_t ErasingOnGoing;
+
+// Log positions count double-words: page sequence * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE + slot
+static uint32_t u32_write_pos       = 0;  // Next free slot
+static uint32_t u32_read_pos        = 0;  // First record not yet sent
+static uint32_t u32_oldest_pos      = 0;  // Header of the oldest page still in flash
+static uint32_t u32_boot_pos        = 0;  // Everything before was written before the last reset
+static uint32_t u32_peek_end_pos    = 0;  // Position after the last record returned by flash_sample_log_peek()
+static uint32_t u32_pending         = 0;  // Samples from the read position on, flash_sample_log_is_empty() must not scan the flash
+static uint32_t u32_time_base_s     = 0;
+static bool b_time_base_in_page     = false;
+
+/* Prototypes ----------------------------------------------------------------*/
+static uint8_t flash_sample_log_crc8( uint64_t u64_record );
+static uint64_t flash_sample_log_make_record( flash_sample_log_record_type_t type, uint64_t u64_payload );
+static bool flash_sample_log_read_record( uint32_t u32_pos, flash_sample_log_record_type_t *type, uint64_t *u64_payload );
+static uint32_t flash_sample_log_count_samples( uint32_t u32_from_pos, uint32_t u32_to_pos );
+static bool flash_sample_log_program( uint32_t u32_pos, uint64_t u64_record );
+static bool flash_sample_log_open_page( uint32_t u32_seq );
+static bool flash_sample_log_write_record( flash_sample_log_record_type_t type, uint64_t u64_payload );
+static uint64_t flash_sample_log_pack_sample( const app_sample_t *sample, uint32_t u32_offset_min );
+static void flash_sample_log_unpack_sample( uint64_t u64_payload, app_sample_t *sample, uint32_t *u32_offset_min );
+
+/* Exported functions ------------------------------------------------------- */
+/**
+  * @brief  Scans the log pages once after reset to restore the write and read positions.
+  * @retval None
+  */
+void flash_sample_log_init( void )
+{
+  flash_sample_log_record_type_t type;
+  uint64_t u64_payload = 0;
+  bool b_found = false;
+  uint32_t u32_seq = 0;
+
+  for( uint32_t page = 0; page < FLASH_SAMPLE_LOG_PAGES_NUMBER; page++ )
+  {
+    if( flash_sample_log_read_record( page * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE, &type, &u64_payload ) && ( type == FLASH_SAMPLE_LOG_RECORD_HEADER ) )
+    {
+      uint32_t u32_page_seq = ( uint32_t ) ( u64_payload >> 16 );
+
+      if( ( ( u64_payload & 0xFFFFU ) == FLASH_SAMPLE_LOG_MAGIC ) && ( ( u32_page_seq % FLASH_SAMPLE_LOG_PAGES_NUMBER ) == page ) )
+      {
+        if( !b_found || ( u32_page_seq > u32_seq ) )
+        {
+          u32_seq = u32_page_seq;
+        }
+        b_found = true;
+      }
+    }
+  }
+
+  if( !b_found )
+  {
+    // Empty or foreign content: start a fresh log
+    flash_sample_log_open_page( 0 );
+    u32_oldest_pos  = 0;
+    u32_read_pos    = 1;
+    u32_boot_pos    = u32_write_pos;
+    u32_pending     = 0;
+    return;
+  }
+
+  // Find the first free slot of the newest page
+  u32_write_pos = ( u32_seq * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE ) + 1;
+  while( ( FLASH_SAMPLE_LOG_SLOT_OF( u32_write_pos ) != 0 ) && ( *( __IO uint64_t * ) FLASH_SAMPLE_LOG_ADDRESS( u32_write_pos ) != FLASH_SAMPLE_LOG_ERASED ) )
+  {
+    u32_write_pos++;
+  }
+
+  // Find the oldest page which still belongs to the log
+  for( uint32_t s = ( u32_seq >= ( FLASH_SAMPLE_LOG_PAGES_NUMBER - 1 ) ) ? ( u32_seq - ( FLASH_SAMPLE_LOG_PAGES_NUMBER - 1 ) ) : 0; s <= u32_seq; s++ )
+  {
+    if( flash_sample_log_read_record( s * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE, &type, &u64_payload ) && ( type == FLASH_SAMPLE_LOG_RECORD_HEADER ) && ( ( uint32_t ) ( u64_payload >> 16 ) == s ) )
+    {
+      u32_oldest_pos = s * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE;
+      break;
+    }
+  }
+
+  // The newest drained mark tells where sending has to continue
+  u32_read_pos = u32_oldest_pos + 1;
+  for( uint32_t pos = u32_oldest_pos; pos < u32_write_pos; pos++ )
+  {
+    if( flash_sample_log_read_record( pos, &type, &u64_payload ) && ( type == FLASH_SAMPLE_LOG_RECORD_DRAINED ) )
+    {
+      if( ( uint32_t ) u64_payload > u32_read_pos )
+      {
+        u32_read_pos = ( uint32_t ) u64_payload;
+      }
+    }
+  }
+
+  u32_boot_pos        = u32_write_pos;
+  u32_pending         = flash_sample_log_count_samples( u32_read_pos, u32_write_pos );
+  b_time_base_in_page = false;
+}
+
+/**
+  * @brief  Appends a sample. Costs one double-word program, plus a time base record
+  *         for the first sample of a page or after a reset, plus a page erase when a page is opened.
+  * @param[in] sample Sample to store.
+  * @retval true if the sample was written.
+  */
+bool flash_sample_log_append( const app_sample_t *sample )
+{
+  uint32_t u32_now_s = SysTimeGet().Seconds;
+
+  for( uint8_t attempt = 0; attempt < 3; attempt++ )
+  {
+    if( FLASH_SAMPLE_LOG_SLOT_OF( u32_write_pos ) == 0 )
+    {
+      if( !flash_sample_log_open_page( u32_write_pos / FLASH_SAMPLE_LOG_SLOTS_PER_PAGE ) )
+      {
+        return false;
+      }
+    }
+
+    if( !b_time_base_in_page || ( ( ( u32_now_s - u32_time_base_s ) / 60 ) > FLASH_SAMPLE_LOG_MAX_OFFSET_MIN ) )
+    {
+      if( !flash_sample_log_write_record( FLASH_SAMPLE_LOG_RECORD_TIME_BASE, u32_now_s ) )
+      {
+        return false;
+      }
+      u32_time_base_s     = u32_now_s;
+      b_time_base_in_page = true;
+      continue;   // The time base may have used the last slot of the page
+    }
+
+    if( !flash_sample_log_write_record( FLASH_SAMPLE_LOG_RECORD_SAMPLE, flash_sample_log_pack_sample( sample, ( u32_now_s - u32_time_base_s ) / 60 ) ) )
+    {
+      return false;
+    }
+    u32_pending++;
+    return true;
+  }
+
+  return false;
+}
+
+bool flash_sample_log_is_empty( void )
+{
+  return ( u32_pending == 0 );
+}
+
+/**
+  * @brief  Reads the oldest samples not yet sent without removing them.
+  *         Call flash_sample_log_confirm_peek() once they have been handed to the MAC.
+  * @param[out] samples Destination for up to u8_max_samples samples.
+  * @param[out] u32_ages_s Age of each sample in seconds or FLASH_SAMPLE_LOG_AGE_UNKNOWN.
+  * @param[in] u8_max_samples Maximum number of samples to read.
+  * @retval Number of samples read.
+  */
+uint8_t flash_sample_log_peek( app_sample_t *samples, uint32_t *u32_ages_s, uint8_t u8_max_samples )
+{
+  flash_sample_log_record_type_t type;
+  uint64_t u64_payload = 0;
+  uint32_t u32_now_s = SysTimeGet().Seconds;
+  uint32_t u32_base_s = 0;
+  uint32_t u32_offset_min = 0;
+  uint8_t u8_count = 0;
+
+  u32_peek_end_pos = u32_write_pos;
+
+  if( u8_max_samples == 0 )
+  {
+    u32_peek_end_pos = u32_read_pos;
+    return 0;
+  }
+
+  // Each page carries its own time base in front of its first sample
+  for( uint32_t pos = u32_read_pos - FLASH_SAMPLE_LOG_SLOT_OF( u32_read_pos ); pos < u32_write_pos; pos++ )
+  {
+    if( !flash_sample_log_read_record( pos, &type, &u64_payload ) )
+    {
+      continue;   // Torn write, skip the record
+    }
+
+    if( type == FLASH_SAMPLE_LOG_RECORD_TIME_BASE )
+    {
+      u32_base_s = ( uint32_t ) u64_payload;
+    }
+    else if( ( type == FLASH_SAMPLE_LOG_RECORD_SAMPLE ) && ( pos >= u32_read_pos ) )
+    {
+      flash_sample_log_unpack_sample( u64_payload, &samples[u8_count], &u32_offset_min );
+
+      if( pos >= u32_boot_pos )
+      {
+        u32_ages_s[u8_count] = u32_now_s - ( u32_base_s + ( u32_offset_min * 60 ) );
+      }
+      else
+      {
+        u32_ages_s[u8_count] = FLASH_SAMPLE_LOG_AGE_UNKNOWN;
+      }
+
+      if( ++u8_count == u8_max_samples )
+      {
+        u32_peek_end_pos = pos + 1;
+        break;
+      }
+    }
+  }
+
+  return u8_count;
+}
+
+/**
+  * @brief  Marks the samples of the last flash_sample_log_peek() as sent.
+  * @retval true if the drained mark was written.
+  */
+bool flash_sample_log_confirm_peek( void )
+{
+  uint32_t u32_sent = 0;
+
+  if( u32_peek_end_pos <= u32_read_pos )
+  {
+    return true;
+  }
+
+  if( FLASH_SAMPLE_LOG_SLOT_OF( u32_write_pos ) == 0 )
+  {
+    if( !flash_sample_log_open_page( u32_write_pos / FLASH_SAMPLE_LOG_SLOTS_PER_PAGE ) )
+    {
+      return false;
+    }
+  }
+
+  // Counted after opening the page, samples of an erased page are already taken off
+  u32_sent = flash_sample_log_count_samples( u32_read_pos, u32_peek_end_pos );
+
+  if( !flash_sample_log_write_record( FLASH_SAMPLE_LOG_RECORD_DRAINED, u32_peek_end_pos ) )
+  {
+    return false;
+  }
+
+  u32_read_pos  = MAX( u32_read_pos, u32_peek_end_pos );
+  u32_pending  -= MIN( u32_sent, u32_pending );
+
+  return true;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static uint8_t flash_sample_log_crc8( uint64_t u64_record )
+{
+  uint8_t u8_crc = 0;
+
+  for( uint8_t byte = 1; byte < 8; byte++ )
+  {
+    u8_crc ^= ( uint8_t ) ( u64_record >> ( byte * 8 ) );
+    for( uint8_t bit = 0; bit < 8; bit++ )
+    {
+      u8_crc = ( u8_crc & 0x80 ) ? ( uint8_t ) ( ( u8_crc << 1 ) ^ 0x07 ) : ( uint8_t ) ( u8_crc << 1 );
+    }
+  }
+
+  return u8_crc;
+}
+
+static uint64_t flash_sample_log_make_record( flash_sample_log_record_type_t type, uint64_t u64_payload )
+{
+  uint64_t u64_record = ( ( u64_payload << 10 ) | ( ( uint64_t ) type << 8 ) );
+
+  return u64_record | flash_sample_log_crc8( u64_record );
+}
+
+static bool flash_sample_log_read_record( uint32_t u32_pos, flash_sample_log_record_type_t *type, uint64_t *u64_payload )
+{
+  uint64_t u64_record = *( __IO uint64_t * ) FLASH_SAMPLE_LOG_ADDRESS( u32_pos );
+
+  if( ( u64_record == FLASH_SAMPLE_LOG_ERASED ) || ( ( uint8_t ) u64_record != flash_sample_log_crc8( u64_record ) ) )
+  {
+    return false;
+  }
+
+  *type         = ( flash_sample_log_record_type_t ) ( ( u64_record >> 8 ) & 0x3 );
+  *u64_payload  = u64_record >> 10;
+
+  return true;
+}
+
+/**
+  * @brief  Counts the valid samples in [u32_from_pos, u32_to_pos). Only used at init
+  *         and for the few records of a peek or an erased page.
+  */
+static uint32_t flash_sample_log_count_samples( uint32_t u32_from_pos, uint32_t u32_to_pos )
+{
+  flash_sample_log_record_type_t type;
+  uint64_t u64_payload = 0;
+  uint32_t u32_count = 0;
+
+  for( uint32_t pos = u32_from_pos; pos < u32_to_pos; pos++ )
+  {
+    if( flash_sample_log_read_record( pos, &type, &u64_payload ) && ( type == FLASH_SAMPLE_LOG_RECORD_SAMPLE ) )
+    {
+      u32_count++;
+    }
+  }
+
+  return u32_count;
+}
+
+static bool flash_sample_log_program( uint32_t u32_pos, uint64_t u64_record )
+{
+  HAL_StatusTypeDef status;
+
+  /* Wait any cleanup is completed before accessing flash again */
+  while( ErasingOnGoing == 1 )
+  {
+    ;
+  }
+
+  HAL_FLASH_Unlock();
+  status = FI_WriteDoubleWord( FLASH_SAMPLE_LOG_ADDRESS( u32_pos ), u64_record );
+  HAL_FLASH_Lock();
+
+  return ( status == HAL_OK );
+}
+
+static bool flash_sample_log_open_page( uint32_t u32_seq )
+{
+  EE_Status ee_status;
+  uint32_t u32_page = ( FLASH_SAMPLE_LOG_START_ADDRESS - FLASH_BASE ) / FLASH_SAMPLE_LOG_PAGE_SIZE + ( u32_seq % FLASH_SAMPLE_LOG_PAGES_NUMBER );
+  uint32_t u32_lost = 0;
+
+  // Samples not yet sent on the page to be erased
+  if( u32_seq >= FLASH_SAMPLE_LOG_PAGES_NUMBER )
+  {
+    uint32_t u32_erased_pos = ( u32_seq - FLASH_SAMPLE_LOG_PAGES_NUMBER ) * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE;
+
+    u32_lost = flash_sample_log_count_samples( MAX( u32_read_pos, u32_erased_pos ), MIN( u32_erased_pos + FLASH_SAMPLE_LOG_SLOTS_PER_PAGE, u32_write_pos ) );
+  }
+
+  while( ErasingOnGoing == 1 )
+  {
+    ;
+  }
+
+  HAL_FLASH_Unlock();
+  ee_status = FI_PageErase( u32_page, 1 );
+  FI_CacheFlush();
+  HAL_FLASH_Lock();
+
+  if( ee_status != EE_OK )
+  {
+    return false;
+  }
+  u32_pending -= MIN( u32_lost, u32_pending );
+
+  u32_write_pos = u32_seq * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE;
+  if( !flash_sample_log_program( u32_write_pos, flash_sample_log_make_record( FLASH_SAMPLE_LOG_RECORD_HEADER, ( ( uint64_t ) u32_seq << 16 ) | FLASH_SAMPLE_LOG_MAGIC ) ) )
+  {
+    return false;
+  }
+  u32_write_pos++;
+  b_time_base_in_page = false;
+
+  // The erased page held the oldest records, they are lost now
+  if( u32_seq >= FLASH_SAMPLE_LOG_PAGES_NUMBER )
+  {
+    u32_oldest_pos = ( u32_seq - ( FLASH_SAMPLE_LOG_PAGES_NUMBER - 1 ) ) * FLASH_SAMPLE_LOG_SLOTS_PER_PAGE;
+    if( u32_read_pos <= u32_oldest_pos )
+    {
+      u32_read_pos = u32_oldest_pos + 1;
+    }
+  }
+
+  return true;
+}
+
+static bool flash_sample_log_write_record( flash_sample_log_record_type_t type, uint64_t u64_payload )
+{
+  if( !flash_sample_log_program( u32_write_pos, flash_sample_log_make_record( type, u64_payload ) ) )
+  {
+    return false;
+  }
+  u32_write_pos++;
+
+  return true;
+}
+
+static uint64_t flash_sample_log_pack_sample( const app_sample_t *sample, uint32_t u32_offset_min )
+{
+  int32_t i32_ntc = sample->i16_ntc_temperature;
+  int32_t i32_hdc = sample->i16_HDC2080_temperature;
+  uint32_t u32_hum = sample->u8_HDC2080_humidity;
+  uint32_t u32_vdd = 0;
+
+  if( ( ( uint16_t ) i32_ntc >= TEMPERATURE_UNKNOWN ) && ( ( uint16_t ) i32_ntc <= TEMPERATURE_UNDERFLOW ) )
+  {
+    i32_ntc = FLASH_SAMPLE_LOG_TEMP_INVALID;
+  }
+  if( ( ( uint16_t ) i32_hdc >= TEMPERATURE_UNKNOWN ) && ( ( uint16_t ) i32_hdc <= TEMPERATURE_UNDERFLOW ) )
+  {
+    i32_hdc = FLASH_SAMPLE_LOG_TEMP_INVALID;
+  }
+  i32_ntc = ( i32_ntc < -2047 ) ? FLASH_SAMPLE_LOG_TEMP_INVALID : ( ( i32_ntc > 2047 ) ? 2047 : i32_ntc );
+  i32_hdc = ( i32_hdc < -2047 ) ? FLASH_SAMPLE_LOG_TEMP_INVALID : ( ( i32_hdc > 2047 ) ? 2047 : i32_hdc );
+  u32_hum = ( u32_hum > 100 ) ? FLASH_SAMPLE_LOG_HUM_INVALID : u32_hum;
+
+  if( sample->u16_supply_voltage > FLASH_SAMPLE_LOG_VDD_OFFSET_MV )
+  {
+    u32_vdd = ( sample->u16_supply_voltage - FLASH_SAMPLE_LOG_VDD_OFFSET_MV + ( FLASH_SAMPLE_LOG_VDD_STEP_MV / 2 ) ) / FLASH_SAMPLE_LOG_VDD_STEP_MV;
+    u32_vdd = ( u32_vdd > 0xFF ) ? 0xFF : u32_vdd;
+  }
+
+  return ( ( uint64_t ) ( u32_offset_min & FLASH_SAMPLE_LOG_MAX_OFFSET_MIN ) )
+       | ( ( uint64_t ) ( ( uint32_t ) i32_ntc & 0xFFFU ) << 15 )
+       | ( ( uint64_t ) ( ( uint32_t ) i32_hdc & 0xFFFU ) << 27 )
+       | ( ( uint64_t ) ( u32_hum & 0x7FU ) << 39 )
+       | ( ( uint64_t ) ( u32_vdd & 0xFFU ) << 46 );
+}
+
+static void flash_sample_log_unpack_sample( uint64_t u64_payload, app_sample_t *sample, uint32_t *u32_offset_min )
+{
+  int16_t i16_ntc = ( int16_t ) ( ( ( uint16_t ) ( u64_payload >> 15 ) & 0xFFFU ) << 4 ) >> 4;
+  int16_t i16_hdc = ( int16_t ) ( ( ( uint16_t ) ( u64_payload >> 27 ) & 0xFFFU ) << 4 ) >> 4;
+  uint8_t u8_hum  = ( uint8_t ) ( ( u64_payload >> 39 ) & 0x7FU );
+
+  *u32_offset_min = ( uint32_t ) ( u64_payload & FLASH_SAMPLE_LOG_MAX_OFFSET_MIN );
+
+  sample->i16_ntc_temperature     = ( i16_ntc == FLASH_SAMPLE_LOG_TEMP_INVALID ) ? ( int16_t ) TEMPERATURE_UNKNOWN : i16_ntc;
+  sample->i16_HDC2080_temperature = ( i16_hdc == FLASH_SAMPLE_LOG_TEMP_INVALID ) ? ( int16_t ) TEMPERATURE_UNKNOWN : i16_hdc;
+  sample->u8_HDC2080_humidity     = ( u8_hum == FLASH_SAMPLE_LOG_HUM_INVALID ) ? APP_SAMPLES_HUMIDITY_INVALID : u8_hum;
+  sample->u16_supply_voltage      = ( uint16_t ) ( FLASH_SAMPLE_LOG_VDD_OFFSET_MV + ( ( ( u64_payload >> 46 ) & 0xFFU ) * FLASH_SAMPLE_LOG_VDD_STEP_MV ) );
+}
@@ -21,10 +21,19 @@
 EE_Status flash_user_func_init( bool b_force_default )
 {
   EE_Status ee_status = EE_OK;
+  uint32_t u32_dev_nonce = 0;
   
   ee_status = EEPROM_emulation_init();
   
+  // A used DevNonce must never be sent again, it survives the reset to defaults
+  u32_dev_nonce = flash_user_func_get_dev_nonce();
+
   ee_status = EEPROM_check_persist_data_init( EEPROM_EMU_DATA_INIT_VALUE, b_force_default );
+
+  if( ( u32_dev_nonce != 0 ) && ( flash_user_func_get_dev_nonce() != u32_dev_nonce ) )
+  {
+    ee_status = flash_user_func_set_dev_nonce( u32_dev_nonce );
+  }
   
   return ee_status;
 }
@@ -41,8 +50,14 @@ EE_Status flash_user_func_reinit( void )
 EE_Status flash_user_func_reset( void )
 {
   EE_Status ee_status = EE_OK;
+  uint32_t u32_dev_nonce = flash_user_func_get_dev_nonce();
 
   ee_status = EEPROM_emulation_reset();
+
+  if( u32_dev_nonce != 0 )
+  {
+    ee_status = flash_user_func_set_dev_nonce( u32_dev_nonce );
+  }
   
   return ee_status;
 }
@@ -56,6 +71,68 @@ EE_Status flash_user_func_eeprom_data_set_default( void )
   return ee_status;
 }
 
+/**
+  * @brief  Reads the DevNonce bound of the join scheduler
+  * @retval DevNonce bound, 0 if none was stored yet
+  */
+uint32_t flash_user_func_get_dev_nonce( void )
+{
+  uint32_t u32_dev_nonce = 0;
+
+  // Not stored by older firmware, EEPROM_read_ee_variable_32bits() would treat that as an error
+  if( EE_ReadVariable32bits( EEPROM_EMU_DEVNONCE_ADDRESS, &u32_dev_nonce ) != EE_OK )
+  {
+    u32_dev_nonce = 0;
+  }
+
+  return u32_dev_nonce;
+}
+
+EE_Status flash_user_func_set_dev_nonce( uint32_t u32_dev_nonce )
+{
+  return EEPROM_write_ee_variable_32bits( EEPROM_EMU_DEVNONCE_ADDRESS, u32_dev_nonce );
+}
+
+/**
+  * @brief  Reads the random generator seed saved at the previous boot
+  * @param  seed: FLASH_USER_FUNC_RANDOM_SEED_WORDS * 4 bytes
+  * @retval false if no seed was stored yet, after a reset to defaults or by older firmware
+  */
+bool flash_user_func_get_random_seed( uint8_t *seed )
+{
+  uint32_t u32_word = 0;
+
+  for( uint8_t i = 0; i < FLASH_USER_FUNC_RANDOM_SEED_WORDS; i++ )
+  {
+    if( EE_ReadVariable32bits( EEPROM_EMU_RANDOM_SEED_ADDRESS + i, &u32_word ) != EE_OK )
+    {
+      return false;
+    }
+    for( uint8_t j = 0; j < 4; j++ )
+    {
+      seed[( i * 4 ) + j] = ( uint8_t )( u32_word >> ( 8 * j ) );
+    }
+  }
+
+  return true;
+}
+
+EE_Status flash_user_func_set_random_seed( const uint8_t *seed )
+{
+  EE_Status ee_status = EE_OK;
+
+  // A failed write ends in EEPROM_Error_Handler(), a cleanup status is no reason to stop
+  for( uint8_t i = 0; i < FLASH_USER_FUNC_RANDOM_SEED_WORDS; i++ )
+  {
+    uint32_t u32_word = ( uint32_t )seed[i * 4] | ( ( uint32_t )seed[( i * 4 ) + 1] << 8 )
+                        | ( ( uint32_t )seed[( i * 4 ) + 2] << 16 ) | ( ( uint32_t )seed[( i * 4 ) + 3] << 24 );
+
+    ee_status = EEPROM_write_ee_variable_32bits( EEPROM_EMU_RANDOM_SEED_ADDRESS + i, u32_word );
+  }
+
+  return ee_status;
+}
+
 void EEPROM_Error_Handler( void )
 {
   HW_GPIO_Write( LED_RED_GPIO_PORT, LED_RED_GPIO_PIN, GPIO_PIN_SET );
@@ -0,0 +1,88 @@
+/**
+* @file rtc_temp_comp.c
+* @brief Temperature compensation of the RTC clock (LSE crystal).
+*
+* The frequency of a 32.768 kHz tuning fork crystal follows a parabola around
+* its turnover temperature: error = RTC_TEMP_COEFFICIENT * ( T - RTC_TEMP_TURNOVER )^2.
+* The error is cancelled by the RTC smooth calibration, which adds or masks
+* RTCCLK pulses over a 32 s cycle in steps of 2^-20 ( 0.954 ppm ).
+**/
+
+// Includes --------------------------------------------------------------------
+#include "rtc.h"
+#include "lorawan_conf.h"
+#include "rtc_temp_comp.h"
+
+// Definitions -----------------------------------------------------------------
+#define RTC_TEMP_COMP_MIN_TEMPERATURE   ( -400 )  // Lowest valid temperature [0.1 degC]
+#define RTC_TEMP_COMP_MAX_TEMPERATURE   ( 1250 )  // Highest valid temperature [0.1 degC]
+#define RTC_TEMP_COMP_CALM_MAX          ( 511 )   // Highest number of masked pulses
+#define RTC_TEMP_COMP_CALP_PULSES       ( 512 )   // Number of pulses added by CALP
+
+// Crystal parameters of lorawan_conf.h in integer units, folded at compile time
+#define RTC_TEMP_COMP_COEFFICIENT       ( ( int32_t ) ( RTC_TEMP_COEFFICIENT * 1000.0 ) )  // [ppb/degC^2]
+#define RTC_TEMP_COMP_TURNOVER          ( ( int32_t ) ( RTC_TEMP_TURNOVER * 10.0 ) )          // [0.1 degC]
+
+// Typedefs --------------------------------------------------------------------
+// Variables -------------------------------------------------------------------
+static int32_t i32_error_ppb          = 0;              // Frequency error compensated at last
+static uint32_t u32_calib_plus        = RTC_SMOOTHCALIB_PLUSPULSES_RESET;
+static uint32_t u32_calib_minus       = 0;
+
+// Prototypes ------------------------------------------------------------------
+// Exported functions ----------------------------------------------------------
+void rtc_temp_comp_update( int16_t i16_temperature )
+{
+#if ( RTC_TEMP_COMPENSATION_ENABLED == 1 )
+  int32_t i32_delta = 0;
+  int32_t i32_steps = 0;
+  uint32_t u32_plus = RTC_SMOOTHCALIB_PLUSPULSES_RESET;
+  uint32_t u32_minus = 0;
+
+  if( ( i16_temperature < RTC_TEMP_COMP_MIN_TEMPERATURE ) || ( i16_temperature > RTC_TEMP_COMP_MAX_TEMPERATURE ) )
+  {
+    return;
+  }
+
+  // Frequency error of the crystal [ppb], divided once at the end, the product stays below 4 * 10^7
+  i32_delta = ( int32_t ) i16_temperature - RTC_TEMP_COMP_TURNOVER;
+  i32_error_ppb = ( RTC_TEMP_COMP_COEFFICIENT * i32_delta * i32_delta ) / 100;
+
+  // Correction in calibration steps of 2^-20, rounded to the nearest
+  i32_steps = ( int32_t ) ( ( ( int64_t ) -i32_error_ppb * ( 1 << 20 ) + ( ( i32_error_ppb > 0 ) ? -500000000 : 500000000 ) ) / 1000000000 );
+
+  if( i32_steps > 0 )
+  {
+    // Crystal too slow: add 512 pulses, mask the surplus
+    u32_plus = RTC_SMOOTHCALIB_PLUSPULSES_SET;
+    if( i32_steps > RTC_TEMP_COMP_CALP_PULSES )
+    {
+      i32_steps = RTC_TEMP_COMP_CALP_PULSES;
+    }
+    u32_minus = ( uint32_t ) ( RTC_TEMP_COMP_CALP_PULSES - i32_steps );
+  }
+  else
+  {
+    if( i32_steps < -RTC_TEMP_COMP_CALM_MAX )
+    {
+      i32_steps = -RTC_TEMP_COMP_CALM_MAX;
+    }
+    u32_minus = ( uint32_t ) -i32_steps;
+  }
+
+  // Writing the calibration waits for the previous one to be applied
+  if( ( u32_plus != u32_calib_plus ) || ( u32_minus != u32_calib_minus ) )
+  {
+    if( HAL_RTCEx_SetSmoothCalib( &hrtc, RTC_SMOOTHCALIB_PERIOD_32SEC, u32_plus, u32_minus ) == HAL_OK )
+    {
+      u32_calib_plus  = u32_plus;
+      u32_calib_minus = u32_minus;
+    }
+  }
+#endif /* RTC_TEMP_COMPENSATION_ENABLED == 1 */
+}
+
+int32_t rtc_temp_comp_get_error( void )
+{
+  return( i32_error_ppb );
+}
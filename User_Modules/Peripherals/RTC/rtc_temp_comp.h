@@ -0,0 +1,48 @@
+/**
+* @file rtc_temp_comp.h
+* @brief Header file for the temperature compensation of the RTC clock.
+*
+* The temperature is taken from the HDC2080 of the ELV-AM-TH1 add-on board
+* with each sample (app_samples_measure). It is not next to the crystal of
+* the base module, but inside the same housing, whereas the NTC is an
+* external probe which may measure a place far away from the device. Without
+* the add-on board the calibration stays at the reset value.
+**/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RTC_TEMP_COMP_H__
+#define __RTC_TEMP_COMP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Includes --------------------------------------------------------------------
+#include <stdint.h>
+
+// Exported types --------------------------------------------------------------
+// Exported constants ----------------------------------------------------------
+// External variables ----------------------------------------------------------
+// Exported macro --------------------------------------------------------------
+// Exported functions prototypes -----------------------------------------------
+
+/**
+  * @brief Compensates the frequency error of the 32.768 kHz crystal at the given
+  *        temperature with the RTC smooth calibration. The timer ticks, alarms
+  *        and the system time follow without any software correction.
+  * @param[in] i16_temperature Temperature inside the housing [0.1 degC],
+  *            invalid values (e.g. TEMPERATURE_UNKNOWN) are ignored
+  */
+void rtc_temp_comp_update( int16_t i16_temperature );
+
+/**
+  * @brief Get the frequency error of the crystal compensated at last
+  * @return Frequency error [ppb], negative if the crystal runs slow
+  */
+int32_t rtc_temp_comp_get_error( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTC_TEMP_COMP_H__ */